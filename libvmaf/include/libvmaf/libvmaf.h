@@ -52,9 +52,28 @@ enum VmafPoolingMethod {
     VMAF_POOL_METHOD_MAX,
     VMAF_POOL_METHOD_MEAN,
     VMAF_POOL_METHOD_HARMONIC_MEAN,
+    VMAF_POOL_METHOD_PERCENTILE,
+    VMAF_POOL_METHOD_WINDOW_MIN,
     VMAF_POOL_METHOD_NB
 };
 
+/**
+ * @struct VmafPoolingConfiguration
+ * @brief  A temporal pooling method and its parameter.
+ *
+ * @param method  Temporal pooling method to use.
+ *
+ * @param param   For `VMAF_POOL_METHOD_PERCENTILE`, the percentile in
+ *                [0, 100], interpolated linearly between the two nearest
+ *                scores. For `VMAF_POOL_METHOD_WINDOW_MIN`, a whole number
+ *                of frames: the lowest mean score of any window of that many
+ *                consecutive scored frames. Ignored by other methods.
+ */
+typedef struct VmafPoolingConfiguration {
+    enum VmafPoolingMethod method;
+    double param;
+} VmafPoolingConfiguration;
+
 /**
  * @struct VmafConfiguration
  * @brief  Configuration needed to initialize a `VmafContext`
@@ -79,6 +98,24 @@ enum VmafPoolingMethod {
  * 
  * @param gpumask     Restrict permitted GPU operations.
  *                    if gpumask: disable CUDA
+ *
+ * @param thread_affinity Optional. Pin the `n_threads` worker threads to a
+ *                    list of cores, e.g. "0-7,16-23", or to the cores of a
+ *                    list of NUMA nodes, e.g. "node:1". Linux only.
+ *
+ * @param max_frames_in_flight Optional. How many picture pairs
+ *                    `vmaf_submit_pictures()` lets into extraction before it
+ *                    returns -EAGAIN. Defaults to, and is capped at, `n_threads`.
+ *
+ * @param subsample_threshold Optional. Adaptive subsampling: non-temporal
+ *                    features are only extracted for frames whose luma
+ *                    differs from the last extracted frame by a mean absolute
+ *                    difference above this threshold, on an 8-bit scale,
+ *                    in either the reference or the distorted picture.
+ *                    Other frames repeat the scores of the last extracted
+ *                    frame and have a `repeated_frame` score of 1.
+ *                    Temporal features are extracted for every frame.
+ *                    0 disables.
  */
 typedef struct VmafConfiguration {
     enum VmafLogLevel log_level;
@@ -86,6 +123,9 @@ typedef struct VmafConfiguration {
     unsigned n_subsample;
     uint64_t cpumask;
     uint64_t gpumask;
+    const char *thread_affinity;
+    unsigned max_frames_in_flight;
+    float subsample_threshold;
 } VmafConfiguration;
 
 typedef struct VmafContext VmafContext;
@@ -105,6 +145,52 @@ typedef struct VmafContext VmafContext;
  */
 int vmaf_init(VmafContext **vmaf, VmafConfiguration cfg);
 
+/**
+ * Allocate and open a VMAF instance which scores another distorted input
+ * against the reference of `lead`, e.g. one rendition of an encoding ladder.
+ * A lane starts out with the configuration, feature extractors and models
+ * of its lead, and shares the lead's thread pool and preallocated pictures.
+ * Features which depend on the reference only, such as motion, are extracted
+ * once by the lead and their scores are shared with every lane.
+ *
+ * Register all features and models on the lead before creating its lanes.
+ * Read the same reference picture into the lead and every lane, each with
+ * its own `vmaf_picture_ref()`. Flush the lead before its lanes, and close
+ * all lanes before the lead.
+ *
+ * @param vmaf The VMAF instance to open.
+ *             Context should be cleaned up with `vmaf_close()` when finished.
+ *
+ * @param lead VMAF instance allocated with `vmaf_init()`, before any
+ *             pictures are read into it.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_init_lane(VmafContext **vmaf, VmafContext *lead);
+
+/**
+ * Allocate and open a VMAF instance which runs its feature extractors on the
+ * thread pool of `owner`, e.g. to score one input after another without
+ * starting new worker threads for each. `n_threads` and `thread_affinity`
+ * are taken from `owner`, the rest of `cfg` applies as in `vmaf_init()`.
+ *
+ * Contexts sharing a thread pool wait for all of its jobs when they flush,
+ * so they are best used one at a time. Close them before `owner`.
+ *
+ * @param vmaf  The VMAF instance to open.
+ *              Context should be cleaned up with `vmaf_close()` when finished.
+ *
+ * @param cfg   Configuration parameters.
+ *
+ * @param owner VMAF instance allocated with `vmaf_init()` and `n_threads > 0`.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_init_shared_threads(VmafContext **vmaf, VmafConfiguration cfg,
+                             VmafContext *owner);
+
 /**
  * Register feature extractors required by a specific `VmafModel`.
  * This may be called multiple times using different models.
@@ -176,6 +262,51 @@ int vmaf_use_feature(VmafContext *vmaf, const char *feature_name,
 int vmaf_import_feature_score(VmafContext *vmaf, const char *feature_name,
                               double value, unsigned index);
 
+typedef struct VmafPictureConfiguration {
+    struct {
+        unsigned w, h;
+        unsigned bpc;
+        enum VmafPixelFormat pix_fmt;
+    } pic_params;
+    unsigned pic_cnt;
+} VmafPictureConfiguration;
+
+/**
+ * Config and preallocate a pool of host VmafPictures. Pictures fetched from
+ * the pool with `vmaf_fetch_preallocated_picture()` return their data
+ * buffers to the pool on their final `vmaf_picture_unref()`, so a steady
+ * stream of pictures is read without per-frame allocation.
+ *
+ * Call this after registering feature extractors. If none of them reads
+ * chroma, the pool holds `VMAF_PIX_FMT_YUV400P` pictures, so chroma is
+ * neither allocated nor needs to be filled in. Feature extractors that read
+ * chroma can then no longer be registered.
+ *
+ * @param vmaf VMAF context allocated with `vmaf_init()`.
+ *
+ * @param cfg  VmafPicture parameter configuration. `pic_cnt` buffers are
+ *             allocated up front; more are allocated on demand.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_preallocate_pictures(VmafContext *vmaf, VmafPictureConfiguration cfg);
+
+/**
+ * Fetch a preallocated VmafPicture. Unlike `vmaf_picture_alloc()`, the
+ * picture data is not cleared and may hold the contents of a previously
+ * released picture; every visible sample must be written by the caller.
+ *
+ * @param vmaf VMAF context allocated with `vmaf_init()` and
+ *             initialized with `vmaf_preallocate_pictures()`.
+ *
+ * @param pic  Preallocated picture.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_fetch_preallocated_picture(VmafContext *vmaf, VmafPicture *pic);
+
 /**
  * Read a pair of pictures and queue them for eventual feature extraction.
  * This should be called after feature extractors are registered via
@@ -200,6 +331,119 @@ int vmaf_import_feature_score(VmafContext *vmaf, const char *feature_name,
 int vmaf_read_pictures(VmafContext *vmaf, VmafPicture *ref, VmafPicture *dist,
                        unsigned index);
 
+/**
+ * Non-blocking variant of `vmaf_read_pictures()`. With `n_threads > 0`, the
+ * pair is queued for feature extraction and the call returns right away, or
+ * fails with -EAGAIN if `max_frames_in_flight` pairs are still being
+ * extracted. In that case ownership of `ref` and `dist` stays with the
+ * caller, who can retry after a `vmaf_wait_frame()` on an earlier index.
+ * Without a thread pool the pair is extracted before the call returns.
+ *
+ * Flush with `vmaf_read_pictures()` once all pictures are submitted.
+ *
+ * @param vmaf  The VMAF context allocated with `vmaf_init()`.
+ *
+ * @param ref   Reference picture.
+ *
+ * @param dist  Distorted picture.
+ *
+ * @param index Picture index.
+ *
+ *
+ * @return 0 on success, -EAGAIN if too many pairs are in flight,
+ *         or another negative errno code on error.
+ */
+int vmaf_submit_pictures(VmafContext *vmaf, VmafPicture *ref,
+                         VmafPicture *dist, unsigned index);
+
+/**
+ * Query whether feature extraction has finished for the picture pair at
+ * `index`, which was passed to `vmaf_read_pictures()` or
+ * `vmaf_submit_pictures()`. Once it has, the scores of that index can be
+ * retrieved, except for features which are only known after the next pair
+ * or the flush, such as `motion2`. If reading the pair or one of its feature
+ * extractors failed, the error is returned instead, and its scores may be
+ * incomplete.
+ *
+ * @param vmaf  The VMAF context allocated with `vmaf_init()`.
+ *
+ * @param index Picture index.
+ *
+ *
+ * @return 0 if extraction has finished, -EAGAIN if it is still in flight,
+ *         -EINVAL if no pair was read at `index`, or the negative errno code
+ *         extraction failed with.
+ */
+int vmaf_poll_frame(VmafContext *vmaf, unsigned index);
+
+/**
+ * Like `vmaf_poll_frame()`, but block until extraction of the picture pair at
+ * `index` has finished.
+ *
+ * @param vmaf  The VMAF context allocated with `vmaf_init()`.
+ *
+ * @param index Picture index.
+ *
+ *
+ * @return 0 on success, -EINVAL if no pair was read at `index`, or the
+ *         negative errno code extraction failed with.
+ */
+int vmaf_wait_frame(VmafContext *vmaf, unsigned index);
+
+typedef struct VmafTimings {
+    double wall; ///< monotonic seconds since the first picture was read
+    double cpu; ///< process CPU seconds over the same span, all threads
+    double read; ///< seconds the caller spent in `vmaf_read_pictures()`
+    double extract; ///< feature extraction seconds, summed over all threads
+    double flush; ///< seconds spent flushing feature extractors
+} VmafTimings;
+
+typedef struct VmafProgress {
+    unsigned frames_read; ///< picture pairs passed to `vmaf_read_pictures()`
+    unsigned frames_done; ///< picture pairs with all extraction finished
+    unsigned queue_depth; ///< extraction jobs waiting for a worker thread
+    VmafTimings timings;
+} VmafProgress;
+
+/**
+ * Query how far feature extraction has progressed, e.g. for periodic
+ * progress reports while pictures are being read. Timings stop advancing
+ * once the context is flushed, so that they describe the whole run.
+ *
+ * Wall time is measured with a monotonic clock. With `n_threads > 0`,
+ * `extract` and `cpu` may therefore exceed `wall`.
+ *
+ * @param vmaf     The VMAF context allocated with `vmaf_init()`.
+ *
+ * @param progress Progress and timings, written on success.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_get_progress(VmafContext *vmaf, VmafProgress *progress);
+
+/**
+ * Restrict scoring to the pictures with indices in [index_low, index_high].
+ * Pictures outside of this window may still be read, e.g. to warm up
+ * temporal feature extractors at the start of a segment, but their scores
+ * are discarded. This should be called before reading any pictures.
+ *
+ * Together with `vmaf_write_partial_results()` and `vmaf_merge_results()`
+ * this allows scoring a long title as independent segments, each in its own
+ * process, and merging the segments into the result of a single run.
+ *
+ * @param vmaf        The VMAF context allocated with `vmaf_init()`.
+ *
+ * @param index_low   Low picture index of the scoring window.
+ *
+ * @param index_high  High picture index of the scoring window.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_set_score_window(VmafContext *vmaf, unsigned index_low,
+                          unsigned index_high);
+
 /**
  * Predict VMAF score at specific index.
  *
@@ -366,6 +610,58 @@ int vmaf_feature_score_pooled(VmafContext *vmaf, const char *feature_name,
                               enum VmafPoolingMethod pool_method, double *score,
                               unsigned index_low, unsigned index_high);
 
+/**
+ * Like `vmaf_feature_score_pooled()`, also supporting the pooling methods
+ * which take a parameter. Percentiles are found by selection, in time linear
+ * in the number of pictures, and so are window means.
+ *
+ * @param vmaf          The VMAF context allocated with `vmaf_init()`.
+ *
+ * @param feature_name  Name of the feature to fetch.
+ *
+ * @param pool_cfg      Temporal pooling method and parameter to use.
+ *
+ * @param score         Pooled score.
+ *
+ * @param index_low     Low picture index of pooling interval.
+ *
+ * @param index_high    High picture index of pooling interval.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_feature_score_pooled_with_config(VmafContext *vmaf,
+                                          const char *feature_name,
+                                          VmafPoolingConfiguration pool_cfg,
+                                          double *score, unsigned index_low,
+                                          unsigned index_high);
+
+/**
+ * Like `vmaf_score_pooled()`, also supporting the pooling methods which take
+ * a parameter, see `vmaf_feature_score_pooled_with_config()`.
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_score_pooled_with_config(VmafContext *vmaf, VmafModel *model,
+                                  VmafPoolingConfiguration pool_cfg,
+                                  double *score, unsigned index_low,
+                                  unsigned index_high);
+
+/**
+ * Add a pooling method to the pooled metrics of `vmaf_write_output()`, for
+ * every feature, after min, max, mean and harmonic mean. Percentiles are
+ * named "p" followed by the percentile, e.g. "p5", and window minimums
+ * "min_window" followed by the window length, e.g. "min_window48".
+ *
+ * @param vmaf      The VMAF context allocated with `vmaf_init()`.
+ *
+ * @param pool_cfg  Temporal pooling method and parameter to add.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_use_pooling(VmafContext *vmaf, VmafPoolingConfiguration pool_cfg);
+
 /**
  * Close a VMAF instance and free all associated memory.
  *
@@ -392,6 +688,38 @@ int vmaf_close(VmafContext *vmaf);
 int vmaf_write_output(VmafContext *vmaf, const char *output_path,
                       enum VmafOutputFormat fmt);
 
+/**
+ * Write the partial results of a flushed context to a file, so that they can
+ * later be combined with the partial results of other segments using
+ * `vmaf_merge_results()`. Per-frame scores are written with full precision,
+ * together with the state needed to recompute aggregate metrics. Call this
+ * after pooling, so that per-frame model scores are included.
+ *
+ * @param vmaf         The VMAF context allocated with `vmaf_init()`.
+ *
+ * @param output_path  Output file path.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_write_partial_results(VmafContext *vmaf, const char *output_path);
+
+/**
+ * Merge partial results written by `vmaf_write_partial_results()` into a
+ * context which has not read any pictures. Segments may be merged in any
+ * order, but must not overlap. Once all segments are merged, the context
+ * can be written with `vmaf_write_output()` or queried with
+ * `vmaf_feature_score_pooled()`, giving the same scores as a single run.
+ *
+ * @param vmaf        The VMAF context allocated with `vmaf_init()`.
+ *
+ * @param input_path  Path to the partial results of one segment.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_merge_results(VmafContext *vmaf, const char *input_path);
+
 /**
  * Get libvmaf version.
  */
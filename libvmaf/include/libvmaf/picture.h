@@ -50,6 +50,63 @@ int vmaf_picture_alloc(VmafPicture *pic, enum VmafPixelFormat pix_fmt,
 
 int vmaf_picture_unref(VmafPicture *pic);
 
+/**
+ * Make `dst` another reference to the buffers of `src`, e.g. to read one
+ * reference picture into several contexts. Each reference is released with
+ * its own `vmaf_picture_unref()`.
+ */
+int vmaf_picture_ref(VmafPicture *dst, VmafPicture *src);
+
+/**
+ * Copy a plane of samples between strided buffers, widening the samples on
+ * the way when `dst_bpc` is greater than `src_bpc`. Samples of 8 bits are
+ * stored in bytes, deeper samples in native-endian 16-bit words, and
+ * widening is a left shift by `dst_bpc - src_bpc`. Narrowing is not
+ * supported.
+ *
+ * @param dst        Destination plane.
+ *
+ * @param dst_stride Destination stride in bytes.
+ *
+ * @param dst_bpc    Destination bits per component.
+ *
+ * @param src        Source plane.
+ *
+ * @param src_stride Source stride in bytes.
+ *
+ * @param src_bpc    Source bits per component.
+ *
+ * @param w          Plane width in samples.
+ *
+ * @param h          Plane height in samples.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_picture_copy_plane(void *dst, ptrdiff_t dst_stride, unsigned dst_bpc,
+                            const void *src, ptrdiff_t src_stride,
+                            unsigned src_bpc, unsigned w, unsigned h);
+
+/**
+ * Fill an allocated picture from three externally owned planes, as with
+ * `vmaf_picture_copy_plane()`. The visible area of each plane of `pic` is
+ * written, and planes `pic` does not carry are skipped: the chroma of a
+ * source can be dropped by filling a `VMAF_PIX_FMT_YUV400P` picture.
+ *
+ * @param pic    Destination picture.
+ *
+ * @param data   Source planes, in the layout of `pic`.
+ *
+ * @param stride Source strides in bytes.
+ *
+ * @param bpc    Source bits per component, at most `pic->bpc`.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_picture_copy_planes(VmafPicture *pic, void *const data[3],
+                             const ptrdiff_t stride[3], unsigned bpc);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,247 @@
+/**
+ *
+ *  Copyright 2016-2024 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "adaptive_subsample.h"
+#include "model.h"
+#include "picture.h"
+
+// one luma sample per 4x4 block is compared
+#define GRID_STEP 4
+
+typedef struct VmafAdaptiveSubsample {
+    float threshold;
+    struct {
+        uint16_t *ref, *dist;
+        unsigned w, h;
+        unsigned bpc;
+        bool valid;
+    } last;
+    struct {
+        struct {
+            unsigned index, source;
+        } *entry;
+        unsigned cnt, capacity;
+    } repeat;
+    unsigned source;
+} VmafAdaptiveSubsample;
+
+int vmaf_adaptive_subsample_init(VmafAdaptiveSubsample **as, float threshold)
+{
+    if (!as) return -EINVAL;
+    if (!(threshold >= 0.f)) return -EINVAL;
+
+    VmafAdaptiveSubsample *const a = *as = malloc(sizeof(*a));
+    if (!a) return -ENOMEM;
+    memset(a, 0, sizeof(*a));
+    a->threshold = threshold;
+    return 0;
+}
+
+static unsigned grid_len(unsigned len)
+{
+    return (len + GRID_STEP - 1) / GRID_STEP;
+}
+
+static void sample_grid(const VmafPicture *pic, uint16_t *grid)
+{
+    const unsigned w = grid_len(pic->w[0]);
+    const unsigned h = grid_len(pic->h[0]);
+
+    for (unsigned i = 0; i < h; i++) {
+        const uint8_t *row =
+            (const uint8_t *) pic->data[0] + i * GRID_STEP * pic->stride[0];
+        if (pic->bpc == 8) {
+            for (unsigned j = 0; j < w; j++)
+                grid[i * w + j] = row[j * GRID_STEP];
+        } else {
+            const uint16_t *row16 = (const uint16_t *) row;
+            for (unsigned j = 0; j < w; j++)
+                grid[i * w + j] = row16[j * GRID_STEP];
+        }
+    }
+}
+
+// mean absolute difference to grid, on an 8-bit scale
+static float grid_mad(const VmafPicture *pic, const uint16_t *grid)
+{
+    const unsigned w = grid_len(pic->w[0]);
+    const unsigned h = grid_len(pic->h[0]);
+
+    uint64_t sad = 0;
+    for (unsigned i = 0; i < h; i++) {
+        const uint8_t *row =
+            (const uint8_t *) pic->data[0] + i * GRID_STEP * pic->stride[0];
+        const uint16_t *g = grid + i * w;
+        if (pic->bpc == 8) {
+            for (unsigned j = 0; j < w; j++)
+                sad += abs((int) row[j * GRID_STEP] - (int) g[j]);
+        } else {
+            const uint16_t *row16 = (const uint16_t *) row;
+            for (unsigned j = 0; j < w; j++)
+                sad += abs((int) row16[j * GRID_STEP] - (int) g[j]);
+        }
+    }
+
+    return (double) sad / ((uint64_t) w * h) / (1 << (pic->bpc - 8));
+}
+
+static bool on_host(const VmafPicture *pic)
+{
+    const VmafPicturePrivate *priv = pic->priv;
+    return !priv || priv->buf_type != VMAF_PICTURE_BUFFER_TYPE_CUDA_DEVICE;
+}
+
+static int keep(VmafAdaptiveSubsample *as, VmafPicture *ref, VmafPicture *dist,
+                unsigned index)
+{
+    const unsigned w = grid_len(ref->w[0]);
+    const unsigned h = grid_len(ref->h[0]);
+
+    if (!as->last.ref || as->last.w != w || as->last.h != h) {
+        free(as->last.ref);
+        free(as->last.dist);
+        as->last.ref = malloc(sizeof(*as->last.ref) * w * h);
+        as->last.dist = malloc(sizeof(*as->last.dist) * w * h);
+        if (!as->last.ref || !as->last.dist) {
+            free(as->last.ref);
+            free(as->last.dist);
+            as->last.ref = as->last.dist = NULL;
+            as->last.valid = false;
+            return -ENOMEM;
+        }
+        as->last.w = w;
+        as->last.h = h;
+    }
+
+    sample_grid(ref, as->last.ref);
+    sample_grid(dist, as->last.dist);
+    as->last.bpc = ref->bpc;
+    as->last.valid = true;
+    as->source = index;
+    return 0;
+}
+
+static int append_repeat(VmafAdaptiveSubsample *as, unsigned index)
+{
+    if (as->repeat.cnt == as->repeat.capacity) {
+        const unsigned capacity =
+            as->repeat.capacity ? as->repeat.capacity * 2 : 256;
+        void *entry =
+            realloc(as->repeat.entry, sizeof(*as->repeat.entry) * capacity);
+        if (!entry) return -ENOMEM;
+        as->repeat.entry = entry;
+        as->repeat.capacity = capacity;
+    }
+
+    as->repeat.entry[as->repeat.cnt].index = index;
+    as->repeat.entry[as->repeat.cnt].source = as->source;
+    as->repeat.cnt++;
+    return 0;
+}
+
+int vmaf_adaptive_subsample_check(VmafAdaptiveSubsample *as, VmafPicture *ref,
+                                  VmafPicture *dist, unsigned index,
+                                  bool *repeat)
+{
+    if (!as) return -EINVAL;
+    if (!ref) return -EINVAL;
+    if (!dist) return -EINVAL;
+    if (!repeat) return -EINVAL;
+
+    *repeat = false;
+    // device pictures are not compared, every pair is extracted
+    if (!on_host(ref) || !on_host(dist)) return 0;
+
+    if (as->last.valid && as->last.bpc == ref->bpc &&
+        as->last.w == grid_len(ref->w[0]) && as->last.h == grid_len(ref->h[0]))
+    {
+        // compared to the last extracted pair, so that slow changes add up
+        const float mad_ref = grid_mad(ref, as->last.ref);
+        const float mad_dist = grid_mad(dist, as->last.dist);
+        if (mad_ref <= as->threshold && mad_dist <= as->threshold) {
+            const int err = append_repeat(as, index);
+            if (err) return err;
+            *repeat = true;
+            return 0;
+        }
+    }
+
+    return keep(as, ref, dist, index);
+}
+
+void vmaf_adaptive_subsample_reset(VmafAdaptiveSubsample *as)
+{
+    if (!as) return;
+    as->last.valid = false;
+}
+
+static bool is_model_score(VmafFeatureCollector *fc, const char *name)
+{
+    for (VmafPredictModel *m = fc->models; m; m = m->next) {
+        if (!strcmp(m->model->name, name)) return true;
+    }
+    return false;
+}
+
+int vmaf_adaptive_subsample_fill(VmafAdaptiveSubsample *as,
+                                 VmafFeatureCollector *fc)
+{
+    if (!as) return -EINVAL;
+    if (!fc) return -EINVAL;
+
+    int err = 0;
+    // appending may grow fc->feature_vector, it is indexed anew every time
+    for (unsigned i = 0; i < fc->cnt; i++) {
+        const char *name = fc->feature_vector[i]->name;
+        if (!strcmp(name, VMAF_REPEATED_FRAME_FEATURE)) continue;
+        if (is_model_score(fc, name)) continue;
+
+        for (unsigned j = 0; j < as->repeat.cnt; j++) {
+            double score;
+            if (!vmaf_feature_collector_get_score(fc, name, &score,
+                                                  as->repeat.entry[j].index))
+            {
+                continue;
+            }
+            if (vmaf_feature_collector_get_score(fc, name, &score,
+                                                 as->repeat.entry[j].source))
+            {
+                continue;
+            }
+            err = vmaf_feature_collector_append(fc, name, score,
+                                                as->repeat.entry[j].index);
+            if (err) return err;
+        }
+    }
+
+    return err;
+}
+
+void vmaf_adaptive_subsample_destroy(VmafAdaptiveSubsample *as)
+{
+    if (!as) return;
+    free(as->last.ref);
+    free(as->last.dist);
+    free(as->repeat.entry);
+    free(as);
+}
@@ -0,0 +1,57 @@
+/**
+ *
+ *  Copyright 2016-2024 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef __VMAF_ADAPTIVE_SUBSAMPLE_H__
+#define __VMAF_ADAPTIVE_SUBSAMPLE_H__
+
+#include <stdbool.h>
+
+#include "feature/feature_collector.h"
+#include "libvmaf/picture.h"
+
+// Per-frame flag, 1 for frames which repeat the scores of an earlier frame.
+#define VMAF_REPEATED_FRAME_FEATURE "repeated_frame"
+
+typedef struct VmafAdaptiveSubsample VmafAdaptiveSubsample;
+
+int vmaf_adaptive_subsample_init(VmafAdaptiveSubsample **as, float threshold);
+
+/*
+ * Compares the luma of ref and dist to the last pair which was not repeated,
+ * on a sparse grid. If both differ by a mean absolute difference of at most
+ * threshold, on an 8-bit scale, *repeat is set and index is recorded as a
+ * repeat of that pair. Otherwise ref and dist become the pair to compare to.
+ */
+int vmaf_adaptive_subsample_check(VmafAdaptiveSubsample *as, VmafPicture *ref,
+                                  VmafPicture *dist, unsigned index,
+                                  bool *repeat);
+
+// Forgets the last pair, so that the next one is never repeated.
+void vmaf_adaptive_subsample_reset(VmafAdaptiveSubsample *as);
+
+/*
+ * Copies the scores of every repeated pair from the pair it repeats, for
+ * features which were not extracted for it. Model scores are left to be
+ * predicted from the copied features.
+ */
+int vmaf_adaptive_subsample_fill(VmafAdaptiveSubsample *as,
+                                 VmafFeatureCollector *fc);
+
+void vmaf_adaptive_subsample_destroy(VmafAdaptiveSubsample *as);
+
+#endif /* __VMAF_ADAPTIVE_SUBSAMPLE_H__ */
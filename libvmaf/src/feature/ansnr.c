@@ -27,6 +27,7 @@
 #include "mem.h"
 #include "psnr_tools.h"
 #include "ansnr_options.h"
+#include "ansnr.h"
 #include "ansnr_tools.h"
 #include "offset.h"
 
@@ -42,6 +43,15 @@
 #define ansnr_mse          ansnr_mse_s
 #define offset_image       offset_image_s
 
+void ansnr_score(float sig, float noise, int w, int h, double peak,
+        double psnr_max, double *score, double *score_psnr)
+{
+    *score = noise==0 ? psnr_max : 10.0 * log10(sig / noise);
+
+    double eps = 1e-10;
+    *score_psnr = MIN(10 * log10(peak * peak * w * h / MAX(noise, eps)), psnr_max);
+}
+
 int compute_ansnr(const float *ref, const float *dis, int w, int h, int ref_stride, int dis_stride, double *score, double *score_psnr, double peak, double psnr_max)
 {
     float *data_buf = 0;
@@ -102,12 +112,11 @@ int compute_ansnr(const float *ref, const float *dis, int w, int h, int ref_stri
 # endif
     ansnr_mse(ref_filtr, filtd, 0, &noise_min, w, h, buf_stride, buf_stride);
     *score = 10.0 * log10(noise / (noise - noise_min));
-#else
-    *score = noise==0 ? psnr_max : 10.0 * log10(sig / noise);
-#endif
-
     double eps = 1e-10;
     *score_psnr = MIN(10 * log10(peak * peak * w * h / MAX(noise, eps)), psnr_max);
+#else
+    ansnr_score(sig, noise, w, h, peak, psnr_max, score, score_psnr);
+#endif
 
     ret = 0;
 fail:
@@ -19,3 +19,7 @@
 int compute_ansnr(const float *ref, const float *dis, int w, int h,
         int ref_stride, int dis_stride,
         double *score, double *score_psnr, double peak, double psnr_max);
+
+/* the scores of compute_ansnr() from the sums of ansnr_mse_s() */
+void ansnr_score(float sig, float noise, int w, int h, double peak,
+        double psnr_max, double *score, double *score_psnr);
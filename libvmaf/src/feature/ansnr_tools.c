@@ -188,3 +188,41 @@ void ansnr_filter2d_s(const float *f, const float *src, float *dst, int w, int h
     }
 }
 
+void ansnr_filter2d_row_s(const float *f, int fwidth, const float *const *src_row, float *dst, int w)
+{
+    int j, fi, fj;
+
+    for (j = 0; j < w; ++j) {
+        float accum = 0;
+
+        for (fi = 0; fi < fwidth; ++fi) {
+            const float *src = src_row[fi] + j - fwidth / 2;
+            float accum_inner = 0;
+
+            for (fj = 0; fj < fwidth; ++fj) {
+                accum_inner += f[fi * fwidth + fj] * src[fj];
+            }
+
+            accum += accum_inner;
+        }
+
+        dst[j] = accum;
+    }
+}
+
+void ansnr_mse_row_s(const float *ref, const float *dis, int w, float *sig, float *noise)
+{
+    float sig_accum_inner = 0;
+    float noise_accum_inner = 0;
+
+    for (int j = 0; j < w; ++j) {
+        const float ref_val = ref[j];
+        const float dis_val = dis[j];
+
+        sig_accum_inner   += ref_val * ref_val;
+        noise_accum_inner += (ref_val - dis_val) * (ref_val - dis_val);
+    }
+
+    *sig = sig_accum_inner;
+    *noise = noise_accum_inner;
+}
@@ -41,4 +41,14 @@ void ansnr_filter1d_s(const float *f, const float *src, float *dst, int w, int h
 
 void ansnr_filter2d_s(const float *f, const float *src, float *dst, int w, int h, int src_stride, int dst_stride, int fwidth);
 
+/*
+ * One row of ansnr_filter2d_s(). src_row[k] points at input row
+ * i - fwidth / 2 + k, mirrored at the picture borders, and every input row
+ * is padded with fwidth / 2 mirrored samples on both ends.
+ */
+void ansnr_filter2d_row_s(const float *f, int fwidth, const float *const *src_row, float *dst, int w);
+
+/* ansnr_mse_s() of a single row */
+void ansnr_mse_row_s(const float *ref, const float *dis, int w, float *sig, float *noise);
+
 #endif /* ANSNR_TOOLS_H_ */
@@ -8,25 +8,6 @@
 #define MIN(x, y) (((x) < (y)) ? (x) : (y))
 #define MAX(x, y) (((x) > (y)) ? (x) : (y))
 
-static FORCE_INLINE void
-pad_top_and_bottom(VifBuffer buf, unsigned h, int fwidth)
-{
-    const unsigned fwidth_half = fwidth / 2;
-    unsigned char *ref = buf.ref;
-    unsigned char *dis = buf.dis;
-    for (unsigned i = 1; i <= fwidth_half; ++i) {
-        size_t offset = buf.stride * i;
-        memcpy(ref - offset, ref + offset, buf.stride);
-        memcpy(dis - offset, dis + offset, buf.stride);
-        memcpy(ref + buf.stride * (h - 1) + buf.stride * i,
-               ref + buf.stride * (h - 1) - buf.stride * i,
-               buf.stride);
-        memcpy(dis + buf.stride * (h - 1) + buf.stride * i,
-               dis + buf.stride * (h - 1) - buf.stride * i,
-               buf.stride);
-    }
-}
-
 static FORCE_INLINE void
 decimate_and_pad(VifBuffer buf, unsigned w, unsigned h, int scale)
 {
@@ -41,7 +22,10 @@ decimate_and_pad(VifBuffer buf, unsigned w, unsigned h, int scale)
             dis[i * stride + j] = buf.mu2[(i * 2) * mu_stride + (j * 2)];
         }
     }
-    pad_top_and_bottom(buf, h / 2, vif_filter1d_width[scale]);
+    vif_mirror_rows(buf.ref_row, buf.ref, buf.stride, h / 2,
+                    vif_filter1d_width[scale]);
+    vif_mirror_rows(buf.dis_row, buf.dis, buf.stride, h / 2,
+                    vif_filter1d_width[scale]);
 }
 
 
@@ -245,8 +229,6 @@ void vif_subsample_rd_8_neon(VifBuffer buf, unsigned int w, unsigned int h)
     const unsigned int uiw15 = (w > 15 ? w - 15 : 0);
     const unsigned int fwidth = vif_filter1d_width[1];
     const uint16_t *vif_filt_s1 = vif_filter1d_table[1];
-    const uint8_t *ref = (uint8_t *)buf.ref;
-    const uint8_t *dis = (uint8_t *)buf.dis;
     const ptrdiff_t dst_stride = buf.stride_16 / sizeof(uint16_t);
     ptrdiff_t i_dst_stride = 0;
 
@@ -259,13 +241,13 @@ void vif_subsample_rd_8_neon(VifBuffer buf, unsigned int w, unsigned int h)
     {
 
         int ii = i - fwidth / 2;
-        const uint8_t *p_ref = ref + ii * buf.stride;
-        const uint8_t *p_dis = dis + ii * buf.stride;
 
         // VERTICAL Neon
         unsigned int j = 0;
-        for (; j < uiw15; j += 16, p_ref += 16, p_dis += 16)
+        for (; j < uiw15; j += 16)
         {
+            const uint8_t *p_ref = (const uint8_t *)buf.ref_row[ii] + j;
+            const uint8_t *p_dis = (const uint8_t *)buf.dis_row[ii] + j;
             uint8x8_t ref_vec_8u_0 = vld1_u8(p_ref);
             uint16x8_t ref_vec_16u_0 = vmovl_u8(ref_vec_8u_0);
             uint8x8_t dis_vec_8u_0 = vld1_u8(p_dis);
@@ -278,10 +260,10 @@ void vif_subsample_rd_8_neon(VifBuffer buf, unsigned int w, unsigned int h)
             NEON_FILTER_INSTANCE_U32X4_INIT_MULL_U16X4_WITH_CONST_LO_HI_LU2(accum_f_ref, offset_vec_v, ref_vec_16u, vif_filt_s1[0]);
             NEON_FILTER_INSTANCE_U32X4_INIT_MULL_U16X4_WITH_CONST_LO_HI_LU2(accum_f_dis, offset_vec_v, dis_vec_16u, vif_filt_s1[0]);
 
-            const uint8_t *pp_ref = p_ref + buf.stride;
-            const uint8_t *pp_dis = p_dis + buf.stride;
-            for (unsigned fi = 1; fi < fwidth; ++fi, pp_ref += buf.stride, pp_dis += buf.stride)
+            for (unsigned fi = 1; fi < fwidth; ++fi)
             {
+                const uint8_t *pp_ref = (const uint8_t *)buf.ref_row[ii + (int)fi] + j;
+                const uint8_t *pp_dis = (const uint8_t *)buf.dis_row[ii + (int)fi] + j;
                 uint8x8_t ref_vec_8u_0 = vld1_u8(pp_ref);
                 uint16x8_t ref_vec_16u_0 = vmovl_u8(ref_vec_8u_0);
                 uint8x8_t ref_vec_8u_1 = vld1_u8(pp_ref + 8);
@@ -310,10 +292,10 @@ void vif_subsample_rd_8_neon(VifBuffer buf, unsigned int w, unsigned int h)
                 int ii = i - fwidth / 2;
                 int ii_check = ii + fi;
                 const uint16_t fcoeff = vif_filt_s1[fi];
-                const uint8_t *ref = (uint8_t *)buf.ref;
-                const uint8_t *dis = (uint8_t *)buf.dis;
-                accum_ref += fcoeff * (uint32_t)ref[ii_check * buf.stride + j];
-                accum_dis += fcoeff * (uint32_t)dis[ii_check * buf.stride + j];
+                const uint8_t *ref = buf.ref_row[ii_check];
+                const uint8_t *dis = buf.dis_row[ii_check];
+                accum_ref += fcoeff * (uint32_t)ref[j];
+                accum_dis += fcoeff * (uint32_t)dis[j];
             }
             buf.tmp.ref_convol[j] = accum_ref >> 8;
             buf.tmp.dis_convol[j] = accum_dis >> 8;
@@ -393,10 +375,6 @@ void vif_subsample_rd_16_neon(VifBuffer buf, unsigned int w, unsigned int h, int
     const uint32x4_t offset_vec_h = vdupq_n_u32(32768);
     int32x4_t shift_vec_h = vdupq_n_s32(-16);
 
-    const uint16_t *ref = (uint16_t *)buf.ref;
-    const uint16_t *dis = (uint16_t *)buf.dis;
-
-    const ptrdiff_t stride_v = buf.stride / sizeof(uint16_t);
     const ptrdiff_t stride_h = buf.stride_16 / sizeof(uint16_t);
     ptrdiff_t i_dst_stride = 0;
 
@@ -404,13 +382,13 @@ void vif_subsample_rd_16_neon(VifBuffer buf, unsigned int w, unsigned int h, int
     {
 
         int ii = i - fwidth / 2;
-        const uint16_t *p_ref = ref + ii * stride_v;
-        const uint16_t *p_dis = dis + ii * stride_v;
 
         // VERTICAL Neon
         unsigned int j = 0;
-        for (; j < uiw15; j += 16, p_ref += 16, p_dis += 16)
+        for (; j < uiw15; j += 16)
         {
+            const uint16_t *p_ref = (const uint16_t *)buf.ref_row[ii] + j;
+            const uint16_t *p_dis = (const uint16_t *)buf.dis_row[ii] + j;
             uint16x8_t ref_vec_16u_l = vld1q_u16(p_ref);
             uint16x8_t ref_vec_16u_h = vld1q_u16(p_ref + 8);
             uint16x8_t dis_vec_16u_l = vld1q_u16(p_dis);
@@ -419,10 +397,10 @@ void vif_subsample_rd_16_neon(VifBuffer buf, unsigned int w, unsigned int h, int
             NEON_FILTER_INSTANCE_U32X4_INIT_MULL_U16X4_WITH_CONST_LO_HI_LH(accum_f_ref, add_shift_round_VP_vec, ref_vec_16u, vif_filt_s[0]);
             NEON_FILTER_INSTANCE_U32X4_INIT_MULL_U16X4_WITH_CONST_LO_HI_LH(accum_f_dis, add_shift_round_VP_vec, dis_vec_16u, vif_filt_s[0]);
 
-            const uint16_t *pp_ref = p_ref + stride_v;
-            const uint16_t *pp_dis = p_dis + stride_v;
-            for (unsigned fi = 1; fi < fwidth; ++fi, pp_ref += stride_v, pp_dis += stride_v)
+            for (unsigned fi = 1; fi < fwidth; ++fi)
             {
+                const uint16_t *pp_ref = (const uint16_t *)buf.ref_row[ii + (int)fi] + j;
+                const uint16_t *pp_dis = (const uint16_t *)buf.dis_row[ii + (int)fi] + j;
                 ref_vec_16u_l = vld1q_u16(pp_ref);
                 ref_vec_16u_h = vld1q_u16(pp_ref + 8);
                 dis_vec_16u_l = vld1q_u16(pp_dis);
@@ -446,10 +424,10 @@ void vif_subsample_rd_16_neon(VifBuffer buf, unsigned int w, unsigned int h, int
                 int ii = i - fwidth / 2;
                 int ii_check = ii + fi;
                 const uint16_t fcoeff = vif_filt_s[fi];
-                uint16_t *ref = (uint16_t *)buf.ref;
-                uint16_t *dis = (uint16_t *)buf.dis;
-                accum_ref += fcoeff * ((uint32_t)ref[ii_check * stride_v + j]);
-                accum_dis += fcoeff * ((uint32_t)dis[ii_check * stride_v + j]);
+                const uint16_t *ref = buf.ref_row[ii_check];
+                const uint16_t *dis = buf.dis_row[ii_check];
+                accum_ref += fcoeff * ((uint32_t)ref[j]);
+                accum_dis += fcoeff * ((uint32_t)dis[j]);
             }
             buf.tmp.ref_convol[j] = (uint16_t)((accum_ref + add_shift_round_VP) >> shift_VP);
             buf.tmp.dis_convol[j] = (uint16_t)((accum_dis + add_shift_round_VP) >> shift_VP);
@@ -512,7 +490,7 @@ void vif_statistic_8_neon(struct VifPublicState *s, float *num, float *den, unsi
     const unsigned int fwidth = vif_filter1d_width[0];
     const uint16_t *vif_filt_s0 = vif_filter1d_table[0];
     VifBuffer buf = s->buf;
-    uint16_t *log2_table = s->log2_table;
+    const uint16_t *log2_table = s->log2_table;
     double vif_enhn_gain_limit = s->vif_enhn_gain_limit;
 
     int64_t accum_num_log = 0.0;
@@ -521,8 +499,6 @@ void vif_statistic_8_neon(struct VifPublicState *s, float *num, float *den, unsi
     int64_t accum_den_non_log = 0;
     static const int32_t sigma_nsq = 65536 << 1;
 
-    const uint8_t *ref = (uint8_t *)buf.ref;
-    const uint8_t *dis = (uint8_t *)buf.dis;
     const ptrdiff_t dst_stride = buf.stride_32 / sizeof(uint32_t);
     ptrdiff_t i_dst_stride = 0;
 
@@ -537,13 +513,13 @@ void vif_statistic_8_neon(struct VifPublicState *s, float *num, float *den, unsi
     for (unsigned i = 0; i < h; ++i, i_dst_stride += dst_stride)
     {
         int ii = i - fwidth / 2;
-        const uint8_t *p_ref = ref + ii * buf.stride;
-        const uint8_t *p_dis = dis + ii * buf.stride;
 
         // VERTICAL Neon
         unsigned int j = 0;
-        for (; j < uiw15; j += 16, p_ref += 16, p_dis += 16)
+        for (; j < uiw15; j += 16)
         {
+            const uint8_t *p_ref = (const uint8_t *)buf.ref_row[ii] + j;
+            const uint8_t *p_dis = (const uint8_t *)buf.dis_row[ii] + j;
             NEON_FILTER_LOAD_U8X8_MOVE_TO_U16X8_AND_SQR_LU2(ref_vec_8u, ref_vec_16u, ref_ref_vec_16u, p_ref);
             NEON_FILTER_LOAD_U8X8_MOVE_TO_U16X8_AND_SQR_LU2(dis_vec_8u, dis_vec_16u, dis_dis_vec_16u, p_dis);
 
@@ -558,10 +534,10 @@ void vif_statistic_8_neon(struct VifPublicState *s, float *num, float *den, unsi
             uint32x4_t accum_f_ref_dis_1_l = vmulq_u32(accum_f_dis_1_l, vmovl_u16(vget_low_u16(ref_vec_16u_1)));
             uint32x4_t accum_f_ref_dis_1_h = vmulq_u32(accum_f_dis_1_h, vmovl_high_u16(ref_vec_16u_1));
 
-            const uint8_t *pp_ref = p_ref + buf.stride;
-            const uint8_t *pp_dis = p_dis + buf.stride;
-            for (unsigned int fi = 1; fi < fwidth; ++fi, pp_ref += buf.stride, pp_dis += buf.stride)
+            for (unsigned int fi = 1; fi < fwidth; ++fi)
             {
+                const uint8_t *pp_ref = (const uint8_t *)buf.ref_row[ii + (int)fi] + j;
+                const uint8_t *pp_dis = (const uint8_t *)buf.dis_row[ii + (int)fi] + j;
                 NEON_FILTER_LOAD_U8X8_MOVE_TO_U16X8_AND_SQR_LU2(ref_vec_8u, ref_vec_16u, ref_ref_vec_16u, pp_ref);
                 NEON_FILTER_LOAD_U8X8_MOVE_TO_U16X8_AND_SQR_LU2(dis_vec_8u, dis_vec_16u, dis_dis_vec_16u, pp_dis);
 
@@ -609,10 +585,10 @@ void vif_statistic_8_neon(struct VifPublicState *s, float *num, float *den, unsi
                 int ii = i - fwidth / 2;
                 int ii_check = ii + fi;
                 const uint16_t fcoeff = vif_filt_s0[fi];
-                const uint8_t *ref = (uint8_t *)buf.ref;
-                const uint8_t *dis = (uint8_t *)buf.dis;
-                uint16_t imgcoeff_ref = ref[ii_check * buf.stride + j];
-                uint16_t imgcoeff_dis = dis[ii_check * buf.stride + j];
+                const uint8_t *ref = buf.ref_row[ii_check];
+                const uint8_t *dis = buf.dis_row[ii_check];
+                uint16_t imgcoeff_ref = ref[j];
+                uint16_t imgcoeff_dis = dis[j];
                 uint32_t img_coeff_ref = fcoeff * (uint32_t)imgcoeff_ref;
                 uint32_t img_coeff_dis = fcoeff * (uint32_t)imgcoeff_dis;
                 accum_mu1 += img_coeff_ref;
@@ -777,7 +753,7 @@ void vif_statistic_16_neon(struct VifPublicState *s, float *num, float *den, uns
     const unsigned int fwidth = vif_filter1d_width[scale];
     const uint16_t *vif_filt_s = vif_filter1d_table[scale];
     VifBuffer buf = s->buf;
-    uint16_t *log2_table = s->log2_table;
+    const uint16_t *log2_table = s->log2_table;
     double vif_enhn_gain_limit = s->vif_enhn_gain_limit;
 
     int32_t add_shift_round_HP, shift_HP;
@@ -810,10 +786,6 @@ void vif_statistic_16_neon(struct VifPublicState *s, float *num, float *den, uns
     const uint64x2_t add_shift_round_HP_vec = vdupq_n_u64(add_shift_round_HP);
     const int64x2_t shift_vec_HP = vdupq_n_s64(-shift_HP);
 
-    const uint16_t *ref = (uint16_t *)buf.ref;
-    const uint16_t *dis = (uint16_t *)buf.dis;
-
-    const ptrdiff_t stride_16 = buf.stride / sizeof(uint16_t);
     const ptrdiff_t stride_32 = buf.stride_32 / sizeof(uint32_t);
     ptrdiff_t i_dst_stride = 0;
     int32_t xx[8], yy[8], xy[8];
@@ -826,13 +798,13 @@ void vif_statistic_16_neon(struct VifPublicState *s, float *num, float *den, uns
     for (unsigned i = 0; i < h; ++i, i_dst_stride += stride_32)
     {
         int ii = i - fwidth / 2;
-        const uint16_t *p_ref = ref + ii * stride_16;
-        const uint16_t *p_dis = dis + ii * stride_16;
 
         // VERTICAL 
         unsigned int j = 0;
-        for (; j < uiw7; j += 8, p_ref += 8, p_dis += 8)
+        for (; j < uiw7; j += 8)
         {
+            const uint16_t *p_ref = (const uint16_t *)buf.ref_row[ii] + j;
+            const uint16_t *p_dis = (const uint16_t *)buf.dis_row[ii] + j;
             NEON_FILTER_LOAD_U16X8_AND_MOVE_TO_U32X4_AND_SQR(ref_vec_16u, ref_vec_32u, ref_ref_vec, p_ref);
             NEON_FILTER_LOAD_U16X8_AND_MOVE_TO_U32X4_AND_SQR(dis_vec_16u, dis_vec_32u, dis_dis_vec, p_dis);
 
@@ -844,10 +816,10 @@ void vif_statistic_16_neon(struct VifPublicState *s, float *num, float *den, uns
             NEON_FILTER_INSTANCE_U64X2_INIT_MULL_U32X2_LO_HI(accum_f_ref_dis_l, add_shift_round_VP_sq_vec, accum_f_dis_l, ref_vec_32u_l);
             NEON_FILTER_INSTANCE_U64X2_INIT_MULL_U32X2_LO_HI(accum_f_ref_dis_h, add_shift_round_VP_sq_vec, accum_f_dis_h, ref_vec_32u_h);
 
-            const uint16_t *pp_ref = p_ref + stride_16;
-            const uint16_t *pp_dis = p_dis + stride_16;
-            for (unsigned fi = 1; fi < fwidth; ++fi, pp_ref += stride_16, pp_dis += stride_16)
+            for (unsigned fi = 1; fi < fwidth; ++fi)
             {
+                const uint16_t *pp_ref = (const uint16_t *)buf.ref_row[ii + (int)fi] + j;
+                const uint16_t *pp_dis = (const uint16_t *)buf.dis_row[ii + (int)fi] + j;
                 NEON_FILTER_LOAD_U16X8_AND_MOVE_TO_U32X4_AND_SQR(ref_vec_16u, ref_vec_32u, ref_ref_vec, pp_ref);
                 NEON_FILTER_LOAD_U16X8_AND_MOVE_TO_U32X4_AND_SQR(dis_vec_16u, dis_vec_32u, dis_dis_vec, pp_dis);
 
@@ -892,11 +864,10 @@ void vif_statistic_16_neon(struct VifPublicState *s, float *num, float *den, uns
                 int ii = i - fwidth / 2;
                 int ii_check = ii + fi;
                 const uint16_t fcoeff = vif_filt_s[fi];
-                const ptrdiff_t stride = buf.stride / sizeof(uint16_t);
-                uint16_t *ref = (uint16_t *)buf.ref;
-                uint16_t *dis = (uint16_t *)buf.dis;
-                uint16_t imgcoeff_ref = ref[ii_check * stride + j];
-                uint16_t imgcoeff_dis = dis[ii_check * stride + j];
+                const uint16_t *ref = buf.ref_row[ii_check];
+                const uint16_t *dis = buf.dis_row[ii_check];
+                uint16_t imgcoeff_ref = ref[j];
+                uint16_t imgcoeff_dis = dis[j];
                 uint32_t img_coeff_ref = fcoeff * (uint32_t)imgcoeff_ref;
                 uint32_t img_coeff_dis = fcoeff * (uint32_t)imgcoeff_dis;
                 accum_mu1 += img_coeff_ref;
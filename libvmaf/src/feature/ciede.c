@@ -394,4 +394,5 @@ VmafFeatureExtractor vmaf_fex_ciede = {
     .close = close,
     .priv_size = sizeof(CiedeState),
     .provided_features = provided_features,
+    .flags = VMAF_FEATURE_EXTRACTOR_CHROMA,
 };
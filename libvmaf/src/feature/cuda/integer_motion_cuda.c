@@ -41,6 +41,7 @@ typedef struct MotionStateCuda {
     uint64_t* sad_host;
     void* write_score_parameters;
     unsigned index;
+    unsigned pic_cnt;
     double score;
     bool debug;
     bool motion_force_zero;
@@ -76,6 +77,7 @@ typedef struct write_score_parameters_moco {
     MotionStateCuda *s;
     unsigned h, w;
     unsigned index;
+    unsigned pic_cnt;
 } write_score_parameters_moco;
 
 static int extract_force_zero(VmafFeatureExtractor *fex,
@@ -210,7 +212,7 @@ static int flush_fex_cuda(VmafFeatureExtractor *fex,
     CHECK_CUDA(cuStreamSynchronize(s->str));
     CHECK_CUDA(cuStreamSynchronize(s->host_stream));
 
-    if (s->index > 0) {
+    if (s->pic_cnt > 1) {
         ret = vmaf_feature_collector_append(feature_collector,
                 "VMAF_integer_feature_motion2_score",
                 s->score, s->index);
@@ -242,7 +244,7 @@ static int write_scores(write_score_parameters_moco* params)
     }
     if (err) return err;
 
-    if (params->index == 1)
+    if (params->pic_cnt == 2)
         return 0;
 
     err = vmaf_feature_collector_append(feature_collector,
@@ -291,7 +293,9 @@ static int extract_fex_cuda(VmafFeatureExtractor *fex, VmafPicture *ref_pic,
     CHECK_CUDA(cuEventCreate(&s->event, CU_EVENT_DEFAULT));
     CHECK_CUDA(cuCtxPopCurrent(NULL));
 
-    if (index == 0) {
+    // the first picture seen is not necessarily index 0,
+    // e.g. when warming up at the start of a segment
+    if (s->pic_cnt++ == 0) {
         err = vmaf_feature_collector_append(feature_collector,
                 "VMAF_integer_feature_motion2_score",
                 0., index);
@@ -315,6 +319,7 @@ static int extract_fex_cuda(VmafFeatureExtractor *fex, VmafPicture *ref_pic,
     params->h = ref_pic->h[0];
     params->w = ref_pic->w[0];
     params->index = index;
+    params->pic_cnt = s->pic_cnt;
     CHECK_CUDA(cuLaunchHostFunc(s->host_stream, (CUhostFn)write_scores, s->write_score_parameters));
     return 0;
 }
@@ -359,5 +364,6 @@ VmafFeatureExtractor vmaf_fex_integer_motion_cuda = {
     .options = options,
     .priv_size = sizeof(MotionStateCuda),
     .provided_features = provided_features,
-    .flags = VMAF_FEATURE_EXTRACTOR_TEMPORAL | VMAF_FEATURE_EXTRACTOR_CUDA,
+    .flags = VMAF_FEATURE_EXTRACTOR_TEMPORAL | VMAF_FEATURE_EXTRACTOR_CUDA |
+             VMAF_FEATURE_EXTRACTOR_REFERENCE_ONLY,
 };
@@ -30,6 +30,7 @@
 #include "libvmaf/libvmaf.h"
 #include "log.h"
 #include "predict.h"
+#include "timer.h"
 
 static int aggregate_vector_init(AggregateVector *aggregate_vector)
 {
@@ -95,6 +96,124 @@ static void aggregate_vector_destroy(AggregateVector *aggregate_vector)
     free(aggregate_vector->metric);
 }
 
+static int partial_vector_init(PartialVector *partial_vector)
+{
+    if (!partial_vector) return -EINVAL;
+    memset(partial_vector, 0, sizeof(*partial_vector));
+    const unsigned initial_capacity = 8;
+    const size_t metric_vector_sz =
+        sizeof(partial_vector->metric[0]) * initial_capacity;
+    partial_vector->metric = malloc(metric_vector_sz);
+    if (!partial_vector->metric) return -ENOMEM;
+    memset(partial_vector->metric, 0, metric_vector_sz);
+    partial_vector->capacity = initial_capacity;
+
+    return 0;
+}
+
+static int partial_vector_accumulate(PartialVector *partial_vector,
+                                     const char *name, uint64_t value,
+                                     enum VmafPartialMerge merge)
+{
+    if (!partial_vector) return -EINVAL;
+
+    for (unsigned i = 0; i < partial_vector->cnt; i++) {
+        if (strcmp(name, partial_vector->metric[i].name))
+            continue;
+        if (partial_vector->metric[i].merge != merge)
+            return -EINVAL;
+
+        switch (merge) {
+        case VMAF_PARTIAL_MERGE_SUM:
+            partial_vector->metric[i].value += value;
+            return 0;
+        case VMAF_PARTIAL_MERGE_EQUAL:
+            return partial_vector->metric[i].value == value ? 0 : -EINVAL;
+        default:
+            return -EINVAL;
+        }
+    }
+
+    const unsigned cnt = partial_vector->cnt;
+    if (cnt >= partial_vector->capacity) {
+        size_t initial_size =
+            sizeof(partial_vector->metric[0]) * partial_vector->capacity;
+        void *metric = realloc(partial_vector->metric, initial_size * 2);
+        if (!metric) return -ENOMEM;
+        memset((char*)metric + initial_size, 0, initial_size);
+        partial_vector->metric = metric;
+        partial_vector->capacity *= 2;
+    }
+
+    char *n = malloc(strlen(name) + 1);
+    if (!n) return -ENOMEM;
+    strcpy(n, name);
+
+    partial_vector->metric[cnt].name = n;
+    partial_vector->metric[cnt].value = value;
+    partial_vector->metric[cnt].merge = merge;
+    partial_vector->cnt++;
+
+    return 0;
+}
+
+static void partial_vector_destroy(PartialVector *partial_vector)
+{
+    if (!partial_vector) return;
+    for (unsigned i = 0; i < partial_vector->cnt; i++)
+        free(partial_vector->metric[i].name);
+    free(partial_vector->metric);
+}
+
+int vmaf_feature_collector_accumulate_partial(VmafFeatureCollector *feature_collector,
+                                              const char *name, uint64_t value,
+                                              enum VmafPartialMerge merge)
+{
+    if (!feature_collector) return -EINVAL;
+    if (!name) return -EINVAL;
+
+    pthread_mutex_lock(&(feature_collector->lock));
+    int err = partial_vector_accumulate(&feature_collector->partial_vector,
+                                        name, value, merge);
+    pthread_mutex_unlock(&(feature_collector->lock));
+    return err;
+}
+
+int vmaf_feature_collector_get_partial(VmafFeatureCollector *feature_collector,
+                                       const char *name, uint64_t *value)
+{
+    if (!feature_collector) return -EINVAL;
+    if (!name) return -EINVAL;
+    if (!value) return -EINVAL;
+
+    pthread_mutex_lock(&(feature_collector->lock));
+    int err = -EINVAL;
+    PartialVector *pv = &feature_collector->partial_vector;
+    for (unsigned i = 0; i < pv->cnt; i++) {
+        if (!strcmp(pv->metric[i].name, name)) {
+            *value = pv->metric[i].value;
+            err = 0;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&(feature_collector->lock));
+    return err;
+}
+
+void vmaf_feature_collector_clear_aggregates(VmafFeatureCollector *feature_collector)
+{
+    if (!feature_collector) return;
+
+    pthread_mutex_lock(&(feature_collector->lock));
+    AggregateVector *av = &feature_collector->aggregate_vector;
+    for (unsigned i = 0; i < av->cnt; i++) {
+        free(av->metric[i].name);
+        av->metric[i].name = NULL;
+    }
+    av->cnt = 0;
+    pthread_mutex_unlock(&(feature_collector->lock));
+}
+
 int vmaf_feature_collector_set_aggregate(VmafFeatureCollector *feature_collector,
                                          const char *feature_name, double score)
 {
@@ -216,14 +335,18 @@ int vmaf_feature_collector_init(VmafFeatureCollector **const feature_collector)
     memset(fc->feature_vector, 0, sizeof(*(fc->feature_vector)) * fc->capacity);
     err = aggregate_vector_init(&fc->aggregate_vector);
     if (err) goto free_feature_vector;
-    err = pthread_mutex_init(&(fc->lock), NULL);
+    err = partial_vector_init(&fc->partial_vector);
     if (err) goto free_aggregate_vector;
+    err = pthread_mutex_init(&(fc->lock), NULL);
+    if (err) goto free_partial_vector;
     err = vmaf_metadata_init(&(fc->metadata));
     if (err) goto free_mutex;
     return 0;
 
 free_mutex:
     pthread_mutex_destroy(&(fc->lock));
+free_partial_vector:
+    partial_vector_destroy(&(fc->partial_vector));
 free_aggregate_vector:
     aggregate_vector_destroy(&(fc->aggregate_vector));
 free_feature_vector:
@@ -246,13 +369,9 @@ int vmaf_feature_collector_mount_model(VmafFeatureCollector *feature_collector,
     m->next = NULL;
 
     VmafPredictModel **head = &feature_collector->models;
-    while (*head && (*head)->next != NULL)
-        *head = (*head)->next;
-
-    if (!(*head))
-        *head = m;
-    else
-        (*head)->next = m;
+    while (*head)
+        head = &(*head)->next;
+    *head = m;
 
     return 0;
 }
@@ -290,6 +409,30 @@ int vmaf_feature_collector_register_metadata(VmafFeatureCollector *feature_colle
     return 0;
 }
 
+int vmaf_feature_collector_set_window(VmafFeatureCollector *feature_collector,
+                                      unsigned low, unsigned high)
+{
+    if (!feature_collector) return -EINVAL;
+    if (low > high) return -EINVAL;
+
+    pthread_mutex_lock(&(feature_collector->lock));
+    feature_collector->window.enabled = true;
+    feature_collector->window.low = low;
+    feature_collector->window.high = high;
+    pthread_mutex_unlock(&(feature_collector->lock));
+    return 0;
+}
+
+bool vmaf_feature_collector_in_window(VmafFeatureCollector *feature_collector,
+                                      unsigned index)
+{
+    if (!feature_collector) return false;
+    if (!feature_collector->window.enabled) return true;
+
+    return index >= feature_collector->window.low &&
+           index <= feature_collector->window.high;
+}
+
 static FeatureVector *find_feature_vector(VmafFeatureCollector *fc,
                                           const char *feature_name)
 {
@@ -304,6 +447,93 @@ static FeatureVector *find_feature_vector(VmafFeatureCollector *fc,
     return feature_vector;
 }
 
+int vmaf_feature_collector_forward(VmafFeatureCollector *feature_collector,
+                                   const char *feature_name,
+                                   VmafFeatureCollector *target)
+{
+    if (!feature_collector) return -EINVAL;
+    if (!feature_name) return -EINVAL;
+    if (!target) return -EINVAL;
+    if (target == feature_collector) return -EINVAL;
+
+    int err = 0;
+    pthread_mutex_lock(&(feature_collector->lock));
+
+    for (unsigned i = 0; i < feature_collector->forward.cnt; i++) {
+        if (feature_collector->forward.entry[i].target == target &&
+            !strcmp(feature_collector->forward.entry[i].name, feature_name))
+        {
+            goto unlock;
+        }
+    }
+
+    if (feature_collector->forward.cnt == feature_collector->forward.capacity) {
+        const unsigned capacity = feature_collector->forward.capacity ?
+            feature_collector->forward.capacity * 2 : 4;
+        void *entry = realloc(feature_collector->forward.entry,
+                              sizeof(*feature_collector->forward.entry) *
+                              capacity);
+        if (!entry) {
+            err = -ENOMEM;
+            goto unlock;
+        }
+        feature_collector->forward.entry = entry;
+        feature_collector->forward.capacity = capacity;
+    }
+
+    char *name = malloc(strlen(feature_name) + 1);
+    if (!name) {
+        err = -ENOMEM;
+        goto unlock;
+    }
+    strcpy(name, feature_name);
+    const unsigned n = feature_collector->forward.cnt++;
+    feature_collector->forward.entry[n].name = name;
+    feature_collector->forward.entry[n].target = target;
+
+unlock:
+    pthread_mutex_unlock(&(feature_collector->lock));
+    return err;
+}
+
+int vmaf_feature_collector_unforward(VmafFeatureCollector *feature_collector,
+                                     VmafFeatureCollector *target)
+{
+    if (!feature_collector) return -EINVAL;
+    if (!target) return -EINVAL;
+
+    pthread_mutex_lock(&(feature_collector->lock));
+    unsigned n = 0;
+    for (unsigned i = 0; i < feature_collector->forward.cnt; i++) {
+        if (feature_collector->forward.entry[i].target == target) {
+            free(feature_collector->forward.entry[i].name);
+            continue;
+        }
+        feature_collector->forward.entry[n++] =
+            feature_collector->forward.entry[i];
+    }
+    feature_collector->forward.cnt = n;
+    pthread_mutex_unlock(&(feature_collector->lock));
+    return 0;
+}
+
+static int forward_score(VmafFeatureCollector *feature_collector,
+                         const char *feature_name, double score,
+                         unsigned picture_index)
+{
+    int err = 0;
+    pthread_mutex_lock(&(feature_collector->lock));
+    for (unsigned i = 0; i < feature_collector->forward.cnt; i++) {
+        if (strcmp(feature_collector->forward.entry[i].name, feature_name))
+            continue;
+        err |= vmaf_feature_collector_append(
+                    feature_collector->forward.entry[i].target,
+                    feature_name, score, picture_index);
+    }
+    pthread_mutex_unlock(&(feature_collector->lock));
+    return err;
+}
+
 int vmaf_feature_collector_append(VmafFeatureCollector *feature_collector,
                                   const char *feature_name, double score,
                                   unsigned picture_index)
@@ -311,11 +541,20 @@ int vmaf_feature_collector_append(VmafFeatureCollector *feature_collector,
     if (!feature_collector) return -EINVAL;
     if (!feature_name) return -EINVAL;
 
+    if (feature_collector->forward.cnt) {
+        int err = forward_score(feature_collector, feature_name, score,
+                                picture_index);
+        if (err) return err;
+    }
+
+    if (!vmaf_feature_collector_in_window(feature_collector, picture_index))
+        return 0;
+
     pthread_mutex_lock(&(feature_collector->lock));
     int err = 0;
 
     if (!feature_collector->timer.begin)
-        feature_collector->timer.begin = clock();
+        feature_collector->timer.begin = vmaf_timer_wall_ns();
 
     FeatureVector *feature_vector =
         find_feature_vector(feature_collector, feature_name);
@@ -390,7 +629,7 @@ int vmaf_feature_collector_append(VmafFeatureCollector *feature_collector,
     }
 
 unlock:
-    feature_collector->timer.end = clock();
+    feature_collector->timer.end = vmaf_timer_wall_ns();
     pthread_mutex_unlock(&(feature_collector->lock));
     return err;
 }
@@ -444,6 +683,7 @@ void vmaf_feature_collector_destroy(VmafFeatureCollector *feature_collector)
 
     pthread_mutex_lock(&(feature_collector->lock));
     aggregate_vector_destroy(&(feature_collector->aggregate_vector));
+    partial_vector_destroy(&(feature_collector->partial_vector));
     for (unsigned i = 0; i < feature_collector->cnt; i++)
         feature_vector_destroy(feature_collector->feature_vector[i]);
     while (feature_collector->models)
@@ -451,6 +691,9 @@ void vmaf_feature_collector_destroy(VmafFeatureCollector *feature_collector)
                                              feature_collector->models->model);
     vmaf_metadata_destroy(feature_collector->metadata);
     free(feature_collector->feature_vector);
+    for (unsigned i = 0; i < feature_collector->forward.cnt; i++)
+        free(feature_collector->forward.entry[i].name);
+    free(feature_collector->forward.entry);
     pthread_mutex_unlock(&(feature_collector->lock));
     pthread_mutex_destroy(&(feature_collector->lock));
     free(feature_collector);
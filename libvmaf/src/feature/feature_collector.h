@@ -21,6 +21,7 @@
 
 #include <pthread.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <time.h>
 
 #include "dict.h"
@@ -44,6 +45,20 @@ typedef struct {
     unsigned cnt, capacity;
 } AggregateVector;
 
+enum VmafPartialMerge {
+    VMAF_PARTIAL_MERGE_SUM = 0,
+    VMAF_PARTIAL_MERGE_EQUAL,
+};
+
+typedef struct {
+    struct {
+        char *name;
+        uint64_t value;
+        enum VmafPartialMerge merge;
+    } *metric;
+    unsigned cnt, capacity;
+} PartialVector;
+
 typedef struct VmafPredictModel {
     VmafModel *model;
     struct VmafPredictModel *next;
@@ -52,10 +67,22 @@ typedef struct VmafPredictModel {
 typedef struct VmafFeatureCollector {
     FeatureVector **feature_vector;
     AggregateVector aggregate_vector;
+    PartialVector partial_vector;
     VmafCallbackList *metadata;
     VmafPredictModel *models;
     unsigned cnt, capacity;
-    struct { clock_t begin, end; } timer;
+    struct { uint64_t begin, end; } timer;
+    struct {
+        bool enabled;
+        unsigned low, high;
+    } window;
+    struct {
+        struct {
+            char *name;
+            struct VmafFeatureCollector *target;
+        } *entry;
+        unsigned cnt, capacity;
+    } forward;
     pthread_mutex_t lock;
 } VmafFeatureCollector;
 
@@ -86,6 +113,48 @@ int vmaf_feature_collector_get_aggregate(VmafFeatureCollector *feature_collector
                                          const char *feature_name,
                                          double *score);
 
+/**
+ * Partial state is extractor state which can not be reconstructed from
+ * per-frame scores, e.g. the sums behind an aggregate metric. It is kept
+ * alongside the scores so that results of independently scored segments
+ * can be merged. Accumulating a value which does not exist yet inserts it,
+ * otherwise it is summed or checked for equality according to `merge`.
+ */
+int vmaf_feature_collector_accumulate_partial(VmafFeatureCollector *feature_collector,
+                                              const char *name, uint64_t value,
+                                              enum VmafPartialMerge merge);
+
+int vmaf_feature_collector_get_partial(VmafFeatureCollector *feature_collector,
+                                       const char *name, uint64_t *value);
+
+void vmaf_feature_collector_clear_aggregates(VmafFeatureCollector *feature_collector);
+
+/**
+ * Scores appended for pictures outside of [low, high] are discarded.
+ * Temporal feature extractors which keep state across pictures still see
+ * every picture, but should only let in-window pictures contribute to
+ * aggregate state.
+ */
+int vmaf_feature_collector_set_window(VmafFeatureCollector *feature_collector,
+                                      unsigned low, unsigned high);
+
+bool vmaf_feature_collector_in_window(VmafFeatureCollector *feature_collector,
+                                      unsigned index);
+
+/**
+ * Also append every score of `feature_name` to `target`, so that a feature
+ * computed once can be shared by several contexts. Forwarding is independent
+ * of the score window of `feature_collector`, `target` applies its own.
+ * `target` has to outlive the forwarding, see
+ * `vmaf_feature_collector_unforward()`.
+ */
+int vmaf_feature_collector_forward(VmafFeatureCollector *feature_collector,
+                                   const char *feature_name,
+                                   VmafFeatureCollector *target);
+
+int vmaf_feature_collector_unforward(VmafFeatureCollector *feature_collector,
+                                     VmafFeatureCollector *target);
+
 void vmaf_feature_collector_destroy(VmafFeatureCollector *feature_collector);
 
 #endif /* __VMAF_FEATURE_COLLECTOR_H__ */
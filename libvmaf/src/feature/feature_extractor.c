@@ -49,6 +49,7 @@ extern VmafFeatureExtractor vmaf_fex_psnr_hvs;
 extern VmafFeatureExtractor vmaf_fex_integer_adm;
 extern VmafFeatureExtractor vmaf_fex_integer_motion;
 extern VmafFeatureExtractor vmaf_fex_integer_vif;
+extern VmafFeatureExtractor vmaf_fex_ssim;
 extern VmafFeatureExtractor vmaf_fex_cambi;
 #if HAVE_CUDA
 extern VmafFeatureExtractor vmaf_fex_integer_adm_cuda;
@@ -74,6 +75,7 @@ static VmafFeatureExtractor *feature_extractor_list[] = {
     &vmaf_fex_integer_adm,
     &vmaf_fex_integer_motion,
     &vmaf_fex_integer_vif,
+    &vmaf_fex_ssim,
     &vmaf_fex_cambi,
 #if HAVE_CUDA
     &vmaf_fex_integer_adm_cuda,
@@ -166,6 +168,21 @@ free_f:
     return -ENOMEM;
 }
 
+bool vmaf_feature_extractor_context_uses_chroma(
+                                        VmafFeatureExtractorContext *fex_ctx)
+{
+    const VmafFeatureExtractor *fex = fex_ctx->fex;
+    if (!(fex->flags & VMAF_FEATURE_EXTRACTOR_CHROMA)) return false;
+    if (!fex->options || !fex->priv) return true;
+
+    for (const VmafOption *opt = fex->options; opt->name; opt++) {
+        if (opt->type != VMAF_OPT_TYPE_BOOL) continue;
+        if (strcmp(opt->name, "enable_chroma")) continue;
+        return *((bool*)((uint8_t*)fex->priv + opt->offset));
+    }
+    return true;
+}
+
 int vmaf_feature_extractor_context_init(VmafFeatureExtractorContext *fex_ctx,
                                         enum VmafPixelFormat pix_fmt,
                                         unsigned bpc, unsigned w, unsigned h)
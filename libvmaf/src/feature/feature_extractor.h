@@ -38,6 +38,18 @@ enum VmafFeatureExtractorFlags {
     VMAF_FEATURE_EXTRACTOR_TEMPORAL = 1 << 0,
     VMAF_FEATURE_EXTRACTOR_CUDA = 1 << 1,
     VMAF_FEATURE_FRAME_SYNC = 1 << 2,
+    /**
+     * Reads the chroma planes. If the extractor has a boolean
+     * `enable_chroma` option, chroma is read only while it is set.
+     * Without any such extractor, pictures are fed as luma only.
+     */
+    VMAF_FEATURE_EXTRACTOR_CHROMA = 1 << 3,
+    /**
+     * Scores depend on the reference pictures only, e.g. motion. When one
+     * reference is scored against several distorted inputs, such an
+     * extractor runs once and its scores are shared.
+     */
+    VMAF_FEATURE_EXTRACTOR_REFERENCE_ONLY = 1 << 4,
 };
 
 typedef struct VmafFeatureExtractor {
@@ -137,6 +149,9 @@ int vmaf_feature_extractor_context_delete(VmafFeatureExtractorContext *fex_ctx);
 
 int vmaf_feature_extractor_context_destroy(VmafFeatureExtractorContext *fex_ctx);
 
+bool vmaf_feature_extractor_context_uses_chroma(
+                                        VmafFeatureExtractorContext *fex_ctx);
+
 typedef struct VmafFeatureExtractorContextPool {
     struct fex_list_entry {
         VmafFeatureExtractor *fex;
@@ -17,34 +17,62 @@
  */
 
 #include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <string.h>
 
 #include "feature_collector.h"
 #include "feature_extractor.h"
 
+#include "config.h"
+#include "cpu.h"
 #include "mem.h"
 #include "ansnr.h"
-#include "picture_copy.h"
+#include "ansnr_options.h"
+#include "ansnr_tools.h"
+
+#if ARCH_X86
+#include "x86/ansnr_avx2.h"
+#if HAVE_AVX512
+#include "x86/ansnr_avx512.h"
+#endif
+#endif
+
+#if defined(ANSNR_OPT_FILTER_1D) || defined(ANSNR_OPT_NORMALIZE) || \
+    defined(ANSNR_OPT_BORDER_REPLICATE)
+#error "float_ansnr filters rows with the default ansnr options only"
+#endif
+
+/*
+ * The pictures are converted to float, filtered and compared one row at a
+ * time. The converted rows live in a ring of as many rows as the taller
+ * filter, and are padded with mirrored samples, so the filters read them
+ * without border checks. The padding keeps the rows aligned.
+ */
+#define ANSNR_RING_ROWS 5
+#define ANSNR_ROW_PAD 8
 
 typedef struct AnsnrState {
-    size_t float_stride;
-    float *ref;
-    float *dist;
+    void *data;
+    float *ref[ANSNR_RING_ROWS];
+    float *dist[ANSNR_RING_ROWS];
+    float *ref_filtr;
+    float *filtd;
     double peak;
     double psnr_max;
+    void (*filter2d_row)(const float *f, int fwidth,
+                         const float *const *src_row, float *dst, int w);
+    void (*mse_row)(const float *ref, const float *dis, int w,
+                    float *sig, float *noise);
 } AnsnrState;
 
 static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
                 unsigned bpc, unsigned w, unsigned h)
 {
     (void)pix_fmt;
+    (void)h;
 
     AnsnrState *s = fex->priv;
-    s->float_stride = ALIGN_CEIL(w * sizeof(float));
-    s->ref = aligned_malloc(s->float_stride * h, 32);
-    if (!s->ref) goto fail;
-    s->dist = aligned_malloc(s->float_stride * h, 32);
-    if (!s->dist) goto free_ref;
 
     if (bpc == 8) {
         s->peak = 255.0;
@@ -59,15 +87,70 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
         s->peak = 255.99609375;
         s->psnr_max = 108.0;
     } else {
-        goto fail;
+        return -EINVAL;
+    }
+
+    s->filter2d_row = ansnr_filter2d_row_s;
+    s->mse_row = ansnr_mse_row_s;
+#if ARCH_X86
+    unsigned flags = vmaf_get_cpu_flags();
+    if (flags & VMAF_X86_CPU_FLAG_AVX2) {
+        s->filter2d_row = ansnr_filter2d_row_avx2;
+        s->mse_row = ansnr_mse_row_avx2;
+    }
+#if HAVE_AVX512
+    if (flags & VMAF_X86_CPU_FLAG_AVX512) {
+        s->filter2d_row = ansnr_filter2d_row_avx512;
+        s->mse_row = ansnr_mse_row_avx512;
+    }
+#endif
+#endif
+
+    const size_t row_stride = ALIGN_CEIL((w + 2 * ANSNR_ROW_PAD) * sizeof(float));
+    char *data = aligned_malloc(row_stride * (2 * ANSNR_RING_ROWS + 2), 32);
+    if (!data) return -ENOMEM;
+
+    s->data = data;
+    for (unsigned k = 0; k < ANSNR_RING_ROWS; k++) {
+        s->ref[k] = (float *)data + ANSNR_ROW_PAD; data += row_stride;
+        s->dist[k] = (float *)data + ANSNR_ROW_PAD; data += row_stride;
     }
+    s->ref_filtr = (float *)data; data += row_stride;
+    s->filtd = (float *)data;
 
     return 0;
+}
+
+/* picture_copy() of row i, with mirrored samples beyond both ends */
+static void convert_row(float *dst, VmafPicture *pic, unsigned i)
+{
+    const int w = pic->w[0];
+    const int offset = -128;
 
-    free_ref:
-    free(s->ref);
-    fail:
-    return -ENOMEM;
+    if (pic->bpc == 8) {
+        const uint8_t *data = (uint8_t *)pic->data[0] + i * pic->stride[0];
+        for (int j = 0; j < w; j++)
+            dst[j] = (float) data[j] + offset;
+    } else {
+        const float scaler = pic->bpc == 10 ? 4.0f :
+                             pic->bpc == 12 ? 16.0f : 256.0f;
+        const uint16_t *data =
+            (uint16_t *)((uint8_t *)pic->data[0] + i * pic->stride[0]);
+        for (int j = 0; j < w; j++)
+            dst[j] = (float) data[j] / scaler + offset;
+    }
+
+    for (int k = 1; k <= ansnr_filter2d_dis_width / 2; k++) {
+        dst[-k] = dst[k < w ? k : w - 1];
+        dst[w - 1 + k] = dst[w - k >= 0 ? w - k : 0];
+    }
+}
+
+static int mirror(int i, int h)
+{
+    if (i < 0) i = -i;
+    else if (i >= h) i = 2 * h - i - 1;
+    return i < 0 ? 0 : i >= h ? h - 1 : i;
 }
 
 static int extract(VmafFeatureExtractor *fex,
@@ -81,15 +164,45 @@ static int extract(VmafFeatureExtractor *fex,
     (void) ref_pic_90;
     (void) dist_pic_90;
 
-    picture_copy(s->ref, s->float_stride, ref_pic, -128, ref_pic->bpc);
-    picture_copy(s->dist, s->float_stride, dist_pic, -128, dist_pic->bpc);
+    const int w = ref_pic->w[0], h = ref_pic->h[0];
+    const int ref_radius = ansnr_filter2d_ref_width / 2;
+    const int dis_radius = ansnr_filter2d_dis_width / 2;
+    const float *ref_row[ANSNR_RING_ROWS], *dis_row[ANSNR_RING_ROWS];
+    float sig_accum = 0, noise_accum = 0;
+    int converted = 0;
+
+    for (int i = 0; i < h; i++) {
+        for (; converted < h && converted <= i + dis_radius; converted++) {
+            convert_row(s->ref[converted % ANSNR_RING_ROWS], ref_pic,
+                        converted);
+            convert_row(s->dist[converted % ANSNR_RING_ROWS], dist_pic,
+                        converted);
+        }
+
+        for (int fi = 0; fi < ansnr_filter2d_ref_width; fi++) {
+            const int ii = mirror(i - ref_radius + fi, h);
+            ref_row[fi] = s->ref[ii % ANSNR_RING_ROWS];
+        }
+        for (int fi = 0; fi < ansnr_filter2d_dis_width; fi++) {
+            const int ii = mirror(i - dis_radius + fi, h);
+            dis_row[fi] = s->dist[ii % ANSNR_RING_ROWS];
+        }
+
+        s->filter2d_row(ansnr_filter2d_ref_s, ansnr_filter2d_ref_width,
+                        ref_row, s->ref_filtr, w);
+        s->filter2d_row(ansnr_filter2d_dis_s, ansnr_filter2d_dis_width,
+                        dis_row, s->filtd, w);
+
+        float sig, noise;
+        s->mse_row(s->ref_filtr, s->filtd, w, &sig, &noise);
+        sig_accum += sig;
+        noise_accum += noise;
+    }
 
     double score, score_psnr;
-    err = compute_ansnr(s->ref, s->dist, ref_pic->w[0], ref_pic->h[0],
-                        s->float_stride, s->float_stride, &score, &score_psnr,
-                        s->peak, s->psnr_max);
+    ansnr_score(sig_accum, noise_accum, w, h, s->peak, s->psnr_max, &score,
+                &score_psnr);
 
-    if (err) return err;
     err = vmaf_feature_collector_append(feature_collector, "float_ansnr",
                                         score, index);
     if (err) return err;
@@ -102,8 +215,7 @@ static int extract(VmafFeatureExtractor *fex,
 static int close(VmafFeatureExtractor *fex)
 {
     AnsnrState *s = fex->priv;
-    if (s->ref) aligned_free(s->ref);
-    if (s->dist) aligned_free(s->dist);
+    if (s->data) aligned_free(s->data);
     return 0;
 }
 
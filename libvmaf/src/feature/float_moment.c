@@ -23,23 +23,55 @@
 #include "feature_collector.h"
 #include "feature_extractor.h"
 
+#include "config.h"
+#include "cpu.h"
 #include "mem.h"
 #include "moment.h"
 #include "picture_copy.h"
 
+#if ARCH_X86
+#include "x86/moment_avx2.h"
+#if HAVE_AVX512
+#include "x86/moment_avx512.h"
+#endif
+#endif
+
 typedef struct MomentState {
     size_t float_stride;
     float *ref;
     float *dist;
+    void (*sums_8)(const uint8_t *pic, ptrdiff_t stride, unsigned w,
+                   unsigned h, uint64_t *sum, uint64_t *sum_sq);
+    void (*sums_16)(const uint16_t *pic, ptrdiff_t stride, unsigned w,
+                    unsigned h, uint64_t *sum, uint64_t *sum_sq);
 } MomentState;
 
 static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
                 unsigned bpc, unsigned w, unsigned h)
 {
     (void)pix_fmt;
-    (void)bpc;
 
     MomentState *s = fex->priv;
+
+    s->sums_8 = moment_sums_8;
+    s->sums_16 = moment_sums_16;
+#if ARCH_X86
+    unsigned flags = vmaf_get_cpu_flags();
+    if (flags & VMAF_X86_CPU_FLAG_AVX2) {
+        s->sums_8 = moment_sums_8_avx2;
+        s->sums_16 = moment_sums_16_avx2;
+    }
+#if HAVE_AVX512
+    if (flags & VMAF_X86_CPU_FLAG_AVX512) {
+        s->sums_8 = moment_sums_8_avx512;
+        s->sums_16 = moment_sums_16_avx512;
+    }
+#endif
+#endif
+
+    /* up to 12 bits, the moments come from exact integer sums */
+    if (bpc <= 12) return 0;
+
     s->float_stride = ALIGN_CEIL(w * sizeof(float));
     s->ref = aligned_malloc(s->float_stride * h, 32);
     if (!s->ref) goto fail;
@@ -49,26 +81,39 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
     return 0;
 
 free_ref:
-    free(s->ref);
+    aligned_free(s->ref);
 fail:
     return -ENOMEM;
 }
 
-static int extract(VmafFeatureExtractor *fex,
-                   VmafPicture *ref_pic, VmafPicture *ref_pic_90,
-                   VmafPicture *dist_pic, VmafPicture *dist_pic_90,
-                   unsigned index, VmafFeatureCollector *feature_collector)
+/*
+ * The float planes hold the samples scaled to 8 bits by a power of two,
+ * and every sum of them is exact in double, as are the integer sums
+ * converted and scaled here. The moments are therefore identical.
+ */
+static void integer_moments(MomentState *s, VmafPicture *pic,
+                            double *first, double *second)
 {
-    MomentState *s = fex->priv;
-    int err = 0;
+    const unsigned w = pic->w[0], h = pic->h[0];
+    uint64_t sum, sum_sq;
+    if (pic->bpc == 8)
+        s->sums_8(pic->data[0], pic->stride[0], w, h, &sum, &sum_sq);
+    else
+        s->sums_16(pic->data[0], pic->stride[0], w, h, &sum, &sum_sq);
+
+    const double scale = 1 << (pic->bpc - 8);
+    *first = (double)sum / scale / (w * h);
+    *second = (double)sum_sq / (scale * scale) / (w * h);
+}
 
-    (void) ref_pic_90;
-    (void) dist_pic_90;
+static int float_moments(MomentState *s, VmafPicture *ref_pic,
+                         VmafPicture *dist_pic, double score[4])
+{
+    int err;
 
     picture_copy(s->ref, s->float_stride, ref_pic, 0, ref_pic->bpc);
     picture_copy(s->dist, s->float_stride, dist_pic, 0, dist_pic->bpc);
 
-    double score[4];
     err = compute_1st_moment(s->ref, ref_pic->w[0], ref_pic->h[0],
                              s->float_stride, &score[0]);
     if (err) return err;
@@ -80,7 +125,28 @@ static int extract(VmafFeatureExtractor *fex,
     if (err) return err;
     err = compute_2nd_moment(s->dist, dist_pic->w[0], dist_pic->h[0],
                              s->float_stride, &score[3]);
-    if (err) return err;
+    return err;
+}
+
+static int extract(VmafFeatureExtractor *fex,
+                   VmafPicture *ref_pic, VmafPicture *ref_pic_90,
+                   VmafPicture *dist_pic, VmafPicture *dist_pic_90,
+                   unsigned index, VmafFeatureCollector *feature_collector)
+{
+    MomentState *s = fex->priv;
+    int err = 0;
+
+    (void) ref_pic_90;
+    (void) dist_pic_90;
+
+    double score[4];
+    if (ref_pic->bpc <= 12) {
+        integer_moments(s, ref_pic, &score[0], &score[2]);
+        integer_moments(s, dist_pic, &score[1], &score[3]);
+    } else {
+        err = float_moments(s, ref_pic, dist_pic, score);
+        if (err) return err;
+    }
 
     err = vmaf_feature_collector_append(feature_collector,
                                         "float_moment_ref1st",
@@ -36,6 +36,7 @@ typedef struct MotionState {
     float *tmp;
     float *blur[3];
     unsigned index;
+    unsigned pic_cnt;
     double score;
     bool debug;
     bool motion_force_zero;
@@ -106,7 +107,7 @@ static int flush(VmafFeatureExtractor *fex,
     MotionState *s = fex->priv;
     int ret = 0;
 
-    if (s->index > 0) {
+    if (s->pic_cnt > 1) {
         ret = vmaf_feature_collector_append(feature_collector,
                                             "VMAF_feature_motion2_score",
                                             s->score, s->index);
@@ -152,7 +153,9 @@ static int extract(VmafFeatureExtractor *fex,
                         s->float_stride / sizeof(float),
                         s->float_stride / sizeof(float));
 
-    if (index == 0) {
+    // the first picture seen is not necessarily index 0,
+    // e.g. when warming up at the start of a segment
+    if (s->pic_cnt++ == 0) {
         err = vmaf_feature_collector_append(feature_collector,
                                              "VMAF_feature_motion2_score",
                                              0., index);
@@ -178,7 +181,7 @@ static int extract(VmafFeatureExtractor *fex,
     if (err) return err;
     s->score = score;
 
-    if (index == 1)
+    if (s->pic_cnt == 2)
         return 0;
     
     double score2;
@@ -223,5 +226,6 @@ VmafFeatureExtractor vmaf_fex_float_motion = {
     .close = close,
     .priv_size = sizeof(MotionState),
     .provided_features = provided_features,
-    .flags = VMAF_FEATURE_EXTRACTOR_TEMPORAL,
+    .flags = VMAF_FEATURE_EXTRACTOR_TEMPORAL |
+             VMAF_FEATURE_EXTRACTOR_REFERENCE_ONLY,
 };
@@ -34,6 +34,7 @@ typedef struct VifState {
     size_t float_stride;
     float *ref;
     float *dist;
+    VifFloatBuffer buf;
     bool debug;
     double vif_enhn_gain_limit;
     double vif_kernelscale;
@@ -87,6 +88,7 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
     if (!s->ref) goto fail;
     s->dist = aligned_malloc(s->float_stride * h, 32);
     if (!s->dist) goto fail;
+    if (vif_float_buffer_init(&s->buf, w, h)) goto fail;
 
     s->feature_name_dict =
         vmaf_feature_name_dict_from_provided_features(fex->provided_features,
@@ -98,6 +100,7 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
 fail:
     if (s->ref) aligned_free(s->ref);
     if (s->dist) aligned_free(s->dist);
+    vif_float_buffer_free(&s->buf);
     vmaf_dictionary_free(&s->feature_name_dict);
     return -ENOMEM;
 }
@@ -118,11 +121,11 @@ static int extract(VmafFeatureExtractor *fex,
 
     double score, score_num, score_den;
     double scores[8];
-    err = compute_vif(s->ref, s->dist, ref_pic->w[0], ref_pic->h[0],
-                      s->float_stride, s->float_stride,
-                      &score, &score_num, &score_den, scores,
-                      s->vif_enhn_gain_limit,
-                      s->vif_kernelscale);
+    err = compute_vif_with_buffer(s->ref, s->dist, ref_pic->w[0], ref_pic->h[0],
+                                  s->float_stride, s->float_stride,
+                                  &score, &score_num, &score_den, scores,
+                                  s->vif_enhn_gain_limit,
+                                  s->vif_kernelscale, &s->buf);
     if (err) return err;
 
     err |= vmaf_feature_collector_append_with_dict(feature_collector,
@@ -184,6 +187,7 @@ static int close(VmafFeatureExtractor *fex)
     VifState *s = fex->priv;
     if (s->ref) aligned_free(s->ref);
     if (s->dist) aligned_free(s->dist);
+    vif_float_buffer_free(&s->buf);
     vmaf_dictionary_free(&s->feature_name_dict);
     return 0;
 }
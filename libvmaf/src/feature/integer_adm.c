@@ -16,6 +16,8 @@
  *
  */
 
+#include <pthread.h>
+
 #include "cpu.h"
 #include "dict.h"
 #include "feature_collector.h"
@@ -31,6 +33,24 @@
 #include <arm_neon.h>
 #endif
 
+static int32_t div_lookup[65537];
+static pthread_once_t div_lookup_once = PTHREAD_ONCE_INIT;
+
+static void div_lookup_generator(void)
+{
+    for (int i = 1; i <= 32768; ++i) {
+        int32_t recip = (int32_t)(div_Q_factor / i);
+        div_lookup[32768 + i] = recip;
+        div_lookup[32768 - i] = 0 - recip;
+    }
+}
+
+const int32_t *adm_div_lookup(void)
+{
+    pthread_once(&div_lookup_once, div_lookup_generator);
+    return div_lookup;
+}
+
 typedef struct AdmState {
     size_t integer_stride;
     AdmBuffer buf;
@@ -2640,7 +2660,7 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
     void *ind_buf_x = s->buf.buf_x_orig;
     init_index(s->buf.ind_x, ind_buf_x, s->buf.ind_size_x);
 
-    div_lookup_generator();
+    adm_div_lookup();
 
     s->feature_name_dict =
         vmaf_feature_name_dict_from_provided_features(fex->provided_features,
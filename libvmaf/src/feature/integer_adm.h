@@ -8,16 +8,14 @@
 #include <stdint.h>
 #include <string.h>
 
-static int32_t div_lookup[65537];
 static const int32_t div_Q_factor = 1073741824; // 2^30
 
-static inline void div_lookup_generator() {
-    for (int i = 1; i <= 32768; ++i) {
-        int32_t recip = (int32_t)(div_Q_factor / i);
-        div_lookup[32768 + i] = recip;
-        div_lookup[32768 - i] = 0 - recip;
-    }
-}
+/*
+ * div_Q_factor / (i - 32768) for i = 0 .. 65536, 0 at i = 32768. The table
+ * is generated once per process on first use and shared read-only by every
+ * adm context.
+ */
+const int32_t *adm_div_lookup(void);
 
 typedef struct adm_dwt_band_t {
     int16_t *band_a; /* Low-pass V + low-pass H. */
@@ -41,6 +41,7 @@ typedef struct MotionState {
     VmafPicture tmp;
     VmafPicture blur[3];
     unsigned index;
+    unsigned pic_cnt;
     double score;
     bool debug;
     bool motion_force_zero;
@@ -328,7 +329,7 @@ static int flush(VmafFeatureExtractor *fex,
     MotionState *s = fex->priv;
     int ret = 0;
 
-    if (s->index > 0) {
+    if (s->pic_cnt > 1) {
         ret = vmaf_feature_collector_append(feature_collector,
                                             "VMAF_integer_feature_motion2_score",
                                             s->score, s->index);
@@ -371,7 +372,9 @@ static int extract(VmafFeatureExtractor *fex,
                      s->tmp.w[0], s->tmp.h[0], s->tmp.stride[0] / 2,
                      s->blur[blur_idx_0].stride[0] / 2);
 
-    if (index == 0) {
+    // the first picture seen is not necessarily index 0,
+    // e.g. when warming up at the start of a segment
+    if (s->pic_cnt++ == 0) {
         err = vmaf_feature_collector_append(feature_collector,
                                             "VMAF_integer_feature_motion2_score",
                                             0., index);
@@ -395,7 +398,7 @@ static int extract(VmafFeatureExtractor *fex,
     }
     if (err) return err;
 
-    if (index == 1)
+    if (s->pic_cnt == 2)
         return 0;
 
     uint64_t sad2;
@@ -436,5 +439,6 @@ VmafFeatureExtractor vmaf_fex_integer_motion = {
     .options = options,
     .priv_size = sizeof(MotionState),
     .provided_features = provided_features,
-    .flags = VMAF_FEATURE_EXTRACTOR_TEMPORAL,
+    .flags = VMAF_FEATURE_EXTRACTOR_TEMPORAL |
+             VMAF_FEATURE_EXTRACTOR_REFERENCE_ONLY,
 };
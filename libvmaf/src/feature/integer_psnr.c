@@ -20,11 +20,13 @@
 #include <float.h>
 #include <math.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "feature_collector.h"
 #include "feature_extractor.h"
+#include "integer_psnr.h"
 #include "opt.h"
 
 typedef struct PsnrState {
@@ -138,7 +140,9 @@ static int psnr(VmafPicture *ref_pic, VmafPicture *dist_pic,
             dis += dist_pic->stride[p];
         }
 
-        if (s->enable_apsnr) {
+        if (s->enable_apsnr &&
+            vmaf_feature_collector_in_window(feature_collector, index))
+        {
             s->apsnr.sse[p] += sse;
             s->apsnr.n_pixels[p] += ref_pic->h[p] * ref_pic->w[p];
         }
@@ -180,7 +184,9 @@ static int psnr_hbd(VmafPicture *ref_pic, VmafPicture *dist_pic,
             dis += dist_pic->stride[p] / 2;
         }
 
-        if (s->enable_apsnr) {
+        if (s->enable_apsnr &&
+            vmaf_feature_collector_in_window(feature_collector, index))
+        {
             s->apsnr.sse[p] += sse;
             s->apsnr.n_pixels[p] += ref_pic->h[p] * ref_pic->w[p];
         }
@@ -223,30 +229,69 @@ static int extract(VmafFeatureExtractor *fex,
     }
 }
 
+static const char *apsnr_name[3] = { "apsnr_y", "apsnr_cb", "apsnr_cr" };
+
+int vmaf_apsnr_set_aggregates(VmafFeatureCollector *feature_collector)
+{
+    uint64_t peak;
+    if (vmaf_feature_collector_get_partial(feature_collector, "apsnr_peak",
+                                           &peak))
+    {
+        return 0;
+    }
+
+    int err = 0;
+    for (unsigned i = 0; i < 3; i++) {
+        char name[32];
+        uint64_t sse, n_pixels;
+        snprintf(name, sizeof(name), "%s_sse", apsnr_name[i]);
+        err |= vmaf_feature_collector_get_partial(feature_collector, name,
+                                                  &sse);
+        snprintf(name, sizeof(name), "%s_n_pixels", apsnr_name[i]);
+        err |= vmaf_feature_collector_get_partial(feature_collector, name,
+                                                  &n_pixels);
+        if (err) return err;
+
+        double apsnr = 10 * (log10(peak * peak) +
+                             log10(n_pixels) -
+                             log10(sse));
+
+        double max_apsnr =
+            ceil(10 * log10(peak * peak *
+                            n_pixels *
+                            2));
+
+        err |=
+            vmaf_feature_collector_set_aggregate(feature_collector,
+                                                 apsnr_name[i],
+                                                 MIN(apsnr, max_apsnr));
+    }
+
+    return err;
+}
+
 static int flush(VmafFeatureExtractor *fex,
                  VmafFeatureCollector *feature_collector)
 {
     PsnrState *s = fex->priv;
-    const char *apsnr_name[3] = { "apsnr_y", "apsnr_cb", "apsnr_cr" };
 
     int err = 0;
     if (s->enable_apsnr) {
+        err |= vmaf_feature_collector_accumulate_partial(feature_collector,
+                                "apsnr_peak", s->peak,
+                                VMAF_PARTIAL_MERGE_EQUAL);
         for (unsigned i = 0; i < 3; i++) {
-
-            double apsnr = 10 * (log10(s->peak * s->peak) +
-                                 log10(s->apsnr.n_pixels[i]) -
-                                 log10(s->apsnr.sse[i]));
-
-            double max_apsnr =
-                ceil(10 * log10(s->peak * s->peak *
-                                s->apsnr.n_pixels[i] *
-                                2));
-
-            err |=
-                vmaf_feature_collector_set_aggregate(feature_collector,
-                                                     apsnr_name[i],
-                                                     MIN(apsnr, max_apsnr));
+            char name[32];
+            snprintf(name, sizeof(name), "%s_sse", apsnr_name[i]);
+            err |= vmaf_feature_collector_accumulate_partial(feature_collector,
+                                    name, s->apsnr.sse[i],
+                                    VMAF_PARTIAL_MERGE_SUM);
+            snprintf(name, sizeof(name), "%s_n_pixels", apsnr_name[i]);
+            err |= vmaf_feature_collector_accumulate_partial(feature_collector,
+                                    name, s->apsnr.n_pixels[i],
+                                    VMAF_PARTIAL_MERGE_SUM);
         }
+        err |= vmaf_apsnr_set_aggregates(feature_collector);
     }
 
     return (err < 0) ? err : !err;
@@ -265,5 +310,5 @@ VmafFeatureExtractor vmaf_fex_psnr = {
     .flush = flush,
     .priv_size = sizeof(PsnrState),
     .provided_features = provided_features,
-    .flags = VMAF_FEATURE_EXTRACTOR_TEMPORAL,
+    .flags = VMAF_FEATURE_EXTRACTOR_TEMPORAL | VMAF_FEATURE_EXTRACTOR_CHROMA,
 };
@@ -0,0 +1,33 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef FEATURE_INTEGER_PSNR_H_
+#define FEATURE_INTEGER_PSNR_H_
+
+#include "feature_collector.h"
+
+/**
+ * Compute the APSNR aggregates from the SSE and pixel count partials
+ * published by the psnr extractor. Used when flushing the extractor and
+ * again after merging the partial results of several segments, so both
+ * paths share the exact same arithmetic. Does nothing if no APSNR
+ * partials are present.
+ */
+int vmaf_apsnr_set_aggregates(VmafFeatureCollector *feature_collector);
+
+#endif /* FEATURE_INTEGER_PSNR_H_ */
@@ -1,205 +1,234 @@
-/*
-Copyright 2001-2012 Xiph.Org and contributors.
-
-Redistribution and use in source and binary forms, with or without
-modification, are permitted provided that the following conditions
-are met:
-
-- Redistributions of source code must retain the above copyright
-notice, this list of conditions and the following disclaimer.
-
-- Redistributions in binary form must reproduce the above copyright
-notice, this list of conditions and the following disclaimer in the
-documentation and/or other materials provided with the distribution.
-
-THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
-``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
-LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
-A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
-OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
-EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
-PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
-PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
-LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
-NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
-SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
-*/
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
 
+#include <errno.h>
 #include <math.h>
-#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
 
+#include "cpu.h"
 #include "feature_collector.h"
 #include "feature_extractor.h"
+#include "integer_ssim.h"
+#include "mem.h"
+#include "picture.h"
 
-#define KERNEL_SHIFT (8)
-#define KERNEL_WEIGHT (1<<KERNEL_SHIFT)
-#define KERNEL_ROUND ((1<<KERNEL_SHIFT)>>1)
-
-#ifndef M_PI
-#define M_PI 3.141592653589793238462643
+#if ARCH_X86
+#include "x86/ssim_avx2.h"
+#if HAVE_AVX512
+#include "x86/ssim_avx512.h"
+#endif
 #endif
 
-static int gaussian_filter_init(unsigned **_kernel,double _sigma,int _max_len){
-  unsigned *kernel;
-  double    scale;
-  double    nhisigma2;
-  double    s;
-  double    len;
-  unsigned  sum;
-  int       kernel_len;
-  int       kernel_sz;
-  int       ci;
-  scale=1/(sqrt(2*M_PI)*_sigma);
-  nhisigma2=-0.5/(_sigma*_sigma);
-  /*Compute the kernel size so that the error in the first truncated
-     coefficient is no larger than 0.5*KERNEL_WEIGHT.
-    There is no point in going beyond this given our working precision.*/
-  s=sqrt(0.5*M_PI)*_sigma*(1.0/KERNEL_WEIGHT);
-  if(s>=1)len=0;
-  else len=floor(_sigma*sqrt(-2*log(s)));
-  kernel_len=len>=_max_len?_max_len-1:(int)len;
-  kernel_sz=kernel_len<<1|1;
-  kernel=(unsigned *)malloc(kernel_sz*sizeof(*kernel));
-  sum=0;
-  for(ci=kernel_len;ci>0;ci--){
-    kernel[kernel_len-ci]=kernel[kernel_len+ci]=
-     (unsigned)(KERNEL_WEIGHT*scale*exp(nhisigma2*ci*ci)+0.5);
-    sum+=kernel[kernel_len-ci];
-  }
-  kernel[kernel_len]=KERNEL_WEIGHT-(sum<<1);
-  *_kernel=kernel;
-  return kernel_sz;
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+
+typedef struct SsimState {
+    unsigned scale;
+    unsigned w, h;
+    ptrdiff_t stride;
+    uint16_t *ref, *dis;
+    unsigned *col;
+    uint32_t *acc;
+    SsimMoments m;
+    void (*filter_v)(const uint16_t *ref, const uint16_t *dis,
+                     ptrdiff_t stride, unsigned w, SsimMoments *m);
+    double (*accumulate_row)(const SsimMoments *m, unsigned w);
+} SsimState;
+
+void ssim_filter_v(const uint16_t *ref, const uint16_t *dis, ptrdiff_t stride,
+                   unsigned w, SsimMoments *m)
+{
+    for (unsigned j = 0; j < w; j++) {
+        uint32_t mu_x = 0, mu_y = 0, xx = 0, yy = 0, xy = 0;
+        for (unsigned k = 0; k < SSIM_WINDOW; k++) {
+            const uint32_t x = ref[k * stride + j];
+            const uint32_t y = dis[k * stride + j];
+            const uint32_t g = ssim_filter[k];
+            mu_x += g * x;
+            mu_y += g * y;
+            xx += g * (x * x);
+            yy += g * (y * y);
+            xy += g * (x * y);
+        }
+        m->mu_x[j] = (mu_x + (1 << (SSIM_MU_SHIFT - 1))) >> SSIM_MU_SHIFT;
+        m->mu_y[j] = (mu_y + (1 << (SSIM_MU_SHIFT - 1))) >> SSIM_MU_SHIFT;
+        m->xx[j] = (xx + (1 << (SSIM_SQ_SHIFT - 1))) >> SSIM_SQ_SHIFT;
+        m->yy[j] = (yy + (1 << (SSIM_SQ_SHIFT - 1))) >> SSIM_SQ_SHIFT;
+        m->xy[j] = (xy + (1 << (SSIM_SQ_SHIFT - 1))) >> SSIM_SQ_SHIFT;
+    }
+}
+
+double ssim_accumulate_row(const SsimMoments *m, unsigned w)
+{
+    double sum = 0.;
+    for (unsigned j = 0; j < w; j++) {
+        uint32_t mu_x = 0, mu_y = 0, xx = 0, yy = 0, xy = 0;
+        for (unsigned k = 0; k < SSIM_WINDOW; k++) {
+            const uint32_t g = ssim_filter[k];
+            mu_x += g * m->mu_x[j + k];
+            mu_y += g * m->mu_y[j + k];
+            xx += g * m->xx[j + k];
+            yy += g * m->yy[j + k];
+            xy += g * m->xy[j + k];
+        }
+        sum += ssim_pixel(mu_x, mu_y, xx, yy, xy);
+    }
+    return sum;
 }
 
-typedef struct ssim_moments ssim_moments;
+static inline unsigned reflect(int i, unsigned n)
+{
+    if (i < 0) return -1 - i;
+    if (i >= (int)n) return 2 * n - 1 - i;
+    return i;
+}
 
-struct ssim_moments{
-  int64_t mux;
-  int64_t muy;
-  int64_t x2;
-  int64_t xy;
-  int64_t y2;
-  int64_t w;
-};
+/*
+ * Brings a luma plane to SSIM_BPC, box-filtering it down by s->scale with the
+ * same sample positions and symmetric borders as float_ssim's decimation.
+ */
+static void prepare(SsimState *s, VmafPicture *pic, uint16_t *dst)
+{
+    const unsigned bpc = pic->bpc;
 
-#define SSIM_K1 (0.01*0.01)
-#define SSIM_K2 (0.03*0.03)
-
-static double calc_ssim(const unsigned char *_src,int _systride,
- const unsigned char *_dst,int _dystride,double _par,int depth,int _w,int _h){
-  ssim_moments  *line_buf;
-  ssim_moments **lines;
-  double         ssim;
-  double         ssimw;
-  unsigned      *hkernel;
-  int            hkernel_sz;
-  int            hkernel_offs;
-  unsigned      *vkernel;
-  int            vkernel_sz;
-  int            vkernel_offs;
-  int            log_line_sz;
-  int            line_sz;
-  int            line_mask;
-  int            x;
-  int            y;
-  int            samplemax;
-  samplemax = (1 << depth) - 1;
-  vkernel_sz=gaussian_filter_init(&vkernel,1.5,5);
-  vkernel_offs=vkernel_sz>>1;
-  for(line_sz=1,log_line_sz=0;line_sz<vkernel_sz;line_sz<<=1,log_line_sz++);
-  line_mask=line_sz-1;
-  lines=(ssim_moments **)malloc(line_sz*sizeof(*lines));
-  lines[0]=line_buf=(ssim_moments *)malloc(line_sz*_w*sizeof(*line_buf));
-  for(y=1;y<line_sz;y++)lines[y]=lines[y-1]+_w;
-  hkernel_sz=gaussian_filter_init(&hkernel,1.5,5);
-  hkernel_offs=hkernel_sz>>1;
-  ssim=0;
-  ssimw=0;
-  for(y=0;y<_h+vkernel_offs;y++){
-    ssim_moments *buf;
-    int           k;
-    int           k_min;
-    int           k_max;
-    if(y<_h){
-      buf=lines[y&line_mask];
-      for(x=0;x<_w;x++){
-        ssim_moments m;
-        memset(&m,0,sizeof(m));
-        k_min=hkernel_offs-x<=0?0:hkernel_offs-x;
-        k_max=x+hkernel_offs-_w+1<=0?
-         hkernel_sz:hkernel_sz-(x+hkernel_offs-_w+1);
-        for(k=k_min;k<k_max;k++){
-          signed s;
-          signed d;
-          signed window;
-          if (depth > 8) {
-            s = _src[(x-hkernel_offs+k)*2] +
-             (_src[(x-hkernel_offs+k)*2 + 1] << 8);
-            d = _dst[(x-hkernel_offs+k)*2] +
-             (_dst[(x-hkernel_offs+k)*2 + 1] << 8);
-          } else {
-            s=_src[(x-hkernel_offs+k)];
-            d=_dst[(x-hkernel_offs+k)];
-          }
-          window=hkernel[k];
-          m.mux+=window*s;
-          m.muy+=window*d;
-          m.x2+=window*s*s;
-          m.xy+=window*s*d;
-          m.y2+=window*d*d;
-          m.w+=window;
+    if (s->scale == 1) {
+        for (unsigned i = 0; i < s->h; i++) {
+            if (bpc == 8) {
+                const uint8_t *src = (uint8_t *)pic->data[0] + i * pic->stride[0];
+                for (unsigned j = 0; j < s->w; j++)
+                    dst[j] = src[j] << (SSIM_BPC - 8);
+            } else {
+                const uint16_t *src =
+                    (uint16_t *)((uint8_t *)pic->data[0] + i * pic->stride[0]);
+                if (bpc <= SSIM_BPC) {
+                    for (unsigned j = 0; j < s->w; j++)
+                        dst[j] = src[j] << (SSIM_BPC - bpc);
+                } else {
+                    const unsigned shift = bpc - SSIM_BPC;
+                    for (unsigned j = 0; j < s->w; j++) {
+                        const unsigned x = (src[j] + (1 << (shift - 1))) >> shift;
+                        dst[j] = MIN(x, SSIM_SAMPLE_MAX);
+                    }
+                }
+            }
+            dst += s->stride;
         }
-        *(buf+x)=*&m;
-      }
-      _src+=_systride;
-      _dst+=_dystride;
+        return;
     }
-    if(y>=vkernel_offs){
-      k_min=vkernel_sz-y-1<=0?0:vkernel_sz-y-1;
-      k_max=y+1-_h<=0?vkernel_sz:vkernel_sz-(y+1-_h);
-      for(x=0;x<_w;x++){
-        ssim_moments m;
-        double       c1;
-        double       c2;
-        double       mx2;
-        double       mxy;
-        double       my2;
-        double       w;
-        memset(&m,0,sizeof(m));
-        for(k=k_min;k<k_max;k++){
-          signed window;
-          buf = lines[(y + 1 - vkernel_sz + k) & line_mask] + x;
-          window=vkernel[k];
-          m.mux+=window*buf->mux;
-          m.muy+=window*buf->muy;
-          m.x2+=window*buf->x2;
-          m.xy+=window*buf->xy;
-          m.y2+=window*buf->y2;
-          m.w+=window*buf->w;
+
+    const unsigned f = s->scale;
+    const uint64_t den = (uint64_t)(f * f) << bpc;
+    for (unsigned i = 0; i < s->h; i++) {
+        for (unsigned j = 0; j < s->w; j++)
+            s->acc[j] = 0;
+        for (unsigned v = 0; v < f; v++) {
+            const unsigned row = reflect((int)(i * f + v) - (int)f / 2, pic->h[0]);
+            if (bpc == 8) {
+                const uint8_t *src = (uint8_t *)pic->data[0] + row * pic->stride[0];
+                for (unsigned j = 0; j < s->w; j++) {
+                    for (unsigned u = 0; u < f; u++)
+                        s->acc[j] += src[s->col[j * f + u]];
+                }
+            } else {
+                const uint16_t *src =
+                    (uint16_t *)((uint8_t *)pic->data[0] + row * pic->stride[0]);
+                for (unsigned j = 0; j < s->w; j++) {
+                    for (unsigned u = 0; u < f; u++)
+                        s->acc[j] += src[s->col[j * f + u]];
+                }
+            }
+        }
+        for (unsigned j = 0; j < s->w; j++) {
+            const uint64_t x =
+                (((uint64_t)s->acc[j] << SSIM_BPC) + den / 2) / den;
+            dst[j] = MIN(x, SSIM_SAMPLE_MAX);
         }
-        w=m.w;
-        c1=samplemax*samplemax*SSIM_K1*w*w;
-        c2=samplemax*samplemax*SSIM_K2*w*w;
-        mx2=m.mux*(double)m.mux;
-        mxy=m.mux*(double)m.muy;
-        my2=m.muy*(double)m.muy;
-        ssim+=m.w*(2*mxy+c1)*(c2+2*(m.xy*w-mxy))/
-         ((mx2+my2+c1)*(m.x2*w-mx2+m.y2*w-my2+c2));
-        ssimw+=m.w;
-      }
+        dst += s->stride;
     }
-  }
-  free(line_buf);
-  free(lines);
-  free(vkernel);
-  free(hkernel);
-  return ssim/ssimw;
 }
 
 static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
                 unsigned bpc, unsigned w, unsigned h)
 {
+    (void) pix_fmt;
+    (void) bpc;
+
+    SsimState *s = fex->priv;
+
+    s->scale = MIN(w, h) / 256.f + 0.5f;
+    if (!s->scale) s->scale = 1;
+    s->w = s->scale > 1 ? w / s->scale + (w & 1) : w;
+    s->h = s->scale > 1 ? h / s->scale + (h & 1) : h;
+    if (s->w < SSIM_WINDOW || s->h < SSIM_WINDOW) return -EINVAL;
+
+    s->stride = ALIGN_CEIL(s->w * sizeof(uint16_t)) / sizeof(uint16_t);
+    const size_t plane_sz = s->stride * s->h * sizeof(uint16_t);
+    const size_t row_sz = ALIGN_CEIL(s->w * sizeof(uint32_t));
+
+    s->ref = aligned_malloc(plane_sz, 32);
+    if (!s->ref) goto fail;
+    s->dis = aligned_malloc(plane_sz, 32);
+    if (!s->dis) goto fail;
+    uint32_t *rows = aligned_malloc(row_sz * 6, 32);
+    if (!rows) goto fail;
+    s->m.mu_x = rows;
+    s->m.mu_y = (uint32_t *)((uint8_t *)rows + row_sz * 1);
+    s->m.xx = (uint32_t *)((uint8_t *)rows + row_sz * 2);
+    s->m.yy = (uint32_t *)((uint8_t *)rows + row_sz * 3);
+    s->m.xy = (uint32_t *)((uint8_t *)rows + row_sz * 4);
+    s->acc = (uint32_t *)((uint8_t *)rows + row_sz * 5);
+
+    if (s->scale > 1) {
+        s->col = malloc(sizeof(*s->col) * s->w * s->scale);
+        if (!s->col) goto fail;
+        for (unsigned j = 0; j < s->w; j++) {
+            for (unsigned u = 0; u < s->scale; u++) {
+                const int x = (int)(j * s->scale + u) - (int)s->scale / 2;
+                s->col[j * s->scale + u] = reflect(x, w);
+            }
+        }
+    }
+
+    s->filter_v = ssim_filter_v;
+    s->accumulate_row = ssim_accumulate_row;
+
+#if ARCH_X86
+    unsigned flags = vmaf_get_cpu_flags();
+    if (flags & VMAF_X86_CPU_FLAG_AVX2) {
+        s->filter_v = ssim_filter_v_avx2;
+        s->accumulate_row = ssim_accumulate_row_avx2;
+    }
+#if HAVE_AVX512
+    if (flags & VMAF_X86_CPU_FLAG_AVX512) {
+        s->filter_v = ssim_filter_v_avx512;
+        s->accumulate_row = ssim_accumulate_row_avx512;
+    }
+#endif
+#endif
+
     return 0;
+
+fail:
+    if (s->ref) aligned_free(s->ref);
+    if (s->dis) aligned_free(s->dis);
+    if (s->m.mu_x) aligned_free(s->m.mu_x);
+    return -ENOMEM;
 }
 
 static int extract(VmafFeatureExtractor *fex,
@@ -207,21 +236,34 @@ static int extract(VmafFeatureExtractor *fex,
                    VmafPicture *dist_pic, VmafPicture *dist_pic_90,
                    unsigned index, VmafFeatureCollector *feature_collector)
 {
+    SsimState *s = fex->priv;
+
     (void) ref_pic_90;
     (void) dist_pic_90;
 
-    double score =
-        calc_ssim(ref_pic->data[0], ref_pic->stride[0],
-                  dist_pic->data[0], dist_pic->stride[0], 1.0, ref_pic->bpc,
-                  ref_pic->w[0], ref_pic->h[0]);
-    int err =
-        vmaf_feature_collector_append(feature_collector, "ssim", score, index);
-    if (err) return err;
-    return 0;
+    prepare(s, ref_pic, s->ref);
+    prepare(s, dist_pic, s->dis);
+
+    const unsigned w = s->w - SSIM_WINDOW + 1;
+    const unsigned h = s->h - SSIM_WINDOW + 1;
+    double sum = 0.;
+    for (unsigned i = 0; i < h; i++) {
+        s->filter_v(s->ref + i * s->stride, s->dis + i * s->stride, s->stride,
+                    s->w, &s->m);
+        sum += s->accumulate_row(&s->m, w);
+    }
+
+    return vmaf_feature_collector_append(feature_collector, "ssim",
+                                         sum / ((double)w * h), index);
 }
 
 static int close(VmafFeatureExtractor *fex)
 {
+    SsimState *s = fex->priv;
+    if (s->ref) aligned_free(s->ref);
+    if (s->dis) aligned_free(s->dis);
+    if (s->m.mu_x) aligned_free(s->m.mu_x);
+    if (s->col) free(s->col);
     return 0;
 }
 
@@ -235,5 +277,6 @@ VmafFeatureExtractor vmaf_fex_ssim = {
     .init = init,
     .extract = extract,
     .close = close,
+    .priv_size = sizeof(SsimState),
     .provided_features = provided_features,
 };
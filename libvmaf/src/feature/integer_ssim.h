@@ -0,0 +1,87 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef FEATURE_SSIM_H_
+#define FEATURE_SSIM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Samples are brought to 10 bits before filtering, whatever the input depth,
+ * so that every moment below fits 32-bit lanes.
+ */
+#define SSIM_BPC 10
+#define SSIM_SAMPLE_MAX ((1 << SSIM_BPC) - 1)
+
+/* 11-tap Gaussian (sigma = 1.5) in Q12, the window used by float_ssim */
+#define SSIM_WINDOW 11
+
+static const uint16_t ssim_filter[SSIM_WINDOW] = {
+    4, 31, 148, 448, 872, 1090, 872, 448, 148, 31, 4
+};
+
+/*
+ * The vertical pass rounds its sums down to 19 bits so that the horizontal
+ * pass stays below 2^31: first order moments end up in Q23 and second order
+ * moments in Q15 of the 8-bit sample range.
+ */
+#define SSIM_MU_SHIFT 3
+#define SSIM_SQ_SHIFT 13
+#define SSIM_MU_SCALE (1.f / (1 << 23))
+#define SSIM_SQ_SCALE (1.f / (1 << 15))
+
+/* (K1 * 255)^2 and (K2 * 255)^2 */
+#define SSIM_C1 6.5025f
+#define SSIM_C2 58.5225f
+
+/* Vertically filtered moments of one window row, one entry per column. */
+typedef struct SsimMoments {
+    uint32_t *mu_x, *mu_y;
+    uint32_t *xx, *yy, *xy;
+} SsimMoments;
+
+static inline float ssim_pixel(int32_t mu_x, int32_t mu_y, int32_t xx,
+                               int32_t yy, int32_t xy)
+{
+    const float mx = (float)mu_x * SSIM_MU_SCALE;
+    const float my = (float)mu_y * SSIM_MU_SCALE;
+    const float mxy = mx * my;
+    const float mm = mx * mx + my * my;
+    const float sxx = (float)xx * SSIM_SQ_SCALE - mx * mx;
+    const float syy = (float)yy * SSIM_SQ_SCALE - my * my;
+    const float sxy = (float)xy * SSIM_SQ_SCALE - mxy;
+    const float num = (2.f * mxy + SSIM_C1) * (2.f * sxy + SSIM_C2);
+    const float den = (mm + SSIM_C1) * (sxx + syy + SSIM_C2);
+    return num / den;
+}
+
+/*
+ * Filters SSIM_WINDOW rows of 10-bit samples starting at ref and dis into the
+ * per-column moments m. stride is in samples.
+ */
+void ssim_filter_v(const uint16_t *ref, const uint16_t *dis, ptrdiff_t stride,
+                   unsigned w, SsimMoments *m);
+
+/*
+ * Filters w + SSIM_WINDOW - 1 columns of moments horizontally and returns the
+ * sum of the w resulting SSIM values.
+ */
+double ssim_accumulate_row(const SsimMoments *m, unsigned w);
+
+#endif /* FEATURE_SSIM_H_ */
@@ -18,6 +18,7 @@
 
 #include <errno.h>
 #include <math.h>
+#include <pthread.h>
 #include <string.h>
 #include <stdio.h>
 
@@ -74,25 +75,6 @@ static const VmafOption options[] = {
     { 0 }
 };
 
-static FORCE_INLINE void
-pad_top_and_bottom(VifBuffer buf, unsigned h, int fwidth)
-{
-    const unsigned fwidth_half = fwidth / 2;
-    unsigned char *ref = buf.ref;
-    unsigned char *dis = buf.dis;
-    for (unsigned i = 1; i <= fwidth_half; ++i) {
-        size_t offset = buf.stride * i;
-        memcpy(ref - offset, ref + offset, buf.stride);
-        memcpy(dis - offset, dis + offset, buf.stride);
-        memcpy(ref + buf.stride * (h - 1) + buf.stride * i,
-               ref + buf.stride * (h - 1) - buf.stride * i,
-               buf.stride);
-        memcpy(dis + buf.stride * (h - 1) + buf.stride * i,
-               dis + buf.stride * (h - 1) - buf.stride * i,
-               buf.stride);
-    }
-}
-
 static FORCE_INLINE void
 decimate_and_pad(VifBuffer buf, unsigned w, unsigned h, int scale)
 {
@@ -107,7 +89,10 @@ decimate_and_pad(VifBuffer buf, unsigned w, unsigned h, int scale)
             dis[i * stride + j] = buf.mu2[(i * 2) * mu_stride + (j * 2)];
         }
     }
-    pad_top_and_bottom(buf, h / 2, vif_filter1d_width[scale]);
+    vif_mirror_rows(buf.ref_row, buf.ref, buf.stride, h / 2,
+                    vif_filter1d_width[scale]);
+    vif_mirror_rows(buf.dis_row, buf.dis, buf.stride, h / 2,
+                    vif_filter1d_width[scale]);
 }
 
 static void subsample_rd_8(VifBuffer buf, unsigned w, unsigned h)
@@ -124,10 +109,10 @@ static void subsample_rd_8(VifBuffer buf, unsigned w, unsigned h)
                 int ii = i - fwidth / 2;
                 int ii_check = ii + fi;
                 const uint16_t fcoeff = vif_filt_s1[fi];
-                const uint8_t *ref = (uint8_t*)buf.ref;
-                const uint8_t *dis = (uint8_t*)buf.dis;
-                accum_ref += fcoeff * (uint32_t)ref[ii_check * buf.stride + j];
-                accum_dis += fcoeff * (uint32_t)dis[ii_check * buf.stride + j];
+                const uint8_t *ref = buf.ref_row[ii_check];
+                const uint8_t *dis = buf.dis_row[ii_check];
+                accum_ref += fcoeff * (uint32_t)ref[j];
+                accum_dis += fcoeff * (uint32_t)dis[j];
             }
             buf.tmp.ref_convol[j] = (accum_ref + 128) >> 8;
             buf.tmp.dis_convol[j] = (accum_dis + 128) >> 8;
@@ -178,11 +163,10 @@ static void subsample_rd_16(VifBuffer buf, unsigned w, unsigned h, int scale, in
                 int ii = i - fwidth / 2;
                 int ii_check = ii + fi;
                 const uint16_t fcoeff = vif_filt[fi];
-                const ptrdiff_t stride = buf.stride / sizeof(uint16_t);
-                uint16_t *ref = buf.ref;
-                uint16_t *dis = buf.dis;
-                accum_ref += fcoeff * ((uint32_t)ref[ii_check * stride + j]);
-                accum_dis += fcoeff * ((uint32_t)dis[ii_check * stride + j]);
+                const uint16_t *ref = buf.ref_row[ii_check];
+                const uint16_t *dis = buf.dis_row[ii_check];
+                accum_ref += fcoeff * ((uint32_t)ref[j]);
+                accum_dis += fcoeff * ((uint32_t)dis[j]);
             }
             buf.tmp.ref_convol[j] = (uint16_t)((accum_ref + add_shift_round_VP) >> shift_VP);
             buf.tmp.dis_convol[j] = (uint16_t)((accum_dis + add_shift_round_VP) >> shift_VP);
@@ -212,13 +196,22 @@ static void subsample_rd_16(VifBuffer buf, unsigned w, unsigned h, int scale, in
 #define MIN(x, y) (((x) < (y)) ? (x) : (y))
 #define MAX(x, y) (((x) > (y)) ? (x) : (y))
 
-static inline void log_generate(uint16_t *log2_table)
+static uint16_t log2_lut[65537];
+static pthread_once_t log2_lut_once = PTHREAD_ONCE_INIT;
+
+static void log_generate(void)
 {
     for (unsigned i = 32767; i < 65536; ++i) {
-        log2_table[i] = (uint16_t)round(log2f((float)i) * 2048);
+        log2_lut[i] = (uint16_t)round(log2f((float)i) * 2048);
     }
 }
 
+const uint16_t *vif_log2_table(void)
+{
+    pthread_once(&log2_lut_once, log_generate);
+    return log2_lut;
+}
+
 void vif_statistic_8(struct VifPublicState *s, float *num, float *den, unsigned w, unsigned h) {
     const unsigned fwidth = vif_filter1d_width[0];
     const uint16_t *vif_filt_s0 = vif_filter1d_table[0];
@@ -228,7 +221,7 @@ void vif_statistic_8(struct VifPublicState *s, float *num, float *den, unsigned
     int64_t accum_num_non_log = 0;
     int64_t accum_den_non_log = 0;
     static const int32_t sigma_nsq = 65536 << 1;
-    uint16_t *log2_table = s->log2_table;
+    const uint16_t *log2_table = s->log2_table;
     double vif_enhn_gain_limit = s->vif_enhn_gain_limit;
 
     for (unsigned i = 0; i < h; ++i) {
@@ -243,10 +236,10 @@ void vif_statistic_8(struct VifPublicState *s, float *num, float *den, unsigned
                 int ii = i - fwidth / 2;
                 int ii_check = ii + fi;
                 const uint16_t fcoeff = vif_filt_s0[fi];
-                const uint8_t *ref = (uint8_t*)buf.ref;
-                const uint8_t *dis = (uint8_t*)buf.dis;
-                uint16_t imgcoeff_ref = ref[ii_check * buf.stride + j];
-                uint16_t imgcoeff_dis = dis[ii_check * buf.stride + j];
+                const uint8_t *ref = buf.ref_row[ii_check];
+                const uint8_t *dis = buf.dis_row[ii_check];
+                uint16_t imgcoeff_ref = ref[j];
+                uint16_t imgcoeff_dis = dis[j];
                 uint32_t img_coeff_ref = fcoeff * (uint32_t)imgcoeff_ref;
                 uint32_t img_coeff_dis = fcoeff * (uint32_t)imgcoeff_dis;
                 accum_mu1 += img_coeff_ref;
@@ -351,7 +344,7 @@ void vif_statistic_16(struct VifPublicState *s, float *num, float *den, unsigned
     int64_t accum_num_non_log = 0;
     int64_t accum_den_non_log = 0;
     static const int32_t sigma_nsq = 65536 << 1;
-    uint16_t *log2_table = s->log2_table;
+    const uint16_t *log2_table = s->log2_table;
     double vif_enhn_gain_limit = s->vif_enhn_gain_limit;
     int32_t add_shift_round_HP, shift_HP;
     int32_t add_shift_round_VP, shift_VP;
@@ -385,11 +378,10 @@ void vif_statistic_16(struct VifPublicState *s, float *num, float *den, unsigned
                 int ii = i - fwidth / 2;
                 int ii_check = ii + fi;
                 const uint16_t fcoeff = vif_filt[fi];
-                const ptrdiff_t stride = buf.stride / sizeof(uint16_t);
-                uint16_t *ref = buf.ref;
-                uint16_t *dis = buf.dis;
-                uint16_t imgcoeff_ref = ref[ii_check * stride + j];
-                uint16_t imgcoeff_dis = dis[ii_check * stride + j];
+                const uint16_t *ref = buf.ref_row[ii_check];
+                const uint16_t *dis = buf.dis_row[ii_check];
+                uint16_t imgcoeff_ref = ref[j];
+                uint16_t imgcoeff_dis = dis[j];
                 uint32_t img_coeff_ref = fcoeff * (uint32_t)imgcoeff_ref;
                 uint32_t img_coeff_dis = fcoeff * (uint32_t)imgcoeff_dis;
                 accum_mu1 += img_coeff_ref;
@@ -611,7 +603,7 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
     }
 #endif
 
-    log_generate(s->public.log2_table);
+    s->public.log2_table = vif_log2_table();
 
     (void)pix_fmt;
     const bool hbd = bpc > 8;
@@ -621,18 +613,24 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
     s->public.buf.stride_32 = ALIGN_CEIL(w * sizeof(uint32_t));
     s->public.buf.stride_tmp =
         ALIGN_CEIL((MAX_ALIGN + w + MAX_ALIGN) * sizeof(uint32_t));
-    const size_t frame_size = s->public.buf.stride * h;
-    const size_t pad_size = s->public.buf.stride * 8;
+    // scale 0 is read straight from the pictures, only the decimated
+    // scales are stored here
+    const size_t frame_size = s->public.buf.stride * (h / 2);
+    const unsigned row_pad = vif_filter1d_width[0] / 2;
+    const size_t rows_size =
+        ALIGN_CEIL((row_pad + h + row_pad) * sizeof(*s->public.buf.ref_row));
     const size_t data_sz =
-        2 * (pad_size + frame_size + pad_size) + 2 * (h * s->public.buf.stride_16) +
+        2 * frame_size + 2 * rows_size + 2 * (h * s->public.buf.stride_16) +
         5 * (s->public.buf.stride_32) + 7 * s->public.buf.stride_tmp;
     void *data = aligned_malloc(data_sz, MAX_ALIGN);
     if (!data) return -ENOMEM;
     memset(data, 0, data_sz);
 
-    s->public.buf.data = data; data += pad_size;
-    s->public.buf.ref = data; data += frame_size + pad_size + pad_size;
-    s->public.buf.dis = data; data += frame_size + pad_size;
+    s->public.buf.data = data;
+    s->public.buf.ref = data; data += frame_size;
+    s->public.buf.dis = data; data += frame_size;
+    s->public.buf.ref_row = (const void **)data + row_pad; data += rows_size;
+    s->public.buf.dis_row = (const void **)data + row_pad; data += rows_size;
     s->public.buf.mu1 = data; data += h * s->public.buf.stride_16;
     s->public.buf.mu2 = data; data += h * s->public.buf.stride_16;
     s->public.buf.mu1_32 = data; data += s->public.buf.stride_32;
@@ -759,20 +757,10 @@ static int extract(VmafFeatureExtractor *fex,
     unsigned w = ref_pic->w[0];
     unsigned h = dist_pic->h[0];
 
-    unsigned char *ref_in = ref_pic->data[0];
-    unsigned char *dis_in = dist_pic->data[0];
-    unsigned char *ref_out = s->public.buf.ref;
-    unsigned char *dis_out = s->public.buf.dis;
-
-    for (unsigned i = 0; i < h; i++) {
-        memcpy(ref_out, ref_in, ref_pic->stride[0]);
-        memcpy(dis_out, dis_in, dist_pic->stride[0]);
-        ref_in += ref_pic->stride[0];
-        dis_in += dist_pic->stride[0];
-        ref_out += s->public.buf.stride;
-        dis_out += s->public.buf.stride;
-    }
-    pad_top_and_bottom(s->public.buf, h, vif_filter1d_width[0]);
+    vif_mirror_rows(s->public.buf.ref_row, ref_pic->data[0],
+                    ref_pic->stride[0], h, vif_filter1d_width[0]);
+    vif_mirror_rows(s->public.buf.dis_row, dist_pic->data[0],
+                    dist_pic->stride[0], h, vif_filter1d_width[0]);
 
     VifScore vif_score;
     for (unsigned scale = 0; scale < 4; ++scale) {
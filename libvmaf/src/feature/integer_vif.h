@@ -42,6 +42,8 @@ typedef struct VifBuffer {
 
     void *ref;
     void *dis;
+    const void **ref_row;
+    const void **dis_row;
     uint16_t *mu1;
     uint16_t *mu2;
     uint32_t *mu1_32;
@@ -75,10 +77,29 @@ typedef struct VifResiduals {
 
 typedef struct VifPublicState {
     VifBuffer buf;
-    uint16_t log2_table[65537];
+    const uint16_t *log2_table;
     double vif_enhn_gain_limit;
 } VifPublicState;
 
+/*
+ * Point row[i] at every row the vertical filters may read for an h-row
+ * plane, i = -fwidth / 2 .. h + fwidth / 2 - 1. Rows outside the plane are
+ * mirrored about the first and last row, so the filters can read the
+ * caller's picture in place instead of a copy padded at top and bottom.
+ */
+static inline void vif_mirror_rows(const void **row, const void *data,
+                                   ptrdiff_t stride, unsigned h, int fwidth)
+{
+    const int fwidth_half = fwidth / 2;
+    const int last = (int)h - 1;
+    for (int i = -fwidth_half; i <= last + fwidth_half; ++i) {
+        int ii = i < 0 ? -i : i;
+        if (ii > last) ii = 2 * last - ii;
+        if (ii < 0) ii = 0;
+        row[i] = (const uint8_t *)data + ii * stride;
+    }
+}
+
 static inline void PADDING_SQ_DATA(VifBuffer buf, int w, unsigned fwidth_half)
 {
     for (unsigned f = 1; f <= fwidth_half; ++f) {
@@ -115,6 +136,12 @@ static inline void PADDING_SQ_DATA_2(VifBuffer buf, int w, unsigned fwidth_half)
     }
 }
 
+/*
+ * log2(i) * 2048 for i = 32767 .. 65535. The table is generated once per
+ * process on first use and shared read-only by every vif context.
+ */
+const uint16_t *vif_log2_table(void);
+
 void vif_statistic_8(struct VifPublicState *s, float *num, float *den, unsigned w, unsigned h);
 void vif_statistic_16(struct VifPublicState *s, float *num, float *den, unsigned w, unsigned h, int bpc, int scale);
 
@@ -71,3 +71,43 @@ int compute_2nd_moment(const float *pic, int w, int h, int stride, double *score
 
     return 0;
 }
+
+void moment_sums_8(const uint8_t *pic, ptrdiff_t stride, unsigned w,
+                   unsigned h, uint64_t *sum, uint64_t *sum_sq)
+{
+    uint64_t s = 0, sq = 0;
+
+    for (unsigned i = 0; i < h; ++i)
+    {
+        for (unsigned j = 0; j < w; ++j)
+        {
+            const uint32_t x = pic[j];
+            s += x;
+            sq += x * x;
+        }
+        pic += stride;
+    }
+
+    *sum = s;
+    *sum_sq = sq;
+}
+
+void moment_sums_16(const uint16_t *pic, ptrdiff_t stride, unsigned w,
+                    unsigned h, uint64_t *sum, uint64_t *sum_sq)
+{
+    uint64_t s = 0, sq = 0;
+
+    for (unsigned i = 0; i < h; ++i)
+    {
+        for (unsigned j = 0; j < w; ++j)
+        {
+            const uint32_t x = pic[j];
+            s += x;
+            sq += x * x;
+        }
+        pic += stride / sizeof(uint16_t);
+    }
+
+    *sum = s;
+    *sum_sq = sq;
+}
@@ -18,3 +18,18 @@
 
 int compute_1st_moment(const float *pic, int w, int h, int stride, double *score);
 int compute_2nd_moment(const float *pic, int w, int h, int stride, double *score);
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Sums of the samples of a plane and of their squares, for up to 12-bit
+ * samples. These are exact, so for such pictures float_moment gets the
+ * moments of the float planes without converting to float.
+ * Strides are in bytes.
+ */
+void moment_sums_8(const uint8_t *pic, ptrdiff_t stride, unsigned w,
+                   unsigned h, uint64_t *sum, uint64_t *sum_sq);
+
+void moment_sums_16(const uint16_t *pic, ptrdiff_t stride, unsigned w,
+                    unsigned h, uint64_t *sum, uint64_t *sum_sq);
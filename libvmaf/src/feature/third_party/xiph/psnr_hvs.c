@@ -31,10 +31,15 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdint.h>
 #include <string.h>
 
+#include "cpu.h"
 #include "feature_collector.h"
 #include "feature_extractor.h"
 #include "log.h"
 
+#if ARCH_X86
+#include "x86/psnr_hvs_avx2.h"
+#endif
+
 typedef int32_t od_coeff;
 
 #define OD_DCT_OVERFLOW_CHECK(val, scale, offset, idx)
@@ -200,14 +205,123 @@ static float csf_cr420[8][8] = {
     {0.593906509971, 0.802254508198, 0.706020324706, 0.587716619023, 0.478717061273, 0.393021669543, 0.330555063063, 0.285345396658}
 };
 
+typedef void (*psnr_hvs_block_fn)(const unsigned char *src, int src_stride,
+                                  const unsigned char *dst, int dst_stride,
+                                  int depth, const float csf[8][8],
+                                  const float mask[8][8], float *ret);
+
+typedef struct PsnrHvsState {
+    psnr_hvs_block_fn block;
+} PsnrHvsState;
+
+/*
+ Adds the masked, CSF weighted DCT error of the 8x8 block at _src/_dst to *_ret.
+*/
+static void psnr_hvs_block(const unsigned char *_src, int _systride,
+                           const unsigned char *_dst, int _dystride,
+                           int depth, const float _csf[8][8],
+                           const float mask[8][8], float *_ret)
+{
+    od_coeff dct_s[8 * 8];
+    od_coeff dct_d[8 * 8];
+    float ret = *_ret;
+    int i;
+    int j;
+    float s_means[4];
+    float d_means[4];
+    float s_vars[4];
+    float d_vars[4];
+    float s_gmean = 0;
+    float d_gmean = 0;
+    float s_gvar = 0;
+    float d_gvar = 0;
+    float s_mask = 0;
+    float d_mask = 0;
+    for (i = 0; i < 4; i++)
+        s_means[i] = d_means[i] = s_vars[i] = d_vars[i] = 0;
+    for (i = 0; i < 8; i++) {
+        for (j = 0; j < 8; j++) {
+            int sub = ((i & 12) >> 2) + ((j & 12) >> 1);
+            if (depth > 8) {
+                dct_s[i * 8 + j] =
+                    _src[i * _systride + j * 2] +
+                    (_src[i * _systride + j * 2 + 1] << 8);
+                dct_d[i * 8 + j] =
+                    _dst[i * _dystride + j * 2] +
+                    (_dst[i * _dystride + j * 2 + 1] << 8);
+            } else {
+                dct_s[i * 8 + j] = _src[i * _systride + j];
+                dct_d[i * 8 + j] = _dst[i * _dystride + j];
+            }
+            s_gmean += dct_s[i * 8 + j];
+            d_gmean += dct_d[i * 8 + j];
+            s_means[sub] += dct_s[i * 8 + j];
+            d_means[sub] += dct_d[i * 8 + j];
+        }
+    }
+    s_gmean /= 64.f;
+    d_gmean /= 64.f;
+    for (i = 0; i < 4; i++)
+        s_means[i] /= 16.f;
+    for (i = 0; i < 4; i++)
+        d_means[i] /= 16.f;
+    for (i = 0; i < 8; i++) {
+        for (j = 0; j < 8; j++) {
+            int sub = ((i & 12) >> 2) + ((j & 12) >> 1);
+            s_gvar += (dct_s[i * 8 + j] - s_gmean) *
+                      (dct_s[i * 8 + j] - s_gmean);
+            d_gvar += (dct_d[i * 8 + j] - d_gmean) *
+                      (dct_d[i * 8 + j] - d_gmean);
+            s_vars[sub] += (dct_s[i * 8 + j] - s_means[sub]) *
+                           (dct_s[i * 8 + j] - s_means[sub]);
+            d_vars[sub] += (dct_d[i * 8 + j] - d_means[sub]) *
+                           (dct_d[i * 8 + j] - d_means[sub]);
+        }
+    }
+    s_gvar *= 1 / 63.f * 64;
+    d_gvar *= 1 / 63.f * 64;
+    for (i = 0; i < 4; i++)
+        s_vars[i] *= 1 / 15.f * 16;
+    for (i = 0; i < 4; i++)
+        d_vars[i] *= 1 / 15.f * 16;
+    if (s_gvar > 0)
+        s_gvar =
+            (s_vars[0] + s_vars[1] + s_vars[2] + s_vars[3]) / s_gvar;
+    if (d_gvar > 0)
+        d_gvar =
+            (d_vars[0] + d_vars[1] + d_vars[2] + d_vars[3]) / d_gvar;
+    od_bin_fdct8x8(dct_s, 8, dct_s, 8);
+    od_bin_fdct8x8(dct_d, 8, dct_d, 8);
+    for (i = 0; i < 8; i++)
+        for (j = (i == 0); j < 8; j++)
+            s_mask += dct_s[i * 8 + j] * dct_s[i * 8 + j] * mask[i][j];
+    for (i = 0; i < 8; i++)
+        for (j = (i == 0); j < 8; j++)
+            d_mask += dct_d[i * 8 + j] * dct_d[i * 8 + j] * mask[i][j];
+    s_mask = sqrt(s_mask * s_gvar) / 32.f;
+    d_mask = sqrt(d_mask * d_gvar) / 32.f;
+    if (d_mask > s_mask)
+        s_mask = d_mask;
+    for (i = 0; i < 8; i++) {
+        for (j = 0; j < 8; j++) {
+            float err;
+            err = abs(dct_s[i * 8 + j] - dct_d[i * 8 + j]);
+            if (i != 0 || j != 0)
+                err = err < s_mask / mask[i][j]
+                          ? 0
+                          : err - s_mask / mask[i][j];
+            ret += (err * _csf[i][j]) * (err * _csf[i][j]);
+        }
+    }
+    *_ret = ret;
+}
+
 static double calc_psnrhvs(const unsigned char *_src, int _systride,
                            const unsigned char *_dst, int _dystride,
                            double _par, int depth, int _w, int _h, int _step,
-                           float _csf[8][8])
+                           float _csf[8][8], psnr_hvs_block_fn block)
 {
     float ret;
-    od_coeff dct_s[8 * 8];
-    od_coeff dct_d[8 * 8];
     float mask[8][8];
     int pixels;
     int x;
@@ -240,95 +354,11 @@ static double calc_psnrhvs(const unsigned char *_src, int _systride,
 
     for (y = 0; y < _h - 7; y += _step) {
         for (x = 0; x < _w - 7; x += _step) {
-            int i;
-            int j;
-            float s_means[4];
-            float d_means[4];
-            float s_vars[4];
-            float d_vars[4];
-            float s_gmean = 0;
-            float d_gmean = 0;
-            float s_gvar = 0;
-            float d_gvar = 0;
-            float s_mask = 0;
-            float d_mask = 0;
-            for (i = 0; i < 4; i++)
-                s_means[i] = d_means[i] = s_vars[i] = d_vars[i] = 0;
-            for (i = 0; i < 8; i++) {
-                for (j = 0; j < 8; j++) {
-                    int sub = ((i & 12) >> 2) + ((j & 12) >> 1);
-                    if (depth > 8) {
-                        dct_s[i * 8 + j] =
-                            _src[(y + i) * _systride + (j + x) * 2] +
-                            (_src[(y + i) * _systride + (j + x) * 2 + 1] << 8);
-                        dct_d[i * 8 + j] =
-                            _dst[(y + i) * _dystride + (j + x) * 2] +
-                            (_dst[(y + i) * _dystride + (j + x) * 2 + 1] << 8);
-                    } else {
-                        dct_s[i * 8 + j] = _src[(y + i) * _systride + (j + x)];
-                        dct_d[i * 8 + j] = _dst[(y + i) * _dystride + (j + x)];
-                    }
-                    s_gmean += dct_s[i * 8 + j];
-                    d_gmean += dct_d[i * 8 + j];
-                    s_means[sub] += dct_s[i * 8 + j];
-                    d_means[sub] += dct_d[i * 8 + j];
-                }
-            }
-            s_gmean /= 64.f;
-            d_gmean /= 64.f;
-            for (i = 0; i < 4; i++)
-                s_means[i] /= 16.f;
-            for (i = 0; i < 4; i++)
-                d_means[i] /= 16.f;
-            for (i = 0; i < 8; i++) {
-                for (j = 0; j < 8; j++) {
-                    int sub = ((i & 12) >> 2) + ((j & 12) >> 1);
-                    s_gvar += (dct_s[i * 8 + j] - s_gmean) *
-                              (dct_s[i * 8 + j] - s_gmean);
-                    d_gvar += (dct_d[i * 8 + j] - d_gmean) *
-                              (dct_d[i * 8 + j] - d_gmean);
-                    s_vars[sub] += (dct_s[i * 8 + j] - s_means[sub]) *
-                                   (dct_s[i * 8 + j] - s_means[sub]);
-                    d_vars[sub] += (dct_d[i * 8 + j] - d_means[sub]) *
-                                   (dct_d[i * 8 + j] - d_means[sub]);
-                }
-            }
-            s_gvar *= 1 / 63.f * 64;
-            d_gvar *= 1 / 63.f * 64;
-            for (i = 0; i < 4; i++)
-                s_vars[i] *= 1 / 15.f * 16;
-            for (i = 0; i < 4; i++)
-                d_vars[i] *= 1 / 15.f * 16;
-            if (s_gvar > 0)
-                s_gvar =
-                    (s_vars[0] + s_vars[1] + s_vars[2] + s_vars[3]) / s_gvar;
-            if (d_gvar > 0)
-                d_gvar =
-                    (d_vars[0] + d_vars[1] + d_vars[2] + d_vars[3]) / d_gvar;
-            od_bin_fdct8x8(dct_s, 8, dct_s, 8);
-            od_bin_fdct8x8(dct_d, 8, dct_d, 8);
-            for (i = 0; i < 8; i++)
-                for (j = (i == 0); j < 8; j++)
-                    s_mask += dct_s[i * 8 + j] * dct_s[i * 8 + j] * mask[i][j];
-            for (i = 0; i < 8; i++)
-                for (j = (i == 0); j < 8; j++)
-                    d_mask += dct_d[i * 8 + j] * dct_d[i * 8 + j] * mask[i][j];
-            s_mask = sqrt(s_mask * s_gvar) / 32.f;
-            d_mask = sqrt(d_mask * d_gvar) / 32.f;
-            if (d_mask > s_mask)
-                s_mask = d_mask;
-            for (i = 0; i < 8; i++) {
-                for (j = 0; j < 8; j++) {
-                    float err;
-                    err = abs(dct_s[i * 8 + j] - dct_d[i * 8 + j]);
-                    if (i != 0 || j != 0)
-                        err = err < s_mask / mask[i][j]
-                                  ? 0
-                                  : err - s_mask / mask[i][j];
-                    ret += (err * _csf[i][j]) * (err * _csf[i][j]);
-                    pixels++;
-                }
-            }
+            const int bytes = depth > 8 ? 2 : 1;
+            block(_src + y * _systride + x * bytes, _systride,
+                  _dst + y * _dystride + x * bytes, _dystride, depth,
+                  (const float (*)[8])_csf, (const float (*)[8])mask, &ret);
+            pixels += 64;
         }
     }
     ret /= pixels;
@@ -345,11 +375,11 @@ static double convert_score_db(double _score, double _weight)
 static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
                 unsigned bpc, unsigned w, unsigned h)
 {
-    (void) fex;
-    (void) bpc;
     (void) w;
     (void) h;
 
+    PsnrHvsState *s = fex->priv;
+
     if (bpc > 12) {
         vmaf_log(VMAF_LOG_LEVEL_ERROR,
                  "%s: invalid bitdepth (%d), "
@@ -360,8 +390,14 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
 
     if (pix_fmt == VMAF_PIX_FMT_YUV400P)
         return -EINVAL;
-    else
-        return 0;
+
+    s->block = psnr_hvs_block;
+#if ARCH_X86
+    if (vmaf_get_cpu_flags() & VMAF_X86_CPU_FLAG_AVX2)
+        s->block = psnr_hvs_block_avx2;
+#endif
+
+    return 0;
 }
 
 static int extract(VmafFeatureExtractor *fex, VmafPicture *ref_pic,
@@ -369,6 +405,7 @@ static int extract(VmafFeatureExtractor *fex, VmafPicture *ref_pic,
                    VmafPicture *dist_pic_90, unsigned index,
                    VmafFeatureCollector *feature_collector)
 {
+    PsnrHvsState *s = fex->priv;
     int err = 0;
 
     (void)ref_pic_90;
@@ -380,7 +417,8 @@ static int extract(VmafFeatureExtractor *fex, VmafPicture *ref_pic,
             calc_psnrhvs(ref_pic->data[i], ref_pic->stride[i],
                          dist_pic->data[i], dist_pic->stride[i], 1.0,
                          ref_pic->bpc, ref_pic->w[i], ref_pic->h[i], 7,
-                         i == 0 ? csf_y : i == 1 ? csf_cb420 : csf_cr420);
+                         i == 0 ? csf_y : i == 1 ? csf_cb420 : csf_cr420,
+                         s->block);
 
         err |= vmaf_feature_collector_append(feature_collector,
                                              fex->provided_features[i],
@@ -404,5 +442,7 @@ VmafFeatureExtractor vmaf_fex_psnr_hvs = {
     .name = "psnr_hvs",
     .init = init,
     .extract = extract,
+    .priv_size = sizeof(PsnrHvsState),
     .provided_features = provided_features,
+    .flags = VMAF_FEATURE_EXTRACTOR_CHROMA,
 };
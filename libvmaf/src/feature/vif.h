@@ -16,6 +16,34 @@
  *
  */
 
+#pragma once
+
+#ifndef VIF_H_
+#define VIF_H_
+
+#include <stddef.h>
+
+/* Scratch planes and rows of compute_vif_with_buffer(), kept across frames. */
+typedef struct VifFloatBuffer {
+    void *data;
+    float *ref[2];
+    float *dis[2];
+    int stride[2];
+    float *tmp;
+    int w, h;
+} VifFloatBuffer;
+
+int vif_float_buffer_init(VifFloatBuffer *buf, int w, int h);
+
+void vif_float_buffer_free(VifFloatBuffer *buf);
+
+/* compute_vif() on a buffer allocated for pictures of at most w x h */
+int compute_vif_with_buffer(const float *ref, const float *dis, int w, int h, int ref_stride, int dis_stride,
+        double *score, double *score_num, double *score_den, double *scores,
+        double vif_enhn_gain_limit, double vif_kernelscale, VifFloatBuffer *buf);
+
 int compute_vif(const float *ref, const float *dis, int w, int h, int ref_stride, int dis_stride,
         double *score, double *score_num, double *score_den, double *scores,
         double vif_enhn_gain_limit, double vif_kernelscale);
+
+#endif /* VIF_H_ */
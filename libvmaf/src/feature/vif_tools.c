@@ -26,9 +26,14 @@
 #include "cpu.h"
 #include "mem.h"
 #include "common/convolution.h"
+#include "common/macros.h"
 #include "vif_options.h"
 #include "vif_tools.h"
 
+#if ARCH_X86
+#include "x86/float_vif_avx2.h"
+#endif
+
 #define MIN(x, y) (((x) < (y)) ? (x) : (y))
 #define MAX(x, y) (((x) > (y)) ? (x) : (y))
 
@@ -271,116 +276,134 @@ float vif_sum_s(const float *x, int w, int h, int stride)
     return accum;
 }
 
-void vif_statistic_s(const float *mu1, const float *mu2, const float *xx_filt, const float *yy_filt, const float *xy_filt, float *num, float *den,
-    int w, int h, int mu1_stride, int mu2_stride, int xx_filt_stride, int yy_filt_stride, int xy_filt_stride,
-    double vif_enhn_gain_limit)
+/*
+ * VIF statistic of one row, accumulated over the row in the order of
+ * vif_statistic_s(), so that callers summing the rows get the same result.
+ */
+static void vif_statistic_row_s(const float *mu1, const float *mu2, const float *xx_filt, const float *yy_filt, const float *xy_filt,
+    int w, float vif_enhn_gain_limit_f, float *num, float *den)
 {
     static const float sigma_nsq = 2;
     static const float sigma_max_inv = 4.0 / (255.0*255.0);
 
-    int mu1_px_stride = mu1_stride / sizeof(float);
-    int mu2_px_stride = mu2_stride / sizeof(float);
-    int xx_filt_px_stride = xx_filt_stride / sizeof(float);
-    int yy_filt_px_stride = yy_filt_stride / sizeof(float);
-    int xy_filt_px_stride = xy_filt_stride / sizeof(float);
-
     float mu1_sq_val, mu2_sq_val, mu1_mu2_val, xx_filt_val, yy_filt_val, xy_filt_val;
     float sigma1_sq, sigma2_sq, sigma12;
     float num_val, den_val;
-    int i, j;
+    int j;
 
     /* ==== vif_stat_mode = 'matching_c' ==== */
     // float num_log_den, num_log_num;
     /* ==== vif_stat_mode = 'matching_matlab' ==== */
     float g, sv_sq, eps = 1.0e-10f;
-    float vif_enhn_gain_limit_f = (float) vif_enhn_gain_limit;
     /* == end of vif_stat_mode = 'matching_matlab' == */
 
-    float accum_num = 0.0f;
-    float accum_den = 0.0f;
-
-    for (i = 0; i < h; ++i) {
-        float accum_inner_num = 0;
-        float accum_inner_den = 0;
-        for (j = 0; j < w; ++j) {
-            float mu1_val = mu1[i * mu1_px_stride + j];
-            float mu2_val = mu2[i * mu2_px_stride + j];
-            mu1_sq_val = mu1_val * mu1_val; // same name as the Matlab code vifp_mscale.m
-            mu2_sq_val = mu2_val * mu2_val;
-            mu1_mu2_val = mu1_val * mu2_val; //mu1_mu2[i * mu1_mu2_px_stride + j];
-            xx_filt_val = xx_filt[i * xx_filt_px_stride + j];
-            yy_filt_val = yy_filt[i * yy_filt_px_stride + j];
-            xy_filt_val = xy_filt[i * xy_filt_px_stride + j];
-
-            sigma1_sq = xx_filt_val - mu1_sq_val;
-            sigma2_sq = yy_filt_val - mu2_sq_val;
-            sigma12 = xy_filt_val - mu1_mu2_val;
-
-            /* ==== vif_stat_mode = 'matching_c' ==== */
-
-            /* if (sigma1_sq < sigma_nsq) {
-                num_val = 1.0 - sigma2_sq * sigma_max_inv;
-                den_val = 1.0;
+    float accum_inner_num = 0;
+    float accum_inner_den = 0;
+    for (j = 0; j < w; ++j) {
+        float mu1_val = mu1[j];
+        float mu2_val = mu2[j];
+        mu1_sq_val = mu1_val * mu1_val; // same name as the Matlab code vifp_mscale.m
+        mu2_sq_val = mu2_val * mu2_val;
+        mu1_mu2_val = mu1_val * mu2_val; //mu1_mu2[i * mu1_mu2_px_stride + j];
+        xx_filt_val = xx_filt[j];
+        yy_filt_val = yy_filt[j];
+        xy_filt_val = xy_filt[j];
+
+        sigma1_sq = xx_filt_val - mu1_sq_val;
+        sigma2_sq = yy_filt_val - mu2_sq_val;
+        sigma12 = xy_filt_val - mu1_mu2_val;
+
+        /* ==== vif_stat_mode = 'matching_c' ==== */
+
+        /* if (sigma1_sq < sigma_nsq) {
+            num_val = 1.0 - sigma2_sq * sigma_max_inv;
+            den_val = 1.0;
+        }
+        else {
+            num_log_num = (sigma2_sq + sigma_nsq) * sigma1_sq;
+            if (sigma12 < 0)
+            {
+                num_val = 0.0;
             }
-            else {
-                num_log_num = (sigma2_sq + sigma_nsq) * sigma1_sq;
-                if (sigma12 < 0)
-                {
-                    num_val = 0.0;
-                }
-                else
-                {
-                    num_log_den = num_log_num - sigma12 * sigma12;
-                    num_val = log2f(num_log_num / num_log_den);
-                }
-                den_val = log2f(1.0f + sigma1_sq / sigma_nsq);
-            } */
-
-            /* ==== vif_stat_mode = 'matching_matlab' ==== */
-
-            sigma1_sq = MAX(sigma1_sq, 0.0f);
-            sigma2_sq = MAX(sigma2_sq, 0.0f);
-
-            g = sigma12 / (sigma1_sq + eps);
-            sv_sq = sigma2_sq - g * sigma12;
-
-            if (sigma1_sq < eps) {
-                g = 0.0f;
-                sv_sq = sigma2_sq;
-                sigma1_sq = 0.0f;
+            else
+            {
+                num_log_den = num_log_num - sigma12 * sigma12;
+                num_val = log2f(num_log_num / num_log_den);
             }
+            den_val = log2f(1.0f + sigma1_sq / sigma_nsq);
+        } */
 
-            if (sigma2_sq < eps) {
-                g = 0.0f;
-                sv_sq = 0.0f;
-            }
+        /* ==== vif_stat_mode = 'matching_matlab' ==== */
 
-            if (g < 0.0f) {
-                sv_sq = sigma2_sq;
-                g = 0.0f;
-            }
-            sv_sq = MAX(sv_sq, eps);
+        sigma1_sq = MAX(sigma1_sq, 0.0f);
+        sigma2_sq = MAX(sigma2_sq, 0.0f);
 
-            g = MIN(g, vif_enhn_gain_limit_f);
+        g = sigma12 / (sigma1_sq + eps);
+        sv_sq = sigma2_sq - g * sigma12;
 
-            num_val = log2f(1.0f + (g * g * sigma1_sq) / (sv_sq + sigma_nsq));
-            den_val = log2f(1.0f + (sigma1_sq) / (sigma_nsq));
+        if (sigma1_sq < eps) {
+            g = 0.0f;
+            sv_sq = sigma2_sq;
+            sigma1_sq = 0.0f;
+        }
 
-            if (sigma12 < 0.0f) {
-                num_val = 0.0f;
-            }
+        if (sigma2_sq < eps) {
+            g = 0.0f;
+            sv_sq = 0.0f;
+        }
 
-            if (sigma1_sq < sigma_nsq) {
-                num_val = 1.0f - sigma2_sq * sigma_max_inv;
-                den_val = 1.0f;
-            }
+        if (g < 0.0f) {
+            sv_sq = sigma2_sq;
+            g = 0.0f;
+        }
+        sv_sq = MAX(sv_sq, eps);
+
+        g = MIN(g, vif_enhn_gain_limit_f);
+
+        num_val = log2f(1.0f + (g * g * sigma1_sq) / (sv_sq + sigma_nsq));
+        den_val = log2f(1.0f + (sigma1_sq) / (sigma_nsq));
 
-            /* == end of vif_stat_mode = 'matching_matlab' == */
+        if (sigma12 < 0.0f) {
+            num_val = 0.0f;
+        }
 
-            accum_inner_num += num_val;
-            accum_inner_den += den_val;
+        if (sigma1_sq < sigma_nsq) {
+            num_val = 1.0f - sigma2_sq * sigma_max_inv;
+            den_val = 1.0f;
         }
 
+        /* == end of vif_stat_mode = 'matching_matlab' == */
+
+        accum_inner_num += num_val;
+        accum_inner_den += den_val;
+    }
+
+    *num = accum_inner_num;
+    *den = accum_inner_den;
+}
+
+void vif_statistic_s(const float *mu1, const float *mu2, const float *xx_filt, const float *yy_filt, const float *xy_filt, float *num, float *den,
+    int w, int h, int mu1_stride, int mu2_stride, int xx_filt_stride, int yy_filt_stride, int xy_filt_stride,
+    double vif_enhn_gain_limit)
+{
+    int mu1_px_stride = mu1_stride / sizeof(float);
+    int mu2_px_stride = mu2_stride / sizeof(float);
+    int xx_filt_px_stride = xx_filt_stride / sizeof(float);
+    int yy_filt_px_stride = yy_filt_stride / sizeof(float);
+    int xy_filt_px_stride = xy_filt_stride / sizeof(float);
+
+    float vif_enhn_gain_limit_f = (float) vif_enhn_gain_limit;
+
+    float accum_num = 0.0f;
+    float accum_den = 0.0f;
+
+    for (int i = 0; i < h; ++i) {
+        float accum_inner_num, accum_inner_den;
+        vif_statistic_row_s(mu1 + i * mu1_px_stride, mu2 + i * mu2_px_stride,
+                            xx_filt + i * xx_filt_px_stride, yy_filt + i * yy_filt_px_stride,
+                            xy_filt + i * xy_filt_px_stride, w, vif_enhn_gain_limit_f,
+                            &accum_inner_num, &accum_inner_den);
+
         accum_num += accum_inner_num;
         accum_den += accum_inner_den;
     }
@@ -587,3 +610,187 @@ void vif_filter1d_xy_s(const float *f, const float *src1, const float *src2, flo
 
     aligned_free(tmp);
 }
+
+static inline int vif_mirror_s(int i, int n)
+{
+    i = i < 0 ? -i : (i >= n ? 2 * n - i - 1 : i);
+    return i < 0 ? 0 : (i >= n ? n - 1 : i);
+}
+
+/*
+ * Mirror the fwidth / 2 samples beyond both ends of a row, the way the
+ * filters above mirror their taps, so the horizontal pass needs no checks.
+ */
+static void vif_pad_row_s(float *row, int w, int fwidth)
+{
+    for (int k = 1; k <= fwidth / 2; ++k) {
+        row[-k] = row[vif_mirror_s(-k, w)];
+        row[w - 1 + k] = row[vif_mirror_s(w - 1 + k, w)];
+    }
+}
+
+/*
+ * The fused passes below compute columns j_start..w - 1. Every sum is
+ * accumulated tap by tap in the order of the filters above, which the AVX2
+ * versions keep as well.
+ */
+static void vif_filter1d_h_s(const float *f, int fwidth, const float *RESTRICT src, float *RESTRICT dst, int j_start, int w)
+{
+    src -= fwidth / 2;
+
+    for (int j = j_start; j < w; ++j)
+        dst[j] = 0;
+
+    for (int fj = 0; fj < fwidth; ++fj) {
+        const float fcoeff = f[fj];
+        for (int j = j_start; j < w; ++j)
+            dst[j] += fcoeff * src[fj + j];
+    }
+}
+
+static void vif_filter1d_v_fused_s(const float *f, int fwidth, const float *const *ref_row, const float *const *dis_row,
+    float *RESTRICT mu1, float *RESTRICT mu2, float *RESTRICT ref_sq, float *RESTRICT dis_sq, float *RESTRICT ref_dis,
+    int j_start, int w)
+{
+    for (int j = j_start; j < w; ++j) {
+        mu1[j] = 0;
+        mu2[j] = 0;
+        ref_sq[j] = 0;
+        dis_sq[j] = 0;
+        ref_dis[j] = 0;
+    }
+
+    for (int fi = 0; fi < fwidth; ++fi) {
+        const float fcoeff = f[fi];
+        const float *RESTRICT ref = ref_row[fi];
+        const float *RESTRICT dis = dis_row[fi];
+
+        for (int j = j_start; j < w; ++j) {
+            const float ref_val = ref[j];
+            const float dis_val = dis[j];
+            mu1[j] += fcoeff * ref_val;
+            mu2[j] += fcoeff * dis_val;
+            ref_sq[j] += fcoeff * (ref_val * ref_val);
+            dis_sq[j] += fcoeff * (dis_val * dis_val);
+            ref_dis[j] += fcoeff * (ref_val * dis_val);
+        }
+    }
+}
+
+void vif_filter1d_statistic_s(const float *f, const float *ref, const float *dis, float *tmpbuf, int w, int h, int ref_stride, int dis_stride, int fwidth,
+    double vif_enhn_gain_limit, float *num, float *den)
+{
+    const int ref_px_stride = ref_stride / sizeof(float);
+    const int dis_px_stride = dis_stride / sizeof(float);
+    const ptrdiff_t tmp_px_stride = VIF_FUSED_TMP_STRIDE(w) / sizeof(float);
+    const float vif_enhn_gain_limit_f = (float) vif_enhn_gain_limit;
+
+    int v_simd_end = 0, h_simd_end = 0;
+#if ARCH_X86
+    if (vmaf_get_cpu_flags() & VMAF_X86_CPU_FLAG_AVX2) {
+        v_simd_end = w - w % 8;
+        h_simd_end = w - w % 16;
+    }
+#endif
+
+    /* five vertically filtered rows, padded, then five filtered rows */
+    float *v[5], *filt[5];
+    for (int k = 0; k < 5; ++k) {
+        v[k] = tmpbuf + k * tmp_px_stride + VIF_FILTER1D_MAX_RADIUS;
+        filt[k] = tmpbuf + (5 + k) * tmp_px_stride + VIF_FILTER1D_MAX_RADIUS;
+    }
+
+    const float *ref_row[2 * VIF_FILTER1D_MAX_RADIUS + 1];
+    const float *dis_row[2 * VIF_FILTER1D_MAX_RADIUS + 1];
+
+    float accum_num = 0.0f;
+    float accum_den = 0.0f;
+
+    for (int i = 0; i < h; ++i) {
+        for (int fi = 0; fi < fwidth; ++fi) {
+            const int ii = vif_mirror_s(i - fwidth / 2 + fi, h);
+            ref_row[fi] = ref + ii * ref_px_stride;
+            dis_row[fi] = dis + ii * dis_px_stride;
+        }
+
+#if ARCH_X86
+        if (v_simd_end) {
+            vif_filter1d_v_fused_avx2_s(f, fwidth, ref_row, dis_row,
+                                        v[0], v[1], v[2], v[3], v[4], v_simd_end);
+        }
+#endif
+        vif_filter1d_v_fused_s(f, fwidth, ref_row, dis_row,
+                               v[0], v[1], v[2], v[3], v[4], v_simd_end, w);
+
+        for (int k = 0; k < 5; ++k) {
+            vif_pad_row_s(v[k], w, fwidth);
+#if ARCH_X86
+            if (h_simd_end)
+                vif_filter1d_h_avx2_s(f, fwidth, v[k] - fwidth / 2, filt[k], h_simd_end);
+#endif
+            vif_filter1d_h_s(f, fwidth, v[k], filt[k], h_simd_end, w);
+        }
+
+        float accum_inner_num, accum_inner_den;
+        vif_statistic_row_s(filt[0], filt[1], filt[2], filt[3], filt[4], w,
+                            vif_enhn_gain_limit_f, &accum_inner_num, &accum_inner_den);
+
+        accum_num += accum_inner_num;
+        accum_den += accum_inner_den;
+    }
+
+    *num = accum_num;
+    *den = accum_den;
+}
+
+void vif_filter1d_dec2_s(const float *f, const float *ref, const float *dis, float *ref_dst, float *dis_dst, float *tmpbuf, int w, int h,
+    int ref_stride, int dis_stride, int dst_stride, int fwidth)
+{
+    const int ref_px_stride = ref_stride / sizeof(float);
+    const int dis_px_stride = dis_stride / sizeof(float);
+    const int dst_px_stride = dst_stride / sizeof(float);
+    const ptrdiff_t tmp_px_stride = VIF_FUSED_TMP_STRIDE(w) / sizeof(float);
+    const int fwidth_half = fwidth / 2;
+
+    float *RESTRICT ref_v = tmpbuf + VIF_FILTER1D_MAX_RADIUS;
+    float *RESTRICT dis_v = tmpbuf + tmp_px_stride + VIF_FILTER1D_MAX_RADIUS;
+
+    for (int i = 0; i < h / 2; ++i) {
+        for (int j = 0; j < w; ++j) {
+            ref_v[j] = 0;
+            dis_v[j] = 0;
+        }
+
+        /* Vertical pass, only for the rows which are kept. */
+        for (int fi = 0; fi < fwidth; ++fi) {
+            const float fcoeff = f[fi];
+            const int ii = vif_mirror_s(i * 2 - fwidth_half + fi, h);
+            const float *RESTRICT ref_row = ref + ii * ref_px_stride;
+            const float *RESTRICT dis_row = dis + ii * dis_px_stride;
+
+            for (int j = 0; j < w; ++j) {
+                ref_v[j] += fcoeff * ref_row[j];
+                dis_v[j] += fcoeff * dis_row[j];
+            }
+        }
+
+        vif_pad_row_s(ref_v, w, fwidth);
+        vif_pad_row_s(dis_v, w, fwidth);
+
+        /* Horizontal pass, only for the columns which are kept. */
+        float *RESTRICT ref_out = ref_dst + i * dst_px_stride;
+        float *RESTRICT dis_out = dis_dst + i * dst_px_stride;
+        for (int j = 0; j < w / 2; ++j) {
+            float accum_ref = 0;
+            float accum_dis = 0;
+
+            for (int fj = 0; fj < fwidth; ++fj) {
+                accum_ref += f[fj] * ref_v[j * 2 - fwidth_half + fj];
+                accum_dis += f[fj] * dis_v[j * 2 - fwidth_half + fj];
+            }
+
+            ref_out[j] = accum_ref;
+            dis_out[j] = accum_dis;
+        }
+    }
+}
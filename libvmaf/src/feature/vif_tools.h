@@ -52,4 +52,31 @@ void vif_filter1d_sq_s(const float *f, const float *src, float *dst, float *tmpb
 
 void vif_filter1d_xy_s(const float *f, const float *src1, const float *src2, float *dst, float *tmpbuf, int w, int h, int src1_stride, int src2_stride, int dst_stride, int fwidth);
 
+/* half the width of the widest filter in vif_filter1d_table_s */
+#define VIF_FILTER1D_MAX_RADIUS 32
+
+/* byte stride of the rows in the tmpbuf of the fused filters below */
+#define VIF_FUSED_TMP_STRIDE(w) ALIGN_CEIL(((w) + 2 * VIF_FILTER1D_MAX_RADIUS) * sizeof(float))
+
+/* rows in the tmpbuf of the fused filters below */
+#define VIF_FUSED_TMP_ROWS 10
+
+/*
+ * Filters ref and dis, their squares and their product in a single sweep,
+ * one row at a time, and accumulates vif_statistic_s() over the filtered
+ * rows. The result matches the separate vif_filter1d_*_s() passes followed
+ * by vif_statistic_s(), without full-size intermediate planes. tmpbuf holds
+ * VIF_FUSED_TMP_ROWS rows of VIF_FUSED_TMP_STRIDE(w) bytes.
+ */
+void vif_filter1d_statistic_s(const float *f, const float *ref, const float *dis, float *tmpbuf, int w, int h, int ref_stride, int dis_stride, int fwidth,
+                              double vif_enhn_gain_limit, float *num, float *den);
+
+/*
+ * Filters ref and dis and decimates both by 2 in each direction, as
+ * vif_filter1d_s() followed by vif_dec2_s(), computing only the samples
+ * which are kept. dst_stride applies to both ref_dst and dis_dst.
+ */
+void vif_filter1d_dec2_s(const float *f, const float *ref, const float *dis, float *ref_dst, float *dis_dst, float *tmpbuf, int w, int h,
+                         int ref_stride, int dis_stride, int dst_stride, int fwidth);
+
 #endif /* VIF_TOOLS_H_ */
@@ -0,0 +1,28 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef X86_AVX2_ANSNR_H_
+#define X86_AVX2_ANSNR_H_
+
+void ansnr_filter2d_row_avx2(const float *f, int fwidth,
+                             const float *const *src_row, float *dst, int w);
+
+void ansnr_mse_row_avx2(const float *ref, const float *dis, int w,
+                        float *sig, float *noise);
+
+#endif /* X86_AVX2_ANSNR_H_ */
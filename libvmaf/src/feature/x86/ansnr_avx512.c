@@ -0,0 +1,99 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <immintrin.h>
+
+#include "ansnr_avx512.h"
+
+static inline float hsum_ps(__m512 v)
+{
+    return _mm512_reduce_add_ps(v);
+}
+
+void ansnr_filter2d_row_avx512(const float *f, int fwidth,
+        const float *const *src_row, float *dst, int w)
+{
+    const int radius = fwidth / 2;
+    const int w_simd = w - w % 16;
+    int j;
+
+    for (j = 0; j < w_simd; j += 16) {
+        __m512 accum = _mm512_setzero_ps();
+
+        for (int fi = 0; fi < fwidth; ++fi) {
+            const float *src = src_row[fi] + j - radius;
+            __m512 accum_inner = _mm512_setzero_ps();
+
+            for (int fj = 0; fj < fwidth; ++fj) {
+                const __m512 fcoeff = _mm512_set1_ps(f[fi * fwidth + fj]);
+                accum_inner = _mm512_add_ps(accum_inner,
+                        _mm512_mul_ps(fcoeff, _mm512_loadu_ps(src + fj)));
+            }
+
+            accum = _mm512_add_ps(accum, accum_inner);
+        }
+
+        _mm512_storeu_ps(dst + j, accum);
+    }
+
+    for (; j < w; ++j) {
+        float accum = 0;
+
+        for (int fi = 0; fi < fwidth; ++fi) {
+            const float *src = src_row[fi] + j - radius;
+            float accum_inner = 0;
+
+            for (int fj = 0; fj < fwidth; ++fj)
+                accum_inner += f[fi * fwidth + fj] * src[fj];
+
+            accum += accum_inner;
+        }
+
+        dst[j] = accum;
+    }
+}
+
+void ansnr_mse_row_avx512(const float *ref, const float *dis, int w,
+        float *sig, float *noise)
+{
+    const int w_simd = w - w % 16;
+    __m512 sig_accum = _mm512_setzero_ps();
+    __m512 noise_accum = _mm512_setzero_ps();
+    int j;
+
+    for (j = 0; j < w_simd; j += 16) {
+        const __m512 ref_val = _mm512_loadu_ps(ref + j);
+        const __m512 diff = _mm512_sub_ps(ref_val, _mm512_loadu_ps(dis + j));
+        sig_accum = _mm512_add_ps(sig_accum, _mm512_mul_ps(ref_val, ref_val));
+        noise_accum = _mm512_add_ps(noise_accum, _mm512_mul_ps(diff, diff));
+    }
+
+    float sig_accum_inner = hsum_ps(sig_accum);
+    float noise_accum_inner = hsum_ps(noise_accum);
+
+    for (; j < w; ++j) {
+        const float ref_val = ref[j];
+        const float dis_val = dis[j];
+
+        sig_accum_inner   += ref_val * ref_val;
+        noise_accum_inner += (ref_val - dis_val) * (ref_val - dis_val);
+    }
+
+    *sig = sig_accum_inner;
+    *noise = noise_accum_inner;
+}
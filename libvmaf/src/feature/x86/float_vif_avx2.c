@@ -0,0 +1,82 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <immintrin.h>
+
+#include "float_vif_avx2.h"
+
+/*
+ * Each sum is accumulated tap by tap with separate multiplies and adds, as
+ * in vif_tools.c, so that the results match the C kernels exactly.
+ */
+
+void vif_filter1d_v_fused_avx2_s(const float *f, int fwidth,
+                                 const float *const *ref_row,
+                                 const float *const *dis_row, float *mu1,
+                                 float *mu2, float *ref_sq, float *dis_sq,
+                                 float *ref_dis, int j_end)
+{
+    for (int j = 0; j < j_end; j += 8) {
+        __m256 accum_mu1 = _mm256_setzero_ps();
+        __m256 accum_mu2 = _mm256_setzero_ps();
+        __m256 accum_ref = _mm256_setzero_ps();
+        __m256 accum_dis = _mm256_setzero_ps();
+        __m256 accum_ref_dis = _mm256_setzero_ps();
+
+        for (int fi = 0; fi < fwidth; ++fi) {
+            const __m256 fcoeff = _mm256_broadcast_ss(f + fi);
+            const __m256 ref = _mm256_loadu_ps(ref_row[fi] + j);
+            const __m256 dis = _mm256_loadu_ps(dis_row[fi] + j);
+
+            accum_mu1 = _mm256_add_ps(accum_mu1, _mm256_mul_ps(fcoeff, ref));
+            accum_mu2 = _mm256_add_ps(accum_mu2, _mm256_mul_ps(fcoeff, dis));
+            accum_ref = _mm256_add_ps(accum_ref,
+                    _mm256_mul_ps(fcoeff, _mm256_mul_ps(ref, ref)));
+            accum_dis = _mm256_add_ps(accum_dis,
+                    _mm256_mul_ps(fcoeff, _mm256_mul_ps(dis, dis)));
+            accum_ref_dis = _mm256_add_ps(accum_ref_dis,
+                    _mm256_mul_ps(fcoeff, _mm256_mul_ps(ref, dis)));
+        }
+
+        _mm256_storeu_ps(mu1 + j, accum_mu1);
+        _mm256_storeu_ps(mu2 + j, accum_mu2);
+        _mm256_storeu_ps(ref_sq + j, accum_ref);
+        _mm256_storeu_ps(dis_sq + j, accum_dis);
+        _mm256_storeu_ps(ref_dis + j, accum_ref_dis);
+    }
+}
+
+void vif_filter1d_h_avx2_s(const float *f, int fwidth, const float *src,
+                           float *dst, int j_end)
+{
+    for (int j = 0; j < j_end; j += 16) {
+        __m256 accum0 = _mm256_setzero_ps();
+        __m256 accum1 = _mm256_setzero_ps();
+
+        for (int fj = 0; fj < fwidth; ++fj) {
+            const __m256 fcoeff = _mm256_broadcast_ss(f + fj);
+            accum0 = _mm256_add_ps(accum0,
+                    _mm256_mul_ps(fcoeff, _mm256_loadu_ps(src + j + fj)));
+            accum1 = _mm256_add_ps(accum1,
+                    _mm256_mul_ps(fcoeff, _mm256_loadu_ps(src + j + fj + 8)));
+        }
+
+        _mm256_storeu_ps(dst + j, accum0);
+        _mm256_storeu_ps(dst + j + 8, accum1);
+    }
+}
@@ -0,0 +1,31 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef X86_AVX2_FLOAT_VIF_H_
+#define X86_AVX2_FLOAT_VIF_H_
+
+void vif_filter1d_v_fused_avx2_s(const float *f, int fwidth,
+                                 const float *const *ref_row,
+                                 const float *const *dis_row, float *mu1,
+                                 float *mu2, float *ref_sq, float *dis_sq,
+                                 float *ref_dis, int j_end);
+
+void vif_filter1d_h_avx2_s(const float *f, int fwidth, const float *src,
+                           float *dst, int j_end);
+
+#endif /* X86_AVX2_FLOAT_VIF_H_ */
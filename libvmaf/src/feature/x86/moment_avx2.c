@@ -0,0 +1,105 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <immintrin.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "moment_avx2.h"
+
+static inline uint64_t hsum_epi64(__m256i v)
+{
+    const __m128i s = _mm_add_epi64(_mm256_castsi256_si128(v),
+                                    _mm256_extracti128_si256(v, 1));
+    return (uint64_t)_mm_cvtsi128_si64(s) + (uint64_t)_mm_extract_epi64(s, 1);
+}
+
+static inline __m256i widen_add_epi32(__m256i acc, __m256i v)
+{
+    acc = _mm256_add_epi64(acc,
+            _mm256_cvtepu32_epi64(_mm256_castsi256_si128(v)));
+    return _mm256_add_epi64(acc,
+            _mm256_cvtepu32_epi64(_mm256_extracti128_si256(v, 1)));
+}
+
+void moment_sums_8_avx2(const uint8_t *pic, ptrdiff_t stride, unsigned w,
+                        unsigned h, uint64_t *sum, uint64_t *sum_sq)
+{
+    const unsigned w_simd = w - w % 32;
+    __m256i s = _mm256_setzero_si256();
+    __m256i sq = _mm256_setzero_si256();
+    uint64_t s_tail = 0, sq_tail = 0;
+
+    for (unsigned i = 0; i < h; i++) {
+        /* squares of 8-bit samples, summed in pairs, fit 32 bits per row */
+        __m256i sq_row = _mm256_setzero_si256();
+
+        for (unsigned j = 0; j < w_simd; j += 32) {
+            const __m256i x = _mm256_loadu_si256((const __m256i *)(pic + j));
+            s = _mm256_add_epi64(s, _mm256_sad_epu8(x, _mm256_setzero_si256()));
+
+            const __m256i lo = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(x));
+            const __m256i hi = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(x, 1));
+            sq_row = _mm256_add_epi32(sq_row, _mm256_madd_epi16(lo, lo));
+            sq_row = _mm256_add_epi32(sq_row, _mm256_madd_epi16(hi, hi));
+        }
+        sq = widen_add_epi32(sq, sq_row);
+
+        for (unsigned j = w_simd; j < w; j++) {
+            const uint32_t x = pic[j];
+            s_tail += x;
+            sq_tail += x * x;
+        }
+        pic += stride;
+    }
+
+    *sum = hsum_epi64(s) + s_tail;
+    *sum_sq = hsum_epi64(sq) + sq_tail;
+}
+
+void moment_sums_16_avx2(const uint16_t *pic, ptrdiff_t stride, unsigned w,
+                         unsigned h, uint64_t *sum, uint64_t *sum_sq)
+{
+    const unsigned w_simd = w - w % 16;
+    const __m256i one = _mm256_set1_epi16(1);
+    __m256i s = _mm256_setzero_si256();
+    __m256i sq = _mm256_setzero_si256();
+    uint64_t s_tail = 0, sq_tail = 0;
+
+    for (unsigned i = 0; i < h; i++) {
+        __m256i s_row = _mm256_setzero_si256();
+
+        for (unsigned j = 0; j < w_simd; j += 16) {
+            /* up to 12-bit samples stay positive as signed 16-bit */
+            const __m256i x = _mm256_loadu_si256((const __m256i *)(pic + j));
+            s_row = _mm256_add_epi32(s_row, _mm256_madd_epi16(x, one));
+            sq = widen_add_epi32(sq, _mm256_madd_epi16(x, x));
+        }
+        s = widen_add_epi32(s, s_row);
+
+        for (unsigned j = w_simd; j < w; j++) {
+            const uint32_t x = pic[j];
+            s_tail += x;
+            sq_tail += x * x;
+        }
+        pic += stride / sizeof(uint16_t);
+    }
+
+    *sum = hsum_epi64(s) + s_tail;
+    *sum_sq = hsum_epi64(sq) + sq_tail;
+}
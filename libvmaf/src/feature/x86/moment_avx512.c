@@ -0,0 +1,98 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <immintrin.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "moment_avx512.h"
+
+static inline __m512i widen_add_epi32(__m512i acc, __m512i v)
+{
+    acc = _mm512_add_epi64(acc,
+            _mm512_cvtepu32_epi64(_mm512_castsi512_si256(v)));
+    return _mm512_add_epi64(acc,
+            _mm512_cvtepu32_epi64(_mm512_extracti64x4_epi64(v, 1)));
+}
+
+void moment_sums_8_avx512(const uint8_t *pic, ptrdiff_t stride, unsigned w,
+                          unsigned h, uint64_t *sum, uint64_t *sum_sq)
+{
+    const unsigned w_simd = w - w % 64;
+    __m512i s = _mm512_setzero_si512();
+    __m512i sq = _mm512_setzero_si512();
+    uint64_t s_tail = 0, sq_tail = 0;
+
+    for (unsigned i = 0; i < h; i++) {
+        /* squares of 8-bit samples, summed in pairs, fit 32 bits per row */
+        __m512i sq_row = _mm512_setzero_si512();
+
+        for (unsigned j = 0; j < w_simd; j += 64) {
+            const __m512i x = _mm512_loadu_si512((const void *)(pic + j));
+            s = _mm512_add_epi64(s, _mm512_sad_epu8(x, _mm512_setzero_si512()));
+
+            const __m512i lo = _mm512_cvtepu8_epi16(_mm512_castsi512_si256(x));
+            const __m512i hi = _mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(x, 1));
+            sq_row = _mm512_add_epi32(sq_row, _mm512_madd_epi16(lo, lo));
+            sq_row = _mm512_add_epi32(sq_row, _mm512_madd_epi16(hi, hi));
+        }
+        sq = widen_add_epi32(sq, sq_row);
+
+        for (unsigned j = w_simd; j < w; j++) {
+            const uint32_t x = pic[j];
+            s_tail += x;
+            sq_tail += x * x;
+        }
+        pic += stride;
+    }
+
+    *sum = (uint64_t)_mm512_reduce_add_epi64(s) + s_tail;
+    *sum_sq = (uint64_t)_mm512_reduce_add_epi64(sq) + sq_tail;
+}
+
+void moment_sums_16_avx512(const uint16_t *pic, ptrdiff_t stride, unsigned w,
+                           unsigned h, uint64_t *sum, uint64_t *sum_sq)
+{
+    const unsigned w_simd = w - w % 32;
+    const __m512i one = _mm512_set1_epi16(1);
+    __m512i s = _mm512_setzero_si512();
+    __m512i sq = _mm512_setzero_si512();
+    uint64_t s_tail = 0, sq_tail = 0;
+
+    for (unsigned i = 0; i < h; i++) {
+        __m512i s_row = _mm512_setzero_si512();
+
+        for (unsigned j = 0; j < w_simd; j += 32) {
+            /* up to 12-bit samples stay positive as signed 16-bit */
+            const __m512i x = _mm512_loadu_si512((const void *)(pic + j));
+            s_row = _mm512_add_epi32(s_row, _mm512_madd_epi16(x, one));
+            sq = widen_add_epi32(sq, _mm512_madd_epi16(x, x));
+        }
+        s = widen_add_epi32(s, s_row);
+
+        for (unsigned j = w_simd; j < w; j++) {
+            const uint32_t x = pic[j];
+            s_tail += x;
+            sq_tail += x * x;
+        }
+        pic += stride / sizeof(uint16_t);
+    }
+
+    *sum = (uint64_t)_mm512_reduce_add_epi64(s) + s_tail;
+    *sum_sq = (uint64_t)_mm512_reduce_add_epi64(sq) + sq_tail;
+}
@@ -0,0 +1,250 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <immintrin.h>
+#include <math.h>
+#include <stdint.h>
+
+#include "feature/x86/psnr_hvs_avx2.h"
+
+/* OD_DCT_RSHIFT(a, 1) */
+static inline __m256i rshift1(__m256i a)
+{
+    return _mm256_srai_epi32(_mm256_add_epi32(a, _mm256_srli_epi32(a, 31)), 1);
+}
+
+/* (a * c + (1 << (shift - 1))) >> shift */
+static inline __m256i mul_round(__m256i a, int c, int shift)
+{
+    const __m256i p = _mm256_mullo_epi32(a, _mm256_set1_epi32(c));
+    return _mm256_srai_epi32(_mm256_add_epi32(p, _mm256_set1_epi32(1 << (shift - 1))),
+                             shift);
+}
+
+/* od_bin_fdct8() on eight independent lanes, step for step. */
+static inline void fdct8(__m256i x[8])
+{
+    __m256i t0 = x[0], t4 = x[1], t2 = x[2], t6 = x[3];
+    __m256i t7 = x[4], t3 = x[5], t5 = x[6], t1 = x[7];
+    __m256i t1h, t4h, t6h;
+
+    t1 = _mm256_sub_epi32(t0, t1);
+    t1h = rshift1(t1);
+    t0 = _mm256_sub_epi32(t0, t1h);
+    t4 = _mm256_add_epi32(t4, t5);
+    t4h = rshift1(t4);
+    t5 = _mm256_sub_epi32(t5, t4h);
+    t3 = _mm256_sub_epi32(t2, t3);
+    t2 = _mm256_sub_epi32(t2, rshift1(t3));
+    t6 = _mm256_add_epi32(t6, t7);
+    t6h = rshift1(t6);
+    t7 = _mm256_sub_epi32(t6h, t7);
+    t0 = _mm256_add_epi32(t0, t6h);
+    t6 = _mm256_sub_epi32(t0, t6);
+    t2 = _mm256_sub_epi32(t4h, t2);
+    t4 = _mm256_sub_epi32(t2, t4);
+    t0 = _mm256_sub_epi32(t0, mul_round(t4, 13573, 15));
+    t4 = _mm256_add_epi32(t4, mul_round(t0, 11585, 14));
+    t0 = _mm256_sub_epi32(t0, mul_round(t4, 13573, 15));
+    t6 = _mm256_sub_epi32(t6, mul_round(t2, 21895, 15));
+    t2 = _mm256_add_epi32(t2, mul_round(t6, 15137, 14));
+    t6 = _mm256_sub_epi32(t6, mul_round(t2, 21895, 15));
+    t3 = _mm256_add_epi32(t3, mul_round(t5, 19195, 15));
+    t5 = _mm256_add_epi32(t5, mul_round(t3, 11585, 14));
+    t3 = _mm256_sub_epi32(t3, mul_round(t5, 7489, 13));
+    t7 = _mm256_sub_epi32(rshift1(t5), t7);
+    t5 = _mm256_sub_epi32(t5, t7);
+    t3 = _mm256_sub_epi32(t1h, t3);
+    t1 = _mm256_sub_epi32(t1, t3);
+    t7 = _mm256_add_epi32(t7, mul_round(t1, 3227, 15));
+    t1 = _mm256_sub_epi32(t1, mul_round(t7, 6393, 15));
+    t7 = _mm256_add_epi32(t7, mul_round(t1, 3227, 15));
+    t5 = _mm256_add_epi32(t5, mul_round(t3, 2485, 13));
+    t3 = _mm256_sub_epi32(t3, mul_round(t5, 18205, 15));
+    t5 = _mm256_add_epi32(t5, mul_round(t3, 2485, 13));
+
+    x[0] = t0;
+    x[1] = t1;
+    x[2] = t2;
+    x[3] = t3;
+    x[4] = t4;
+    x[5] = t5;
+    x[6] = t6;
+    x[7] = t7;
+}
+
+static inline void transpose8x8(__m256i x[8])
+{
+    const __m256i a0 = _mm256_unpacklo_epi32(x[0], x[1]);
+    const __m256i a1 = _mm256_unpackhi_epi32(x[0], x[1]);
+    const __m256i a2 = _mm256_unpacklo_epi32(x[2], x[3]);
+    const __m256i a3 = _mm256_unpackhi_epi32(x[2], x[3]);
+    const __m256i a4 = _mm256_unpacklo_epi32(x[4], x[5]);
+    const __m256i a5 = _mm256_unpackhi_epi32(x[4], x[5]);
+    const __m256i a6 = _mm256_unpacklo_epi32(x[6], x[7]);
+    const __m256i a7 = _mm256_unpackhi_epi32(x[6], x[7]);
+    const __m256i b0 = _mm256_unpacklo_epi64(a0, a2);
+    const __m256i b1 = _mm256_unpackhi_epi64(a0, a2);
+    const __m256i b2 = _mm256_unpacklo_epi64(a1, a3);
+    const __m256i b3 = _mm256_unpackhi_epi64(a1, a3);
+    const __m256i b4 = _mm256_unpacklo_epi64(a4, a6);
+    const __m256i b5 = _mm256_unpackhi_epi64(a4, a6);
+    const __m256i b6 = _mm256_unpacklo_epi64(a5, a7);
+    const __m256i b7 = _mm256_unpackhi_epi64(a5, a7);
+    x[0] = _mm256_permute2x128_si256(b0, b4, 0x20);
+    x[1] = _mm256_permute2x128_si256(b1, b5, 0x20);
+    x[2] = _mm256_permute2x128_si256(b2, b6, 0x20);
+    x[3] = _mm256_permute2x128_si256(b3, b7, 0x20);
+    x[4] = _mm256_permute2x128_si256(b0, b4, 0x31);
+    x[5] = _mm256_permute2x128_si256(b1, b5, 0x31);
+    x[6] = _mm256_permute2x128_si256(b2, b6, 0x31);
+    x[7] = _mm256_permute2x128_si256(b3, b7, 0x31);
+}
+
+static inline float hsum(__m256 x)
+{
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(x), _mm256_extractf128_ps(x, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_movehdup_ps(s));
+    return _mm_cvtss_f32(s);
+}
+
+static inline void load_block(__m256i x[8], const unsigned char *src,
+                              int stride, int depth)
+{
+    for (unsigned i = 0; i < 8; i++) {
+        if (depth > 8)
+            x[i] = _mm256_cvtepu16_epi32(
+                    _mm_loadu_si128((const __m128i *)(src + i * stride)));
+        else
+            x[i] = _mm256_cvtepu8_epi32(
+                    _mm_loadl_epi64((const __m128i *)(src + i * stride)));
+    }
+}
+
+/*
+ The variance ratio used to scale the mask. Sums are exact in integers, so
+ the variances come out correctly rounded rather than accumulated in float.
+*/
+static inline float variance_ratio(const __m256i x[8])
+{
+    __m256i top = _mm256_setzero_si256(), bot = _mm256_setzero_si256();
+    __m256i top2 = _mm256_setzero_si256(), bot2 = _mm256_setzero_si256();
+    for (unsigned i = 0; i < 4; i++) {
+        top = _mm256_add_epi32(top, x[i]);
+        bot = _mm256_add_epi32(bot, x[i + 4]);
+        top2 = _mm256_add_epi32(top2, _mm256_mullo_epi32(x[i], x[i]));
+        bot2 = _mm256_add_epi32(bot2, _mm256_mullo_epi32(x[i + 4], x[i + 4]));
+    }
+    /* quadrants 0, 1 and their squares in the low lane, 2, 3 in the high */
+    const __m256i q = _mm256_hadd_epi32(_mm256_hadd_epi32(top, bot),
+                                        _mm256_hadd_epi32(top2, bot2));
+    int32_t sum[8];
+    _mm256_storeu_si256((__m256i *)sum, q);
+    const int32_t quad[4] = { sum[0], sum[1], sum[4], sum[5] };
+    const int32_t quad2[4] = { sum[2], sum[3], sum[6], sum[7] };
+
+    int64_t s = 0, s2 = 0;
+    float vars[4];
+    for (unsigned i = 0; i < 4; i++) {
+        s += quad[i];
+        s2 += quad2[i];
+        const int64_t n = 16 * (int64_t)quad2[i] - (int64_t)quad[i] * quad[i];
+        vars[i] = (float)(n / 16.);
+        vars[i] *= 1 / 15.f * 16;
+    }
+    float gvar = (float)((64 * s2 - s * s) / 64.);
+    gvar *= 1 / 63.f * 64;
+    if (gvar > 0)
+        gvar = (vars[0] + vars[1] + vars[2] + vars[3]) / gvar;
+    return gvar;
+}
+
+/*
+ * Adds the terms of a block to acc in the order of the C code. The rows here
+ * are the columns of the C block, and the CSF tables are symmetric. The
+ * running sum of a picture grows large against the terms of one block, so
+ * adding them in another order moves it further with every block.
+ */
+static inline float sum_transposed(const __m256 t[8], float acc)
+{
+    float term[8][8];
+    for (unsigned i = 0; i < 8; i++)
+        _mm256_storeu_ps(term[i], t[i]);
+    for (unsigned i = 0; i < 8; i++)
+        for (unsigned j = 0; j < 8; j++)
+            acc += term[j][i];
+    return acc;
+}
+
+/* Columns of the 2-D transform; the CSF tables are symmetric. */
+static inline float masked_energy(const __m256i x[8], const __m256 mask[8])
+{
+    __m256 acc = _mm256_setzero_ps();
+    for (unsigned i = 0; i < 8; i++) {
+        const __m256 e = _mm256_cvtepi32_ps(_mm256_mullo_epi32(x[i], x[i]));
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(e, mask[i]));
+    }
+    return hsum(acc);
+}
+
+void psnr_hvs_block_avx2(const unsigned char *src, int src_stride,
+                         const unsigned char *dst, int dst_stride, int depth,
+                         const float csf[8][8], const float mask[8][8],
+                         float *ret)
+{
+    __m256i s[8], d[8];
+    __m256 ac_mask[8];
+
+    load_block(s, src, src_stride, depth);
+    load_block(d, dst, dst_stride, depth);
+    const float s_gvar = variance_ratio(s);
+    const float d_gvar = variance_ratio(d);
+
+    fdct8(s);
+    fdct8(d);
+    transpose8x8(s);
+    transpose8x8(d);
+    fdct8(s);
+    fdct8(d);
+
+    for (unsigned i = 0; i < 8; i++)
+        ac_mask[i] = _mm256_loadu_ps(mask[i]);
+    ac_mask[0] = _mm256_blend_ps(ac_mask[0], _mm256_setzero_ps(), 1);
+
+    float s_mask = masked_energy(s, ac_mask);
+    float d_mask = masked_energy(d, ac_mask);
+    s_mask = sqrt(s_mask * s_gvar) / 32.f;
+    d_mask = sqrt(d_mask * d_gvar) / 32.f;
+    if (d_mask > s_mask)
+        s_mask = d_mask;
+
+    const __m256 m = _mm256_set1_ps(s_mask);
+    __m256 e2[8];
+    for (unsigned i = 0; i < 8; i++) {
+        __m256 thr = _mm256_div_ps(m, _mm256_loadu_ps(mask[i]));
+        if (!i) thr = _mm256_blend_ps(thr, _mm256_setzero_ps(), 1);
+        const __m256 err =
+            _mm256_cvtepi32_ps(_mm256_abs_epi32(_mm256_sub_epi32(s[i], d[i])));
+        const __m256 e = _mm256_mul_ps(
+                _mm256_max_ps(_mm256_sub_ps(err, thr), _mm256_setzero_ps()),
+                _mm256_loadu_ps(csf[i]));
+        e2[i] = _mm256_mul_ps(e, e);
+    }
+    *ret = sum_transposed(e2, *ret);
+}
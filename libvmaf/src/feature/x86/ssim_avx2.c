@@ -0,0 +1,167 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <immintrin.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "feature/integer_ssim.h"
+
+static inline __m256i round_shift(__m256i v, int shift)
+{
+    const __m256i round = _mm256_set1_epi32(1 << (shift - 1));
+    return _mm256_srli_epi32(_mm256_add_epi32(v, round), shift);
+}
+
+/*
+ * Products are formed on interleaved rows, which leaves columns 0-3 and 8-11
+ * in lo and 4-7 and 12-15 in hi; store them back in column order.
+ */
+static inline void store_moment(uint32_t *dst, __m256i lo, __m256i hi,
+                                int shift)
+{
+    lo = round_shift(lo, shift);
+    hi = round_shift(hi, shift);
+    _mm256_storeu_si256((__m256i *)dst, _mm256_permute2x128_si256(lo, hi, 0x20));
+    _mm256_storeu_si256((__m256i *)(dst + 8),
+                        _mm256_permute2x128_si256(lo, hi, 0x31));
+}
+
+void ssim_filter_v_avx2(const uint16_t *ref, const uint16_t *dis,
+                        ptrdiff_t stride, unsigned w, SsimMoments *m)
+{
+    const int radius = SSIM_WINDOW / 2;
+    unsigned j = 0;
+
+    for (; j + 16 <= w; j += 16) {
+        __m256i mu_x[2], mu_y[2], xx[2], yy[2], xy[2];
+        for (unsigned i = 0; i < 2; i++) {
+            mu_x[i] = mu_y[i] = _mm256_setzero_si256();
+            xx[i] = yy[i] = xy[i] = _mm256_setzero_si256();
+        }
+
+        /* the window is symmetric, so rows k and 10 - k share a tap */
+        for (int k = 0; k <= radius; k++) {
+            const __m256i g16 = _mm256_set1_epi16(ssim_filter[k]);
+            const __m256i g32 = _mm256_set1_epi32(ssim_filter[k]);
+            const __m256i xa =
+                _mm256_loadu_si256((const __m256i *)(ref + k * stride + j));
+            const __m256i ya =
+                _mm256_loadu_si256((const __m256i *)(dis + k * stride + j));
+            __m256i xb = _mm256_setzero_si256(), yb = _mm256_setzero_si256();
+            if (k < radius) {
+                const ptrdiff_t off = (SSIM_WINDOW - 1 - k) * stride + j;
+                xb = _mm256_loadu_si256((const __m256i *)(ref + off));
+                yb = _mm256_loadu_si256((const __m256i *)(dis + off));
+            }
+            const __m256i x[2] = {
+                _mm256_unpacklo_epi16(xa, xb), _mm256_unpackhi_epi16(xa, xb),
+            };
+            const __m256i y[2] = {
+                _mm256_unpacklo_epi16(ya, yb), _mm256_unpackhi_epi16(ya, yb),
+            };
+            for (unsigned i = 0; i < 2; i++) {
+                mu_x[i] = _mm256_add_epi32(mu_x[i], _mm256_madd_epi16(x[i], g16));
+                mu_y[i] = _mm256_add_epi32(mu_y[i], _mm256_madd_epi16(y[i], g16));
+                xx[i] = _mm256_add_epi32(xx[i],
+                        _mm256_mullo_epi32(_mm256_madd_epi16(x[i], x[i]), g32));
+                yy[i] = _mm256_add_epi32(yy[i],
+                        _mm256_mullo_epi32(_mm256_madd_epi16(y[i], y[i]), g32));
+                xy[i] = _mm256_add_epi32(xy[i],
+                        _mm256_mullo_epi32(_mm256_madd_epi16(x[i], y[i]), g32));
+            }
+        }
+
+        store_moment(m->mu_x + j, mu_x[0], mu_x[1], SSIM_MU_SHIFT);
+        store_moment(m->mu_y + j, mu_y[0], mu_y[1], SSIM_MU_SHIFT);
+        store_moment(m->xx + j, xx[0], xx[1], SSIM_SQ_SHIFT);
+        store_moment(m->yy + j, yy[0], yy[1], SSIM_SQ_SHIFT);
+        store_moment(m->xy + j, xy[0], xy[1], SSIM_SQ_SHIFT);
+    }
+
+    if (j < w) {
+        SsimMoments tail = {
+            m->mu_x + j, m->mu_y + j, m->xx + j, m->yy + j, m->xy + j,
+        };
+        ssim_filter_v(ref + j, dis + j, stride, w - j, &tail);
+    }
+}
+
+static inline __m256i filter_h(const uint32_t *src)
+{
+    const int radius = SSIM_WINDOW / 2;
+    __m256i sum = _mm256_mullo_epi32(
+            _mm256_loadu_si256((const __m256i *)(src + radius)),
+            _mm256_set1_epi32(ssim_filter[radius]));
+    for (int k = 0; k < radius; k++) {
+        const __m256i a = _mm256_loadu_si256((const __m256i *)(src + k));
+        const __m256i b =
+            _mm256_loadu_si256((const __m256i *)(src + SSIM_WINDOW - 1 - k));
+        sum = _mm256_add_epi32(sum,
+                _mm256_mullo_epi32(_mm256_add_epi32(a, b),
+                                   _mm256_set1_epi32(ssim_filter[k])));
+    }
+    return sum;
+}
+
+double ssim_accumulate_row_avx2(const SsimMoments *m, unsigned w)
+{
+    const __m256 mu_scale = _mm256_set1_ps(SSIM_MU_SCALE);
+    const __m256 sq_scale = _mm256_set1_ps(SSIM_SQ_SCALE);
+    const __m256 c1 = _mm256_set1_ps(SSIM_C1);
+    const __m256 c2 = _mm256_set1_ps(SSIM_C2);
+    __m256d sum0 = _mm256_setzero_pd(), sum1 = _mm256_setzero_pd();
+    unsigned j = 0;
+
+    for (; j + 8 <= w; j += 8) {
+        const __m256 mx =
+            _mm256_mul_ps(_mm256_cvtepi32_ps(filter_h(m->mu_x + j)), mu_scale);
+        const __m256 my =
+            _mm256_mul_ps(_mm256_cvtepi32_ps(filter_h(m->mu_y + j)), mu_scale);
+        const __m256 mxy = _mm256_mul_ps(mx, my);
+        const __m256 mxx = _mm256_mul_ps(mx, mx);
+        const __m256 myy = _mm256_mul_ps(my, my);
+        const __m256 mm = _mm256_add_ps(mxx, myy);
+        const __m256 sxx = _mm256_sub_ps(_mm256_mul_ps(
+                    _mm256_cvtepi32_ps(filter_h(m->xx + j)), sq_scale), mxx);
+        const __m256 syy = _mm256_sub_ps(_mm256_mul_ps(
+                    _mm256_cvtepi32_ps(filter_h(m->yy + j)), sq_scale), myy);
+        const __m256 sxy = _mm256_sub_ps(_mm256_mul_ps(
+                    _mm256_cvtepi32_ps(filter_h(m->xy + j)), sq_scale), mxy);
+        const __m256 num = _mm256_mul_ps(
+                _mm256_add_ps(_mm256_add_ps(mxy, mxy), c1),
+                _mm256_add_ps(_mm256_add_ps(sxy, sxy), c2));
+        const __m256 den = _mm256_mul_ps(_mm256_add_ps(mm, c1),
+                _mm256_add_ps(_mm256_add_ps(sxx, syy), c2));
+        const __m256 ssim = _mm256_div_ps(num, den);
+        sum0 = _mm256_add_pd(sum0, _mm256_cvtps_pd(_mm256_castps256_ps128(ssim)));
+        sum1 = _mm256_add_pd(sum1, _mm256_cvtps_pd(_mm256_extractf128_ps(ssim, 1)));
+    }
+
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(sum0, sum1));
+    double sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+
+    if (j < w) {
+        const SsimMoments tail = {
+            m->mu_x + j, m->mu_y + j, m->xx + j, m->yy + j, m->xy + j,
+        };
+        sum += ssim_accumulate_row(&tail, w - j);
+    }
+    return sum;
+}
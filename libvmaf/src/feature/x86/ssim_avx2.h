@@ -0,0 +1,32 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef X86_AVX2_SSIM_H_
+#define X86_AVX2_SSIM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "feature/integer_ssim.h"
+
+void ssim_filter_v_avx2(const uint16_t *ref, const uint16_t *dis,
+                        ptrdiff_t stride, unsigned w, SsimMoments *m);
+
+double ssim_accumulate_row_avx2(const SsimMoments *m, unsigned w);
+
+#endif /* X86_AVX2_SSIM_H_ */
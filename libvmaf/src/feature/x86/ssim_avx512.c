@@ -0,0 +1,169 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <immintrin.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "feature/integer_ssim.h"
+
+static inline __m512i round_shift(__m512i v, int shift)
+{
+    const __m512i round = _mm512_set1_epi32(1 << (shift - 1));
+    return _mm512_srli_epi32(_mm512_add_epi32(v, round), shift);
+}
+
+/*
+ * Products are formed on interleaved rows, which leaves columns 0-3, 8-11,
+ * 16-19 and 24-27 in lo and the others in hi; store them back in column order.
+ */
+static inline void store_moment(uint32_t *dst, __m512i lo, __m512i hi,
+                                int shift)
+{
+    lo = round_shift(lo, shift);
+    hi = round_shift(hi, shift);
+    const __m512i first = _mm512_set_epi64(11, 10, 3, 2, 9, 8, 1, 0);
+    const __m512i second = _mm512_set_epi64(15, 14, 7, 6, 13, 12, 5, 4);
+    _mm512_storeu_si512((__m512i *)dst,
+                        _mm512_permutex2var_epi64(lo, first, hi));
+    _mm512_storeu_si512((__m512i *)(dst + 16),
+                        _mm512_permutex2var_epi64(lo, second, hi));
+}
+
+void ssim_filter_v_avx512(const uint16_t *ref, const uint16_t *dis,
+                        ptrdiff_t stride, unsigned w, SsimMoments *m)
+{
+    const int radius = SSIM_WINDOW / 2;
+    unsigned j = 0;
+
+    for (; j + 32 <= w; j += 32) {
+        __m512i mu_x[2], mu_y[2], xx[2], yy[2], xy[2];
+        for (unsigned i = 0; i < 2; i++) {
+            mu_x[i] = mu_y[i] = _mm512_setzero_si512();
+            xx[i] = yy[i] = xy[i] = _mm512_setzero_si512();
+        }
+
+        /* the window is symmetric, so rows k and 10 - k share a tap */
+        for (int k = 0; k <= radius; k++) {
+            const __m512i g16 = _mm512_set1_epi16(ssim_filter[k]);
+            const __m512i g32 = _mm512_set1_epi32(ssim_filter[k]);
+            const __m512i xa =
+                _mm512_loadu_si512((const __m512i *)(ref + k * stride + j));
+            const __m512i ya =
+                _mm512_loadu_si512((const __m512i *)(dis + k * stride + j));
+            __m512i xb = _mm512_setzero_si512(), yb = _mm512_setzero_si512();
+            if (k < radius) {
+                const ptrdiff_t off = (SSIM_WINDOW - 1 - k) * stride + j;
+                xb = _mm512_loadu_si512((const __m512i *)(ref + off));
+                yb = _mm512_loadu_si512((const __m512i *)(dis + off));
+            }
+            const __m512i x[2] = {
+                _mm512_unpacklo_epi16(xa, xb), _mm512_unpackhi_epi16(xa, xb),
+            };
+            const __m512i y[2] = {
+                _mm512_unpacklo_epi16(ya, yb), _mm512_unpackhi_epi16(ya, yb),
+            };
+            for (unsigned i = 0; i < 2; i++) {
+                mu_x[i] = _mm512_add_epi32(mu_x[i], _mm512_madd_epi16(x[i], g16));
+                mu_y[i] = _mm512_add_epi32(mu_y[i], _mm512_madd_epi16(y[i], g16));
+                xx[i] = _mm512_add_epi32(xx[i],
+                        _mm512_mullo_epi32(_mm512_madd_epi16(x[i], x[i]), g32));
+                yy[i] = _mm512_add_epi32(yy[i],
+                        _mm512_mullo_epi32(_mm512_madd_epi16(y[i], y[i]), g32));
+                xy[i] = _mm512_add_epi32(xy[i],
+                        _mm512_mullo_epi32(_mm512_madd_epi16(x[i], y[i]), g32));
+            }
+        }
+
+        store_moment(m->mu_x + j, mu_x[0], mu_x[1], SSIM_MU_SHIFT);
+        store_moment(m->mu_y + j, mu_y[0], mu_y[1], SSIM_MU_SHIFT);
+        store_moment(m->xx + j, xx[0], xx[1], SSIM_SQ_SHIFT);
+        store_moment(m->yy + j, yy[0], yy[1], SSIM_SQ_SHIFT);
+        store_moment(m->xy + j, xy[0], xy[1], SSIM_SQ_SHIFT);
+    }
+
+    if (j < w) {
+        SsimMoments tail = {
+            m->mu_x + j, m->mu_y + j, m->xx + j, m->yy + j, m->xy + j,
+        };
+        ssim_filter_v(ref + j, dis + j, stride, w - j, &tail);
+    }
+}
+
+static inline __m512i filter_h(const uint32_t *src)
+{
+    const int radius = SSIM_WINDOW / 2;
+    __m512i sum = _mm512_mullo_epi32(
+            _mm512_loadu_si512((const __m512i *)(src + radius)),
+            _mm512_set1_epi32(ssim_filter[radius]));
+    for (int k = 0; k < radius; k++) {
+        const __m512i a = _mm512_loadu_si512((const __m512i *)(src + k));
+        const __m512i b =
+            _mm512_loadu_si512((const __m512i *)(src + SSIM_WINDOW - 1 - k));
+        sum = _mm512_add_epi32(sum,
+                _mm512_mullo_epi32(_mm512_add_epi32(a, b),
+                                   _mm512_set1_epi32(ssim_filter[k])));
+    }
+    return sum;
+}
+
+double ssim_accumulate_row_avx512(const SsimMoments *m, unsigned w)
+{
+    const __m512 mu_scale = _mm512_set1_ps(SSIM_MU_SCALE);
+    const __m512 sq_scale = _mm512_set1_ps(SSIM_SQ_SCALE);
+    const __m512 c1 = _mm512_set1_ps(SSIM_C1);
+    const __m512 c2 = _mm512_set1_ps(SSIM_C2);
+    __m512d sum0 = _mm512_setzero_pd(), sum1 = _mm512_setzero_pd();
+    unsigned j = 0;
+
+    for (; j + 16 <= w; j += 16) {
+        const __m512 mx =
+            _mm512_mul_ps(_mm512_cvtepi32_ps(filter_h(m->mu_x + j)), mu_scale);
+        const __m512 my =
+            _mm512_mul_ps(_mm512_cvtepi32_ps(filter_h(m->mu_y + j)), mu_scale);
+        const __m512 mxy = _mm512_mul_ps(mx, my);
+        const __m512 mxx = _mm512_mul_ps(mx, mx);
+        const __m512 myy = _mm512_mul_ps(my, my);
+        const __m512 mm = _mm512_add_ps(mxx, myy);
+        const __m512 sxx = _mm512_sub_ps(_mm512_mul_ps(
+                    _mm512_cvtepi32_ps(filter_h(m->xx + j)), sq_scale), mxx);
+        const __m512 syy = _mm512_sub_ps(_mm512_mul_ps(
+                    _mm512_cvtepi32_ps(filter_h(m->yy + j)), sq_scale), myy);
+        const __m512 sxy = _mm512_sub_ps(_mm512_mul_ps(
+                    _mm512_cvtepi32_ps(filter_h(m->xy + j)), sq_scale), mxy);
+        const __m512 num = _mm512_mul_ps(
+                _mm512_add_ps(_mm512_add_ps(mxy, mxy), c1),
+                _mm512_add_ps(_mm512_add_ps(sxy, sxy), c2));
+        const __m512 den = _mm512_mul_ps(_mm512_add_ps(mm, c1),
+                _mm512_add_ps(_mm512_add_ps(sxx, syy), c2));
+        const __m512 ssim = _mm512_div_ps(num, den);
+        sum0 = _mm512_add_pd(sum0, _mm512_cvtps_pd(_mm512_castps512_ps256(ssim)));
+        sum1 = _mm512_add_pd(sum1, _mm512_cvtps_pd(_mm256_castpd_ps(
+                        _mm512_extractf64x4_pd(_mm512_castps_pd(ssim), 1))));
+    }
+
+    double sum = _mm512_reduce_add_pd(_mm512_add_pd(sum0, sum1));
+
+    if (j < w) {
+        const SsimMoments tail = {
+            m->mu_x + j, m->mu_y + j, m->xx + j, m->yy + j, m->xy + j,
+        };
+        sum += ssim_accumulate_row(&tail, w - j);
+    }
+    return sum;
+}
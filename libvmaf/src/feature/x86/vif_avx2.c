@@ -37,25 +37,6 @@
 #endif
 
 
-static FORCE_INLINE void
-pad_top_and_bottom(VifBuffer buf, unsigned h, int fwidth)
-{
-    const unsigned fwidth_half = fwidth / 2;
-    unsigned char *ref = buf.ref;
-    unsigned char *dis = buf.dis;
-    for (unsigned i = 1; i <= fwidth_half; ++i) {
-        size_t offset = buf.stride * i;
-        memcpy(ref - offset, ref + offset, buf.stride);
-        memcpy(dis - offset, dis + offset, buf.stride);
-        memcpy(ref + buf.stride * (h - 1) + buf.stride * i,
-            ref + buf.stride * (h - 1) - buf.stride * i,
-            buf.stride);
-        memcpy(dis + buf.stride * (h - 1) + buf.stride * i,
-            dis + buf.stride * (h - 1) - buf.stride * i,
-            buf.stride);
-    }
-}
-
 static FORCE_INLINE void
 copy_and_pad(VifBuffer buf, unsigned w, unsigned h, int scale)
 {
@@ -70,7 +51,10 @@ copy_and_pad(VifBuffer buf, unsigned w, unsigned h, int scale)
             dis[i * stride + j] = buf.mu2[i * mu_stride + j];
         }
     }
-    pad_top_and_bottom(buf, h / 2, vif_filter1d_width[scale]);
+    vif_mirror_rows(buf.ref_row, buf.ref, buf.stride, h / 2,
+                    vif_filter1d_width[scale]);
+    vif_mirror_rows(buf.dis_row, buf.dis, buf.stride, h / 2,
+                    vif_filter1d_width[scale]);
 }
 
 // multiply r0 * f and store in 32-bit accumulators (shuffled 0 1 2 3 8 9 10 11 / 4 5 6 7 12 13 14 15)
@@ -132,7 +116,7 @@ void vif_statistic_8_avx2(struct VifPublicState *s, float *num, float *den, unsi
     int64_t accum_den_log = 0;
     int64_t accum_num_non_log = 0;
     int64_t accum_den_non_log = 0;
-    uint16_t *log2_table = s->log2_table;
+    const uint16_t *log2_table = s->log2_table;
 
     // variables used for 16 sample block vif computation
     ALIGNED(32) uint32_t xx[16];
@@ -151,8 +135,8 @@ void vif_statistic_8_avx2(struct VifPublicState *s, float *num, float *den, unsi
             __m256i accum_mu1_left, accum_mu1_right;
 
             __m256i f0 = _mm256_set1_epi16(vif_filt_s0[fwidth / 2]);
-            __m256i r0 = _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i*)(((uint8_t*)buf.ref) + (buf.stride * i) + jj)));
-            __m256i d0 = _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i*)(((uint8_t*)buf.dis) + (buf.stride * i) + jj)));
+            __m256i r0 = _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i*)((const uint8_t *)buf.ref_row[i] + jj)));
+            __m256i d0 = _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i*)((const uint8_t *)buf.dis_row[i] + jj)));
 
             // filtered r,d
             multiply2(accum_mu1_left, accum_mu1_right, r0, f0);
@@ -168,10 +152,10 @@ void vif_statistic_8_avx2(struct VifPublicState *s, float *num, float *den, unsi
                 int ii_check_1 = i + fwidth / 2 - tap;
 
                 __m256i f0 = _mm256_set1_epi16(vif_filt_s0[tap]);
-                __m256i r0 = _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i*)(((uint8_t*)buf.ref) + (buf.stride * ii_check) + jj)));
-                __m256i r1 = _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i*)(((uint8_t*)buf.ref) + (buf.stride * (ii_check_1)) + jj)));
-                __m256i d0 = _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i*)(((uint8_t*)buf.dis) + (buf.stride * ii_check) + jj)));
-                __m256i d1 = _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i*)(((uint8_t*)buf.dis) + (buf.stride * (ii_check_1)) + jj)));
+                __m256i r0 = _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i*)((const uint8_t *)buf.ref_row[ii_check] + jj)));
+                __m256i r1 = _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i*)((const uint8_t *)buf.ref_row[ii_check_1] + jj)));
+                __m256i d0 = _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i*)((const uint8_t *)buf.dis_row[ii_check] + jj)));
+                __m256i d1 = _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i*)((const uint8_t *)buf.dis_row[ii_check_1] + jj)));
 
                 // accumulate filtered r,d
                 multiply2_and_accumulate(accum_mu1_left, accum_mu1_right, r0, r1, f0);
@@ -217,10 +201,10 @@ void vif_statistic_8_avx2(struct VifPublicState *s, float *num, float *den, unsi
                 int ii = i - fwidth / 2;
                 int ii_check = ii + fi;
                 const uint16_t fcoeff = vif_filt_s0[fi];
-                const uint8_t *ref = (uint8_t*)buf.ref;
-                const uint8_t *dis = (uint8_t*)buf.dis;
-                uint16_t imgcoeff_ref = ref[ii_check * buf.stride + j];
-                uint16_t imgcoeff_dis = dis[ii_check * buf.stride + j];
+                const uint8_t *ref = buf.ref_row[ii_check];
+                const uint8_t *dis = buf.dis_row[ii_check];
+                uint16_t imgcoeff_ref = ref[j];
+                uint16_t imgcoeff_dis = dis[j];
                 uint32_t img_coeff_ref = fcoeff * (uint32_t)imgcoeff_ref;
                 uint32_t img_coeff_dis = fcoeff * (uint32_t)imgcoeff_dis;
                 accum_mu1 += img_coeff_ref;
@@ -550,7 +534,6 @@ void vif_statistic_16_avx2(struct VifPublicState *s, float *num, float *den, uns
     const unsigned fwidth = vif_filter1d_width[scale];
     const uint16_t *vif_filt = vif_filter1d_table[scale];
     VifBuffer buf = s->buf;
-    const ptrdiff_t stride = buf.stride / sizeof(uint16_t);
     int fwidth_half = fwidth >> 1;
 
     int32_t add_shift_round_VP, shift_VP;
@@ -591,8 +574,6 @@ void vif_statistic_16_avx2(struct VifPublicState *s, float *num, float *den, uns
             __m256i mask2 = _mm256_set_epi32(7, 5, 3, 1, 6, 4, 2, 0);
             int ii_check = ii;
 
-            uint16_t *ref = buf.ref;
-            uint16_t *dis = buf.dis;
             __m256i accumr_lo, accumr_hi, accumd_lo, accumd_hi, rmul1, rmul2,
                 dmul1, dmul2, accumref1, accumref2, accumref3, accumref4,
                 accumrefdis1, accumrefdis2, accumrefdis3, accumrefdis4,
@@ -606,9 +587,9 @@ void vif_statistic_16_avx2(struct VifPublicState *s, float *num, float *den, uns
             for (unsigned fi = 0; fi < fwidth; ++fi, ii_check = ii + fi) {
                 __m256i f1 = _mm256_set1_epi16(vif_filt[fi]);
                 __m256i ref1 = _mm256_loadu_si256(
-                    (__m256i *)(ref + (ii_check * stride) + j));
+                    (__m256i *)((const uint16_t *)buf.ref_row[ii_check] + j));
                 __m256i dis1 = _mm256_loadu_si256(
-                    (__m256i *)(dis + (ii_check * stride) + j));
+                    (__m256i *)((const uint16_t *)buf.dis_row[ii_check] + j));
                 __m256i result2 = _mm256_mulhi_epu16(ref1, f1);
                 __m256i result2lo = _mm256_mullo_epi16(ref1, f1);
                 rmul1 = _mm256_unpacklo_epi16(result2lo, result2);
@@ -779,10 +760,10 @@ void vif_statistic_16_avx2(struct VifPublicState *s, float *num, float *den, uns
             int ii_check = ii;
             for (unsigned fi = 0; fi < fwidth; ++fi, ii_check = ii + fi) {
                 const uint16_t fcoeff = vif_filt[fi];
-                uint16_t *ref = buf.ref;
-                uint16_t *dis = buf.dis;
-                uint16_t imgcoeff_ref = ref[ii_check * stride + j];
-                uint16_t imgcoeff_dis = dis[ii_check * stride + j];
+                const uint16_t *ref = buf.ref_row[ii_check];
+                const uint16_t *dis = buf.dis_row[ii_check];
+                uint16_t imgcoeff_ref = ref[j];
+                uint16_t imgcoeff_dis = dis[j];
                 uint32_t img_coeff_ref = fcoeff * (uint32_t)imgcoeff_ref;
                 uint32_t img_coeff_dis = fcoeff * (uint32_t)imgcoeff_dis;
                 accum_mu1 += img_coeff_ref;
@@ -1098,8 +1079,6 @@ void vif_statistic_16_avx2(struct VifPublicState *s, float *num, float *den, uns
 void vif_subsample_rd_8_avx2(VifBuffer buf, unsigned w, unsigned h) {
     const unsigned fwidth = vif_filter1d_width[1];
     const uint16_t *vif_filt_s1 = vif_filter1d_table[1];
-    const uint8_t *ref = (uint8_t *)buf.ref;
-    const uint8_t *dis = (uint8_t *)buf.dis;
     const ptrdiff_t stride = buf.stride_16 / sizeof(uint16_t);
     __m256i addnum = _mm256_set1_epi32(32768);
     __m256i mask1 = _mm256_set_epi32(6, 4, 2, 0, 6, 4, 2, 0);
@@ -1124,42 +1103,42 @@ void vif_subsample_rd_8_avx2(VifBuffer buf, unsigned w, unsigned h) {
             __m256i s0, s1, s2, s3, s4, s5, s6, s7, s8;
 
             g0 = _mm256_cvtepu8_epi16(_mm_loadu_si128(
-                (__m128i *)(ref + (buf.stride * ii_check) + j)));
+                (__m128i *)((const uint8_t *)buf.ref_row[ii_check] + j)));
             g1 = _mm256_cvtepu8_epi16(_mm_loadu_si128(
-                (__m128i *)(ref + buf.stride * (ii_check + 1) + j)));
+                (__m128i *)((const uint8_t *)buf.ref_row[ii_check + 1] + j)));
             g2 = _mm256_cvtepu8_epi16(_mm_loadu_si128(
-                (__m128i *)(ref + buf.stride * (ii_check + 2) + j)));
+                (__m128i *)((const uint8_t *)buf.ref_row[ii_check + 2] + j)));
             g3 = _mm256_cvtepu8_epi16(_mm_loadu_si128(
-                (__m128i *)(ref + buf.stride * (ii_check + 3) + j)));
+                (__m128i *)((const uint8_t *)buf.ref_row[ii_check + 3] + j)));
             g4 = _mm256_cvtepu8_epi16(_mm_loadu_si128(
-                (__m128i *)(ref + buf.stride * (ii_check + 4) + j)));
+                (__m128i *)((const uint8_t *)buf.ref_row[ii_check + 4] + j)));
             g5 = _mm256_cvtepu8_epi16(_mm_loadu_si128(
-                (__m128i *)(ref + buf.stride * (ii_check + 5) + j)));
+                (__m128i *)((const uint8_t *)buf.ref_row[ii_check + 5] + j)));
             g6 = _mm256_cvtepu8_epi16(_mm_loadu_si128(
-                (__m128i *)(ref + buf.stride * (ii_check + 6) + j)));
+                (__m128i *)((const uint8_t *)buf.ref_row[ii_check + 6] + j)));
             g7 = _mm256_cvtepu8_epi16(_mm_loadu_si128(
-                (__m128i *)(ref + buf.stride * (ii_check + 7) + j)));
+                (__m128i *)((const uint8_t *)buf.ref_row[ii_check + 7] + j)));
             g8 = _mm256_cvtepu8_epi16(_mm_loadu_si128(
-                (__m128i *)(ref + buf.stride * (ii_check + 8) + j)));
+                (__m128i *)((const uint8_t *)buf.ref_row[ii_check + 8] + j)));
 
             s0 = _mm256_cvtepu8_epi16(_mm_loadu_si128(
-                (__m128i *)(dis + (buf.stride * ii_check) + j)));
+                (__m128i *)((const uint8_t *)buf.dis_row[ii_check] + j)));
             s1 = _mm256_cvtepu8_epi16(_mm_loadu_si128(
-                (__m128i *)(dis + buf.stride * (ii_check + 1) + j)));
+                (__m128i *)((const uint8_t *)buf.dis_row[ii_check + 1] + j)));
             s2 = _mm256_cvtepu8_epi16(_mm_loadu_si128(
-                (__m128i *)(dis + buf.stride * (ii_check + 2) + j)));
+                (__m128i *)((const uint8_t *)buf.dis_row[ii_check + 2] + j)));
             s3 = _mm256_cvtepu8_epi16(_mm_loadu_si128(
-                (__m128i *)(dis + buf.stride * (ii_check + 3) + j)));
+                (__m128i *)((const uint8_t *)buf.dis_row[ii_check + 3] + j)));
             s4 = _mm256_cvtepu8_epi16(_mm_loadu_si128(
-                (__m128i *)(dis + buf.stride * (ii_check + 4) + j)));
+                (__m128i *)((const uint8_t *)buf.dis_row[ii_check + 4] + j)));
             s5 = _mm256_cvtepu8_epi16(_mm_loadu_si128(
-                (__m128i *)(dis + buf.stride * (ii_check + 5) + j)));
+                (__m128i *)((const uint8_t *)buf.dis_row[ii_check + 5] + j)));
             s6 = _mm256_cvtepu8_epi16(_mm_loadu_si128(
-                (__m128i *)(dis + buf.stride * (ii_check + 6) + j)));
+                (__m128i *)((const uint8_t *)buf.dis_row[ii_check + 6] + j)));
             s7 = _mm256_cvtepu8_epi16(_mm_loadu_si128(
-                (__m128i *)(dis + buf.stride * (ii_check + 7) + j)));
+                (__m128i *)((const uint8_t *)buf.dis_row[ii_check + 7] + j)));
             s8 = _mm256_cvtepu8_epi16(_mm_loadu_si128(
-                (__m128i *)(dis + buf.stride * (ii_check + 8) + j)));
+                (__m128i *)((const uint8_t *)buf.dis_row[ii_check + 8] + j)));
 
             multiply2(accum_mu2_lo, accum_mu2_hi, s4, fcoeff4);
             multiply2_and_accumulate(accum_mu2_lo, accum_mu2_hi, s0, s8, fcoeff0);
@@ -1201,10 +1180,10 @@ void vif_subsample_rd_8_avx2(VifBuffer buf, unsigned w, unsigned h) {
                 int ii = i * 2 - fwidth_half;
                 int ii_check = ii + fi;
                 const uint16_t fcoeff = vif_filt_s1[fi];
-                const uint8_t *ref = (uint8_t *)buf.ref;
-                const uint8_t *dis = (uint8_t *)buf.dis;
-                accum_ref += fcoeff * (uint32_t)ref[ii_check * buf.stride + j];
-                accum_dis += fcoeff * (uint32_t)dis[ii_check * buf.stride + j];
+                const uint8_t *ref = buf.ref_row[ii_check];
+                const uint8_t *dis = buf.dis_row[ii_check];
+                accum_ref += fcoeff * (uint32_t)ref[j];
+                accum_dis += fcoeff * (uint32_t)dis[j];
             }
             buf.tmp.ref_convol[j] = (accum_ref + 128) >> 8;
             buf.tmp.dis_convol[j] = (accum_dis + 128) >> 8;
@@ -1391,8 +1370,6 @@ void vif_subsample_rd_16_avx2(VifBuffer buf, unsigned w, unsigned h, int scale,
     int fwidth_half = fwidth >> 1;
     const ptrdiff_t stride = buf.stride / sizeof(uint16_t);
     const ptrdiff_t stride16 = buf.stride_16 / sizeof(uint16_t);
-    uint16_t *ref = buf.ref;
-    uint16_t *dis = buf.dis;
     __m256i mask1 = _mm256_set_epi32(6, 4, 2, 0, 6, 4, 2, 0);
 
     if (scale == 0) {
@@ -1417,9 +1394,9 @@ void vif_subsample_rd_16_avx2(VifBuffer buf, unsigned w, unsigned h, int scale,
             for (unsigned fi = 0; fi < fwidth; ++fi, ii_check = ii + fi) {
                 __m256i f1 = _mm256_set1_epi16(vif_filt[fi]);
                 __m256i ref1 = _mm256_loadu_si256(
-                    (__m256i *)(ref + (ii_check * stride) + j));
+                    (__m256i *)((const uint16_t *)buf.ref_row[ii_check] + j));
                 __m256i dis1 = _mm256_loadu_si256(
-                    (__m256i *)(dis + (ii_check * stride) + j));
+                    (__m256i *)((const uint16_t *)buf.dis_row[ii_check] + j));
                 __m256i result2 = _mm256_mulhi_epu16(ref1, f1);
                 __m256i result2lo = _mm256_mullo_epi16(ref1, f1);
                 rmul1 = _mm256_unpacklo_epi16(result2lo, result2);
@@ -1468,8 +1445,10 @@ void vif_subsample_rd_16_avx2(VifBuffer buf, unsigned w, unsigned h, int scale,
             int ii_check = ii;
             for (unsigned fi = 0; fi < fwidth; ++fi, ii_check = ii + fi) {
                 const uint16_t fcoeff = vif_filt[fi];
-                accum_ref += fcoeff * ((uint32_t)ref[ii_check * stride + j]);
-                accum_dis += fcoeff * ((uint32_t)dis[ii_check * stride + j]);
+                const uint16_t *ref = buf.ref_row[ii_check];
+                const uint16_t *dis = buf.dis_row[ii_check];
+                accum_ref += fcoeff * ((uint32_t)ref[j]);
+                accum_dis += fcoeff * ((uint32_t)dis[j]);
             }
             buf.tmp.ref_convol[j] =
                 (uint16_t)((accum_ref + add_shift_round_VP) >> shift_VP);
@@ -1546,8 +1525,8 @@ void vif_subsample_rd_16_avx2(VifBuffer buf, unsigned w, unsigned h, int scale,
         }
     }
 
-    ref = buf.ref;
-    dis = buf.dis;
+    uint16_t *ref = buf.ref;
+    uint16_t *dis = buf.dis;
 
     for (unsigned i = 0; i < h / 2; ++i) {
         for (unsigned j = 0; j < w / 2; ++j) {
@@ -1555,5 +1534,8 @@ void vif_subsample_rd_16_avx2(VifBuffer buf, unsigned w, unsigned h, int scale,
             dis[i * stride + j] = buf.mu2[i * stride16 + (j * 2)];
         }
     }
-    pad_top_and_bottom(buf, h / 2, vif_filter1d_width[scale]);
+    vif_mirror_rows(buf.ref_row, buf.ref, buf.stride, h / 2,
+                    vif_filter1d_width[scale]);
+    vif_mirror_rows(buf.dis_row, buf.dis, buf.stride, h / 2,
+                    vif_filter1d_width[scale]);
 }
@@ -29,25 +29,6 @@
 #define MIN(x, y) (((x) < (y)) ? (x) : (y))
 #define MAX(x, y) (((x) > (y)) ? (x) : (y))
 
-static inline void
-pad_top_and_bottom(VifBuffer buf, unsigned h, int fwidth)
-{
-    const unsigned fwidth_half = fwidth / 2;
-    unsigned char *ref = buf.ref;
-    unsigned char *dis = buf.dis;
-    for (unsigned i = 1; i <= fwidth_half; ++i) {
-        size_t offset = buf.stride * i;
-        memcpy(ref - offset, ref + offset, buf.stride);
-        memcpy(dis - offset, dis + offset, buf.stride);
-        memcpy(ref + buf.stride * (h - 1) + buf.stride * i,
-            ref + buf.stride * (h - 1) - buf.stride * i,
-            buf.stride);
-        memcpy(dis + buf.stride * (h - 1) + buf.stride * i,
-            dis + buf.stride * (h - 1) - buf.stride * i,
-            buf.stride);
-    }
-}
-
 static inline void
 decimate_and_pad(VifBuffer buf, unsigned w, unsigned h, int scale)
 {
@@ -62,7 +43,10 @@ decimate_and_pad(VifBuffer buf, unsigned w, unsigned h, int scale)
             dis[i * stride + j] = buf.mu2[(i * 2) * mu_stride + (j * 2)];
         }
     }
-    pad_top_and_bottom(buf, h / 2, vif_filter1d_width[scale]);
+    vif_mirror_rows(buf.ref_row, buf.ref, buf.stride, h / 2,
+                    vif_filter1d_width[scale]);
+    vif_mirror_rows(buf.dis_row, buf.dis, buf.stride, h / 2,
+                    vif_filter1d_width[scale]);
 }
 
 typedef struct Residuals512 {
@@ -145,8 +129,6 @@ void vif_statistic_8_avx512(struct VifPublicState *s, float *num, float *den, un
     const unsigned fwidth = vif_filter1d_width[0];
     const uint16_t *vif_filt = vif_filter1d_table[0];
     VifBuffer buf = s->buf;
-    const uint8_t *ref = (uint8_t*)buf.ref;
-    const uint8_t *dis = (uint8_t*)buf.dis;
     const unsigned fwidth_half = fwidth >> 1;
     const uint16_t *log2_table = s->log2_table;
     double vif_enhn_gain_limit = s->vif_enhn_gain_limit;
@@ -183,8 +165,8 @@ void vif_statistic_8_avx512(struct VifPublicState *s, float *num, float *den, un
         for (unsigned jj = 0; jj < n << 4; jj += 16) {
 
             __m512i f0 = _mm512_set1_epi32(vif_filt[fwidth / 2]);
-            __m512i r0 = _mm512_cvtepu8_epi32(_mm_loadu_si128((__m128i*)(ref + (buf.stride * i) + jj)));
-            __m512i d0 = _mm512_cvtepu8_epi32(_mm_loadu_si128((__m128i*)(dis + (buf.stride * i) + jj)));
+            __m512i r0 = _mm512_cvtepu8_epi32(_mm_loadu_si128((__m128i*)((const uint8_t *)buf.ref_row[i] + jj)));
+            __m512i d0 = _mm512_cvtepu8_epi32(_mm_loadu_si128((__m128i*)((const uint8_t *)buf.dis_row[i] + jj)));
 
             // filtered r,d
             __m512i accum_mu1 = _mm512_mullo_epi32(r0, f0);
@@ -198,10 +180,10 @@ void vif_statistic_8_avx512(struct VifPublicState *s, float *num, float *den, un
                 int ii_forward = i_forward - tap;
 
                 __m512i f0 = _mm512_set1_epi32(vif_filt[tap]);
-                __m512i r0 = _mm512_cvtepu8_epi32(_mm_loadu_si128((__m128i*)(ref + (buf.stride * ii_back) + jj)));
-                __m512i d0 = _mm512_cvtepu8_epi32(_mm_loadu_si128((__m128i*)(dis + (buf.stride * ii_back) + jj)));
-                __m512i r1 = _mm512_cvtepu8_epi32(_mm_loadu_si128((__m128i*)(ref + (buf.stride * ii_forward) + jj)));
-                __m512i d1 = _mm512_cvtepu8_epi32(_mm_loadu_si128((__m128i*)(dis + (buf.stride * ii_forward) + jj)));
+                __m512i r0 = _mm512_cvtepu8_epi32(_mm_loadu_si128((__m128i*)((const uint8_t *)buf.ref_row[ii_back] + jj)));
+                __m512i d0 = _mm512_cvtepu8_epi32(_mm_loadu_si128((__m128i*)((const uint8_t *)buf.dis_row[ii_back] + jj)));
+                __m512i r1 = _mm512_cvtepu8_epi32(_mm_loadu_si128((__m128i*)((const uint8_t *)buf.ref_row[ii_forward] + jj)));
+                __m512i d1 = _mm512_cvtepu8_epi32(_mm_loadu_si128((__m128i*)((const uint8_t *)buf.dis_row[ii_forward] + jj)));
 
                 accum_mu1 = _mm512_add_epi32(accum_mu1, _mm512_mullo_epi32(_mm512_add_epi32(r0, r1), f0));
                 accum_mu2 = _mm512_add_epi32(accum_mu2, _mm512_mullo_epi32(_mm512_add_epi32(d0, d1), f0));
@@ -232,8 +214,10 @@ void vif_statistic_8_avx512(struct VifPublicState *s, float *num, float *den, un
                 int ii = i - fwidth_half;
                 int ii_check = ii + fi;
                 const uint16_t fcoeff = vif_filt[fi];
-                uint16_t imgcoeff_ref = ref[ii_check * buf.stride + j];
-                uint16_t imgcoeff_dis = dis[ii_check * buf.stride + j];
+                const uint8_t *ref = buf.ref_row[ii_check];
+                const uint8_t *dis = buf.dis_row[ii_check];
+                uint16_t imgcoeff_ref = ref[j];
+                uint16_t imgcoeff_dis = dis[j];
                 uint32_t img_coeff_ref = fcoeff * (uint32_t)imgcoeff_ref;
                 uint32_t img_coeff_dis = fcoeff * (uint32_t)imgcoeff_dis;
                 accum_mu1 += img_coeff_ref;
@@ -388,7 +372,6 @@ void vif_statistic_16_avx512(struct VifPublicState *s, float *num, float *den, u
     const unsigned fwidth = vif_filter1d_width[scale];
     const uint16_t *vif_filt = vif_filter1d_table[scale];
     VifBuffer buf = s->buf;
-    const ptrdiff_t stride = buf.stride / sizeof(uint16_t);
     int fwidth_half = fwidth >> 1;
 
     int32_t add_shift_round_VP, shift_VP;
@@ -424,8 +407,6 @@ void vif_statistic_16_avx512(struct VifPublicState *s, float *num, float *den, u
     }
     __m512i addnum64 = _mm512_set1_epi64(add_shift_round_VP_sq);
     __m512i addnum = _mm512_set1_epi32(add_shift_round_VP);
-    uint16_t *ref = buf.ref;
-    uint16_t *dis = buf.dis;
 
     for (unsigned i = 0; i < h; ++i)
     {
@@ -451,9 +432,9 @@ void vif_statistic_16_avx512(struct VifPublicState *s, float *num, float *den, u
                 const uint16_t fcoeff = vif_filt[fi];
                 __m512i f1 = _mm512_set1_epi16(fcoeff);
                 __m512i ref1 = _mm512_loadu_si512(
-                    (__m512i*)(ref + (ii_check * stride) + j));
+                    (__m512i*)((const uint16_t *)buf.ref_row[ii_check] + j));
                 __m512i dis1 = _mm512_loadu_si512(
-                    (__m512i*)(dis + (ii_check * stride) + j));
+                    (__m512i*)((const uint16_t *)buf.dis_row[ii_check] + j));
                 __m512i result2 = _mm512_mulhi_epu16(ref1, f1);
                 __m512i result2lo = _mm512_mullo_epi16(ref1, f1);
                 __m512i rmult1 = _mm512_unpacklo_epi16(result2lo, result2);
@@ -582,11 +563,10 @@ void vif_statistic_16_avx512(struct VifPublicState *s, float *num, float *den, u
                 int ii = i - fwidth / 2;
                 int ii_check = ii + fi;
                 const uint16_t fcoeff = vif_filt[fi];
-                const ptrdiff_t stride = buf.stride / sizeof(uint16_t);
-                uint16_t *ref = buf.ref;
-                uint16_t *dis = buf.dis;
-                uint16_t imgcoeff_ref = ref[ii_check * stride + j];
-                uint16_t imgcoeff_dis = dis[ii_check * stride + j];
+                const uint16_t *ref = buf.ref_row[ii_check];
+                const uint16_t *dis = buf.dis_row[ii_check];
+                uint16_t imgcoeff_ref = ref[j];
+                uint16_t imgcoeff_dis = dis[j];
                 uint32_t img_coeff_ref = fcoeff * (uint32_t)imgcoeff_ref;
                 uint32_t img_coeff_dis = fcoeff * (uint32_t)imgcoeff_dis;
                 accum_mu1 += img_coeff_ref;
@@ -760,8 +740,6 @@ void vif_subsample_rd_8_avx512(VifBuffer buf, unsigned w, unsigned h)
 {
     const unsigned fwidth = vif_filter1d_width[1];
     const uint16_t *vif_filt_s1 = vif_filter1d_table[1];
-    const uint8_t *ref = (uint8_t *)buf.ref;
-    const uint8_t *dis = (uint8_t *)buf.dis;
     const ptrdiff_t stride = buf.stride_16 / sizeof(uint16_t);
     __m512i addnum = _mm512_set1_epi32(32768);
 
@@ -808,27 +786,27 @@ void vif_subsample_rd_8_avx512(VifBuffer buf, unsigned w, unsigned h)
                 __m512i g0, g1, g2, g3, g4, g5, g6, g7, g8, g9;
                 __m512i s0, s1, s2, s3, s4, s5, s6, s7, s8, s9;
 
-                g0 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)(ref + (buf.stride * ii_check) + j)));
-                g1 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)(ref + buf.stride * (ii_check) + buf.stride + j)));
-                g2 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)(ref + buf.stride * (ii_check + 2) + j)));
-                g3 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)(ref + buf.stride * (ii_check + 3) + j)));
-                g4 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)(ref + buf.stride * (ii_check + 4) + j)));
-                g5 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)(ref + buf.stride * (ii_check + 5) + j)));
-                g6 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)(ref + buf.stride * (ii_check + 6) + j)));
-                g7 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)(ref + buf.stride * (ii_check + 7) + j)));
-                g8 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)(ref + buf.stride * (ii_check + 8) + j)));
-                g9 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)(ref + buf.stride * (ii_check + 9) + j)));
-
-                s0 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)(dis + (buf.stride * ii_check) + j)));
-                s1 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)(dis + buf.stride * (ii_check + 1) + j)));
-                s2 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)(dis + buf.stride * (ii_check + 2) + j)));
-                s3 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)(dis + buf.stride * (ii_check + 3) + j)));
-                s4 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)(dis + buf.stride * (ii_check + 4) + j)));
-                s5 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)(dis + buf.stride * (ii_check + 5) + j)));
-                s6 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)(dis + buf.stride * (ii_check + 6) + j)));
-                s7 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)(dis + buf.stride * (ii_check + 7) + j)));
-                s8 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)(dis + buf.stride * (ii_check + 8) + j)));
-                s9 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)(dis + buf.stride * (ii_check + 9) + j)));
+                g0 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)((const uint8_t *)buf.ref_row[ii_check] + j)));
+                g1 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)((const uint8_t *)buf.ref_row[ii_check + 1] + j)));
+                g2 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)((const uint8_t *)buf.ref_row[ii_check + 2] + j)));
+                g3 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)((const uint8_t *)buf.ref_row[ii_check + 3] + j)));
+                g4 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)((const uint8_t *)buf.ref_row[ii_check + 4] + j)));
+                g5 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)((const uint8_t *)buf.ref_row[ii_check + 5] + j)));
+                g6 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)((const uint8_t *)buf.ref_row[ii_check + 6] + j)));
+                g7 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)((const uint8_t *)buf.ref_row[ii_check + 7] + j)));
+                g8 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)((const uint8_t *)buf.ref_row[ii_check + 8] + j)));
+                g9 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)((const uint8_t *)buf.ref_row[ii_check + 9] + j)));
+
+                s0 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)((const uint8_t *)buf.dis_row[ii_check] + j)));
+                s1 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)((const uint8_t *)buf.dis_row[ii_check + 1] + j)));
+                s2 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)((const uint8_t *)buf.dis_row[ii_check + 2] + j)));
+                s3 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)((const uint8_t *)buf.dis_row[ii_check + 3] + j)));
+                s4 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)((const uint8_t *)buf.dis_row[ii_check + 4] + j)));
+                s5 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)((const uint8_t *)buf.dis_row[ii_check + 5] + j)));
+                s6 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)((const uint8_t *)buf.dis_row[ii_check + 6] + j)));
+                s7 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)((const uint8_t *)buf.dis_row[ii_check + 7] + j)));
+                s8 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)((const uint8_t *)buf.dis_row[ii_check + 8] + j)));
+                s9 = _mm512_cvtepu8_epi16(_mm256_loadu_si256((__m256i *)((const uint8_t *)buf.dis_row[ii_check + 9] + j)));
 
                 __m512i s0lo = _mm512_unpacklo_epi16(s0, s1);
                 __m512i s0hi = _mm512_unpackhi_epi16(s0, s1);
@@ -918,10 +896,10 @@ void vif_subsample_rd_8_avx512(VifBuffer buf, unsigned w, unsigned h)
                 int ii = i - fwidth_half;
                 int ii_check = ii + fi;
                 const uint16_t fcoeff = vif_filt_s1[fi];
-                const uint8_t *ref = (uint8_t *)buf.ref;
-                const uint8_t *dis = (uint8_t *)buf.dis;
-                accum_ref += fcoeff * (uint32_t)ref[ii_check * buf.stride + j];
-                accum_dis += fcoeff * (uint32_t)dis[ii_check * buf.stride + j];
+                const uint8_t *ref = buf.ref_row[ii_check];
+                const uint8_t *dis = buf.dis_row[ii_check];
+                accum_ref += fcoeff * (uint32_t)ref[j];
+                accum_dis += fcoeff * (uint32_t)dis[j];
             }
             buf.tmp.ref_convol[j] = (accum_ref + 128) >> 8;
             buf.tmp.dis_convol[j] = (accum_dis + 128) >> 8;
@@ -1109,10 +1087,7 @@ void vif_subsample_rd_16_avx512(VifBuffer buf, unsigned w, unsigned h, int scale
     const uint16_t *vif_filt = vif_filter1d_table[scale + 1];
     int32_t add_shift_round_VP, shift_VP;
     int fwidth_half = fwidth >> 1;
-    const ptrdiff_t stride = buf.stride / sizeof(uint16_t);
     const ptrdiff_t stride16 = buf.stride_16 / sizeof(uint16_t);
-    uint16_t *ref = buf.ref;
-    uint16_t *dis = buf.dis;
 
     if (scale == 0)
     {
@@ -1143,8 +1118,8 @@ void vif_subsample_rd_16_avx512(VifBuffer buf, unsigned w, unsigned h, int scale
 
                 const uint16_t fcoeff = vif_filt[fi];
                 __m512i f1 = _mm512_set1_epi16(fcoeff);
-                __m512i ref1 = _mm512_loadu_si512((__m512i *)(ref + (ii_check * stride) + j));
-                __m512i dis1 = _mm512_loadu_si512((__m512i *)(dis + (ii_check * stride) + j));
+                __m512i ref1 = _mm512_loadu_si512((__m512i *)((const uint16_t *)buf.ref_row[ii_check] + j));
+                __m512i dis1 = _mm512_loadu_si512((__m512i *)((const uint16_t *)buf.dis_row[ii_check] + j));
                 __m512i result2 = _mm512_mulhi_epu16(ref1, f1);
                 __m512i result2lo = _mm512_mullo_epi16(ref1, f1);
                 rmul1 = _mm512_unpacklo_epi16(result2lo, result2);
@@ -1189,8 +1164,10 @@ void vif_subsample_rd_16_avx512(VifBuffer buf, unsigned w, unsigned h, int scale
             for (unsigned fi = 0; fi < fwidth; ++fi, ii_check = ii + fi)
             {
                 const uint16_t fcoeff = vif_filt[fi];
-                accum_ref += fcoeff * ((uint32_t)ref[ii_check * stride + j]);
-                accum_dis += fcoeff * ((uint32_t)dis[ii_check * stride + j]);
+                const uint16_t *ref = buf.ref_row[ii_check];
+                const uint16_t *dis = buf.dis_row[ii_check];
+                accum_ref += fcoeff * ((uint32_t)ref[j]);
+                accum_dis += fcoeff * ((uint32_t)dis[j]);
             }
             buf.tmp.ref_convol[j] = (uint16_t)((accum_ref + add_shift_round_VP) >> shift_VP);
             buf.tmp.dis_convol[j] = (uint16_t)((accum_dis + add_shift_round_VP) >> shift_VP);
@@ -0,0 +1,170 @@
+/**
+ *
+ *  Copyright 2016-2024 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "frame_tracker.h"
+
+// a negative state is the error a failed picture pair ended with
+enum {
+    FRAME_UNKNOWN = 0,
+    FRAME_IN_FLIGHT,
+    FRAME_DONE,
+};
+
+typedef struct VmafFrameTracker {
+    pthread_mutex_t lock;
+    pthread_cond_t done;
+    int *state;
+    unsigned capacity;
+    unsigned in_flight;
+} VmafFrameTracker;
+
+int vmaf_frame_tracker_init(VmafFrameTracker **tracker)
+{
+    if (!tracker) return -EINVAL;
+
+    VmafFrameTracker *const t = *tracker = malloc(sizeof(*t));
+    if (!t) return -ENOMEM;
+    memset(t, 0, sizeof(*t));
+    pthread_mutex_init(&(t->lock), NULL);
+    pthread_cond_init(&(t->done), NULL);
+    return 0;
+}
+
+static int grow(VmafFrameTracker *t, unsigned index)
+{
+    if (index < t->capacity) return 0;
+
+    unsigned capacity = t->capacity ? t->capacity : 1024;
+    while (capacity <= index) {
+        if (capacity > UINT32_MAX / 2) {
+            capacity = UINT32_MAX;
+            break;
+        }
+        capacity *= 2;
+    }
+    const size_t sz = (size_t)capacity * sizeof(*t->state);
+    if (sz / sizeof(*t->state) != capacity) return -ENOMEM;
+    int *state = realloc(t->state, sz);
+    if (!state) return -ENOMEM;
+    memset(state + t->capacity, FRAME_UNKNOWN,
+           (capacity - t->capacity) * sizeof(*state));
+    t->state = state;
+    t->capacity = capacity;
+    return 0;
+}
+
+int vmaf_frame_tracker_begin(VmafFrameTracker *tracker, unsigned index,
+                             unsigned limit)
+{
+    if (!tracker) return -EINVAL;
+
+    int err = 0;
+    pthread_mutex_lock(&(tracker->lock));
+    if (limit && tracker->in_flight >= limit) {
+        err = -EAGAIN;
+        goto unlock;
+    }
+    err = grow(tracker, index);
+    if (err) goto unlock;
+    if (tracker->state[index] == FRAME_IN_FLIGHT) {
+        err = -EINVAL;
+        goto unlock;
+    }
+    tracker->state[index] = FRAME_IN_FLIGHT;
+    tracker->in_flight++;
+
+unlock:
+    pthread_mutex_unlock(&(tracker->lock));
+    return err;
+}
+
+int vmaf_frame_tracker_end(VmafFrameTracker *tracker, unsigned index,
+                           int status)
+{
+    if (!tracker) return -EINVAL;
+    if (status > 0) return -EINVAL;
+
+    int err = 0;
+    pthread_mutex_lock(&(tracker->lock));
+    if (index >= tracker->capacity ||
+        tracker->state[index] != FRAME_IN_FLIGHT)
+    {
+        err = -EINVAL;
+        goto unlock;
+    }
+    tracker->state[index] = status ? status : FRAME_DONE;
+    tracker->in_flight--;
+    pthread_cond_broadcast(&(tracker->done));
+
+unlock:
+    pthread_mutex_unlock(&(tracker->lock));
+    return err;
+}
+
+static int state_to_err(VmafFrameTracker *t, unsigned index)
+{
+    if (index >= t->capacity) return -EINVAL;
+    if (t->state[index] < 0) return t->state[index];
+    switch (t->state[index]) {
+    case FRAME_IN_FLIGHT:
+        return -EAGAIN;
+    case FRAME_DONE:
+        return 0;
+    default:
+        return -EINVAL;
+    }
+}
+
+int vmaf_frame_tracker_poll(VmafFrameTracker *tracker, unsigned index)
+{
+    if (!tracker) return -EINVAL;
+
+    pthread_mutex_lock(&(tracker->lock));
+    const int err = state_to_err(tracker, index);
+    pthread_mutex_unlock(&(tracker->lock));
+    return err;
+}
+
+int vmaf_frame_tracker_wait(VmafFrameTracker *tracker, unsigned index)
+{
+    if (!tracker) return -EINVAL;
+
+    pthread_mutex_lock(&(tracker->lock));
+    int err;
+    while ((err = state_to_err(tracker, index)) == -EAGAIN)
+        pthread_cond_wait(&(tracker->done), &(tracker->lock));
+    pthread_mutex_unlock(&(tracker->lock));
+    return err;
+}
+
+int vmaf_frame_tracker_destroy(VmafFrameTracker *tracker)
+{
+    if (!tracker) return -EINVAL;
+
+    pthread_mutex_destroy(&(tracker->lock));
+    pthread_cond_destroy(&(tracker->done));
+    free(tracker->state);
+    free(tracker);
+    return 0;
+}
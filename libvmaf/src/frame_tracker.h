@@ -0,0 +1,51 @@
+/**
+ *
+ *  Copyright 2016-2024 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef __VMAF_FRAME_TRACKER_H__
+#define __VMAF_FRAME_TRACKER_H__
+
+typedef struct VmafFrameTracker VmafFrameTracker;
+
+int vmaf_frame_tracker_init(VmafFrameTracker **tracker);
+
+/*
+ * Marks picture pair index as in flight. With limit > 0, -EAGAIN is returned
+ * instead once limit picture pairs are in flight.
+ */
+int vmaf_frame_tracker_begin(VmafFrameTracker *tracker, unsigned index,
+                             unsigned limit);
+
+/*
+ * Marks picture pair index as complete and wakes up its waiters. A negative
+ * status marks it as failed with that error.
+ */
+int vmaf_frame_tracker_end(VmafFrameTracker *tracker, unsigned index,
+                           int status);
+
+/*
+ * Returns 0 if picture pair index is complete, the error it failed with,
+ * -EAGAIN if it is still in flight and -EINVAL if it was never begun.
+ */
+int vmaf_frame_tracker_poll(VmafFrameTracker *tracker, unsigned index);
+
+// Like vmaf_frame_tracker_poll(), but blocks while index is in flight.
+int vmaf_frame_tracker_wait(VmafFrameTracker *tracker, unsigned index);
+
+int vmaf_frame_tracker_destroy(VmafFrameTracker *tracker);
+
+#endif /* __VMAF_FRAME_TRACKER_H__ */
@@ -18,6 +18,7 @@
 
 #include <errno.h>
 #include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdint.h>
@@ -29,17 +30,24 @@
 #include "libvmaf/feature.h"
 #include "libvmaf/picture.h"
 
+#include "adaptive_subsample.h"
 #include "cpu.h"
 #include "feature/feature_extractor.h"
 #include "feature/feature_collector.h"
+#include "feature/feature_name.h"
 #include "metadata_handler.h"
 #include "fex_ctx_vector.h"
+#include "frame_tracker.h"
 #include "log.h"
 #include "model.h"
 #include "output.h"
+#include "partial_results.h"
 #include "picture.h"
+#include "picture_pool.h"
+#include "pooling.h"
 #include "predict.h"
 #include "thread_pool.h"
+#include "timer.h"
 #include "vcs_version.h"
 
 #ifdef HAVE_CUDA
@@ -53,11 +61,17 @@
 
 typedef struct VmafContext {
     VmafConfiguration cfg;
+    struct VmafContext *lead;
     VmafFeatureCollector *feature_collector;
     RegisteredFeatureExtractors registered_feature_extractors;
     VmafFeatureExtractorContextPool *fex_ctx_pool;
     VmafThreadPool *thread_pool;
+    bool shared_threads;
+    VmafFrameTracker *frame_tracker;
+    VmafAdaptiveSubsample *adaptive_subsample;
     VmafFrameSyncContext *framesync;
+    VmafPicturePool *pic_pool;
+    bool pic_pool_luma_only;
 #ifdef HAVE_CUDA
     struct {
         struct {
@@ -81,14 +95,28 @@ typedef struct VmafContext {
         unsigned bpc;
         enum VmafPictureBufferType buf_type;
     } pic_params;
+    struct {
+        VmafPoolingConfiguration cfg[POOLING_CFG_LEN];
+        unsigned cnt;
+    } pooling;
     unsigned pic_cnt;
     bool flushed;
+    bool merged;
+    struct {
+        uint64_t begin, end;
+        uint64_t cpu_begin, cpu_end;
+        uint64_t read, flush;
+        atomic_uint_fast64_t extract;
+        unsigned frames_read;
+        atomic_uint frames_done;
+    } progress;
 } VmafContext;
 
 
 int vmaf_init(VmafContext **vmaf, VmafConfiguration cfg)
 {
     if (!vmaf) return -EINVAL;
+    if (!(cfg.subsample_threshold >= 0.f)) return -EINVAL;
     int err = 0;
 
     VmafContext *const v = *vmaf = malloc(sizeof(*v));
@@ -101,16 +129,24 @@ int vmaf_init(VmafContext **vmaf, VmafConfiguration cfg)
 
     vmaf_set_log_level(cfg.log_level);
 
-    err = vmaf_framesync_init(&(v->framesync));
+    err = vmaf_frame_tracker_init(&(v->frame_tracker));
     if (err) goto free_v;
+    err = vmaf_framesync_init(&(v->framesync));
+    if (err) goto free_frame_tracker;
     err = vmaf_feature_collector_init(&(v->feature_collector));
     if (err) goto free_framesync;
     err = feature_extractor_vector_init(&(v->registered_feature_extractors));
     if (err) goto free_feature_collector;
+    if (v->cfg.subsample_threshold > 0.f) {
+        err = vmaf_adaptive_subsample_init(&(v->adaptive_subsample),
+                                           v->cfg.subsample_threshold);
+        if (err) goto free_feature_extractor_vector;
+    }
 
     if (v->cfg.n_threads > 0) {
-        err = vmaf_thread_pool_create(&v->thread_pool, v->cfg.n_threads);
-        if (err) goto free_feature_extractor_vector;
+        err = vmaf_thread_pool_create(&v->thread_pool, v->cfg.n_threads,
+                                      v->cfg.thread_affinity);
+        if (err) goto free_adaptive_subsample;
         err = vmaf_fex_ctx_pool_create(&v->fex_ctx_pool, v->cfg.n_threads);
         if (err) goto free_thread_pool;
     }
@@ -119,16 +155,231 @@ int vmaf_init(VmafContext **vmaf, VmafConfiguration cfg)
 
 free_thread_pool:
     vmaf_thread_pool_destroy(v->thread_pool);
+free_adaptive_subsample:
+    vmaf_adaptive_subsample_destroy(v->adaptive_subsample);
 free_feature_extractor_vector:
     feature_extractor_vector_destroy(&(v->registered_feature_extractors));
 free_feature_collector:
     vmaf_feature_collector_destroy(v->feature_collector);
 free_framesync:
     vmaf_framesync_destroy(v->framesync);
+free_frame_tracker:
+    vmaf_frame_tracker_destroy(v->frame_tracker);
 free_v:
     free(v);
 fail:
-    return -ENOMEM;
+    return err ? err : -ENOMEM;
+}
+
+int vmaf_init_shared_threads(VmafContext **vmaf, VmafConfiguration cfg,
+                             VmafContext *owner)
+{
+    if (!vmaf) return -EINVAL;
+    if (!owner) return -EINVAL;
+    if (!owner->thread_pool) return -EINVAL;
+
+    cfg.n_threads = 0;
+    cfg.thread_affinity = NULL;
+    int err = vmaf_init(vmaf, cfg);
+    if (err) return err;
+
+    VmafContext *const v = *vmaf;
+    v->cfg.n_threads = owner->cfg.n_threads;
+    v->cfg.thread_affinity = owner->cfg.thread_affinity;
+    err = vmaf_fex_ctx_pool_create(&v->fex_ctx_pool, v->cfg.n_threads);
+    if (err) {
+        vmaf_close(v);
+        *vmaf = NULL;
+        return err;
+    }
+    v->thread_pool = owner->thread_pool;
+    v->shared_threads = true;
+    return 0;
+}
+
+static int share_feature_extractor(VmafContext *lane,
+                                   VmafFeatureExtractorContext *lead_fex_ctx)
+{
+    VmafFeatureExtractor *fex = lead_fex_ctx->fex;
+    int err = 0;
+
+    // reference-only features are extracted once, by the lead
+    if ((fex->flags & VMAF_FEATURE_EXTRACTOR_REFERENCE_ONLY) &&
+        fex->provided_features)
+    {
+        VmafDictionary *names =
+            vmaf_feature_name_dict_from_provided_features(fex->provided_features,
+                                                          fex->options,
+                                                          fex->priv);
+        if (!names) return -ENOMEM;
+        VmafFeatureCollector *fc = lane->lead->feature_collector;
+        for (unsigned i = 0; i < names->cnt; i++) {
+            err |= vmaf_feature_collector_forward(fc, names->entry[i].key,
+                                                  lane->feature_collector);
+            err |= vmaf_feature_collector_forward(fc, names->entry[i].val,
+                                                  lane->feature_collector);
+        }
+        vmaf_dictionary_free(&names);
+        return err;
+    }
+
+    VmafDictionary *d = NULL;
+    if (lead_fex_ctx->opts_dict) {
+        err = vmaf_dictionary_copy(&lead_fex_ctx->opts_dict, &d);
+        if (err) return err;
+    }
+
+    VmafFeatureExtractorContext *fex_ctx;
+    err = vmaf_feature_extractor_context_create(&fex_ctx, fex, d);
+    if (err) return err;
+    if (fex_ctx->fex->flags & VMAF_FEATURE_FRAME_SYNC)
+        fex_ctx->fex->framesync = lane->framesync;
+
+    err = feature_extractor_vector_append(&lane->registered_feature_extractors,
+                                          fex_ctx, 0);
+    if (err)
+        vmaf_feature_extractor_context_destroy(fex_ctx);
+    return err;
+}
+
+int vmaf_init_lane(VmafContext **vmaf, VmafContext *lead)
+{
+    if (!vmaf) return -EINVAL;
+    if (!lead) return -EINVAL;
+    if (lead->lead) return -EINVAL;
+    if (lead->progress.frames_read || lead->flushed || lead->merged)
+        return -EINVAL;
+#ifdef HAVE_CUDA
+    if (lead->cuda.state.ctx) return -EINVAL;
+#endif
+
+    int err = 0;
+
+    VmafContext *const v = *vmaf = malloc(sizeof(*v));
+    if (!v) return -ENOMEM;
+    memset(v, 0, sizeof(*v));
+    v->cfg = lead->cfg;
+    v->lead = lead;
+    v->pooling = lead->pooling;
+    v->thread_pool = lead->thread_pool;
+
+    err = vmaf_frame_tracker_init(&(v->frame_tracker));
+    if (err) goto free_v;
+    err = vmaf_framesync_init(&(v->framesync));
+    if (err) goto free_frame_tracker;
+    err = vmaf_feature_collector_init(&(v->feature_collector));
+    if (err) goto free_framesync;
+    err = feature_extractor_vector_init(&(v->registered_feature_extractors));
+    if (err) goto free_feature_collector;
+    if (v->cfg.subsample_threshold > 0.f) {
+        err = vmaf_adaptive_subsample_init(&(v->adaptive_subsample),
+                                           v->cfg.subsample_threshold);
+        if (err) goto free_feature_extractor_vector;
+    }
+    if (v->thread_pool) {
+        err = vmaf_fex_ctx_pool_create(&v->fex_ctx_pool, v->cfg.n_threads);
+        if (err) goto free_adaptive_subsample;
+    }
+
+    RegisteredFeatureExtractors *rfe = &(lead->registered_feature_extractors);
+    for (unsigned i = 0; i < rfe->cnt; i++) {
+        err = share_feature_extractor(v, rfe->fex_ctx[i]);
+        if (err) goto close_v;
+    }
+
+    VmafPredictModel *m = lead->feature_collector->models;
+    for (; m; m = m->next) {
+        err = vmaf_feature_collector_mount_model(v->feature_collector,
+                                                 m->model);
+        if (err) goto close_v;
+    }
+
+    return 0;
+
+close_v:
+    vmaf_close(v);
+    *vmaf = NULL;
+    return err;
+free_adaptive_subsample:
+    vmaf_adaptive_subsample_destroy(v->adaptive_subsample);
+free_feature_extractor_vector:
+    feature_extractor_vector_destroy(&(v->registered_feature_extractors));
+free_feature_collector:
+    vmaf_feature_collector_destroy(v->feature_collector);
+free_framesync:
+    vmaf_framesync_destroy(v->framesync);
+free_frame_tracker:
+    vmaf_frame_tracker_destroy(v->frame_tracker);
+free_v:
+    free(v);
+    *vmaf = NULL;
+    return err;
+}
+
+static bool chroma_required(VmafContext *vmaf)
+{
+    RegisteredFeatureExtractors *rfe = &(vmaf->registered_feature_extractors);
+    for (unsigned i = 0; i < rfe->cnt; i++) {
+        if (vmaf_feature_extractor_context_uses_chroma(rfe->fex_ctx[i]))
+            return true;
+    }
+    return false;
+}
+
+static int check_pic_pool_planes(VmafContext *vmaf,
+                                 VmafFeatureExtractorContext *fex_ctx)
+{
+    const bool luma_only = vmaf->pic_pool_luma_only ||
+                           (vmaf->lead && vmaf->lead->pic_pool_luma_only);
+    if (!luma_only) return 0;
+    if (!vmaf_feature_extractor_context_uses_chroma(fex_ctx)) return 0;
+
+    vmaf_log(VMAF_LOG_LEVEL_ERROR,
+             "feature extractor \"%s\" reads chroma, but pictures were "
+             "preallocated luma only. register it before "
+             "vmaf_preallocate_pictures()\n", fex_ctx->fex->name);
+    return -EINVAL;
+}
+
+int vmaf_preallocate_pictures(VmafContext *vmaf, VmafPictureConfiguration cfg)
+{
+    if (!vmaf) return -EINVAL;
+    if (vmaf->pic_pool) return -EINVAL;
+
+    VmafPicturePoolConfig cfg_pool = {
+        .pic_cnt = cfg.pic_cnt,
+        .w = cfg.pic_params.w,
+        .h = cfg.pic_params.h,
+        .bpc = cfg.pic_params.bpc,
+        .pix_fmt = cfg.pic_params.pix_fmt,
+    };
+
+    // chroma is neither allocated nor read when no extractor needs it
+    if (!chroma_required(vmaf)) {
+        cfg_pool.pix_fmt = VMAF_PIX_FMT_YUV400P;
+        vmaf->pic_pool_luma_only = true;
+    }
+
+    int err = vmaf_picture_pool_init(&vmaf->pic_pool, cfg_pool);
+    if (err) {
+        vmaf_log(VMAF_LOG_LEVEL_ERROR,
+                 "problem during picture preallocation\n");
+    }
+    return err;
+}
+
+int vmaf_fetch_preallocated_picture(VmafContext *vmaf, VmafPicture *pic)
+{
+    if (!vmaf) return -EINVAL;
+    if (!pic) return -EINVAL;
+
+    // lanes read the pictures of their lead unless they preallocated their own
+    VmafPicturePool *pool = vmaf->pic_pool;
+    if (!pool && vmaf->lead)
+        pool = vmaf->lead->pic_pool;
+    if (!pool) return -EINVAL;
+
+    return vmaf_picture_pool_fetch(pool, pic);
 }
 
 #ifdef HAVE_CUDA
@@ -254,11 +505,20 @@ int vmaf_close(VmafContext *vmaf)
     if (!vmaf) return -EINVAL;
 
     vmaf_thread_pool_wait(vmaf->thread_pool);
+    if (vmaf->lead) {
+        vmaf_feature_collector_unforward(vmaf->lead->feature_collector,
+                                         vmaf->feature_collector);
+    }
     vmaf_framesync_destroy(vmaf->framesync);
+    vmaf_frame_tracker_destroy(vmaf->frame_tracker);
+    vmaf_adaptive_subsample_destroy(vmaf->adaptive_subsample);
     feature_extractor_vector_destroy(&(vmaf->registered_feature_extractors));
     vmaf_feature_collector_destroy(vmaf->feature_collector);
-    vmaf_thread_pool_destroy(vmaf->thread_pool);
+    if (!vmaf->lead && !vmaf->shared_threads)
+        vmaf_thread_pool_destroy(vmaf->thread_pool);
     vmaf_fex_ctx_pool_destroy(vmaf->fex_ctx_pool);
+    if (vmaf->pic_pool)
+        vmaf_picture_pool_close(vmaf->pic_pool);
 #ifdef HAVE_CUDA
     if (vmaf->cuda.ring_buffer)
         vmaf_ring_buffer_close(vmaf->cuda.ring_buffer);
@@ -310,6 +570,12 @@ int vmaf_use_feature(VmafContext *vmaf, const char *feature_name,
     err |= set_fex_framesync(fex_ctx, vmaf);
     if (err) return err;
 
+    err = check_pic_pool_planes(vmaf, fex_ctx);
+    if (err) {
+        vmaf_feature_extractor_context_destroy(fex_ctx);
+        return err;
+    }
+
     RegisteredFeatureExtractors *rfe = &(vmaf->registered_feature_extractors);
     err = feature_extractor_vector_append(rfe, fex_ctx, 0);
     if (err)
@@ -357,6 +623,11 @@ int vmaf_use_features_from_model(VmafContext *vmaf, VmafModel *model)
 #endif
         err |= set_fex_framesync(fex_ctx, vmaf);
         if (err) return err;
+        err = check_pic_pool_planes(vmaf, fex_ctx);
+        if (err) {
+            vmaf_feature_extractor_context_destroy(fex_ctx);
+            return err;
+        }
         err = feature_extractor_vector_append(rfe, fex_ctx, 0);
         if (err) {
             err |= vmaf_feature_extractor_context_destroy(fex_ctx);
@@ -383,28 +654,77 @@ int vmaf_use_features_from_model_collection(VmafContext *vmaf,
     return err;
 }
 
+// Counts the extraction jobs of one picture pair still in flight. The reading
+// thread holds one count while enqueueing, so that the pair is not reported
+// done before all of its jobs have been queued. The first error of any job
+// marks the pair as failed.
+typedef struct FrameJobs {
+    atomic_uint pending;
+    atomic_int err;
+    atomic_uint *frames_done;
+    VmafFrameTracker *frame_tracker;
+    unsigned index;
+} FrameJobs;
+
+static int frame_jobs_create(FrameJobs **jobs, VmafContext *vmaf,
+                             unsigned index, unsigned limit)
+{
+    FrameJobs *const j = malloc(sizeof(*j));
+    if (!j) return -ENOMEM;
+    const int err = vmaf_frame_tracker_begin(vmaf->frame_tracker, index, limit);
+    if (err) {
+        free(j);
+        return err;
+    }
+    atomic_init(&j->pending, 1);
+    atomic_init(&j->err, 0);
+    j->frames_done = &vmaf->progress.frames_done;
+    j->frame_tracker = vmaf->frame_tracker;
+    j->index = index;
+    *jobs = j;
+    return 0;
+}
+
+static void frame_jobs_release(FrameJobs *jobs, int err)
+{
+    int no_err = 0;
+    if (err) atomic_compare_exchange_strong(&jobs->err, &no_err, err);
+    if (atomic_fetch_sub(&jobs->pending, 1) > 1) return;
+    atomic_fetch_add(jobs->frames_done, 1);
+    vmaf_frame_tracker_end(jobs->frame_tracker, jobs->index,
+                           atomic_load(&jobs->err));
+    free(jobs);
+}
+
 struct ThreadData {
     VmafFeatureExtractorContext *fex_ctx;
     VmafPicture ref, dist;
     unsigned index;
     VmafFeatureCollector *feature_collector;
     VmafFeatureExtractorContextPool *fex_ctx_pool;
+    FrameJobs *jobs;
+    atomic_uint_fast64_t *extract_time;
     int err;
 };
 
 static void threaded_extract_func(void *e)
 {
     struct ThreadData *f = e;
+    const uint64_t t0 = vmaf_timer_wall_ns();
     f->err = vmaf_feature_extractor_context_extract(f->fex_ctx, &f->ref, NULL,
                                                     &f->dist, NULL, f->index,
                                                     f->feature_collector);
-    f->err = vmaf_fex_ctx_pool_release(f->fex_ctx_pool, f->fex_ctx);
+    atomic_fetch_add(f->extract_time, vmaf_timer_wall_ns() - t0);
+    const int err = vmaf_fex_ctx_pool_release(f->fex_ctx_pool, f->fex_ctx);
+    if (!f->err) f->err = err;
     vmaf_picture_unref(&f->ref);
     vmaf_picture_unref(&f->dist);
+    frame_jobs_release(f->jobs, f->err);
 }
 
 static int threaded_read_pictures(VmafContext *vmaf, VmafPicture *ref,
-                                  VmafPicture *dist, unsigned index)
+                                  VmafPicture *dist, unsigned index,
+                                  bool repeat, FrameJobs *jobs)
 {
     if (!vmaf) return -EINVAL;
     if (!ref) return -EINVAL;
@@ -426,6 +746,15 @@ static int threaded_read_pictures(VmafContext *vmaf, VmafPicture *ref,
             continue;
         }
 
+        if (!vmaf_feature_collector_in_window(vmaf->feature_collector, index) &&
+            !(fex->flags & VMAF_FEATURE_EXTRACTOR_TEMPORAL))
+        {
+            continue;
+        }
+
+        if (repeat && !(fex->flags & VMAF_FEATURE_EXTRACTOR_TEMPORAL))
+            continue;
+
         fex->framesync = vmaf->framesync;
         VmafFeatureExtractorContext *fex_ctx;
         err = vmaf_fex_ctx_pool_aquire(vmaf->fex_ctx_pool, fex, opts_dict,
@@ -443,12 +772,16 @@ static int threaded_read_pictures(VmafContext *vmaf, VmafPicture *ref,
             .index = index,
             .feature_collector = vmaf->feature_collector,
             .fex_ctx_pool = vmaf->fex_ctx_pool,
+            .jobs = jobs,
+            .extract_time = &vmaf->progress.extract,
             .err = 0,
         };
 
+        atomic_fetch_add(&jobs->pending, 1);
         err = vmaf_thread_pool_enqueue(vmaf->thread_pool, threaded_extract_func,
                                        &data, sizeof(data));
         if (err) {
+            atomic_fetch_sub(&jobs->pending, 1);
             vmaf_picture_unref(&pic_a);
             vmaf_picture_unref(&pic_b);
             return err;
@@ -651,20 +984,33 @@ static unsigned rfe_hw_flags(RegisteredFeatureExtractors *rfe)
 
 #endif
 
-int vmaf_read_pictures(VmafContext *vmaf, VmafPicture *ref, VmafPicture *dist,
-                       unsigned index)
+static int read_pictures(VmafContext *vmaf, VmafPicture *ref, VmafPicture *dist,
+                         unsigned index, FrameJobs *jobs)
 {
-    if (!vmaf) return -EINVAL;
-    if (vmaf->flushed) return -EINVAL;
-    if (!ref != !dist) return -EINVAL;
-    if (!ref && !dist) return flush_context(vmaf);
-
     int err = 0;
 
-    vmaf->pic_cnt++;
+    // pictures outside of the score window only warm up temporal extractors
+    const bool in_window =
+        vmaf_feature_collector_in_window(vmaf->feature_collector, index);
+    if (in_window)
+        vmaf->pic_cnt++;
     err = validate_pic_params(vmaf, ref, dist);
     if (err) return err;
 
+    const bool subsampled =
+        (vmaf->cfg.n_subsample > 1) && (index % vmaf->cfg.n_subsample);
+    bool repeat = false;
+    if (vmaf->adaptive_subsample && in_window && !subsampled) {
+        err = vmaf_adaptive_subsample_check(vmaf->adaptive_subsample, ref,
+                                            dist, index, &repeat);
+        err |= vmaf_feature_collector_append(vmaf->feature_collector,
+                                             VMAF_REPEATED_FRAME_FEATURE,
+                                             repeat, index);
+        if (err) return err;
+    } else if (vmaf->adaptive_subsample && !in_window) {
+        vmaf_adaptive_subsample_reset(vmaf->adaptive_subsample);
+    }
+
 #ifdef HAVE_CUDA
     err = check_ring_buffer(vmaf);
     if (err) return err;
@@ -685,7 +1031,7 @@ int vmaf_read_pictures(VmafContext *vmaf, VmafPicture *ref, VmafPicture *dist,
             vmaf->registered_feature_extractors.fex_ctx[i];
 
         if (!(fex_ctx->fex->flags & VMAF_FEATURE_EXTRACTOR_TEMPORAL)) {
-            if ((vmaf->cfg.n_subsample > 1) && (index % vmaf->cfg.n_subsample))
+            if (subsampled || !in_window || repeat)
                 continue;
         }
 
@@ -699,9 +1045,11 @@ int vmaf_read_pictures(VmafContext *vmaf, VmafPicture *ref, VmafPicture *dist,
             &dist_device : &dist_host;
 #endif
 
+        const uint64_t t0 = vmaf_timer_wall_ns();
         err = vmaf_feature_extractor_context_extract(fex_ctx, ref, NULL, dist,
                                                      NULL, index,
                                                      vmaf->feature_collector);
+        atomic_fetch_add(&vmaf->progress.extract, vmaf_timer_wall_ns() - t0);
         if (err) return err;
     }
 
@@ -713,7 +1061,7 @@ int vmaf_read_pictures(VmafContext *vmaf, VmafPicture *ref, VmafPicture *dist,
     //multithreading for GPU does not yield performance benefits
     //disabled for now
     if (vmaf->thread_pool){
-        return threaded_read_pictures(vmaf, ref, dist, index);
+        return threaded_read_pictures(vmaf, ref, dist, index, repeat, jobs);
     }
 #ifdef HAVE_CUDA
     if (ref_host.priv)
@@ -744,6 +1092,128 @@ int vmaf_read_pictures(VmafContext *vmaf, VmafPicture *ref, VmafPicture *dist,
     return err;
 }
 
+static void progress_begin(VmafContext *vmaf, uint64_t t0)
+{
+    if (vmaf->progress.begin) return;
+    vmaf->progress.begin = t0;
+    vmaf->progress.cpu_begin = vmaf_timer_cpu_ns();
+}
+
+static int submit_pictures(VmafContext *vmaf, VmafPicture *ref,
+                           VmafPicture *dist, unsigned index, unsigned limit)
+{
+    const uint64_t t0 = vmaf_timer_wall_ns();
+
+    FrameJobs *jobs;
+    int err = frame_jobs_create(&jobs, vmaf, index, limit);
+    if (err) return err;
+
+    progress_begin(vmaf, t0);
+    vmaf->progress.frames_read++;
+    err = read_pictures(vmaf, ref, dist, index, jobs);
+    frame_jobs_release(jobs, err);
+    vmaf->progress.read += vmaf_timer_wall_ns() - t0;
+    return err;
+}
+
+int vmaf_read_pictures(VmafContext *vmaf, VmafPicture *ref, VmafPicture *dist,
+                       unsigned index)
+{
+    if (!vmaf) return -EINVAL;
+    if (vmaf->flushed) return -EINVAL;
+    if (vmaf->merged) return -EINVAL;
+    if (!ref != !dist) return -EINVAL;
+    // the lead has to flush the scores it shares first
+    if (!ref && vmaf->lead && !vmaf->lead->flushed) return -EINVAL;
+
+    if (!ref && !dist) {
+        const uint64_t t0 = vmaf_timer_wall_ns();
+        progress_begin(vmaf, t0);
+        int err = flush_context(vmaf);
+        // repeated pictures take the scores of the picture they repeat
+        if (!err && vmaf->adaptive_subsample) {
+            err = vmaf_adaptive_subsample_fill(vmaf->adaptive_subsample,
+                                               vmaf->feature_collector);
+        }
+        vmaf->progress.end = vmaf_timer_wall_ns();
+        vmaf->progress.cpu_end = vmaf_timer_cpu_ns();
+        vmaf->progress.flush += vmaf->progress.end - t0;
+        return err;
+    }
+
+    return submit_pictures(vmaf, ref, dist, index, 0);
+}
+
+// Each picture pair in flight holds at most one context per feature extractor
+// and the context pools hold n_threads each, so submitting never waits on
+// vmaf_fex_ctx_pool_aquire() as long as the limit stays at n_threads or below.
+static unsigned in_flight_limit(VmafContext *vmaf)
+{
+    if (!vmaf->thread_pool) return 0;
+    const unsigned limit = vmaf->cfg.max_frames_in_flight;
+    if (!limit || limit > vmaf->cfg.n_threads) return vmaf->cfg.n_threads;
+    return limit;
+}
+
+int vmaf_submit_pictures(VmafContext *vmaf, VmafPicture *ref,
+                         VmafPicture *dist, unsigned index)
+{
+    if (!vmaf) return -EINVAL;
+    if (!ref) return -EINVAL;
+    if (!dist) return -EINVAL;
+    if (vmaf->flushed) return -EINVAL;
+    if (vmaf->merged) return -EINVAL;
+
+    return submit_pictures(vmaf, ref, dist, index, in_flight_limit(vmaf));
+}
+
+int vmaf_poll_frame(VmafContext *vmaf, unsigned index)
+{
+    if (!vmaf) return -EINVAL;
+    return vmaf_frame_tracker_poll(vmaf->frame_tracker, index);
+}
+
+int vmaf_wait_frame(VmafContext *vmaf, unsigned index)
+{
+    if (!vmaf) return -EINVAL;
+    return vmaf_frame_tracker_wait(vmaf->frame_tracker, index);
+}
+
+int vmaf_get_progress(VmafContext *vmaf, VmafProgress *progress)
+{
+    if (!vmaf) return -EINVAL;
+    if (!progress) return -EINVAL;
+
+    memset(progress, 0, sizeof(*progress));
+    progress->frames_read = vmaf->progress.frames_read;
+    progress->frames_done = atomic_load(&vmaf->progress.frames_done);
+    if (vmaf->thread_pool)
+        progress->queue_depth = vmaf_thread_pool_queue_depth(vmaf->thread_pool);
+    if (!vmaf->progress.begin) return 0;
+
+    const uint64_t end = vmaf->flushed ?
+        vmaf->progress.end : vmaf_timer_wall_ns();
+    const uint64_t cpu_end = vmaf->flushed ?
+        vmaf->progress.cpu_end : vmaf_timer_cpu_ns();
+    const double ns = 1e-9;
+    progress->timings.wall = (end - vmaf->progress.begin) * ns;
+    progress->timings.cpu = (cpu_end - vmaf->progress.cpu_begin) * ns;
+    progress->timings.read = vmaf->progress.read * ns;
+    progress->timings.extract = atomic_load(&vmaf->progress.extract) * ns;
+    progress->timings.flush = vmaf->progress.flush * ns;
+    return 0;
+}
+
+int vmaf_set_score_window(VmafContext *vmaf, unsigned index_low,
+                          unsigned index_high)
+{
+    if (!vmaf) return -EINVAL;
+    if (vmaf->pic_cnt || vmaf->merged) return -EINVAL;
+
+    return vmaf_feature_collector_set_window(vmaf->feature_collector,
+                                             index_low, index_high);
+}
+
 int vmaf_register_metadata_handler(VmafContext *vmaf, VmafMetadataConfiguration cfg)
 {
     if (!vmaf) return -EINVAL;
@@ -795,6 +1265,121 @@ int vmaf_score_at_index_model_collection(VmafContext *vmaf,
                                                         index, score);
 }
 
+typedef struct {
+    VmafContext *vmaf;
+    VmafModel *model;
+    VmafModelCollection *model_collection;
+    // score a prediction writes last, present once a picture is predicted
+    char *done_name;
+} Predictor;
+
+static int predict_range(const Predictor *p, unsigned index_low,
+                         unsigned index_high)
+{
+    VmafFeatureCollector *fc = p->vmaf->feature_collector;
+    const unsigned n_subsample = p->vmaf->cfg.n_subsample;
+
+    for (unsigned i = index_low; i <= index_high; i++) {
+        if ((n_subsample > 1) && (i % n_subsample))
+            continue;
+        double score;
+        if (!vmaf_feature_collector_get_score(fc, p->done_name, &score, i))
+            continue;
+
+        int err;
+        if (p->model) {
+            err = vmaf_predict_score_at_index(p->model, fc, i, &score, true,
+                                              false, 0);
+        } else {
+            VmafModelCollectionScore s;
+            err = vmaf_predict_score_at_index_model_collection(
+                                                p->model_collection, fc, i, &s);
+        }
+        if (err) return err;
+    }
+
+    return 0;
+}
+
+struct PredictData {
+    const Predictor *predictor;
+    unsigned index_low, index_high;
+    int *err;
+};
+
+static void threaded_predict_func(void *e)
+{
+    struct PredictData *f = e;
+    *f->err = predict_range(f->predictor, f->index_low, f->index_high);
+}
+
+// pictures per prediction job, at least
+#define PREDICT_CHUNK_MIN 64
+
+/*
+ * Predicts the pictures of [index_low, index_high] which do not have a score
+ * yet. Once extraction is done, contiguous chunks are predicted by the
+ * thread pool. Every picture is predicted on its own, so scores do not
+ * depend on the number of threads.
+ */
+static int predict(VmafContext *vmaf, VmafModel *model,
+                   VmafModelCollection *model_collection,
+                   unsigned index_low, unsigned index_high)
+{
+    const char *name = model ? model->name : model_collection->name;
+    const char *suffix = model ? "" : "_ci_p95_hi";
+    const size_t name_sz = strlen(name) + strlen(suffix) + 1;
+    char done_name[name_sz];
+    snprintf(done_name, name_sz, "%s%s", name, suffix);
+
+    const Predictor p = {
+        .vmaf = vmaf,
+        .model = model,
+        .model_collection = model_collection,
+        .done_name = done_name,
+    };
+
+    const uint64_t cnt = (uint64_t) index_high - index_low + 1;
+    uint64_t chunk_cnt = 1;
+    if (vmaf->thread_pool && vmaf->flushed) {
+        chunk_cnt = cnt / PREDICT_CHUNK_MIN;
+        if (chunk_cnt > 4 * vmaf->cfg.n_threads)
+            chunk_cnt = 4 * vmaf->cfg.n_threads;
+    }
+    // the first picture which is not subsampled away is predicted here, so
+    // that new scores are added to the feature collector in the same order
+    // as without threads
+    const unsigned head = vmaf->cfg.n_subsample > 1 ? vmaf->cfg.n_subsample : 1;
+    if (chunk_cnt <= 1 || head >= cnt)
+        return predict_range(&p, index_low, index_high);
+
+    int err = predict_range(&p, index_low, index_low + head - 1);
+    if (err) return err;
+
+    const unsigned low = index_low + head;
+    const uint64_t rest = cnt - head;
+    int *chunk_err = calloc(chunk_cnt, sizeof(*chunk_err));
+    if (!chunk_err) return -ENOMEM;
+
+    for (unsigned i = 0; i < chunk_cnt; i++) {
+        struct PredictData data = {
+            .predictor = &p,
+            .index_low = low + rest * i / chunk_cnt,
+            .index_high = low + rest * (i + 1) / chunk_cnt - 1,
+            .err = &chunk_err[i],
+        };
+        err = vmaf_thread_pool_enqueue(vmaf->thread_pool, threaded_predict_func,
+                                       &data, sizeof(data));
+        if (err) break;
+    }
+    err |= vmaf_thread_pool_wait(vmaf->thread_pool);
+
+    for (unsigned i = 0; !err && i < chunk_cnt; i++)
+        err = chunk_err[i];
+    free(chunk_err);
+    return err;
+}
+
 int vmaf_feature_score_pooled(VmafContext *vmaf, const char *feature_name,
                               enum VmafPoolingMethod pool_method, double *score,
                               unsigned index_low, unsigned index_high)
@@ -815,9 +1400,9 @@ int vmaf_feature_score_pooled(VmafContext *vmaf, const char *feature_name,
         if (err) return err;
         sum += s;
         i_sum += 1. / (s + 1.);
-        if ((i == index_low) || (s < min))
+        if ((pic_cnt == 1) || (s < min))
             min = s;
-        if ((i == index_low) || (s > max))
+        if ((pic_cnt == 1) || (s > max))
             max = s;
     }
 
@@ -841,6 +1426,96 @@ int vmaf_feature_score_pooled(VmafContext *vmaf, const char *feature_name,
     return 0;
 }
 
+static int gather_scores(VmafContext *vmaf, const char *feature_name,
+                         unsigned index_low, unsigned index_high,
+                         double **scores, unsigned *cnt)
+{
+    double *const s = malloc(sizeof(*s) * ((size_t) index_high - index_low + 1));
+    if (!s) return -ENOMEM;
+
+    unsigned n = 0;
+    for (unsigned i = index_low; i <= index_high; i++) {
+        if ((vmaf->cfg.n_subsample > 1) && (i % vmaf->cfg.n_subsample))
+            continue;
+        int err = vmaf_feature_score_at_index(vmaf, feature_name, &s[n++], i);
+        if (err) {
+            free(s);
+            return err;
+        }
+    }
+
+    *scores = s;
+    *cnt = n;
+    return 0;
+}
+
+int vmaf_feature_score_pooled_with_config(VmafContext *vmaf,
+                                          const char *feature_name,
+                                          VmafPoolingConfiguration pool_cfg,
+                                          double *score, unsigned index_low,
+                                          unsigned index_high)
+{
+    if (!vmaf) return -EINVAL;
+    if (!feature_name) return -EINVAL;
+    if (!score) return -EINVAL;
+    if (index_low > index_high) return -EINVAL;
+    if (!vmaf_pooling_cfg_is_valid(pool_cfg)) return -EINVAL;
+
+    if (pool_cfg.method != VMAF_POOL_METHOD_PERCENTILE &&
+        pool_cfg.method != VMAF_POOL_METHOD_WINDOW_MIN)
+    {
+        return vmaf_feature_score_pooled(vmaf, feature_name, pool_cfg.method,
+                                         score, index_low, index_high);
+    }
+
+    double *scores;
+    unsigned cnt;
+    int err = gather_scores(vmaf, feature_name, index_low, index_high, &scores,
+                            &cnt);
+    if (err) return err;
+    if (!cnt) {
+        free(scores);
+        return -EINVAL;
+    }
+
+    if (pool_cfg.method == VMAF_POOL_METHOD_PERCENTILE)
+        *score = vmaf_pool_percentile(scores, cnt, pool_cfg.param);
+    else
+        *score = vmaf_pool_window_min(scores, cnt, pool_cfg.param);
+
+    free(scores);
+    return 0;
+}
+
+
+int vmaf_score_pooled_with_config(VmafContext *vmaf, VmafModel *model,
+                                  VmafPoolingConfiguration pool_cfg,
+                                  double *score, unsigned index_low,
+                                  unsigned index_high)
+{
+    if (!vmaf) return -EINVAL;
+    if (!model) return -EINVAL;
+    if (!score) return -EINVAL;
+    if (index_low > index_high) return -EINVAL;
+    if (!vmaf_pooling_cfg_is_valid(pool_cfg)) return -EINVAL;
+
+    int err = predict(vmaf, model, NULL, index_low, index_high);
+    if (err) return err;
+
+    return vmaf_feature_score_pooled_with_config(vmaf, model->name, pool_cfg,
+                                                 score, index_low, index_high);
+}
+
+int vmaf_use_pooling(VmafContext *vmaf, VmafPoolingConfiguration pool_cfg)
+{
+    if (!vmaf) return -EINVAL;
+    if (!vmaf_pooling_cfg_is_valid(pool_cfg)) return -EINVAL;
+    if (vmaf->pooling.cnt == POOLING_CFG_LEN) return -ENOMEM;
+
+    vmaf->pooling.cfg[vmaf->pooling.cnt++] = pool_cfg;
+    return 0;
+}
+
 int vmaf_score_pooled(VmafContext *vmaf, VmafModel *model,
                       enum VmafPoolingMethod pool_method, double *score,
                       unsigned index_low, unsigned index_high)
@@ -851,13 +1526,8 @@ int vmaf_score_pooled(VmafContext *vmaf, VmafModel *model,
     if (index_low > index_high) return -EINVAL;
     if (!pool_method) return -EINVAL;
 
-    for (unsigned i = index_low; i <= index_high; i++) {
-        if ((vmaf->cfg.n_subsample > 1) && (i % vmaf->cfg.n_subsample))
-            continue;
-        double vmaf_score;
-        int err = vmaf_score_at_index(vmaf, model, &vmaf_score, i);
-        if (err) return err;
-    }
+    int err = predict(vmaf, model, NULL, index_low, index_high);
+    if (err) return err;
 
     return vmaf_feature_score_pooled(vmaf, model->name, pool_method, score,
                                      index_low, index_high);
@@ -875,14 +1545,8 @@ int vmaf_score_pooled_model_collection(VmafContext *vmaf,
     if (index_low > index_high) return -EINVAL;
     if (!pool_method) return -EINVAL;
 
-    int err = 0;
-    for (unsigned i = index_low; i <= index_high; i++) {
-        if ((vmaf->cfg.n_subsample > 1) && (i % vmaf->cfg.n_subsample))
-            continue;
-        VmafModelCollectionScore s;
-        err = vmaf_score_at_index_model_collection(vmaf, model_collection, &s, i);
-        if (err) return err;
-    }
+    int err = predict(vmaf, NULL, model_collection, index_low, index_high);
+    if (err) return err;
 
     score->type = VMAF_MODEL_COLLECTION_SCORE_BOOTSTRAP;
 
@@ -919,6 +1583,121 @@ int vmaf_score_pooled_model_collection(VmafContext *vmaf,
     return err;
 }
 
+static unsigned score_window_low(VmafContext *vmaf)
+{
+    VmafFeatureCollector *fc = vmaf->feature_collector;
+    return fc->window.enabled ? fc->window.low : 0;
+}
+
+int vmaf_write_partial_results(VmafContext *vmaf, const char *output_path)
+{
+    if (!vmaf) return -EINVAL;
+    if (!output_path) return -EINVAL;
+    if (!vmaf->flushed && !vmaf->merged) return -EINVAL;
+
+    FILE *outfile = fopen(output_path, "w");
+    if (!outfile) {
+        fprintf(stderr, "could not open file: %s\n", output_path);
+        return -EINVAL;
+    }
+
+    const VmafPartialResultsHeader hdr = {
+        .w = vmaf->pic_params.w,
+        .h = vmaf->pic_params.h,
+        .pix_fmt = vmaf->pic_params.pix_fmt,
+        .bpc = vmaf->pic_params.bpc,
+        .n_subsample = vmaf->cfg.n_subsample > 1 ? vmaf->cfg.n_subsample : 1,
+        .index_low = score_window_low(vmaf),
+        .pic_cnt = vmaf->pic_cnt,
+    };
+
+    int err = vmaf_partial_results_write(vmaf->feature_collector, outfile,
+                                         &hdr);
+    err |= fclose(outfile);
+    return err;
+}
+
+int vmaf_merge_results(VmafContext *vmaf, const char *input_path)
+{
+    if (!vmaf) return -EINVAL;
+    if (!input_path) return -EINVAL;
+    if (vmaf->pic_cnt && !vmaf->merged) return -EINVAL;
+
+    FILE *infile = fopen(input_path, "r");
+    if (!infile) {
+        fprintf(stderr, "could not open file: %s\n", input_path);
+        return -EINVAL;
+    }
+
+    VmafFeatureCollector *fc;
+    int err = vmaf_feature_collector_init(&fc);
+    if (err) goto close_infile;
+
+    VmafPartialResultsHeader hdr;
+    err = vmaf_partial_results_read(fc, infile, &hdr);
+    if (err) {
+        vmaf_log(VMAF_LOG_LEVEL_ERROR,
+                 "problem reading partial results: %s\n", input_path);
+        goto free_fc;
+    }
+
+    const unsigned n_subsample =
+        vmaf->cfg.n_subsample > 1 ? vmaf->cfg.n_subsample : 1;
+    if (hdr.n_subsample != n_subsample) {
+        vmaf_log(VMAF_LOG_LEVEL_ERROR,
+                 "partial results were subsampled every %u frames, "
+                 "expected %u: %s\n", hdr.n_subsample, n_subsample,
+                 input_path);
+        err = -EINVAL;
+        goto free_fc;
+    }
+
+    if (!vmaf->merged) {
+        vmaf->pic_params.w = hdr.w;
+        vmaf->pic_params.h = hdr.h;
+        vmaf->pic_params.pix_fmt = hdr.pix_fmt;
+        vmaf->pic_params.bpc = hdr.bpc;
+    } else if (vmaf->pic_params.w != hdr.w || vmaf->pic_params.h != hdr.h ||
+               vmaf->pic_params.pix_fmt != hdr.pix_fmt ||
+               vmaf->pic_params.bpc != hdr.bpc)
+    {
+        vmaf_log(VMAF_LOG_LEVEL_ERROR,
+                 "partial results have mismatched picture parameters: %s\n",
+                 input_path);
+        err = -EINVAL;
+        goto free_fc;
+    }
+
+    if (!hdr.pic_cnt) goto free_fc;
+
+    VmafFeatureCollector *dst = vmaf->feature_collector;
+    const unsigned hdr_high = hdr.index_low + hdr.pic_cnt - 1;
+    const bool leading = !dst->window.enabled ||
+                         hdr.index_low < dst->window.low;
+    const unsigned low = leading ? hdr.index_low : dst->window.low;
+    const unsigned high = dst->window.enabled && dst->window.high > hdr_high ?
+                          dst->window.high : hdr_high;
+
+    err = vmaf_feature_collector_set_window(dst, low, high);
+    if (err) goto free_fc;
+    err = vmaf_partial_results_merge(dst, fc, leading);
+    if (err) {
+        vmaf_log(VMAF_LOG_LEVEL_ERROR,
+                 "problem merging partial results, "
+                 "segments may overlap: %s\n", input_path);
+        goto free_fc;
+    }
+
+    vmaf->pic_cnt += hdr.pic_cnt;
+    vmaf->merged = true;
+
+free_fc:
+    vmaf_feature_collector_destroy(fc);
+close_infile:
+    fclose(infile);
+    return err;
+}
+
 const char *vmaf_version(void)
 {
     return VMAF_VERSION;
@@ -935,7 +1714,27 @@ int vmaf_write_output(VmafContext *vmaf, const char *output_path,
 
     const double fps = vmaf->pic_cnt /
                 ((double) (vmaf->feature_collector->timer.end -
-                vmaf->feature_collector->timer.begin) / CLOCKS_PER_SEC);
+                vmaf->feature_collector->timer.begin) / 1e9);
+
+    const unsigned index_low = score_window_low(vmaf);
+    const unsigned index_high = index_low + vmaf->pic_cnt - 1;
+    if (vmaf->merged &&
+        index_high != vmaf->feature_collector->window.high)
+    {
+        vmaf_log(VMAF_LOG_LEVEL_WARNING,
+                 "merged results do not cover frames %u-%u contiguously\n",
+                 index_low, vmaf->feature_collector->window.high);
+    }
+
+    VmafPoolingConfiguration pool_cfg[4 + POOLING_CFG_LEN] = {
+        { .method = VMAF_POOL_METHOD_MIN },
+        { .method = VMAF_POOL_METHOD_MAX },
+        { .method = VMAF_POOL_METHOD_MEAN },
+        { .method = VMAF_POOL_METHOD_HARMONIC_MEAN },
+    };
+    unsigned pool_cnt = 4;
+    for (unsigned i = 0; i < vmaf->pooling.cnt; i++)
+        pool_cfg[pool_cnt++] = vmaf->pooling.cfg[i];
 
     int ret = 0;
     switch (fmt) {
@@ -943,11 +1742,13 @@ int vmaf_write_output(VmafContext *vmaf, const char *output_path,
         ret = vmaf_write_output_xml(vmaf, vmaf->feature_collector, outfile,
                                     vmaf->cfg.n_subsample,
                                     vmaf->pic_params.w, vmaf->pic_params.h,
-                                    fps, vmaf->pic_cnt);
+                                    fps, index_low, index_high, pool_cfg,
+                                    pool_cnt);
         break;
     case VMAF_OUTPUT_FORMAT_JSON:
         ret = vmaf_write_output_json(vmaf, vmaf->feature_collector, outfile,
-                                     vmaf->cfg.n_subsample, fps, vmaf->pic_cnt);
+                                     vmaf->cfg.n_subsample, fps, index_low,
+                                     index_high, pool_cfg, pool_cnt);
         break;
     case VMAF_OUTPUT_FORMAT_CSV:
         ret = vmaf_write_output_csv(vmaf->feature_collector, outfile,
@@ -225,6 +225,9 @@ int vmaf_model_collection_append(VmafModelCollection **model_collection,
 
     if (mc->type != model->type) return -EINVAL;
 
+    vmaf_shared_kernel_destroy(mc->shared_kernel);
+    mc->shared_kernel = NULL;
+
     if (mc->cnt == mc->size) {
         const size_t sz = mc->size * sizeof(*mc->model) * 2;
         VmafModel **m = realloc(mc->model, sz);
@@ -245,9 +248,20 @@ fail:
     return -ENOMEM;
 }
 
+int vmaf_model_collection_share_kernels(VmafModelCollection *model_collection)
+{
+    if (!model_collection) return -EINVAL;
+
+    vmaf_shared_kernel_destroy(model_collection->shared_kernel);
+    return vmaf_shared_kernel_init(&model_collection->shared_kernel,
+                                   model_collection->model,
+                                   model_collection->cnt);
+}
+
 void vmaf_model_collection_destroy(VmafModelCollection *model_collection)
 {
     if (!model_collection) return;
+    vmaf_shared_kernel_destroy(model_collection->shared_kernel);
     for (unsigned i = 0; i < model_collection->cnt; i++)
         vmaf_model_destroy(model_collection->model[i]);
     free(model_collection->model);
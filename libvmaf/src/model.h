@@ -23,6 +23,7 @@
 
 #include "dict.h"
 #include "libvmaf/model.h"
+#include "shared_kernel.h"
 
 enum VmafModelType {
     VMAF_MODEL_TYPE_UNKNOWN = 0,
@@ -81,6 +82,7 @@ typedef struct VmafModelCollection {
     unsigned cnt, size;
     enum VmafModelType type;
     const char *name;
+    VmafSharedKernel *shared_kernel;
 } VmafModelCollection;
 
 char *vmaf_model_generate_name(VmafModelConfig *cfg);
@@ -88,4 +90,11 @@ char *vmaf_model_generate_name(VmafModelConfig *cfg);
 int vmaf_model_collection_append(VmafModelCollection **model_collection,
                                  VmafModel *model);
 
+/*
+ * Dedupes the support vectors of all models in the collection, so that
+ * each distinct kernel value is evaluated once per frame. Collections which
+ * cannot share kernel evaluations are left as they are.
+ */
+int vmaf_model_collection_share_kernels(VmafModelCollection *model_collection);
+
 #endif /* __VMAF_SRC_MODEL_H__ */
@@ -22,6 +22,7 @@
 
 #include "feature/alias.h"
 #include "feature/feature_collector.h"
+#include "pooling.h"
 
 #include "libvmaf/libvmaf.h"
 
@@ -37,13 +38,6 @@ static unsigned max_capacity(VmafFeatureCollector *fc)
     return capacity;
 }
 
-static const char *pool_method_name[] = {
-    [VMAF_POOL_METHOD_MIN] = "min",
-    [VMAF_POOL_METHOD_MAX] = "max",
-    [VMAF_POOL_METHOD_MEAN] = "mean",
-    [VMAF_POOL_METHOD_HARMONIC_MEAN] = "harmonic_mean",
-};
-
 static int count_leading_zeros_d(double x)
 {
     if(x < 0)
@@ -66,7 +60,10 @@ static int count_leading_zeros_d(double x)
 
 int vmaf_write_output_xml(VmafContext *vmaf, VmafFeatureCollector *fc,
                           FILE *outfile, unsigned subsample, unsigned width,
-                          unsigned height, double fps, unsigned pic_cnt)
+                          unsigned height, double fps, unsigned index_low,
+                          unsigned index_high,
+                          const VmafPoolingConfiguration *pool_cfg,
+                          unsigned pool_cnt)
 {
     if (!vmaf) return -EINVAL;
     if (!fc) return -EINVAL;
@@ -120,17 +117,22 @@ int vmaf_write_output_xml(VmafContext *vmaf, VmafFeatureCollector *fc,
         fprintf(outfile, "    <metric name=\"%s\" ",
                 vmaf_feature_name_alias(feature_name));
 
-        for (unsigned j = 1; j < VMAF_POOL_METHOD_NB; j++) {
+        for (unsigned j = 0; j < pool_cnt; j++) {
             double score;
-            int err = vmaf_feature_score_pooled(vmaf, feature_name, j, &score,
-                                                0, pic_cnt - 1);
+            char pool_name[32];
+            int err = vmaf_feature_score_pooled_with_config(vmaf, feature_name,
+                                                            pool_cfg[j], &score,
+                                                            index_low,
+                                                            index_high);
+            err |= vmaf_pooling_cfg_name(pool_cfg[j], pool_name,
+                                         sizeof(pool_name));
             if (!err)
             {
                 leading_zeros_count = count_leading_zeros_d(score);
                 if (leading_zeros_count <= 6)
-                    fprintf(outfile, "%s=\"%.6f\" ", pool_method_name[j], score);
+                    fprintf(outfile, "%s=\"%.6f\" ", pool_name, score);
                 else
-                    fprintf(outfile, "%s=\"%.16f\" ", pool_method_name[j], score);
+                    fprintf(outfile, "%s=\"%.16f\" ", pool_name, score);
             }
         }
         fprintf(outfile, "/>\n");
@@ -159,7 +161,9 @@ int vmaf_write_output_xml(VmafContext *vmaf, VmafFeatureCollector *fc,
 
 int vmaf_write_output_json(VmafContext *vmaf, VmafFeatureCollector *fc,
                            FILE *outfile, unsigned subsample, double fps,
-                           unsigned pic_cnt)
+                           unsigned index_low, unsigned index_high,
+                           const VmafPoolingConfiguration *pool_cfg,
+                           unsigned pool_cnt)
 {
     int leading_zeros_count;
     fprintf(outfile, "{\n");
@@ -189,7 +193,7 @@ int vmaf_write_output_json(VmafContext *vmaf, VmafFeatureCollector *fc,
                 cnt++;
         }
         if (!cnt) continue;
-        fprintf(outfile, "%s", i > 0 ? ",\n" : "\n");
+        fprintf(outfile, "%s", n_frames > 0 ? ",\n" : "\n");
 
         fprintf(outfile, "    {\n");
         fprintf(outfile, "      \"frameNum\": %d,\n", i);
@@ -239,12 +243,18 @@ int vmaf_write_output_json(VmafContext *vmaf, VmafFeatureCollector *fc,
         fprintf(outfile, "%s", i > 0 ? ",\n" : "\n");
         fprintf(outfile, "    \"%s\": {",
                 vmaf_feature_name_alias(feature_name));
-        for (unsigned j = 1; j < VMAF_POOL_METHOD_NB; j++) {
+        unsigned pooled_cnt = 0;
+        for (unsigned j = 0; j < pool_cnt; j++) {
             double score;
-            int err = vmaf_feature_score_pooled(vmaf, feature_name, j, &score,
-                                                0, pic_cnt - 1);
+            char pool_name[32];
+            int err = vmaf_feature_score_pooled_with_config(vmaf, feature_name,
+                                                            pool_cfg[j], &score,
+                                                            index_low,
+                                                            index_high);
+            err |= vmaf_pooling_cfg_name(pool_cfg[j], pool_name,
+                                         sizeof(pool_name));
             if (!err) {
-                fprintf(outfile, "%s", j > 1 ? ",\n" : "\n");
+                fprintf(outfile, "%s", pooled_cnt++ ? ",\n" : "\n");
                 switch(fpclassify(score)) {
                 case FP_NORMAL:
                 case FP_ZERO:
@@ -252,15 +262,15 @@ int vmaf_write_output_json(VmafContext *vmaf, VmafFeatureCollector *fc,
                     leading_zeros_count = count_leading_zeros_d((double)score);
                     if (leading_zeros_count <= 6)
                         fprintf(outfile, "      \"%s\": %.6f",
-                            pool_method_name[j], score);
+                            pool_name, score);
                     else
                         fprintf(outfile, "      \"%s\": %.16f",
-                            pool_method_name[j], score);
+                            pool_name, score);
                     break;
                 case FP_INFINITE:
                 case FP_NAN:
                     fprintf(outfile, "      \"%s\": null",
-                            pool_method_name[j]);
+                            pool_name);
                     break;
                 }
             }
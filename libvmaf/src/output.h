@@ -21,11 +21,16 @@
 
 int vmaf_write_output_xml(VmafContext *vmaf, VmafFeatureCollector *fc, FILE *outfile,
                           unsigned subsample, unsigned width, unsigned height,
-                          double fps, unsigned pic_cnt);
+                          double fps, unsigned index_low,
+                          unsigned index_high,
+                          const VmafPoolingConfiguration *pool_cfg,
+                          unsigned pool_cnt);
 
 int vmaf_write_output_json(VmafContext *vmaf, VmafFeatureCollector *fc,
                            FILE *outfile, unsigned subsample, double fps,
-                           unsigned pic_cnt);
+                           unsigned index_low, unsigned index_high,
+                           const VmafPoolingConfiguration *pool_cfg,
+                           unsigned pool_cnt);
 
 int vmaf_write_output_csv(VmafFeatureCollector *fc, FILE *outfile,
                            unsigned subsample);
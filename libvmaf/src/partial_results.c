@@ -0,0 +1,298 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "feature/feature_collector.h"
+#include "feature/integer_psnr.h"
+#include "libvmaf/libvmaf.h"
+#include "log.h"
+#include "partial_results.h"
+
+#define PARTIAL_RESULTS_MAGIC "vmaf_partial_results"
+#define PARTIAL_RESULTS_VERSION 1
+#define TOKEN_SZ 1024
+
+static const char *partial_merge_name[] = {
+    [VMAF_PARTIAL_MERGE_SUM] = "sum",
+    [VMAF_PARTIAL_MERGE_EQUAL] = "equal",
+};
+
+static bool is_token(const char *name)
+{
+    if (!name[0] || strlen(name) >= TOKEN_SZ) return false;
+    for (const char *c = name; *c; c++) {
+        if (*c == ' ' || *c == '\t' || *c == '\n' || *c == '\r')
+            return false;
+    }
+    return true;
+}
+
+int vmaf_partial_results_write(VmafFeatureCollector *fc, FILE *outfile,
+                               const VmafPartialResultsHeader *hdr)
+{
+    if (!fc) return -EINVAL;
+    if (!outfile) return -EINVAL;
+    if (!hdr) return -EINVAL;
+
+    fprintf(outfile, "%s %d\n", PARTIAL_RESULTS_MAGIC,
+            PARTIAL_RESULTS_VERSION);
+    fprintf(outfile, "libvmaf %s\n", vmaf_version());
+    fprintf(outfile, "params %u %u %d %u %u\n", hdr->w, hdr->h,
+            hdr->pix_fmt, hdr->bpc, hdr->n_subsample);
+    fprintf(outfile, "window %u %u\n", hdr->index_low, hdr->pic_cnt);
+
+    for (unsigned i = 0; i < fc->partial_vector.cnt; i++) {
+        if (!is_token(fc->partial_vector.metric[i].name)) return -EINVAL;
+        fprintf(outfile, "partial %s %s %" PRIu64 "\n",
+                fc->partial_vector.metric[i].name,
+                partial_merge_name[fc->partial_vector.metric[i].merge],
+                fc->partial_vector.metric[i].value);
+    }
+
+    for (unsigned i = 0; i < fc->cnt; i++) {
+        FeatureVector *fv = fc->feature_vector[i];
+        if (!is_token(fv->name)) {
+            vmaf_log(VMAF_LOG_LEVEL_ERROR,
+                     "feature name \"%s\" can not be written to partial "
+                     "results\n", fv->name);
+            return -EINVAL;
+        }
+
+        unsigned cnt = 0;
+        for (unsigned j = 0; j < fv->capacity; j++)
+            cnt += fv->score[j].written;
+
+        fprintf(outfile, "feature %s %u\n", fv->name, cnt);
+        for (unsigned j = 0; j < fv->capacity; j++) {
+            if (!fv->score[j].written) continue;
+            // %.17g round-trips every double exactly
+            fprintf(outfile, "%u %.17g\n", j, fv->score[j].value);
+        }
+    }
+
+    fprintf(outfile, "end\n");
+
+    return ferror(outfile) ? -EIO : 0;
+}
+
+static int read_token(FILE *infile, char *token)
+{
+    return fscanf(infile, "%1023s", token) == 1 ? 0 : -EINVAL;
+}
+
+static int read_unsigned(FILE *infile, unsigned *value)
+{
+    char token[TOKEN_SZ];
+    if (read_token(infile, token)) return -EINVAL;
+    char *end;
+    const unsigned long v = strtoul(token, &end, 10);
+    if (*end || end == token || token[0] == '-') return -EINVAL;
+    *value = v;
+    return 0;
+}
+
+static int read_header(FILE *infile, VmafPartialResultsHeader *hdr)
+{
+    char token[TOKEN_SZ];
+    unsigned version, pix_fmt;
+
+    if (read_token(infile, token) || strcmp(token, PARTIAL_RESULTS_MAGIC))
+        return -EINVAL;
+    if (read_unsigned(infile, &version)) return -EINVAL;
+    if (version != PARTIAL_RESULTS_VERSION) {
+        vmaf_log(VMAF_LOG_LEVEL_ERROR,
+                 "unsupported partial results version: %u\n", version);
+        return -EINVAL;
+    }
+
+    if (read_token(infile, token) || strcmp(token, "libvmaf")) return -EINVAL;
+    if (read_token(infile, token)) return -EINVAL;
+    if (strcmp(token, vmaf_version())) {
+        vmaf_log(VMAF_LOG_LEVEL_WARNING,
+                 "partial results written by libvmaf %s, merging with %s\n",
+                 token, vmaf_version());
+    }
+
+    if (read_token(infile, token) || strcmp(token, "params")) return -EINVAL;
+    if (read_unsigned(infile, &hdr->w) || read_unsigned(infile, &hdr->h) ||
+        read_unsigned(infile, &pix_fmt) || read_unsigned(infile, &hdr->bpc) ||
+        read_unsigned(infile, &hdr->n_subsample))
+    {
+        return -EINVAL;
+    }
+    hdr->pix_fmt = pix_fmt;
+
+    if (read_token(infile, token) || strcmp(token, "window")) return -EINVAL;
+    if (read_unsigned(infile, &hdr->index_low) ||
+        read_unsigned(infile, &hdr->pic_cnt))
+    {
+        return -EINVAL;
+    }
+
+    return 0;
+}
+
+static int read_partial(VmafFeatureCollector *fc, FILE *infile)
+{
+    char name[TOKEN_SZ], merge[TOKEN_SZ], token[TOKEN_SZ];
+    if (read_token(infile, name) || read_token(infile, merge) ||
+        read_token(infile, token))
+    {
+        return -EINVAL;
+    }
+
+    enum VmafPartialMerge m;
+    if (!strcmp(merge, partial_merge_name[VMAF_PARTIAL_MERGE_SUM]))
+        m = VMAF_PARTIAL_MERGE_SUM;
+    else if (!strcmp(merge, partial_merge_name[VMAF_PARTIAL_MERGE_EQUAL]))
+        m = VMAF_PARTIAL_MERGE_EQUAL;
+    else
+        return -EINVAL;
+
+    char *end;
+    const uint64_t value = strtoull(token, &end, 10);
+    if (*end || end == token) return -EINVAL;
+
+    return vmaf_feature_collector_accumulate_partial(fc, name, value, m);
+}
+
+static int read_feature(VmafFeatureCollector *fc, FILE *infile)
+{
+    char name[TOKEN_SZ], token[TOKEN_SZ];
+    unsigned cnt;
+    if (read_token(infile, name) || read_unsigned(infile, &cnt))
+        return -EINVAL;
+
+    for (unsigned i = 0; i < cnt; i++) {
+        unsigned index;
+        if (read_unsigned(infile, &index) || read_token(infile, token))
+            return -EINVAL;
+        char *end;
+        const double score = strtod(token, &end);
+        if (*end || end == token) return -EINVAL;
+        int err = vmaf_feature_collector_append(fc, name, score, index);
+        if (err) return err;
+    }
+
+    return 0;
+}
+
+int vmaf_partial_results_read(VmafFeatureCollector *fc, FILE *infile,
+                              VmafPartialResultsHeader *hdr)
+{
+    if (!fc) return -EINVAL;
+    if (!infile) return -EINVAL;
+    if (!hdr) return -EINVAL;
+
+    int err = read_header(infile, hdr);
+    if (err) return err;
+
+    char token[TOKEN_SZ];
+    while (!(err = read_token(infile, token))) {
+        if (!strcmp(token, "partial"))
+            err = read_partial(fc, infile);
+        else if (!strcmp(token, "feature"))
+            err = read_feature(fc, infile);
+        else if (!strcmp(token, "end"))
+            return 0;
+        else
+            err = -EINVAL;
+        if (err) return err;
+    }
+
+    // truncated, e.g. a segment which did not finish writing
+    return -EINVAL;
+}
+
+static int lead_feature_order(VmafFeatureCollector *dst,
+                              VmafFeatureCollector *src)
+{
+    FeatureVector **fv = malloc(sizeof(*fv) * dst->capacity);
+    if (!fv) return -ENOMEM;
+    memset(fv, 0, sizeof(*fv) * dst->capacity);
+
+    unsigned n = 0;
+    for (unsigned i = 0; i < src->cnt; i++) {
+        for (unsigned j = 0; j < dst->cnt; j++) {
+            if (!dst->feature_vector[j]) continue;
+            if (strcmp(dst->feature_vector[j]->name,
+                       src->feature_vector[i]->name))
+            {
+                continue;
+            }
+            fv[n++] = dst->feature_vector[j];
+            dst->feature_vector[j] = NULL;
+            break;
+        }
+    }
+
+    for (unsigned j = 0; j < dst->cnt; j++) {
+        if (dst->feature_vector[j])
+            fv[n++] = dst->feature_vector[j];
+    }
+
+    free(dst->feature_vector);
+    dst->feature_vector = fv;
+    return 0;
+}
+
+int vmaf_partial_results_merge(VmafFeatureCollector *dst,
+                               VmafFeatureCollector *src, bool leading)
+{
+    if (!dst) return -EINVAL;
+    if (!src) return -EINVAL;
+
+    int err = 0;
+
+    for (unsigned i = 0; i < src->cnt; i++) {
+        FeatureVector *fv = src->feature_vector[i];
+        for (unsigned j = 0; j < fv->capacity; j++) {
+            if (!fv->score[j].written) continue;
+            err = vmaf_feature_collector_append(dst, fv->name,
+                                                fv->score[j].value, j);
+            if (err) return err;
+        }
+    }
+
+    for (unsigned i = 0; i < src->partial_vector.cnt; i++) {
+        err = vmaf_feature_collector_accumulate_partial(dst,
+                                        src->partial_vector.metric[i].name,
+                                        src->partial_vector.metric[i].value,
+                                        src->partial_vector.metric[i].merge);
+        if (err) {
+            vmaf_log(VMAF_LOG_LEVEL_ERROR,
+                     "partial state \"%s\" can not be merged\n",
+                     src->partial_vector.metric[i].name);
+            return err;
+        }
+    }
+
+    if (leading) {
+        err = lead_feature_order(dst, src);
+        if (err) return err;
+    }
+
+    vmaf_feature_collector_clear_aggregates(dst);
+    return vmaf_apsnr_set_aggregates(dst);
+}
@@ -0,0 +1,53 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef __VMAF_PARTIAL_RESULTS_H__
+#define __VMAF_PARTIAL_RESULTS_H__
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "feature/feature_collector.h"
+#include "libvmaf/picture.h"
+
+typedef struct VmafPartialResultsHeader {
+    unsigned w, h;
+    enum VmafPixelFormat pix_fmt;
+    unsigned bpc;
+    unsigned n_subsample;
+    unsigned index_low;
+    unsigned pic_cnt;
+} VmafPartialResultsHeader;
+
+int vmaf_partial_results_write(VmafFeatureCollector *fc, FILE *outfile,
+                               const VmafPartialResultsHeader *hdr);
+
+int vmaf_partial_results_read(VmafFeatureCollector *fc, FILE *infile,
+                              VmafPartialResultsHeader *hdr);
+
+/**
+ * Merge the scores and partial state of `src` into `dst`. The window of
+ * `dst` must already cover the scores of `src`. If `src` is the leading
+ * segment, i.e. it has the lowest picture indices merged so far, its
+ * feature order takes precedence so that the merged output is laid out
+ * exactly like the output of a single run.
+ */
+int vmaf_partial_results_merge(VmafFeatureCollector *dst,
+                               VmafFeatureCollector *src, bool leading);
+
+#endif /* __VMAF_PARTIAL_RESULTS_H__ */
@@ -25,7 +25,7 @@
 #include "picture.h"
 #include "ref.h"
 
-#define DATA_ALIGN 32
+#define DATA_ALIGN VMAF_PICTURE_DATA_ALIGN
 
 static int default_release_picture(VmafPicture *pic, void *cookie)
 {
@@ -56,15 +56,9 @@ int vmaf_picture_priv_init(VmafPicture *pic)
     return 0;
 }
 
-int vmaf_picture_alloc(VmafPicture *pic, enum VmafPixelFormat pix_fmt,
-                       unsigned bpc, unsigned w, unsigned h)
+size_t vmaf_picture_layout(VmafPicture *pic, enum VmafPixelFormat pix_fmt,
+                           unsigned bpc, unsigned w, unsigned h)
 {
-    if (!pic) return -EINVAL;
-    if (!pix_fmt) return -EINVAL;
-    if (bpc < 8 || bpc > 16) return -EINVAL;
-
-    int err = 0;
-
     memset(pic, 0, sizeof(*pic));
     pic->pix_fmt = pix_fmt;
     pic->bpc = bpc;
@@ -84,16 +78,34 @@ int vmaf_picture_alloc(VmafPicture *pic, enum VmafPixelFormat pix_fmt,
     pic->stride[1] = pic->stride[2] = aligned_c << hbd;
     const size_t y_sz = pic->stride[0] * pic->h[0];
     const size_t uv_sz = pic->stride[1] * pic->h[1];
-    const size_t pic_size = y_sz + 2 * uv_sz;
+    return y_sz + 2 * uv_sz;
+}
 
-    uint8_t *data = aligned_malloc(pic_size, DATA_ALIGN);
-    if (!data) goto fail;
-    memset(data, 0, pic_size);
+void vmaf_picture_set_data(VmafPicture *pic, uint8_t *data)
+{
+    const size_t y_sz = pic->stride[0] * pic->h[0];
+    const size_t uv_sz = pic->stride[1] * pic->h[1];
     pic->data[0] = data;
     pic->data[1] = data + y_sz;
     pic->data[2] = data + y_sz + uv_sz;
     if (pic->pix_fmt == VMAF_PIX_FMT_YUV400P)
         pic->data[1] = pic->data[2] = NULL;
+}
+
+int vmaf_picture_alloc(VmafPicture *pic, enum VmafPixelFormat pix_fmt,
+                       unsigned bpc, unsigned w, unsigned h)
+{
+    if (!pic) return -EINVAL;
+    if (!pix_fmt) return -EINVAL;
+    if (bpc < 8 || bpc > 16) return -EINVAL;
+
+    int err = 0;
+
+    const size_t pic_size = vmaf_picture_layout(pic, pix_fmt, bpc, w, h);
+    uint8_t *data = aligned_malloc(pic_size, DATA_ALIGN);
+    if (!data) goto fail;
+    memset(data, 0, pic_size);
+    vmaf_picture_set_data(pic, data);
 
     err |= vmaf_picture_priv_init(pic);
     err |= vmaf_picture_set_release_callback(pic, NULL, default_release_picture);
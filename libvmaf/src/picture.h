@@ -23,8 +23,13 @@
 #include <cuda.h>
 #include "libvmaf/libvmaf_cuda.h"
 #endif
+#include <stddef.h>
+#include <stdint.h>
+
 #include "libvmaf/picture.h"
 
+#define VMAF_PICTURE_DATA_ALIGN 32
+
 enum VmafPictureBufferType {
     VMAF_PICTURE_BUFFER_TYPE_HOST = 0,
     VMAF_PICTURE_BUFFER_TYPE_CUDA_HOST_PINNED,
@@ -46,7 +51,15 @@ typedef struct VmafPicturePrivate {
 
 int vmaf_picture_priv_init(VmafPicture *pic);
 
-int vmaf_picture_ref(VmafPicture *dst, VmafPicture *src);
+/**
+ * Set the geometry and strides of `pic` as `vmaf_picture_alloc()` would,
+ * without allocating. Returns the size of the single data buffer backing
+ * all planes, which is then attached with `vmaf_picture_set_data()`.
+ */
+size_t vmaf_picture_layout(VmafPicture *pic, enum VmafPixelFormat pix_fmt,
+                           unsigned bpc, unsigned w, unsigned h);
+
+void vmaf_picture_set_data(VmafPicture *pic, uint8_t *data);
 
 int vmaf_picture_set_release_callback(VmafPicture *pic, void *cookie,
                         int (*release_picture)(VmafPicture *pic, void *cookie));
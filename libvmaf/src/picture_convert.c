@@ -0,0 +1,123 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "config.h"
+#include "cpu.h"
+#include "picture_convert.h"
+#include "libvmaf/picture.h"
+
+#if ARCH_X86
+#include "x86/picture_convert_avx2.h"
+#endif
+
+void picture_widen_8_16_c(uint16_t *dst, ptrdiff_t dst_stride,
+                          const uint8_t *src, ptrdiff_t src_stride,
+                          unsigned w, unsigned h, unsigned shift)
+{
+    for (unsigned i = 0; i < h; i++) {
+        for (unsigned j = 0; j < w; j++)
+            dst[j] = src[j] << shift;
+        src += src_stride;
+        dst += dst_stride / sizeof(*dst);
+    }
+}
+
+void picture_shift_16_c(uint16_t *dst, ptrdiff_t dst_stride,
+                        const uint16_t *src, ptrdiff_t src_stride,
+                        unsigned w, unsigned h, unsigned shift)
+{
+    for (unsigned i = 0; i < h; i++) {
+        for (unsigned j = 0; j < w; j++)
+            dst[j] = src[j] << shift;
+        src += src_stride / sizeof(*src);
+        dst += dst_stride / sizeof(*dst);
+    }
+}
+
+static void copy_plane(uint8_t *dst, ptrdiff_t dst_stride,
+                       const uint8_t *src, ptrdiff_t src_stride,
+                       size_t row_sz, unsigned h)
+{
+    if (dst_stride == src_stride && (size_t) dst_stride == row_sz) {
+        memcpy(dst, src, row_sz * h);
+        return;
+    }
+    for (unsigned i = 0; i < h; i++) {
+        memcpy(dst, src, row_sz);
+        src += src_stride;
+        dst += dst_stride;
+    }
+}
+
+int vmaf_picture_copy_plane(void *dst, ptrdiff_t dst_stride, unsigned dst_bpc,
+                            const void *src, ptrdiff_t src_stride,
+                            unsigned src_bpc, unsigned w, unsigned h)
+{
+    if (!dst || !src) return -EINVAL;
+    if (src_bpc < 8 || src_bpc > 16) return -EINVAL;
+    if (dst_bpc < src_bpc || dst_bpc > 16) return -EINVAL;
+
+    if (dst_bpc == src_bpc) {
+        const size_t row_sz = (size_t) w << (src_bpc > 8);
+        copy_plane(dst, dst_stride, src, src_stride, row_sz, h);
+        return 0;
+    }
+
+    void (*widen_8_16)(uint16_t *, ptrdiff_t, const uint8_t *, ptrdiff_t,
+                       unsigned, unsigned, unsigned) = picture_widen_8_16_c;
+    void (*shift_16)(uint16_t *, ptrdiff_t, const uint16_t *, ptrdiff_t,
+                     unsigned, unsigned, unsigned) = picture_shift_16_c;
+#if ARCH_X86
+    if (vmaf_get_cpu_flags() & VMAF_X86_CPU_FLAG_AVX2) {
+        widen_8_16 = picture_widen_8_16_avx2;
+        shift_16 = picture_shift_16_avx2;
+    }
+#endif
+
+    const unsigned shift = dst_bpc - src_bpc;
+    if (src_bpc == 8)
+        widen_8_16(dst, dst_stride, src, src_stride, w, h, shift);
+    else
+        shift_16(dst, dst_stride, src, src_stride, w, h, shift);
+
+    return 0;
+}
+
+int vmaf_picture_copy_planes(VmafPicture *pic, void *const data[3],
+                             const ptrdiff_t stride[3], unsigned bpc)
+{
+    if (!pic) return -EINVAL;
+    if (!data || !stride) return -EINVAL;
+
+    int err = 0;
+    for (unsigned i = 0; i < 3; i++) {
+        // planes the picture does not carry, e.g. yuv400 chroma, are dropped
+        if (!pic->data[i] || !pic->w[i] || !pic->h[i]) continue;
+        err = vmaf_picture_copy_plane(pic->data[i], pic->stride[i], pic->bpc,
+                                      data[i], stride[i], bpc,
+                                      pic->w[i], pic->h[i]);
+        if (err) return err;
+    }
+
+    return 0;
+}
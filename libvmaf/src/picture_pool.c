@@ -0,0 +1,173 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem.h"
+#include "picture.h"
+#include "picture_pool.h"
+#include "ref.h"
+
+typedef struct VmafPicturePool {
+    VmafPicturePoolConfig cfg;
+    size_t buf_sz;
+    pthread_mutex_t lock;
+    uint8_t **free_buf;
+    unsigned free_cnt, capacity;
+    unsigned outstanding;
+    bool closed;
+} VmafPicturePool;
+
+static void pool_destroy(VmafPicturePool *pool)
+{
+    for (unsigned i = 0; i < pool->free_cnt; i++)
+        aligned_free(pool->free_buf[i]);
+    free(pool->free_buf);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool);
+}
+
+static int push_free_buf(VmafPicturePool *pool, uint8_t *buf)
+{
+    if (pool->free_cnt == pool->capacity) {
+        const unsigned capacity = pool->capacity ? pool->capacity * 2 : 4;
+        uint8_t **free_buf =
+            realloc(pool->free_buf, sizeof(*free_buf) * capacity);
+        if (!free_buf) return -ENOMEM;
+        pool->free_buf = free_buf;
+        pool->capacity = capacity;
+    }
+    pool->free_buf[pool->free_cnt++] = buf;
+    return 0;
+}
+
+static int release_picture(VmafPicture *pic, void *cookie)
+{
+    VmafPicturePool *pool = cookie;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->outstanding--;
+    if (pool->closed || push_free_buf(pool, pic->data[0]))
+        aligned_free(pic->data[0]);
+    const bool destroy = pool->closed && !pool->outstanding;
+    pthread_mutex_unlock(&pool->lock);
+
+    if (destroy) pool_destroy(pool);
+    return 0;
+}
+
+int vmaf_picture_pool_init(VmafPicturePool **pool, VmafPicturePoolConfig cfg)
+{
+    if (!pool) return -EINVAL;
+    if (!cfg.w || !cfg.h) return -EINVAL;
+    if (!cfg.pix_fmt) return -EINVAL;
+    if (cfg.bpc < 8 || cfg.bpc > 16) return -EINVAL;
+
+    VmafPicturePool *const p = *pool = malloc(sizeof(*p));
+    if (!p) return -ENOMEM;
+    memset(p, 0, sizeof(*p));
+    p->cfg = cfg;
+    pthread_mutex_init(&p->lock, NULL);
+
+    VmafPicture pic;
+    p->buf_sz = vmaf_picture_layout(&pic, cfg.pix_fmt, cfg.bpc, cfg.w, cfg.h);
+
+    for (unsigned i = 0; i < cfg.pic_cnt; i++) {
+        uint8_t *buf = aligned_malloc(p->buf_sz, VMAF_PICTURE_DATA_ALIGN);
+        if (!buf) goto fail;
+        // zeroed once, so that row padding is deterministic
+        memset(buf, 0, p->buf_sz);
+        if (push_free_buf(p, buf)) {
+            aligned_free(buf);
+            goto fail;
+        }
+    }
+
+    return 0;
+
+fail:
+    pool_destroy(p);
+    *pool = NULL;
+    return -ENOMEM;
+}
+
+int vmaf_picture_pool_fetch(VmafPicturePool *pool, VmafPicture *pic)
+{
+    if (!pool) return -EINVAL;
+    if (!pic) return -EINVAL;
+
+    const VmafPicturePoolConfig *cfg = &pool->cfg;
+    vmaf_picture_layout(pic, cfg->pix_fmt, cfg->bpc, cfg->w, cfg->h);
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->closed) {
+        pthread_mutex_unlock(&pool->lock);
+        return -EINVAL;
+    }
+    uint8_t *buf = pool->free_cnt ? pool->free_buf[--pool->free_cnt] : NULL;
+    pool->outstanding++;
+    pthread_mutex_unlock(&pool->lock);
+
+    int err = 0;
+    if (!buf) {
+        buf = aligned_malloc(pool->buf_sz, VMAF_PICTURE_DATA_ALIGN);
+        if (!buf) {
+            err = -ENOMEM;
+            goto fail;
+        }
+        memset(buf, 0, pool->buf_sz);
+    }
+    vmaf_picture_set_data(pic, buf);
+
+    err = vmaf_picture_priv_init(pic);
+    if (err) goto free_buf;
+    err = vmaf_picture_set_release_callback(pic, pool, release_picture);
+    if (err) goto free_priv;
+    err = vmaf_ref_init(&pic->ref);
+    if (err) goto free_priv;
+
+    return 0;
+
+free_priv:
+    free(pic->priv);
+free_buf:
+    aligned_free(buf);
+fail:
+    pthread_mutex_lock(&pool->lock);
+    pool->outstanding--;
+    pthread_mutex_unlock(&pool->lock);
+    memset(pic, 0, sizeof(*pic));
+    return err ? err : -ENOMEM;
+}
+
+int vmaf_picture_pool_close(VmafPicturePool *pool)
+{
+    if (!pool) return -EINVAL;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->closed = true;
+    const bool destroy = !pool->outstanding;
+    pthread_mutex_unlock(&pool->lock);
+
+    if (destroy) pool_destroy(pool);
+    return 0;
+}
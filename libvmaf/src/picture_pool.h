@@ -0,0 +1,43 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef __VMAF_SRC_PICTURE_POOL_H__
+#define __VMAF_SRC_PICTURE_POOL_H__
+
+#include "picture.h"
+
+typedef struct VmafPicturePoolConfig {
+    unsigned pic_cnt;
+    unsigned w, h;
+    unsigned bpc;
+    enum VmafPixelFormat pix_fmt;
+} VmafPicturePoolConfig;
+
+typedef struct VmafPicturePool VmafPicturePool;
+
+int vmaf_picture_pool_init(VmafPicturePool **pool, VmafPicturePoolConfig cfg);
+
+// Pictures are handed out with their previous contents, not zeroed. When the
+// pool is empty a new buffer is allocated rather than waiting for a release,
+// since pictures may be held by the thread pool for an unbounded time.
+int vmaf_picture_pool_fetch(VmafPicturePool *pool, VmafPicture *pic);
+
+// Outstanding pictures stay valid; their buffers are freed on final unref.
+int vmaf_picture_pool_close(VmafPicturePool *pool);
+
+#endif /* __VMAF_SRC_PICTURE_POOL_H__ */
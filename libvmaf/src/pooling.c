@@ -0,0 +1,139 @@
+/**
+ *
+ *  Copyright 2016-2024 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+
+#include "pooling.h"
+
+static const char *pool_method_name[] = {
+    [VMAF_POOL_METHOD_MIN] = "min",
+    [VMAF_POOL_METHOD_MAX] = "max",
+    [VMAF_POOL_METHOD_MEAN] = "mean",
+    [VMAF_POOL_METHOD_HARMONIC_MEAN] = "harmonic_mean",
+};
+
+bool vmaf_pooling_cfg_is_valid(VmafPoolingConfiguration cfg)
+{
+    switch (cfg.method) {
+    case VMAF_POOL_METHOD_MIN:
+    case VMAF_POOL_METHOD_MAX:
+    case VMAF_POOL_METHOD_MEAN:
+    case VMAF_POOL_METHOD_HARMONIC_MEAN:
+        return true;
+    case VMAF_POOL_METHOD_PERCENTILE:
+        return cfg.param >= 0. && cfg.param <= 100.;
+    case VMAF_POOL_METHOD_WINDOW_MIN:
+        return cfg.param >= 1. && cfg.param <= 4294967295. &&
+               cfg.param == floor(cfg.param);
+    default:
+        return false;
+    }
+}
+
+int vmaf_pooling_cfg_name(VmafPoolingConfiguration cfg, char *name,
+                          size_t name_sz)
+{
+    if (!vmaf_pooling_cfg_is_valid(cfg)) return -EINVAL;
+
+    int n;
+    switch (cfg.method) {
+    case VMAF_POOL_METHOD_PERCENTILE:
+        n = snprintf(name, name_sz, "p%g", cfg.param);
+        break;
+    case VMAF_POOL_METHOD_WINDOW_MIN:
+        n = snprintf(name, name_sz, "min_window%.0f", cfg.param);
+        break;
+    default:
+        n = snprintf(name, name_sz, "%s", pool_method_name[cfg.method]);
+        break;
+    }
+
+    return n < 0 || (size_t) n >= name_sz ? -EINVAL : 0;
+}
+
+static void swap(double *a, int i, int j)
+{
+    const double t = a[i];
+    a[i] = a[j];
+    a[j] = t;
+}
+
+// Quickselect: reorders a so that a[k] is in its sorted position, a[0, k)
+// are not above it and a(k, cnt) are not below it.
+static void select_kth(double *a, unsigned cnt, unsigned k)
+{
+    int lo = 0, hi = cnt - 1;
+
+    while (lo < hi) {
+        // median of three, so that sorted scores do not degrade to O(n^2)
+        const int mid = lo + (hi - lo) / 2;
+        if (a[mid] < a[lo]) swap(a, mid, lo);
+        if (a[hi] < a[lo]) swap(a, hi, lo);
+        if (a[hi] < a[mid]) swap(a, hi, mid);
+        const double pivot = a[mid];
+
+        int i = lo, j = hi;
+        while (i <= j) {
+            while (a[i] < pivot) i++;
+            while (a[j] > pivot) j--;
+            if (i <= j) swap(a, i++, j--);
+        }
+
+        // [lo, j] are not above pivot, [i, hi] not below, (j, i) equal to it
+        if ((int) k <= j)
+            hi = j;
+        else if ((int) k >= i)
+            lo = i;
+        else
+            return;
+    }
+}
+
+double vmaf_pool_percentile(double *scores, unsigned cnt, double p)
+{
+    const double rank = p / 100. * (cnt - 1);
+    const unsigned k = floor(rank);
+    select_kth(scores, cnt, k);
+    if (k + 1 >= cnt || rank == k) return scores[k];
+
+    // the next rank is the lowest score above k
+    double next = scores[k + 1];
+    for (unsigned i = k + 2; i < cnt; i++) {
+        if (scores[i] < next) next = scores[i];
+    }
+    return scores[k] + (next - scores[k]) * (rank - k);
+}
+
+double vmaf_pool_window_min(const double *scores, unsigned cnt,
+                            unsigned window)
+{
+    if (window > cnt) window = cnt;
+
+    double sum = 0.;
+    for (unsigned i = 0; i < window; i++)
+        sum += scores[i];
+
+    double min = sum;
+    for (unsigned i = window; i < cnt; i++) {
+        sum += scores[i] - scores[i - window];
+        if (sum < min) min = sum;
+    }
+    return min / window;
+}
@@ -0,0 +1,46 @@
+/**
+ *
+ *  Copyright 2016-2024 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef __VMAF_POOLING_H__
+#define __VMAF_POOLING_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "libvmaf/libvmaf.h"
+
+// pooling methods a context adds to its output
+#define POOLING_CFG_LEN 32
+
+bool vmaf_pooling_cfg_is_valid(VmafPoolingConfiguration cfg);
+
+// Writes the name of cfg in pooled metrics, e.g. "mean", "p5", "min_window48".
+int vmaf_pooling_cfg_name(VmafPoolingConfiguration cfg, char *name,
+                          size_t name_sz);
+
+/*
+ * Percentile p of the cnt scores, interpolated linearly between the nearest
+ * ranks. scores is reordered.
+ */
+double vmaf_pool_percentile(double *scores, unsigned cnt, double p);
+
+// Lowest mean of window consecutive scores, or the mean if cnt < window.
+double vmaf_pool_window_min(const double *scores, unsigned cnt,
+                            unsigned window);
+
+#endif /* __VMAF_POOLING_H__ */
@@ -30,6 +30,7 @@
 #include "log.h"
 #include "model.h"
 #include "predict.h"
+#include "shared_kernel.h"
 #include "svm.h"
 
 static int normalize(const VmafModel *model, double slope, double intercept,
@@ -224,22 +225,13 @@ static int clip(const VmafModel *model, double *prediction,
     return 0;
 }
 
-int vmaf_predict_score_at_index(VmafModel *model,
-                                VmafFeatureCollector *feature_collector,
-                                unsigned index, double *vmaf_score,
-                                bool write_prediction,
-                                bool propagate_metadata,
-                                enum VmafModelFlags flags)
+static int normalized_features(VmafModel *model,
+                               VmafFeatureCollector *feature_collector,
+                               unsigned index, struct svm_node *node,
+                               bool propagate_metadata)
 {
-    if (!model) return -EINVAL;
-    if (!feature_collector) return -EINVAL;
-    if (!vmaf_score) return -EINVAL;
-
     int err = 0;
 
-    struct svm_node *node = malloc(sizeof(*node) * (model->n_features + 1));
-    if (!node) return -ENOMEM;
-
     for (unsigned i = 0; i < model->n_features; i++) {
         VmafFeatureExtractor *fex =
             vmaf_get_feature_extractor_by_feature_name(model->feature[i].name, 0);
@@ -248,8 +240,7 @@ int vmaf_predict_score_at_index(VmafModel *model,
             vmaf_log(VMAF_LOG_LEVEL_ERROR,
                      "vmaf_predict_score_at_index(): no feature extractor "
                      "providing feature '%s'\n", model->feature[i].name);
-            err = -EINVAL;
-            goto free_node;
+            return -EINVAL;
         }
 
         VmafDictionary *opts_dict = NULL;
@@ -278,8 +269,7 @@ int vmaf_predict_score_at_index(VmafModel *model,
             vmaf_log(VMAF_LOG_LEVEL_ERROR,
                      "vmaf_predict_score_at_index(): could not generate "
                      "feature name\n");
-            err = -ENOMEM;
-            goto free_node;
+            return -ENOMEM;
         }
 
         double feature_score;
@@ -294,19 +284,40 @@ int vmaf_predict_score_at_index(VmafModel *model,
                        "at index %d\n", feature_name, index);
             }
             free(feature_name);
-            goto free_node;
+            return err;
         }
         free(feature_name);
 
         err = normalize(model, model->feature[i].slope,
                         model->feature[i].intercept, &feature_score);
-        if (err) goto free_node;
+        if (err) return err;
 
         node[i].index = i + 1;
         node[i].value = feature_score;
     }
     node[model->n_features].index = -1;
 
+    return 0;
+}
+
+int vmaf_predict_score_at_index(VmafModel *model,
+                                VmafFeatureCollector *feature_collector,
+                                unsigned index, double *vmaf_score,
+                                bool write_prediction,
+                                bool propagate_metadata,
+                                enum VmafModelFlags flags)
+{
+    if (!model) return -EINVAL;
+    if (!feature_collector) return -EINVAL;
+    if (!vmaf_score) return -EINVAL;
+
+    struct svm_node *node = malloc(sizeof(*node) * (model->n_features + 1));
+    if (!node) return -ENOMEM;
+
+    int err = normalized_features(model, feature_collector, index, node,
+                                  propagate_metadata);
+    if (err) goto free_node;
+
     double prediction = svm_predict(model->svm, node);
 
     err = denormalize(model, &prediction);
@@ -351,6 +362,46 @@ static double percentile(double *scores, unsigned n_scores, double perc)
         scores[idx_l] * (idx_r - p) + scores[idx_r] * (p - idx_l);
 }
 
+/*
+ * Same scores as vmaf_predict_score_at_index() for every model of the
+ * collection, with and without transform/clip, but with every distinct
+ * kernel value evaluated once. Only the unclipped scores are returned.
+ */
+static int shared_kernel_predict(VmafModelCollection *model_collection,
+                                 VmafFeatureCollector *feature_collector,
+                                 unsigned index, double *scores)
+{
+    VmafModel *model = model_collection->model[0];
+    struct svm_node *node = malloc(sizeof(*node) * (model->n_features + 1));
+    if (!node) return -ENOMEM;
+
+    int err = normalized_features(model, feature_collector, index, node,
+                                  false);
+    if (err) goto free_node;
+    err = vmaf_shared_kernel_predict(model_collection->shared_kernel, node,
+                                     scores);
+    if (err) goto free_node;
+
+    for (unsigned i = 0; i < model_collection->cnt; i++) {
+        model = model_collection->model[i];
+        err = denormalize(model, &scores[i]);
+        if (err) goto free_node;
+
+        double score = scores[i];
+        err = transform(model, &score, 0);
+        if (err) goto free_node;
+        err = clip(model, &score, 0);
+        if (err) goto free_node;
+        err = vmaf_feature_collector_append(feature_collector, model->name,
+                                            score, index);
+        if (err) goto free_node;
+    }
+
+free_node:
+    free(node);
+    return err;
+}
+
 static int vmaf_bootstrap_predict_score_at_index(
                                         VmafModelCollection *model_collection,
                                         VmafFeatureCollector *feature_collector,
@@ -360,25 +411,31 @@ static int vmaf_bootstrap_predict_score_at_index(
     int err = 0;
     double scores[model_collection->cnt];
 
-    for (unsigned i = 0; i < model_collection->cnt; i++) {
-        // mean, stddev, etc. are calculated on untransformed/unclipped scores
-        // gather the unclipped scores, for the purposes of these calculations
-        // but do not write them to the feature collector
-        const unsigned flags =
-            VMAF_MODEL_FLAG_DISABLE_CLIP | VMAF_MODEL_FLAG_DISABLE_TRANSFORM;
-        err = vmaf_predict_score_at_index(model_collection->model[i],
-                                          feature_collector, index,
-                                          &scores[i], false,
-                                          false, flags);
+    if (model_collection->shared_kernel) {
+        err = shared_kernel_predict(model_collection, feature_collector,
+                                    index, scores);
         if (err) return err;
+    } else {
+        for (unsigned i = 0; i < model_collection->cnt; i++) {
+            // mean, stddev, etc. are calculated on untransformed/unclipped
+            // scores, gather the unclipped scores, for the purposes of these
+            // calculations but do not write them to the feature collector
+            const unsigned flags =
+                VMAF_MODEL_FLAG_DISABLE_CLIP | VMAF_MODEL_FLAG_DISABLE_TRANSFORM;
+            err = vmaf_predict_score_at_index(model_collection->model[i],
+                                              feature_collector, index,
+                                              &scores[i], false,
+                                              false, flags);
+            if (err) return err;
 
-        // do not override the model's transform/clip behavior
-        // write the scores to the feature collector
-        double score;
-        err = vmaf_predict_score_at_index(model_collection->model[i],
-                                          feature_collector, index,
-                                          &score, true, false, 0);
-        if (err) return err;
+            // do not override the model's transform/clip behavior
+            // write the scores to the feature collector
+            double score;
+            err = vmaf_predict_score_at_index(model_collection->model[i],
+                                              feature_collector, index,
+                                              &score, true, false, 0);
+            if (err) return err;
+        }
     }
 
     score->type = VMAF_MODEL_COLLECTION_SCORE_BOOTSTRAP;
@@ -528,7 +528,8 @@ static int model_collection_parse(json_stream *s, VmafModel **model,
 
     free((char*)name);
     if (!(*model_collection)) return -EINVAL;
-    return err;
+    if (err) return err;
+    return vmaf_model_collection_share_kernels(*model_collection);
 }
 
 int vmaf_read_json_model_collection_from_path(VmafModel **model,
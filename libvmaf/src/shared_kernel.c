@@ -0,0 +1,196 @@
+/**
+ *
+ *  Copyright 2016-2024 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dict.h"
+#include "model.h"
+#include "shared_kernel.h"
+#include "svm.h"
+
+typedef struct VmafSharedKernel {
+    const struct svm_model *param_model;
+    const struct svm_node **sv;
+    unsigned sv_cnt;
+    struct {
+        const struct svm_model *svm;
+        int *kvalue_index;
+    } *member;
+    unsigned member_cnt;
+} VmafSharedKernel;
+
+static bool is_shareable(const VmafModel *a, const VmafModel *b)
+{
+    const struct svm_parameter *pa = &a->svm->param;
+    const struct svm_parameter *pb = &b->svm->param;
+
+    if (pb->svm_type != NU_SVR && pb->svm_type != EPSILON_SVR) return false;
+    if (pb->kernel_type != RBF) return false;
+    if (pa->svm_type != pb->svm_type) return false;
+    if (pa->kernel_type != pb->kernel_type) return false;
+    if (pa->gamma != pb->gamma) return false;
+
+    if (a->norm_type != b->norm_type) return false;
+    if (a->n_features != b->n_features) return false;
+    for (unsigned i = 0; i < a->n_features; i++) {
+        if (strcmp(a->feature[i].name, b->feature[i].name)) return false;
+        if (a->feature[i].slope != b->feature[i].slope) return false;
+        if (a->feature[i].intercept != b->feature[i].intercept) return false;
+        if (vmaf_dictionary_compare(a->feature[i].opts_dict,
+                                    b->feature[i].opts_dict))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// FNV-1a over the indices and the bit patterns of the values
+static uint64_t sv_hash(const struct svm_node *sv)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (; sv->index != -1; sv++) {
+        uint64_t bits;
+        memcpy(&bits, &sv->value, sizeof(bits));
+        const uint64_t word[2] = { (uint64_t) sv->index, bits };
+        for (unsigned i = 0; i < 2; i++) {
+            for (unsigned j = 0; j < 8; j++) {
+                h ^= (word[i] >> (8 * j)) & 0xff;
+                h *= 0x100000001b3ULL;
+            }
+        }
+    }
+    return h;
+}
+
+// kernel values only depend on the node values, compared bit by bit
+static bool sv_equal(const struct svm_node *a, const struct svm_node *b)
+{
+    for (; a->index != -1 && b->index != -1; a++, b++) {
+        if (a->index != b->index) return false;
+        if (memcmp(&a->value, &b->value, sizeof(a->value))) return false;
+    }
+    return a->index == b->index;
+}
+
+int vmaf_shared_kernel_init(VmafSharedKernel **sk, VmafModel **model,
+                            unsigned cnt)
+{
+    if (!sk) return -EINVAL;
+    if (!model) return -EINVAL;
+
+    *sk = NULL;
+    if (cnt < 2) return 0;
+    for (unsigned i = 0; i < cnt; i++) {
+        if (!model[i]->svm) return 0;
+        if (!is_shareable(model[0], model[i])) return 0;
+    }
+
+    unsigned total = 0;
+    for (unsigned i = 0; i < cnt; i++)
+        total += model[i]->svm->l;
+
+    unsigned capacity = 16;
+    while (capacity < 2 * total) capacity *= 2;
+
+    VmafSharedKernel *const s = malloc(sizeof(*s));
+    if (!s) return -ENOMEM;
+    memset(s, 0, sizeof(*s));
+    s->param_model = model[0]->svm;
+
+    // slots hold a distinct support vector index + 1, 0 is empty
+    unsigned *slot = calloc(capacity, sizeof(*slot));
+    s->sv = malloc(sizeof(*s->sv) * (total ? total : 1));
+    s->member = calloc(cnt, sizeof(*s->member));
+    if (!slot || !s->sv || !s->member) goto fail;
+    s->member_cnt = cnt;
+
+    for (unsigned i = 0; i < cnt; i++) {
+        const struct svm_model *svm = model[i]->svm;
+        s->member[i].svm = svm;
+        s->member[i].kvalue_index =
+            malloc(sizeof(*s->member[i].kvalue_index) * (svm->l ? svm->l : 1));
+        if (!s->member[i].kvalue_index) goto fail;
+
+        for (int j = 0; j < svm->l; j++) {
+            const struct svm_node *sv = svm->SV[j];
+            unsigned k = sv_hash(sv) & (capacity - 1);
+            while (slot[k] && !sv_equal(s->sv[slot[k] - 1], sv))
+                k = (k + 1) & (capacity - 1);
+            if (!slot[k]) {
+                s->sv[s->sv_cnt++] = sv;
+                slot[k] = s->sv_cnt;
+            }
+            s->member[i].kvalue_index[j] = slot[k] - 1;
+        }
+    }
+
+    free(slot);
+    *sk = s;
+    return 0;
+
+fail:
+    free(slot);
+    vmaf_shared_kernel_destroy(s);
+    return -ENOMEM;
+}
+
+int vmaf_shared_kernel_predict(VmafSharedKernel *sk, const struct svm_node *x,
+                               double *prediction)
+{
+    if (!sk) return -EINVAL;
+    if (!x) return -EINVAL;
+    if (!prediction) return -EINVAL;
+
+    double *kvalue = malloc(sizeof(*kvalue) * (sk->sv_cnt ? sk->sv_cnt : 1));
+    if (!kvalue) return -ENOMEM;
+
+    for (unsigned i = 0; i < sk->sv_cnt; i++)
+        kvalue[i] = svm_kernel_value(sk->param_model, x, sk->sv[i]);
+
+    for (unsigned i = 0; i < sk->member_cnt; i++) {
+        prediction[i] =
+            svm_predict_values_from_kernel(sk->member[i].svm, kvalue,
+                                           sk->member[i].kvalue_index);
+    }
+
+    free(kvalue);
+    return 0;
+}
+
+unsigned vmaf_shared_kernel_sv_cnt(VmafSharedKernel *sk)
+{
+    return sk ? sk->sv_cnt : 0;
+}
+
+void vmaf_shared_kernel_destroy(VmafSharedKernel *sk)
+{
+    if (!sk) return;
+    if (sk->member) {
+        for (unsigned i = 0; i < sk->member_cnt; i++)
+            free(sk->member[i].kvalue_index);
+    }
+    free(sk->member);
+    free(sk->sv);
+    free(sk);
+}
@@ -0,0 +1,48 @@
+/**
+ *
+ *  Copyright 2016-2024 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef __VMAF_SRC_SHARED_KERNEL_H__
+#define __VMAF_SRC_SHARED_KERNEL_H__
+
+#include "libvmaf/model.h"
+#include "svm.h"
+
+typedef struct VmafSharedKernel VmafSharedKernel;
+
+/*
+ * Collects the distinct support vectors of cnt models, which are trained on
+ * resamples of the same data. Sharing requires RBF regression models with
+ * the same gamma, which normalize the same features in the same way.
+ * Otherwise *sk is set to NULL, and 0 is returned.
+ */
+int vmaf_shared_kernel_init(VmafSharedKernel **sk, VmafModel **model,
+                            unsigned cnt);
+
+/*
+ * Evaluates every distinct kernel value once, and writes the decision value
+ * of each model to prediction. These are identical to svm_predict() for the
+ * individual models, for the normalized features x.
+ */
+int vmaf_shared_kernel_predict(VmafSharedKernel *sk, const struct svm_node *x,
+                               double *prediction);
+
+unsigned vmaf_shared_kernel_sv_cnt(VmafSharedKernel *sk);
+
+void vmaf_shared_kernel_destroy(VmafSharedKernel *sk);
+
+#endif /* __VMAF_SRC_SHARED_KERNEL_H__ */
@@ -2578,6 +2578,25 @@ double svm_predict_values(const svm_model *model, const svm_node *x, double* dec
 	}
 }
 
+double svm_kernel_value(const svm_model *model, const svm_node *x,
+			const svm_node *sv)
+{
+	return Kernel::k_function(x,sv,model->param);
+}
+
+double svm_predict_values_from_kernel(const svm_model *model,
+				      const double *kvalue,
+				      const int *kvalue_index)
+{
+	// same accumulation order as svm_predict_values(), results are identical
+	double *sv_coef = model->sv_coef[0];
+	double sum = 0;
+	for(int i=0;i<model->l;i++)
+		sum += sv_coef[i] * kvalue[kvalue_index[i]];
+	sum -= model->rho[0];
+	return sum;
+}
+
 double svm_predict(const svm_model *model, const svm_node *x)
 {
 	int nr_class = model->nr_class;
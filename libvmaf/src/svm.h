@@ -122,6 +122,13 @@ double svm_get_svr_probability(const struct svm_model *model);
 
 double svm_predict_values(const struct svm_model *model, const struct svm_node *x, double* dec_values);
 double svm_predict(const struct svm_model *model, const struct svm_node *x);
+/*
+ * Kernel value of x and one support vector, and the decision value of a
+ * regression model given the kernel values of all of its support vectors,
+ * where kvalue[kvalue_index[i]] belongs to model->SV[i].
+ */
+double svm_kernel_value(const struct svm_model *model, const struct svm_node *x, const struct svm_node *sv);
+double svm_predict_values_from_kernel(const struct svm_model *model, const double *kvalue, const int *kvalue_index);
 double svm_predict_probability(const struct svm_model *model, const struct svm_node *x, double* prob_estimates);
 
 void svm_free_model_content(struct svm_model *model_ptr);
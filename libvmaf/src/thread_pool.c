@@ -19,9 +19,14 @@
 #include <errno.h>
 #include <pthread.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef __linux__
+#include <sched.h>
+#endif
+
 typedef struct VmafThreadPoolJob {
     void (*func)(void *data);
     void *data;
@@ -33,6 +38,7 @@ typedef struct VmafTreadPool {
         pthread_mutex_t lock;
         pthread_cond_t empty;
         VmafThreadPoolJob *head, *tail;
+        unsigned depth;
     } queue;
     pthread_cond_t working;
     unsigned n_threads;
@@ -52,6 +58,7 @@ static VmafThreadPoolJob *vmaf_thread_pool_fetch_job(VmafThreadPool *pool)
     } else {
         pool->queue.head = job->next;
     }
+    pool->queue.depth--;
     return job;
 }
 
@@ -92,13 +99,95 @@ static void *vmaf_thread_pool_runner(void *p)
     return NULL;
 }
 
-int vmaf_thread_pool_create(VmafThreadPool **pool, unsigned n_threads)
+int vmaf_thread_pool_destroy(VmafThreadPool *pool);
+
+#ifdef __linux__
+static int parse_cpu_list(const char *str, cpu_set_t *set)
+{
+    const char *p = str;
+    for (;;) {
+        char *end;
+        const unsigned long first = strtoul(p, &end, 10);
+        if (end == p) return -EINVAL;
+        unsigned long last = first;
+        p = end;
+        if (*p == '-') {
+            p++;
+            last = strtoul(p, &end, 10);
+            if (end == p || last < first) return -EINVAL;
+            p = end;
+        }
+        if (last >= CPU_SETSIZE) return -EINVAL;
+        for (unsigned long cpu = first; cpu <= last; cpu++)
+            CPU_SET(cpu, set);
+        if (*p == '\0' || *p == '\n') return 0;
+        if (*p++ != ',') return -EINVAL;
+    }
+}
+
+static int parse_node_list(const char *str, cpu_set_t *set)
+{
+    cpu_set_t nodes;
+    CPU_ZERO(&nodes);
+    int err = parse_cpu_list(str, &nodes);
+    if (err) return err;
+
+    for (unsigned node = 0; node < CPU_SETSIZE; node++) {
+        if (!CPU_ISSET(node, &nodes)) continue;
+        char path[64], buf[4096];
+        snprintf(path, sizeof(path),
+                 "/sys/devices/system/node/node%u/cpulist", node);
+        FILE *f = fopen(path, "r");
+        if (!f) return -EINVAL;
+        const char *line = fgets(buf, sizeof(buf), f);
+        fclose(f);
+        // memory-only nodes have an empty cpulist
+        if (!line || *line == '\n') return -EINVAL;
+        err = parse_cpu_list(line, set);
+        if (err) return err;
+    }
+    return 0;
+}
+
+static int parse_affinity(const char *affinity, cpu_set_t *set)
+{
+    CPU_ZERO(set);
+    int err = !strncmp(affinity, "node:", 5) ?
+        parse_node_list(affinity + 5, set) : parse_cpu_list(affinity, set);
+    if (err) return err;
+    return CPU_COUNT(set) ? 0 : -EINVAL;
+}
+#endif
+
+int vmaf_thread_pool_create(VmafThreadPool **pool, unsigned n_threads,
+                            const char *affinity)
 {
     if (!pool) return -EINVAL;
     if (!n_threads) return -EINVAL;
 
+    pthread_attr_t *pattr = NULL;
+#ifdef __linux__
+    pthread_attr_t attr;
+#endif
+    if (affinity) {
+#ifdef __linux__
+        cpu_set_t set;
+        int err = parse_affinity(affinity, &set);
+        if (err) return err;
+        if (pthread_attr_init(&attr)) return -ENOMEM;
+        pattr = &attr;
+        err = pthread_attr_setaffinity_np(pattr, sizeof(set), &set);
+        if (err) {
+            pthread_attr_destroy(pattr);
+            return -err;
+        }
+#else
+        return -ENOTSUP;
+#endif
+    }
+
     VmafThreadPool *const p = *pool = malloc(sizeof(*p));
-    if (!p) return -ENOMEM;
+    if (!p) goto fail;
     memset(p, 0, sizeof(*p));
     p->n_threads = n_threads;
 
@@ -108,11 +197,26 @@ int vmaf_thread_pool_create(VmafThreadPool **pool, unsigned n_threads)
 
     for (unsigned i = 0; i < n_threads; i++) {
         pthread_t thread;
-        pthread_create(&thread, NULL, vmaf_thread_pool_runner, p);
+        const int err = pthread_create(&thread, pattr, vmaf_thread_pool_runner, p);
+        if (err) {
+            // e.g. none of the requested CPUs is available to this process
+            pthread_mutex_lock(&(p->queue.lock));
+            p->n_threads -= n_threads - i;
+            pthread_mutex_unlock(&(p->queue.lock));
+            vmaf_thread_pool_destroy(p);
+            *pool = NULL;
+            if (pattr) pthread_attr_destroy(pattr);
+            return -err;
+        }
         pthread_detach(thread);
     }
 
+    if (pattr) pthread_attr_destroy(pattr);
     return 0;
+
+fail:
+    if (pattr) pthread_attr_destroy(pattr);
+    return -ENOMEM;
 }
 
 int vmaf_thread_pool_enqueue(VmafThreadPool *pool, void (*func)(void *data),
@@ -140,6 +244,7 @@ int vmaf_thread_pool_enqueue(VmafThreadPool *pool, void (*func)(void *data),
         pool->queue.tail->next = job;
         pool->queue.tail = job;
     }
+    pool->queue.depth++;
 
     pthread_cond_broadcast(&(pool->queue.empty));
     pthread_mutex_unlock(&(pool->queue.lock));
@@ -162,6 +267,16 @@ int vmaf_thread_pool_wait(VmafThreadPool *pool)
     pthread_mutex_unlock(&(pool->queue.lock));
     return 0;
 }
+
+unsigned vmaf_thread_pool_queue_depth(VmafThreadPool *pool)
+{
+    if (!pool) return 0;
+
+    pthread_mutex_lock(&(pool->queue.lock));
+    const unsigned depth = pool->queue.depth;
+    pthread_mutex_unlock(&(pool->queue.lock));
+    return depth;
+}
 int vmaf_thread_pool_destroy(VmafThreadPool *pool)
 {
     if (!pool) return -EINVAL;
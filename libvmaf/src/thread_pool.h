@@ -23,13 +23,24 @@
 
 typedef struct VmafThreadPool VmafThreadPool;
 
-int vmaf_thread_pool_create(VmafThreadPool **tpool, unsigned n_threads);
+/*
+ * affinity optionally pins every worker to a set of CPUs, either a list of
+ * cores such as "0-7,16-23" or a list of NUMA nodes such as "node:1". Workers
+ * are pinned before they start, so memory they touch first, such as the
+ * buffers feature extractors allocate on their first frame, stays node-local.
+ * Pinning is only supported on Linux, -ENOTSUP is returned elsewhere.
+ */
+int vmaf_thread_pool_create(VmafThreadPool **tpool, unsigned n_threads,
+                            const char *affinity);
 
 int vmaf_thread_pool_enqueue(VmafThreadPool *pool, void (*func)(void *data),
                              void *data, size_t data_sz);
 
 int vmaf_thread_pool_wait(VmafThreadPool *pool);
 
+// Number of enqueued jobs which have not been picked up by a thread yet.
+unsigned vmaf_thread_pool_queue_depth(VmafThreadPool *pool);
+
 int vmaf_thread_pool_destroy(VmafThreadPool *tpool);
 
 #endif /* __VMAF_THREAD_POOL_H__ */
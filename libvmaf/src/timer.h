@@ -0,0 +1,51 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef __VMAF_SRC_TIMER_H__
+#define __VMAF_SRC_TIMER_H__
+
+#include <stdint.h>
+#include <time.h>
+
+static inline uint64_t timespec_to_ns(struct timespec ts)
+{
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ * Wall-clock nanoseconds from an arbitrary origin. Unlike clock(), this keeps
+ * advancing at real time regardless of how many threads are busy.
+ */
+static inline uint64_t vmaf_timer_wall_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return timespec_to_ns(ts);
+}
+
+/**
+ * CPU nanoseconds consumed by the whole process, summed over all threads.
+ */
+static inline uint64_t vmaf_timer_cpu_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return timespec_to_ns(ts);
+}
+
+#endif /* __VMAF_SRC_TIMER_H__ */
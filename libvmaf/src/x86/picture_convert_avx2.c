@@ -0,0 +1,65 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <immintrin.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "x86/picture_convert_avx2.h"
+
+void picture_widen_8_16_avx2(uint16_t *dst, ptrdiff_t dst_stride,
+                             const uint8_t *src, ptrdiff_t src_stride,
+                             unsigned w, unsigned h, unsigned shift)
+{
+    const __m128i sh = _mm_cvtsi32_si128(shift);
+
+    for (unsigned i = 0; i < h; i++) {
+        unsigned j = 0;
+        for (; j + 32 <= w; j += 32) {
+            __m128i s0 = _mm_loadu_si128((const __m128i*)(src + j));
+            __m128i s1 = _mm_loadu_si128((const __m128i*)(src + j + 16));
+            __m256i d0 = _mm256_sll_epi16(_mm256_cvtepu8_epi16(s0), sh);
+            __m256i d1 = _mm256_sll_epi16(_mm256_cvtepu8_epi16(s1), sh);
+            _mm256_storeu_si256((__m256i*)(dst + j), d0);
+            _mm256_storeu_si256((__m256i*)(dst + j + 16), d1);
+        }
+        for (; j < w; j++)
+            dst[j] = src[j] << shift;
+        src += src_stride;
+        dst += dst_stride / sizeof(*dst);
+    }
+}
+
+void picture_shift_16_avx2(uint16_t *dst, ptrdiff_t dst_stride,
+                           const uint16_t *src, ptrdiff_t src_stride,
+                           unsigned w, unsigned h, unsigned shift)
+{
+    const __m128i sh = _mm_cvtsi32_si128(shift);
+
+    for (unsigned i = 0; i < h; i++) {
+        unsigned j = 0;
+        for (; j + 16 <= w; j += 16) {
+            __m256i s = _mm256_loadu_si256((const __m256i*)(src + j));
+            _mm256_storeu_si256((__m256i*)(dst + j), _mm256_sll_epi16(s, sh));
+        }
+        for (; j < w; j++)
+            dst[j] = src[j] << shift;
+        src += src_stride / sizeof(*src);
+        dst += dst_stride / sizeof(*dst);
+    }
+}
@@ -0,0 +1,162 @@
+/**
+ *
+ *  Copyright 2016-2024 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "test.h"
+#include "libvmaf/libvmaf.h"
+#include "libvmaf/model.h"
+
+#define PIC_CNT 12
+#define PIC_W 160
+#define PIC_H 120
+
+static uint8_t texture(unsigned x, unsigned y)
+{
+    return ((x * x + 3 * y) ^ (7 * x + y * y)) & 0xff;
+}
+
+/*
+ * A textured picture moving 5 pixels to the right per frame, or standing
+ * still with one bit of noise. The distorted picture is quantized.
+ */
+static int fill_picture(VmafPicture *pic, unsigned index, bool motion,
+                        bool distorted)
+{
+    int err = vmaf_picture_alloc(pic, VMAF_PIX_FMT_YUV420P, 8, PIC_W, PIC_H);
+    if (err) return err;
+
+    uint32_t state = 1 + index * 7919;
+    for (unsigned p = 0; p < 3; p++) {
+        uint8_t *data = pic->data[p];
+        for (unsigned i = 0; i < pic->h[p]; i++) {
+            for (unsigned j = 0; j < pic->w[p]; j++) {
+                state = state * 1664525 + 1013904223;
+                unsigned v = motion ? texture(j + 5 * index, i) :
+                                      texture(j, i) | (state >> 31);
+                if (distorted) v = (v & 0xf0) | 0x08;
+                data[j] = v;
+            }
+            data += pic->stride[p];
+        }
+    }
+
+    return 0;
+}
+
+static int score_sequence(bool motion, float threshold, unsigned n_threads,
+                          double *score, double *repeated)
+{
+    VmafConfiguration cfg = {
+        .n_threads = n_threads,
+        .subsample_threshold = threshold,
+    };
+    VmafContext *vmaf;
+    int err = vmaf_init(&vmaf, cfg);
+    if (err) return err;
+
+    VmafModel *model;
+    VmafModelConfig model_cfg = { 0 };
+    err = vmaf_model_load(&model, &model_cfg, "vmaf_v0.6.1");
+    if (err) goto close_vmaf;
+    err = vmaf_use_features_from_model(vmaf, model);
+    if (err) goto destroy_model;
+
+    for (unsigned i = 0; i < PIC_CNT; i++) {
+        VmafPicture ref, dist;
+        err |= fill_picture(&ref, i, motion, false);
+        err |= fill_picture(&dist, i, motion, true);
+        if (err) goto destroy_model;
+        err = vmaf_read_pictures(vmaf, &ref, &dist, i);
+        if (err) goto destroy_model;
+    }
+    err = vmaf_read_pictures(vmaf, NULL, NULL, 0);
+    if (err) goto destroy_model;
+
+    err = vmaf_score_pooled(vmaf, model, VMAF_POOL_METHOD_MEAN, score, 0,
+                            PIC_CNT - 1);
+    if (err) goto destroy_model;
+
+    *repeated = 0.;
+    if (threshold > 0.f) {
+        err = vmaf_feature_score_pooled(vmaf, "repeated_frame",
+                                        VMAF_POOL_METHOD_MEAN, repeated, 0,
+                                        PIC_CNT - 1);
+    }
+
+destroy_model:
+    vmaf_model_destroy(model);
+close_vmaf:
+    vmaf_close(vmaf);
+    return err;
+}
+
+static char *test_static_sequence()
+{
+    double full, adaptive, repeated;
+    int err = score_sequence(false, 0.f, 0, &full, &repeated);
+    mu_assert("problem scoring every frame", !err);
+
+    for (unsigned n_threads = 0; n_threads <= 2; n_threads += 2) {
+        err = score_sequence(false, 1.f, n_threads, &adaptive, &repeated);
+        mu_assert("problem scoring with adaptive subsampling", !err);
+        mu_assert("all but the first frame should be repeated",
+                  fabs(repeated - (PIC_CNT - 1.) / PIC_CNT) < 1e-6);
+        mu_assert("pooled score of a static sequence deviates too much",
+                  fabs(adaptive - full) < 0.5);
+    }
+
+    return NULL;
+}
+
+static char *test_motion_sequence()
+{
+    double full, adaptive, repeated;
+    int err = score_sequence(true, 0.f, 0, &full, &repeated);
+    mu_assert("problem scoring every frame", !err);
+
+    for (unsigned n_threads = 0; n_threads <= 2; n_threads += 2) {
+        err = score_sequence(true, 1.f, n_threads, &adaptive, &repeated);
+        mu_assert("problem scoring with adaptive subsampling", !err);
+        mu_assert("no frame of a moving sequence should be repeated",
+                  repeated == 0.);
+        mu_assert("pooled score of a moving sequence should not change",
+                  fabs(adaptive - full) < 1e-6);
+    }
+
+    return NULL;
+}
+
+static char *test_invalid_threshold()
+{
+    VmafConfiguration cfg = { .subsample_threshold = NAN };
+    VmafContext *vmaf;
+    int err = vmaf_init(&vmaf, cfg);
+    mu_assert("a NaN threshold should be rejected", err);
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_static_sequence);
+    mu_run_test(test_motion_sequence);
+    mu_run_test(test_invalid_threshold);
+    return NULL;
+}
@@ -16,7 +16,10 @@
  *
  */
 
+#include <errno.h>
 #include <getopt.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "test.h"
 
@@ -142,6 +145,158 @@ static char *test_nflx_ctc_v1_0()
     return NULL;
 }
 
+static char *test_frame_range()
+{
+    char *argv[7] = {"vmaf", "-r", "ref.y4m", "-d", "dis.y4m", "--frame_range", "100:250"};
+    int argc = 7;
+    CLISettings settings;
+    optind = 1;
+    cli_parse(argc, argv, &settings);
+    mu_assert("cli_parse: --frame_range 100:250 provided but start is not 100", settings.frame_range.start == 100);
+    mu_assert("cli_parse: --frame_range 100:250 provided but end is not 250", settings.frame_range.end == 250);
+    cli_free(&settings);
+    cli_free_dicts(&settings);
+
+    return NULL;
+}
+
+static char *test_merge()
+{
+    char *argv[7] = {"vmaf", "merge", "-o", "out.xml", "--json", "seg0.state", "seg1.state"};
+    int argc = 7;
+    CLISettings settings;
+    optind = 1;
+    cli_parse(argc, argv, &settings);
+    mu_assert("cli_parse: merge subcommand not detected", settings.merge);
+    mu_assert("cli_parse: merge output path not parsed", !strcmp(settings.output_path[0], "out.xml"));
+    mu_assert("cli_parse: merge output format not parsed", settings.output_fmt == VMAF_OUTPUT_FORMAT_JSON);
+    mu_assert("cli_parse: merge should collect 2 partial results", settings.merge_cnt == 2);
+    mu_assert("cli_parse: first partial results path mismatch", !strcmp(settings.merge_path[0], "seg0.state"));
+    mu_assert("cli_parse: second partial results path mismatch", !strcmp(settings.merge_path[1], "seg1.state"));
+    cli_free(&settings);
+
+    return NULL;
+}
+
+static char *test_multiple_distorted()
+{
+    char *argv[11] = {"vmaf", "-r", "ref.y4m", "-d", "dis0.y4m", "-o", "out0.xml", "-d", "dis1.y4m", "-o", "out1.xml"};
+    int argc = 11;
+    CLISettings settings;
+    optind = 1;
+    cli_parse(argc, argv, &settings);
+    mu_assert("cli_parse: two distorted inputs provided but dist_cnt is not 2", settings.dist_cnt == 2);
+    mu_assert("cli_parse: second distorted path mismatch", !strcmp(settings.path_dist[1], "dis1.y4m"));
+    mu_assert("cli_parse: two outputs provided but output_cnt is not 2", settings.output_cnt == 2);
+    mu_assert("cli_parse: second output path mismatch", !strcmp(settings.output_path[1], "out1.xml"));
+    cli_free(&settings);
+    cli_free_dicts(&settings);
+
+    return NULL;
+}
+
+static char *test_thread_affinity()
+{
+    char *argv[9] = {"vmaf", "-r", "ref.y4m", "-d", "dis.y4m", "--threads", "4", "--thread_affinity", "node:1"};
+    int argc = 9;
+    CLISettings settings;
+    optind = 1;
+    cli_parse(argc, argv, &settings);
+    mu_assert("cli_parse: --threads 4 provided but thread_cnt is not 4", settings.thread_cnt == 4);
+    mu_assert("cli_parse: --thread_affinity mismatch", !strcmp(settings.thread_affinity, "node:1"));
+    cli_free(&settings);
+    cli_free_dicts(&settings);
+
+    return NULL;
+}
+
+static char *test_serve()
+{
+    char *argv[5] = {"vmaf", "--serve", "vmaf.sock", "--threads", "2"};
+    int argc = 5;
+    CLISettings settings;
+    optind = 1;
+    cli_parse(argc, argv, &settings);
+    mu_assert("cli_parse: serve socket path not parsed", !strcmp(settings.serve_path, "vmaf.sock"));
+    mu_assert("cli_parse: serve thread count not parsed", settings.thread_cnt == 2);
+    mu_assert("cli_parse: serve should not be a client", !settings.client_path);
+    cli_free(&settings);
+
+    char *argv2[10] = {"vmaf", "client", "-r", "ref.y4m", "-d", "dis.y4m", "-o", "out.json", "--json", "vmaf.sock"};
+    argc = 10;
+    optind = 1;
+    cli_parse(argc, argv2, &settings);
+    mu_assert("cli_parse: client socket path not parsed", !strcmp(settings.client_path, "vmaf.sock"));
+    mu_assert("cli_parse: client should not serve", !settings.serve_path);
+    mu_assert("cli_parse: client reference not parsed", !strcmp(settings.path_ref, "ref.y4m"));
+    mu_assert("cli_parse: client output path not parsed", !strcmp(settings.output_path[0], "out.json"));
+    cli_free(&settings);
+
+    return NULL;
+}
+
+static char *test_serve_job_error()
+{
+    char *argv[8] = {"vmaf", "client", "-r", "ref.y4m", "-d", "dis.y4m", "--frame_range", "9:3"};
+    int argc = 8;
+    CLISettings settings;
+    char *log_buf = NULL;
+    size_t log_sz = 0;
+    FILE *log = open_memstream(&log_buf, &log_sz);
+    mu_assert("cli_parse: could not open job log", log);
+    int err = cli_parse_job(argc, argv, &settings, log);
+    fclose(log);
+    mu_assert("cli_parse: bad job argument not rejected", err == -EINVAL);
+    mu_assert("cli_parse: job error not logged", strstr(log_buf, "frame range"));
+    free(log_buf);
+
+    char *argv2[7] = {"vmaf", "client", "-r", "ref.y4m", "-d", "dis.y4m", "vmaf.sock"};
+    argc = 7;
+    err = cli_parse_job(argc, argv2, &settings, stderr);
+    mu_assert("cli_parse: valid job rejected", !err);
+    mu_assert("cli_parse: job socket path not parsed", !strcmp(settings.client_path, "vmaf.sock"));
+    cli_free(&settings);
+
+    // a job rejected in the middle of "-vq" must not leave "q" to the next one
+    char *argv3[4] = {"vmaf", "client", "-vq", "vmaf.sock"};
+    argc = 4;
+    log = open_memstream(&log_buf, &log_sz);
+    mu_assert("cli_parse: could not open job log", log);
+    err = cli_parse_job(argc, argv3, &settings, log);
+    fclose(log);
+    mu_assert("cli_parse: --version job not rejected", err == -EINVAL);
+    free(log_buf);
+    argc = 7;
+    err = cli_parse_job(argc, argv2, &settings, stderr);
+    mu_assert("cli_parse: job after a rejected job failed", !err);
+    mu_assert("cli_parse: rejected job leaked an option", !settings.quiet);
+    cli_free(&settings);
+
+    return NULL;
+}
+
+static char *test_pool()
+{
+    char *argv[11] = {"vmaf", "-r", "ref.y4m", "-d", "dis.y4m", "--pool", "p5", "--pool", "p0.5", "--pool", "min_window48"};
+    int argc = 11;
+    CLISettings settings;
+    optind = 1;
+    cli_parse(argc, argv, &settings);
+    mu_assert("cli_parse: pooling methods not parsed", settings.pool_cnt == 3);
+    mu_assert("cli_parse: percentile not parsed",
+              settings.pool_cfg[0].method == VMAF_POOL_METHOD_PERCENTILE &&
+              settings.pool_cfg[0].param == 5.);
+    mu_assert("cli_parse: fractional percentile not parsed",
+              settings.pool_cfg[1].method == VMAF_POOL_METHOD_PERCENTILE &&
+              settings.pool_cfg[1].param == 0.5);
+    mu_assert("cli_parse: window minimum not parsed",
+              settings.pool_cfg[2].method == VMAF_POOL_METHOD_WINDOW_MIN &&
+              settings.pool_cfg[2].param == 48.);
+    cli_free(&settings);
+
+    return NULL;
+}
+
 char *run_tests()
 {
     mu_run_test(test_aom_ctc_v1_0);
@@ -151,5 +306,12 @@ char *run_tests()
     mu_run_test(test_aom_ctc_v5_0);
     mu_run_test(test_aom_ctc_v6_0);
     mu_run_test(test_nflx_ctc_v1_0);
+    mu_run_test(test_frame_range);
+    mu_run_test(test_merge);
+    mu_run_test(test_multiple_distorted);
+    mu_run_test(test_thread_affinity);
+    mu_run_test(test_serve);
+    mu_run_test(test_serve_job_error);
+    mu_run_test(test_pool);
     return NULL;
 }
@@ -16,6 +16,8 @@
  *
  */
 
+#include <errno.h>
+
 #include "test.h"
 #include "libvmaf/libvmaf.h"
 
@@ -70,9 +72,303 @@ static char *test_get_feature_score()
     return NULL;
 }
 
+static char *test_preallocate_luma_only()
+{
+    int err = 0;
+    VmafContext *vmaf;
+    VmafConfiguration cfg = { 0 };
+    VmafPictureConfiguration pic_cfg = {
+        .pic_params = {
+            .w = 64, .h = 64, .bpc = 8, .pix_fmt = VMAF_PIX_FMT_YUV420P,
+        },
+        .pic_cnt = 2,
+    };
+    VmafPicture pic;
+
+    err = vmaf_init(&vmaf, cfg);
+    mu_assert("problem during vmaf_init", !err);
+    err = vmaf_use_feature(vmaf, "vif", NULL);
+    mu_assert("problem during vmaf_use_feature", !err);
+    err = vmaf_preallocate_pictures(vmaf, pic_cfg);
+    mu_assert("problem during vmaf_preallocate_pictures", !err);
+    err = vmaf_fetch_preallocated_picture(vmaf, &pic);
+    mu_assert("problem during vmaf_fetch_preallocated_picture", !err);
+    mu_assert("luma-only features should get YUV400 pictures",
+              pic.pix_fmt == VMAF_PIX_FMT_YUV400P);
+    mu_assert("chroma planes should be absent", !pic.data[1] && !pic.data[2]);
+    err = vmaf_picture_unref(&pic);
+    mu_assert("problem during vmaf_picture_unref", !err);
+    err = vmaf_use_feature(vmaf, "psnr", NULL);
+    mu_assert("chroma feature should be rejected after preallocation", err);
+    err = vmaf_close(vmaf);
+    mu_assert("problem during vmaf_close", !err);
+
+    err = vmaf_init(&vmaf, cfg);
+    mu_assert("problem during vmaf_init", !err);
+    err = vmaf_use_feature(vmaf, "psnr", NULL);
+    mu_assert("problem during vmaf_use_feature", !err);
+    err = vmaf_preallocate_pictures(vmaf, pic_cfg);
+    mu_assert("problem during vmaf_preallocate_pictures", !err);
+    err = vmaf_fetch_preallocated_picture(vmaf, &pic);
+    mu_assert("problem during vmaf_fetch_preallocated_picture", !err);
+    mu_assert("chroma features should keep the configured format",
+              pic.pix_fmt == VMAF_PIX_FMT_YUV420P);
+    err = vmaf_picture_unref(&pic);
+    mu_assert("problem during vmaf_picture_unref", !err);
+    err = vmaf_close(vmaf);
+    mu_assert("problem during vmaf_close", !err);
+
+    return NULL;
+}
+
+static char *test_get_progress()
+{
+    int err = 0;
+    VmafContext *vmaf;
+    VmafConfiguration cfg = { .n_threads = 2 };
+    VmafProgress progress;
+
+    err = vmaf_init(&vmaf, cfg);
+    mu_assert("problem during vmaf_init", !err);
+    err = vmaf_use_feature(vmaf, "psnr", NULL);
+    mu_assert("problem during vmaf_use_feature", !err);
+    err = vmaf_get_progress(vmaf, &progress);
+    mu_assert("problem during vmaf_get_progress", !err);
+    mu_assert("no pictures should be read yet",
+              !progress.frames_read && !progress.frames_done &&
+              progress.timings.wall == 0.);
+
+    for (unsigned i = 0; i < 3; i++) {
+        VmafPicture ref, dist;
+        err = vmaf_picture_alloc(&ref, VMAF_PIX_FMT_YUV420P, 8, 64, 64);
+        err |= vmaf_picture_alloc(&dist, VMAF_PIX_FMT_YUV420P, 8, 64, 64);
+        mu_assert("problem during vmaf_picture_alloc", !err);
+        err = vmaf_read_pictures(vmaf, &ref, &dist, i);
+        mu_assert("problem during vmaf_read_pictures", !err);
+    }
+    err = vmaf_read_pictures(vmaf, NULL, NULL, 0);
+    mu_assert("problem flushing context", !err);
+
+    err = vmaf_get_progress(vmaf, &progress);
+    mu_assert("problem during vmaf_get_progress", !err);
+    mu_assert("all pictures should be read and done",
+              progress.frames_read == 3 && progress.frames_done == 3);
+    mu_assert("queue should be drained", !progress.queue_depth);
+    mu_assert("wall time should be measured", progress.timings.wall > 0.);
+    mu_assert("stage timings should fit into wall time",
+              progress.timings.read + progress.timings.flush <=
+              progress.timings.wall);
+
+    VmafProgress again;
+    err = vmaf_get_progress(vmaf, &again);
+    mu_assert("problem during vmaf_get_progress", !err);
+    mu_assert("timings should stop advancing after flush",
+              again.timings.wall == progress.timings.wall);
+
+    err = vmaf_close(vmaf);
+    mu_assert("problem during vmaf_close", !err);
+
+    return NULL;
+}
+
+static void fill_picture(VmafPicture *pic, unsigned seed)
+{
+    for (unsigned p = 0; p < 3; p++) {
+        uint8_t *data = pic->data[p];
+        for (unsigned i = 0; i < pic->h[p]; i++) {
+            for (unsigned j = 0; j < pic->w[p]; j++)
+                data[j] = (i * 7 + j * 3 + seed * 11) & 0xff;
+            data += pic->stride[p];
+        }
+    }
+}
+
+static char *test_init_lane()
+{
+    int err = 0;
+    VmafContext *vmaf, *lane;
+    VmafConfiguration cfg = { .n_threads = 2 };
+
+    err = vmaf_init(&vmaf, cfg);
+    mu_assert("problem during vmaf_init", !err);
+    err = vmaf_use_feature(vmaf, "motion", NULL);
+    err |= vmaf_use_feature(vmaf, "psnr", NULL);
+    mu_assert("problem during vmaf_use_feature", !err);
+    err = vmaf_init_lane(&lane, vmaf);
+    mu_assert("problem during vmaf_init_lane", !err);
+
+    for (unsigned i = 0; i < 4; i++) {
+        VmafPicture ref, ref_lane, dist, dist_lane;
+        err = vmaf_picture_alloc(&ref, VMAF_PIX_FMT_YUV420P, 8, 64, 64);
+        err |= vmaf_picture_alloc(&dist, VMAF_PIX_FMT_YUV420P, 8, 64, 64);
+        err |= vmaf_picture_alloc(&dist_lane, VMAF_PIX_FMT_YUV420P, 8, 64, 64);
+        mu_assert("problem during vmaf_picture_alloc", !err);
+        fill_picture(&ref, i);
+        fill_picture(&dist, i + 1);
+        fill_picture(&dist_lane, i);
+        err = vmaf_picture_ref(&ref_lane, &ref);
+        mu_assert("problem during vmaf_picture_ref", !err);
+        err = vmaf_read_pictures(vmaf, &ref, &dist, i);
+        err |= vmaf_read_pictures(lane, &ref_lane, &dist_lane, i);
+        mu_assert("problem during vmaf_read_pictures", !err);
+    }
+
+    err = vmaf_read_pictures(lane, NULL, NULL, 0);
+    mu_assert("lane should not flush before its lead", err);
+    err = vmaf_read_pictures(vmaf, NULL, NULL, 0);
+    err |= vmaf_read_pictures(lane, NULL, NULL, 0);
+    mu_assert("problem flushing context", !err);
+
+    for (unsigned i = 0; i < 4; i++) {
+        double motion, motion_lane, psnr, psnr_lane;
+        err = vmaf_feature_score_at_index(vmaf,
+                "VMAF_integer_feature_motion2_score", &motion, i);
+        err |= vmaf_feature_score_at_index(lane,
+                "VMAF_integer_feature_motion2_score", &motion_lane, i);
+        mu_assert("motion should be shared with the lane", !err);
+        mu_assert("shared motion scores should match", motion == motion_lane);
+        err = vmaf_feature_score_at_index(vmaf, "psnr_y", &psnr, i);
+        err |= vmaf_feature_score_at_index(lane, "psnr_y", &psnr_lane, i);
+        mu_assert("problem during vmaf_feature_score_at_index", !err);
+        mu_assert("lane should score its own distorted input",
+                  psnr_lane > psnr);
+    }
+
+    err = vmaf_close(lane);
+    err |= vmaf_close(vmaf);
+    mu_assert("problem during vmaf_close", !err);
+
+    return NULL;
+}
+
+static char *test_submit_pictures()
+{
+    int err = 0;
+    VmafContext *vmaf, *ref_vmaf;
+    VmafConfiguration cfg = { .n_threads = 2, .max_frames_in_flight = 1 };
+    VmafConfiguration ref_cfg = { 0 };
+
+    err = vmaf_init(&vmaf, cfg);
+    err |= vmaf_init(&ref_vmaf, ref_cfg);
+    mu_assert("problem during vmaf_init", !err);
+    err = vmaf_use_feature(vmaf, "psnr", NULL);
+    err |= vmaf_use_feature(ref_vmaf, "psnr", NULL);
+    mu_assert("problem during vmaf_use_feature", !err);
+
+    err = vmaf_poll_frame(vmaf, 0);
+    mu_assert("unread index should not be known", err == -EINVAL);
+
+    for (unsigned i = 0; i < 8; i++) {
+        VmafPicture ref, dist, ref_sync, dist_sync;
+        err = vmaf_picture_alloc(&ref, VMAF_PIX_FMT_YUV420P, 8, 256, 256);
+        err |= vmaf_picture_alloc(&dist, VMAF_PIX_FMT_YUV420P, 8, 256, 256);
+        err |= vmaf_picture_alloc(&ref_sync, VMAF_PIX_FMT_YUV420P, 8, 256, 256);
+        err |= vmaf_picture_alloc(&dist_sync, VMAF_PIX_FMT_YUV420P, 8, 256, 256);
+        mu_assert("problem during vmaf_picture_alloc", !err);
+        fill_picture(&ref, i);
+        fill_picture(&dist, i + 1);
+        fill_picture(&ref_sync, i);
+        fill_picture(&dist_sync, i + 1);
+
+        while ((err = vmaf_submit_pictures(vmaf, &ref, &dist, i)) == -EAGAIN) {
+            mu_assert("only the previous index can be in flight", i > 0);
+            err = vmaf_wait_frame(vmaf, i - 1);
+            mu_assert("problem during vmaf_wait_frame", !err);
+        }
+        mu_assert("problem during vmaf_submit_pictures", !err);
+        if (i > 0) {
+            err = vmaf_poll_frame(vmaf, i - 1);
+            mu_assert("previous index should be done within the limit", !err);
+        }
+        err = vmaf_read_pictures(ref_vmaf, &ref_sync, &dist_sync, i);
+        mu_assert("problem during vmaf_read_pictures", !err);
+        err = vmaf_poll_frame(ref_vmaf, i);
+        mu_assert("synchronous reads should be done on return", !err);
+    }
+
+    err = vmaf_wait_frame(vmaf, 7);
+    mu_assert("problem during vmaf_wait_frame", !err);
+    VmafProgress progress;
+    err = vmaf_get_progress(vmaf, &progress);
+    mu_assert("problem during vmaf_get_progress", !err);
+    mu_assert("all submitted pictures should be done",
+              progress.frames_read == 8 && progress.frames_done == 8);
+
+    for (unsigned i = 0; i < 8; i++) {
+        double psnr, psnr_sync;
+        err = vmaf_poll_frame(vmaf, i);
+        mu_assert("submitted index should be done", !err);
+        err = vmaf_feature_score_at_index(vmaf, "psnr_y", &psnr, i);
+        err |= vmaf_feature_score_at_index(ref_vmaf, "psnr_y", &psnr_sync, i);
+        mu_assert("scores of a done index should be available", !err);
+        mu_assert("submitted scores should match read scores",
+                  psnr == psnr_sync);
+    }
+
+    err = vmaf_read_pictures(vmaf, NULL, NULL, 0);
+    err |= vmaf_read_pictures(ref_vmaf, NULL, NULL, 0);
+    mu_assert("problem flushing context", !err);
+    err = vmaf_close(vmaf);
+    err |= vmaf_close(ref_vmaf);
+    mu_assert("problem during vmaf_close", !err);
+
+    return NULL;
+}
+
+static char *test_submit_pictures_error()
+{
+    int err = 0;
+    VmafContext *vmaf;
+    VmafConfiguration cfg = { .n_threads = 2 };
+
+    err = vmaf_init(&vmaf, cfg);
+    mu_assert("problem during vmaf_init", !err);
+    err = vmaf_use_feature(vmaf, "psnr", NULL);
+    mu_assert("problem during vmaf_use_feature", !err);
+
+    VmafPicture ref, dist;
+    for (unsigned i = 0; i < 2; i++) {
+        err = vmaf_picture_alloc(&ref, VMAF_PIX_FMT_YUV420P, 8, 256, 256);
+        err |= vmaf_picture_alloc(&dist, VMAF_PIX_FMT_YUV420P, 8, 256, 256);
+        mu_assert("problem during vmaf_picture_alloc", !err);
+        fill_picture(&ref, i);
+        fill_picture(&dist, i + 1);
+
+        // the scores of the second submission cannot overwrite the first
+        err = vmaf_submit_pictures(vmaf, &ref, &dist, 0);
+        mu_assert("problem during vmaf_submit_pictures", !err);
+        err = vmaf_wait_frame(vmaf, 0);
+        mu_assert(i ? "failed extraction should be returned from wait" :
+                      "problem during vmaf_wait_frame", !err == !i);
+        mu_assert("poll should agree with wait",
+                  vmaf_poll_frame(vmaf, 0) == err);
+    }
+
+    // pictures of another size fail while reading
+    err = vmaf_picture_alloc(&ref, VMAF_PIX_FMT_YUV420P, 8, 128, 128);
+    err |= vmaf_picture_alloc(&dist, VMAF_PIX_FMT_YUV420P, 8, 128, 128);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    err = vmaf_submit_pictures(vmaf, &ref, &dist, 1);
+    mu_assert("mismatched pictures should be rejected", err);
+    mu_assert("a rejected index should report its error",
+              vmaf_wait_frame(vmaf, 1) == err && vmaf_poll_frame(vmaf, 1) == err);
+    vmaf_picture_unref(&ref);
+    vmaf_picture_unref(&dist);
+
+    err = vmaf_close(vmaf);
+    mu_assert("problem during vmaf_close", !err);
+
+    return NULL;
+}
+
 char *run_tests()
 {
     mu_run_test(test_context_init_and_close);
     mu_run_test(test_get_feature_score);
+    mu_run_test(test_preallocate_luma_only);
+    mu_run_test(test_get_progress);
+    mu_run_test(test_init_lane);
+    mu_run_test(test_submit_pictures);
+    mu_run_test(test_submit_pictures_error);
     return NULL;
 }
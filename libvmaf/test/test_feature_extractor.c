@@ -16,6 +16,7 @@
  *
  */
 
+#include <pthread.h>
 #include <stdint.h>
 #include <string.h>
 
@@ -23,6 +24,8 @@
 #include "dict.h"
 #include "feature/feature_extractor.h"
 #include "feature/feature_collector.h"
+#include "feature/integer_adm.h"
+#include "feature/integer_vif.h"
 #include "test.h"
 #include "picture.h"
 #include "libvmaf/picture.h"
@@ -184,11 +187,74 @@ static char *test_feature_extractor_initialization_options()
     return NULL;
 }
 
+typedef struct LookupTableJob {
+    const char *name;
+    VmafFeatureExtractorContext *fex_ctx;
+    int err;
+} LookupTableJob;
+
+static void *init_lookup_table_job(void *data)
+{
+    LookupTableJob *job = data;
+    VmafFeatureExtractor *fex = vmaf_get_feature_extractor_by_name(job->name);
+    job->err = vmaf_feature_extractor_context_create(&job->fex_ctx, fex, NULL);
+    if (job->err) return NULL;
+    job->err = vmaf_feature_extractor_context_init(job->fex_ctx,
+                                                   VMAF_PIX_FMT_YUV420P, 8,
+                                                   128, 128);
+    return NULL;
+}
+
+static char *test_feature_extractor_shared_lookup_tables()
+{
+    int err = 0;
+
+    const unsigned n_jobs = 8;
+    LookupTableJob job[n_jobs];
+    pthread_t thread[n_jobs];
+    for (unsigned i = 0; i < n_jobs; i++) {
+        job[i] = (LookupTableJob) { .name = i & 1 ? "adm" : "vif" };
+        err = pthread_create(&thread[i], NULL, init_lookup_table_job, &job[i]);
+        mu_assert("problem during pthread_create", !err);
+    }
+    for (unsigned i = 0; i < n_jobs; i++) {
+        pthread_join(thread[i], NULL);
+        mu_assert("problem during vmaf_feature_extractor_context_init",
+                  !job[i].err);
+    }
+
+    const uint16_t *log2_table = vif_log2_table();
+    for (unsigned i = 0; i < n_jobs; i += 2) {
+        VifPublicState *vif = job[i].fex_ctx->fex->priv;
+        mu_assert("vif contexts should share one log2 table",
+                  vif->log2_table == log2_table);
+    }
+    mu_assert("log2 table should hold log2(i) * 2048",
+              log2_table[32768] == 15 * 2048 && log2_table[65535] == 32768);
+
+    const int32_t *div_lookup = adm_div_lookup();
+    mu_assert("adm_div_lookup() should return the same table",
+              div_lookup == adm_div_lookup());
+    mu_assert("div lookup should hold Q30 reciprocals",
+              div_lookup[32768 + 1] == 1 << 30 &&
+              div_lookup[32768 - 2] == -(1 << 29) && !div_lookup[32768]);
+
+    for (unsigned i = 0; i < n_jobs; i++) {
+        err = vmaf_feature_extractor_context_close(job[i].fex_ctx);
+        mu_assert("problem during vmaf_feature_extractor_context_close", !err);
+        err = vmaf_feature_extractor_context_destroy(job[i].fex_ctx);
+        mu_assert("problem during vmaf_feature_extractor_context_destroy", !err);
+    }
+
+    return NULL;
+}
+
 char *run_tests()
 {
     mu_run_test(test_get_feature_extractor_by_name_and_feature_name);
     mu_run_test(test_feature_extractor_context_pool);
     mu_run_test(test_feature_extractor_flush);
     mu_run_test(test_feature_extractor_initialization_options);
+    mu_run_test(test_feature_extractor_shared_lookup_tables);
     return NULL;
 }
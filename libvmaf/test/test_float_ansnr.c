@@ -0,0 +1,169 @@
+/**
+ *
+ *  Copyright 2016-2024 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "test.h"
+#include "libvmaf/libvmaf.h"
+#include "mem.h"
+#include "feature/ansnr.h"
+#include "feature/picture_copy.h"
+
+/* full range texture, mirrored at random */
+static int fill_picture(VmafPicture *pic, unsigned bpc, unsigned w,
+                        unsigned h, unsigned seed)
+{
+    int err = vmaf_picture_alloc(pic, VMAF_PIX_FMT_YUV420P, bpc, w, h);
+    if (err) return err;
+
+    const unsigned max = (1u << bpc) - 1;
+    uint32_t lcg = seed * 2654435761u + 1;
+    for (unsigned p = 0; p < 3; p++) {
+        uint8_t *data = pic->data[p];
+        for (unsigned i = 0; i < pic->h[p]; i++) {
+            for (unsigned j = 0; j < pic->w[p]; j++) {
+                lcg = lcg * 1664525u + 1013904223u;
+                const unsigned x = (i * j + (i ^ j) * 37) % (max + 1);
+                const unsigned v = (lcg >> 31) ? max - x : x;
+                if (bpc == 8) data[j] = v;
+                else ((uint16_t *)data)[j] = v;
+            }
+            data += pic->stride[p];
+        }
+    }
+
+    return 0;
+}
+
+static void peak(unsigned bpc, double *peak, double *psnr_max)
+{
+    *peak = bpc == 8 ? 255.0 : bpc == 10 ? 255.75 :
+            bpc == 12 ? 255.9375 : 255.99609375;
+    *psnr_max = bpc == 8 ? 60.0 : bpc == 10 ? 72.0 :
+                bpc == 12 ? 84.0 : 108.0;
+}
+
+/* picture_copy() and compute_ansnr() of the luma planes */
+static int reference_ansnr(VmafPicture *ref, VmafPicture *dist,
+                           double *score, double *score_psnr)
+{
+    const unsigned w = ref->w[0], h = ref->h[0];
+    const size_t stride = ALIGN_CEIL(w * sizeof(float));
+    float *buf = aligned_malloc(2 * stride * h, 32);
+    if (!buf) return -1;
+    float *ref_buf = buf;
+    float *dist_buf = buf + stride / sizeof(float) * h;
+
+    picture_copy(ref_buf, stride, ref, -128, ref->bpc);
+    picture_copy(dist_buf, stride, dist, -128, dist->bpc);
+
+    double p, psnr_max;
+    peak(ref->bpc, &p, &psnr_max);
+    int err = compute_ansnr(ref_buf, dist_buf, w, h, stride, stride, score,
+                            score_psnr, p, psnr_max);
+
+    aligned_free(buf);
+    return err;
+}
+
+static int extract_ansnr(unsigned cpumask, unsigned bpc, unsigned w,
+                         unsigned h, double *score, double *score_psnr)
+{
+    VmafConfiguration cfg = { .cpumask = cpumask };
+    VmafContext *vmaf;
+    int err = vmaf_init(&vmaf, cfg);
+    if (err) return err;
+
+    err = vmaf_use_feature(vmaf, "float_ansnr", NULL);
+    if (err) goto close_vmaf;
+
+    VmafPicture ref, dist;
+    err |= fill_picture(&ref, bpc, w, h, 1);
+    err |= fill_picture(&dist, bpc, w, h, 2);
+    if (err) goto close_vmaf;
+    err = vmaf_read_pictures(vmaf, &ref, &dist, 0);
+    if (err) goto close_vmaf;
+    err = vmaf_read_pictures(vmaf, NULL, NULL, 0);
+    if (err) goto close_vmaf;
+
+    err |= vmaf_feature_score_at_index(vmaf, "float_ansnr", score, 0);
+    err |= vmaf_feature_score_at_index(vmaf, "float_anpsnr", score_psnr, 0);
+
+close_vmaf:
+    vmaf_close(vmaf);
+    return err;
+}
+
+static char *test_ansnr_matches_float_reference()
+{
+    const unsigned bpc[] = { 8, 10, 12, 16 };
+    const struct {
+        unsigned w, h;
+    } size[] = {
+        { 176, 144 }, { 67, 35 }, { 203, 9 }, { 5, 3 },
+    };
+    /*
+     * The C rows sum in the order of compute_ansnr(). The SIMD rows sum in
+     * lanes, which moves the noise sum, and so the score, by up to 2e-6.
+     */
+    const struct {
+        unsigned cpumask;
+        double tolerance;
+    } path[] = {
+        { ~0u, 0. }, { 16, 5e-6 }, { 0, 5e-6 },
+    };
+
+    for (unsigned b = 0; b < sizeof(bpc) / sizeof(bpc[0]); b++) {
+        for (unsigned s = 0; s < sizeof(size) / sizeof(size[0]); s++) {
+            const unsigned w = size[s].w, h = size[s].h;
+
+            VmafPicture ref, dist;
+            double expected, expected_psnr;
+            int err = fill_picture(&ref, bpc[b], w, h, 1);
+            err |= fill_picture(&dist, bpc[b], w, h, 2);
+            mu_assert("problem allocating pictures", !err);
+            err = reference_ansnr(&ref, &dist, &expected, &expected_psnr);
+            mu_assert("problem computing reference ansnr", !err);
+            vmaf_picture_unref(&ref);
+            vmaf_picture_unref(&dist);
+
+            for (unsigned p = 0; p < sizeof(path) / sizeof(path[0]); p++) {
+                double score, score_psnr;
+                err = extract_ansnr(path[p].cpumask, bpc[b], w, h, &score,
+                                    &score_psnr);
+                mu_assert("problem extracting float_ansnr", !err);
+                mu_assert("float_ansnr should match the float reference",
+                          fabs(score - expected) <=
+                          path[p].tolerance * fabs(expected));
+                mu_assert("float_anpsnr should match the float reference",
+                          fabs(score_psnr - expected_psnr) <=
+                          path[p].tolerance * fabs(expected_psnr));
+            }
+        }
+    }
+
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_ansnr_matches_float_reference);
+    return NULL;
+}
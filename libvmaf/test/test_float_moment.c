@@ -0,0 +1,148 @@
+/**
+ *
+ *  Copyright 2016-2024 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "test.h"
+#include "libvmaf/libvmaf.h"
+#include "mem.h"
+#include "feature/moment.h"
+#include "feature/picture_copy.h"
+
+static const char *feature_name[4] = {
+    "float_moment_ref1st", "float_moment_dis1st",
+    "float_moment_ref2nd", "float_moment_dis2nd",
+};
+
+/* full range samples, so the squares exercise the widest accumulators */
+static int fill_picture(VmafPicture *pic, unsigned bpc, unsigned w,
+                        unsigned h, unsigned seed)
+{
+    int err = vmaf_picture_alloc(pic, VMAF_PIX_FMT_YUV420P, bpc, w, h);
+    if (err) return err;
+
+    const unsigned max = (1u << bpc) - 1;
+    uint32_t lcg = seed * 2654435761u + 1;
+    for (unsigned p = 0; p < 3; p++) {
+        uint8_t *data = pic->data[p];
+        for (unsigned i = 0; i < pic->h[p]; i++) {
+            for (unsigned j = 0; j < pic->w[p]; j++) {
+                lcg = lcg * 1664525u + 1013904223u;
+                const unsigned x = (i * j + (i ^ j) * 37) % (max + 1);
+                const unsigned v = (lcg >> 31) ? max - x : x;
+                if (bpc == 8) data[j] = v;
+                else ((uint16_t *)data)[j] = v;
+            }
+            data += pic->stride[p];
+        }
+    }
+
+    return 0;
+}
+
+/* picture_copy() and compute_{1st,2nd}_moment() of the luma plane */
+static int reference_moments(VmafPicture *pic, double *first, double *second)
+{
+    const unsigned w = pic->w[0], h = pic->h[0];
+    const size_t stride = ALIGN_CEIL(w * sizeof(float));
+    float *buf = aligned_malloc(stride * h, 32);
+    if (!buf) return -1;
+
+    picture_copy(buf, stride, pic, 0, pic->bpc);
+    int err = compute_1st_moment(buf, w, h, stride, first);
+    err |= compute_2nd_moment(buf, w, h, stride, second);
+
+    aligned_free(buf);
+    return err;
+}
+
+static int extract_moments(unsigned cpumask, unsigned bpc, unsigned w,
+                           unsigned h, double score[4])
+{
+    VmafConfiguration cfg = { .cpumask = cpumask };
+    VmafContext *vmaf;
+    int err = vmaf_init(&vmaf, cfg);
+    if (err) return err;
+
+    err = vmaf_use_feature(vmaf, "float_moment", NULL);
+    if (err) goto close_vmaf;
+
+    VmafPicture ref, dist;
+    err |= fill_picture(&ref, bpc, w, h, 1);
+    err |= fill_picture(&dist, bpc, w, h, 2);
+    if (err) goto close_vmaf;
+    err = vmaf_read_pictures(vmaf, &ref, &dist, 0);
+    if (err) goto close_vmaf;
+    err = vmaf_read_pictures(vmaf, NULL, NULL, 0);
+    if (err) goto close_vmaf;
+
+    for (unsigned i = 0; i < 4; i++)
+        err |= vmaf_feature_score_at_index(vmaf, feature_name[i], &score[i], 0);
+
+close_vmaf:
+    vmaf_close(vmaf);
+    return err;
+}
+
+static char *test_moments_match_float_reference()
+{
+    const unsigned bpc[] = { 8, 10, 12, 16 };
+    const struct {
+        unsigned w, h;
+    } size[] = {
+        { 176, 144 }, { 67, 35 }, { 203, 9 }, { 5, 3 },
+    };
+    /* AVX-512, AVX2 and C */
+    const unsigned cpumask[] = { 0, 16, ~0u };
+
+    for (unsigned b = 0; b < sizeof(bpc) / sizeof(bpc[0]); b++) {
+        for (unsigned s = 0; s < sizeof(size) / sizeof(size[0]); s++) {
+            const unsigned w = size[s].w, h = size[s].h;
+
+            VmafPicture ref, dist;
+            double expected[4];
+            int err = fill_picture(&ref, bpc[b], w, h, 1);
+            err |= fill_picture(&dist, bpc[b], w, h, 2);
+            mu_assert("problem allocating pictures", !err);
+            err = reference_moments(&ref, &expected[0], &expected[2]);
+            err |= reference_moments(&dist, &expected[1], &expected[3]);
+            mu_assert("problem computing reference moments", !err);
+            vmaf_picture_unref(&ref);
+            vmaf_picture_unref(&dist);
+
+            for (unsigned m = 0; m < sizeof(cpumask) / sizeof(cpumask[0]); m++) {
+                double score[4];
+                err = extract_moments(cpumask[m], bpc[b], w, h, score);
+                mu_assert("problem extracting float_moment", !err);
+                for (unsigned i = 0; i < 4; i++) {
+                    mu_assert("moments should equal the float reference",
+                              score[i] == expected[i]);
+                }
+            }
+        }
+    }
+
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_moments_match_float_reference);
+    return NULL;
+}
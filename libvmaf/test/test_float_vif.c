@@ -0,0 +1,251 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test.h"
+#include "config.h"
+#include "cpu.h"
+#include "mem.h"
+#include "feature/vif.h"
+#include "feature/vif_options.h"
+#include "feature/vif_tools.h"
+
+static double diff(double a, double b)
+{
+    return a > b ? a - b : b - a;
+}
+
+/* Gradients and texture around zero, like the offset float pictures. */
+static float *alloc_picture(int w, int h, int *stride, unsigned seed,
+                            unsigned noise)
+{
+    *stride = ALIGN_CEIL(w * sizeof(float));
+    float *pic = aligned_malloc(*stride * h, MAX_ALIGN);
+    if (!pic) return NULL;
+
+    uint32_t lcg = seed * 2654435761u + 1;
+    for (int i = 0; i < h; i++) {
+        float *row = pic + i * (*stride / sizeof(float));
+        for (int j = 0; j < w; j++) {
+            lcg = lcg * 1664525u + 1013904223u;
+            const int base = ((i * 3 + j * 5) % 200) + 28 + ((i * j) & 15);
+            int x = base + (int)(lcg >> 24) % (noise + 1) - noise / 2;
+            x = x < 0 ? 0 : x > 255 ? 255 : x;
+            row[j] = x - 128;
+        }
+    }
+
+    return pic;
+}
+
+/* compute_vif() as separate filter passes over full-size planes */
+static int compute_vif_unfused(const float *ref, const float *dis, int w,
+                               int h, int stride, double *scores)
+{
+    const int buf_stride = ALIGN_CEIL(w * sizeof(float));
+    const size_t buf_sz = (size_t)buf_stride * h;
+    char *data = aligned_malloc(buf_sz * 8, MAX_ALIGN);
+    if (!data) return -1;
+
+    float *ref_scale = (float *)(data + 0 * buf_sz);
+    float *dis_scale = (float *)(data + 1 * buf_sz);
+    float *mu1 = (float *)(data + 2 * buf_sz);
+    float *mu2 = (float *)(data + 3 * buf_sz);
+    float *ref_sq = (float *)(data + 4 * buf_sz);
+    float *dis_sq = (float *)(data + 5 * buf_sz);
+    float *ref_dis = (float *)(data + 6 * buf_sz);
+    float *tmp = (float *)(data + 7 * buf_sz);
+
+    const float *curr_ref = ref, *curr_dis = dis;
+    int curr_stride = stride;
+
+    for (int scale = 0; scale < 4; scale++) {
+        const float *f = vif_filter1d_table_s[vif_kernelscale_1][scale];
+        const int fwidth = vif_filter1d_width[vif_kernelscale_1][scale];
+
+        if (scale > 0) {
+            vif_filter1d_s(f, curr_ref, mu1, tmp, w, h, curr_stride,
+                           buf_stride, fwidth);
+            vif_filter1d_s(f, curr_dis, mu2, tmp, w, h, curr_stride,
+                           buf_stride, fwidth);
+            vif_dec2_s(mu1, ref_scale, w, h, buf_stride, buf_stride);
+            vif_dec2_s(mu2, dis_scale, w, h, buf_stride, buf_stride);
+            w /= 2;
+            h /= 2;
+            curr_ref = ref_scale;
+            curr_dis = dis_scale;
+            curr_stride = buf_stride;
+        }
+
+        vif_filter1d_s(f, curr_ref, mu1, tmp, w, h, curr_stride, buf_stride,
+                       fwidth);
+        vif_filter1d_s(f, curr_dis, mu2, tmp, w, h, curr_stride, buf_stride,
+                       fwidth);
+        vif_filter1d_sq_s(f, curr_ref, ref_sq, tmp, w, h, curr_stride,
+                          buf_stride, fwidth);
+        vif_filter1d_sq_s(f, curr_dis, dis_sq, tmp, w, h, curr_stride,
+                          buf_stride, fwidth);
+        vif_filter1d_xy_s(f, curr_ref, curr_dis, ref_dis, tmp, w, h,
+                          curr_stride, curr_stride, buf_stride, fwidth);
+
+        float num, den;
+        vif_statistic_s(mu1, mu2, ref_sq, dis_sq, ref_dis, &num, &den, w, h,
+                        buf_stride, buf_stride, buf_stride, buf_stride,
+                        buf_stride, DEFAULT_VIF_ENHN_GAIN_LIMIT);
+        scores[2 * scale] = num;
+        scores[2 * scale + 1] = den;
+    }
+
+    aligned_free(data);
+    return 0;
+}
+
+static char *compare(VifFloatBuffer *buf, int w, int h, unsigned seed,
+                     unsigned noise, double tolerance)
+{
+    int stride;
+    float *ref = alloc_picture(w, h, &stride, seed, 4);
+    float *dis = alloc_picture(w, h, &stride, seed + 1, noise);
+    mu_assert("problem allocating pictures", ref && dis);
+
+    double expected[8], scores[8];
+    double score, score_num, score_den;
+    int err = compute_vif_unfused(ref, dis, w, h, stride, expected);
+    mu_assert("problem computing unfused vif", !err);
+    err = compute_vif_with_buffer(ref, dis, w, h, stride, stride, &score,
+                                  &score_num, &score_den, scores,
+                                  DEFAULT_VIF_ENHN_GAIN_LIMIT,
+                                  DEFAULT_VIF_KERNELSCALE, buf);
+    mu_assert("problem computing fused vif", !err);
+
+    for (unsigned i = 0; i < 8; i++) {
+        mu_assert("fused vif should match the separate filter passes",
+                  diff(scores[i], expected[i]) <= tolerance * expected[i]);
+    }
+    mu_assert("vif should be the ratio of the summed scales",
+              diff(score, score_num / score_den) < 1e-12);
+
+    aligned_free(ref);
+    aligned_free(dis);
+    return NULL;
+}
+
+static char *test_fused_vif_matches_unfused()
+{
+    /* odd sizes, and pictures smaller than the buffer */
+    const struct {
+        int w, h;
+    } size[] = {
+        { 176, 144 }, { 67, 35 }, { 99, 73 }, { 160, 96 },
+    };
+
+    vmaf_init_cpu();
+
+    VifFloatBuffer buf;
+    int err = vif_float_buffer_init(&buf, 176, 144);
+    mu_assert("problem during vif_float_buffer_init", !err);
+
+    for (unsigned i = 0; i < sizeof(size) / sizeof(size[0]); i++) {
+        for (unsigned noise = 0; noise <= 64; noise += 32) {
+            /* the C filters sum in the same order as the fused ones */
+            vmaf_set_cpu_flags_mask(0);
+            char *msg = compare(&buf, size[i].w, size[i].h, i, noise, 0.);
+            if (msg) return msg;
+
+            /* the AVX2 filters of the separate passes sum in another order */
+            vmaf_set_cpu_flags_mask(~0u);
+            msg = compare(&buf, size[i].w, size[i].h, i, noise, 1e-5);
+            if (msg) return msg;
+        }
+    }
+
+    vif_float_buffer_free(&buf);
+    return NULL;
+}
+
+static char *test_fused_vif_simd_matches_c()
+{
+    vmaf_init_cpu();
+
+    int stride;
+    const int w = 203, h = 117;
+    float *ref = alloc_picture(w, h, &stride, 7, 4);
+    float *dis = alloc_picture(w, h, &stride, 8, 48);
+    mu_assert("problem allocating pictures", ref && dis);
+
+    VifFloatBuffer buf;
+    int err = vif_float_buffer_init(&buf, w, h);
+    mu_assert("problem during vif_float_buffer_init", !err);
+
+    double scores[2][8];
+    double score, score_num, score_den;
+    for (unsigned i = 0; i < 2; i++) {
+        vmaf_set_cpu_flags_mask(i ? ~0u : 0);
+        err = compute_vif_with_buffer(ref, dis, w, h, stride, stride, &score,
+                                      &score_num, &score_den, scores[i],
+                                      DEFAULT_VIF_ENHN_GAIN_LIMIT,
+                                      DEFAULT_VIF_KERNELSCALE, &buf);
+        mu_assert("problem computing fused vif", !err);
+    }
+    vmaf_set_cpu_flags_mask(~0u);
+
+    mu_assert("simd vif should match the c implementation",
+              !memcmp(scores[0], scores[1], sizeof(scores[0])));
+
+    vif_float_buffer_free(&buf);
+    aligned_free(ref);
+    aligned_free(dis);
+    return NULL;
+}
+
+static char *test_fused_vif_buffer_too_small()
+{
+    VifFloatBuffer buf;
+    int err = vif_float_buffer_init(&buf, 64, 48);
+    mu_assert("problem during vif_float_buffer_init", !err);
+
+    int stride;
+    float *pic = alloc_picture(64, 64, &stride, 1, 0);
+    mu_assert("problem allocating picture", pic);
+
+    double scores[8];
+    double score, score_num, score_den;
+    err = compute_vif_with_buffer(pic, pic, 64, 64, stride, stride, &score,
+                                  &score_num, &score_den, scores,
+                                  DEFAULT_VIF_ENHN_GAIN_LIMIT,
+                                  DEFAULT_VIF_KERNELSCALE, &buf);
+    mu_assert("a picture larger than the buffer should be rejected", err);
+
+    vif_float_buffer_free(&buf);
+    aligned_free(pic);
+
+    err = vif_float_buffer_init(&buf, 0, 48);
+    mu_assert("an empty picture should be rejected", err);
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_fused_vif_matches_unfused);
+    mu_run_test(test_fused_vif_simd_matches_c);
+    mu_run_test(test_fused_vif_buffer_too_small);
+    return NULL;
+}
@@ -97,7 +97,7 @@ static char *test_framesync_create_process_and_destroy()
     VmafFrameSyncContext *fs_ctx;
     unsigned n_threads = 2;
 
-    err = vmaf_thread_pool_create(&pool, n_threads);
+    err = vmaf_thread_pool_create(&pool, n_threads, NULL);
     mu_assert("problem during vmaf_thread_pool_init", !err);
 
     err = vmaf_framesync_init(&fs_ctx);
@@ -0,0 +1,199 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "libvmaf/libvmaf.h"
+#include "libvmaf/feature.h"
+
+#define PIC_CNT 10
+#define PIC_W 64
+#define PIC_H 48
+
+static int fill_picture(VmafPicture *pic, unsigned index, unsigned seed)
+{
+    int err = vmaf_picture_alloc(pic, VMAF_PIX_FMT_YUV420P, 8, PIC_W, PIC_H);
+    if (err) return err;
+
+    uint32_t state = 1 + index * 7919 + seed;
+    for (unsigned p = 0; p < 3; p++) {
+        uint8_t *data = pic->data[p];
+        for (unsigned i = 0; i < pic->h[p]; i++) {
+            for (unsigned j = 0; j < pic->w[p]; j++) {
+                state = state * 1664525 + 1013904223;
+                data[j] = ((i + j + 3 * index) & 0xC0) | (state >> 26);
+            }
+            data += pic->stride[p];
+        }
+    }
+
+    return 0;
+}
+
+static int init_context(VmafContext **vmaf)
+{
+    VmafConfiguration cfg = { 0 };
+    int err = vmaf_init(vmaf, cfg);
+    if (err) return err;
+
+    VmafFeatureDictionary *psnr_opts = NULL;
+    err |= vmaf_feature_dictionary_set(&psnr_opts, "enable_apsnr", "true");
+    err |= vmaf_use_feature(*vmaf, "psnr", psnr_opts);
+    err |= vmaf_use_feature(*vmaf, "motion", NULL);
+    err |= vmaf_use_feature(*vmaf, "vif", NULL);
+    return err;
+}
+
+static int score_frames(VmafContext *vmaf, unsigned from, unsigned to)
+{
+    int err = 0;
+    for (unsigned i = from; i < to; i++) {
+        VmafPicture ref, dist;
+        err |= fill_picture(&ref, i, 0);
+        err |= fill_picture(&dist, i, 1);
+        if (err) return err;
+        err = vmaf_read_pictures(vmaf, &ref, &dist, i);
+        if (err) return err;
+    }
+    return vmaf_read_pictures(vmaf, NULL, NULL, 0);
+}
+
+static int score_segment(unsigned low, unsigned high, const char *path)
+{
+    VmafContext *vmaf;
+    int err = init_context(&vmaf);
+    err |= vmaf_set_score_window(vmaf, low, high);
+    if (err) return err;
+
+    // one frame of temporal context on either side of the segment
+    const unsigned from = low > 0 ? low - 1 : 0;
+    const unsigned to = high + 2 < PIC_CNT ? high + 2 : PIC_CNT;
+    err |= score_frames(vmaf, from, to);
+    err |= vmaf_write_partial_results(vmaf, path);
+    err |= vmaf_close(vmaf);
+    return err;
+}
+
+static int files_match(const char *path_a, const char *path_b)
+{
+    FILE *a = fopen(path_a, "r");
+    FILE *b = fopen(path_b, "r");
+    int match = a && b;
+
+    char line_a[4096], line_b[4096];
+    while (match) {
+        char *ra = fgets(line_a, sizeof(line_a), a);
+        char *rb = fgets(line_b, sizeof(line_b), b);
+        if (!ra || !rb) {
+            match = !ra && !rb;
+            break;
+        }
+        // throughput differs between runs
+        if (strstr(line_a, "fps") && strstr(line_b, "fps"))
+            continue;
+        match = !strcmp(line_a, line_b);
+    }
+
+    if (a) fclose(a);
+    if (b) fclose(b);
+    return match;
+}
+
+static char *test_merge_segments_matches_single_run()
+{
+    const char *single_path = "test_partial_results_single.xml";
+    const char *merged_path = "test_partial_results_merged.xml";
+    const char *segment_path[3] = {
+        "test_partial_results_0.state",
+        "test_partial_results_1.state",
+        "test_partial_results_2.state",
+    };
+    const unsigned segment[3][2] = { { 0, 3 }, { 4, 6 }, { 7, 9 } };
+
+    VmafContext *vmaf;
+    int err = init_context(&vmaf);
+    mu_assert("problem during init_context", !err);
+    err = score_frames(vmaf, 0, PIC_CNT);
+    mu_assert("problem scoring single run", !err);
+    err = vmaf_write_output(vmaf, single_path, VMAF_OUTPUT_FORMAT_XML);
+    mu_assert("problem writing single run output", !err);
+    vmaf_close(vmaf);
+
+    for (unsigned i = 0; i < 3; i++) {
+        err = score_segment(segment[i][0], segment[i][1], segment_path[i]);
+        mu_assert("problem scoring segment", !err);
+    }
+
+    VmafConfiguration cfg = { 0 };
+    err = vmaf_init(&vmaf, cfg);
+    mu_assert("problem during vmaf_init", !err);
+    // merge order must not matter
+    err |= vmaf_merge_results(vmaf, segment_path[2]);
+    err |= vmaf_merge_results(vmaf, segment_path[0]);
+    err |= vmaf_merge_results(vmaf, segment_path[1]);
+    mu_assert("problem during vmaf_merge_results", !err);
+
+    double score;
+    err = vmaf_feature_score_pooled(vmaf, "psnr_y", VMAF_POOL_METHOD_MEAN,
+                                    &score, 0, PIC_CNT - 1);
+    mu_assert("merged context is missing frames", !err);
+
+    err = vmaf_merge_results(vmaf, segment_path[1]);
+    mu_assert("overlapping segments should not merge", err);
+
+    err = vmaf_write_output(vmaf, merged_path, VMAF_OUTPUT_FORMAT_XML);
+    mu_assert("problem writing merged output", !err);
+    vmaf_close(vmaf);
+
+    mu_assert("merged output does not match single run",
+              files_match(single_path, merged_path));
+
+    remove(single_path);
+    remove(merged_path);
+    for (unsigned i = 0; i < 3; i++)
+        remove(segment_path[i]);
+
+    return NULL;
+}
+
+static char *test_merge_rejects_read_context()
+{
+    VmafContext *vmaf;
+    int err = init_context(&vmaf);
+    mu_assert("problem during init_context", !err);
+    err = score_frames(vmaf, 0, 2);
+    mu_assert("problem scoring frames", !err);
+
+    err = vmaf_merge_results(vmaf, "test_partial_results_missing.state");
+    mu_assert("merging into a context with pictures should fail", err);
+    err = vmaf_set_score_window(vmaf, 0, 1);
+    mu_assert("setting a window after reading pictures should fail", err);
+
+    vmaf_close(vmaf);
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_merge_segments_matches_single_run);
+    mu_run_test(test_merge_rejects_read_context);
+    return NULL;
+}
@@ -20,6 +20,7 @@
 
 #include "test.h"
 #include "picture.h"
+#include "picture_pool.h"
 #include "libvmaf/picture.h"
 #include "ref.h"
 
@@ -65,9 +66,62 @@ static char *test_picture_data_alignment()
     return NULL;
 }
 
+static char *test_picture_pool()
+{
+    int err;
+
+    VmafPicturePool *pool;
+    VmafPicturePoolConfig cfg = {
+        .pic_cnt = 2, .w = 1920 + 1, .h = 1080, .bpc = 10,
+        .pix_fmt = VMAF_PIX_FMT_YUV420P,
+    };
+    err = vmaf_picture_pool_init(&pool, cfg);
+    mu_assert("problem during vmaf_picture_pool_init", !err);
+
+    VmafPicture pic[3];
+    for (unsigned i = 0; i < 3; i++) {
+        err = vmaf_picture_pool_fetch(pool, &pic[i]);
+        mu_assert("problem during vmaf_picture_pool_fetch", !err);
+    }
+
+    VmafPicture expected;
+    vmaf_picture_alloc(&expected, cfg.pix_fmt, cfg.bpc, cfg.w, cfg.h);
+    for (unsigned i = 0; i < 3; i++) {
+        mu_assert("pooled picture layout should match vmaf_picture_alloc",
+                  pic[i].w[1] == expected.w[1] &&
+                  pic[i].h[1] == expected.h[1] &&
+                  pic[i].stride[0] == expected.stride[0] &&
+                  pic[i].stride[1] == expected.stride[1] &&
+                  pic[i].data[1] - pic[i].data[0] ==
+                  expected.data[1] - expected.data[0]);
+        mu_assert("pooled picture data is not 32-byte alligned",
+                  !(((uintptr_t) pic[i].data[0]) % 32) &&
+                  !(((uintptr_t) pic[i].data[2]) % 32));
+    }
+    vmaf_picture_unref(&expected);
+
+    uint8_t *released = pic[1].data[0];
+    err = vmaf_picture_unref(&pic[1]);
+    mu_assert("problem during vmaf_picture_unref", !err);
+    err = vmaf_picture_pool_fetch(pool, &pic[1]);
+    mu_assert("problem during vmaf_picture_pool_fetch", !err);
+    mu_assert("released buffer should be reused", pic[1].data[0] == released);
+
+    // pictures outlive the pool
+    err = vmaf_picture_pool_close(pool);
+    mu_assert("problem during vmaf_picture_pool_close", !err);
+    for (unsigned i = 0; i < 3; i++) {
+        err = vmaf_picture_unref(&pic[i]);
+        mu_assert("problem during vmaf_picture_unref", !err);
+    }
+
+    return NULL;
+}
+
 char *run_tests()
 {
     mu_run_test(test_picture_alloc_ref_and_unref);
     mu_run_test(test_picture_data_alignment);
+    mu_run_test(test_picture_pool);
     return NULL;
 }
@@ -0,0 +1,137 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test.h"
+#include "cpu.h"
+#include "libvmaf/picture.h"
+
+#define W 71
+#define H 5
+
+static uint8_t src8[H][W + 9];
+static uint16_t src16[H][W + 13];
+
+static void fill_sources()
+{
+    unsigned seed = 1;
+    for (unsigned i = 0; i < H; i++) {
+        for (unsigned j = 0; j < W; j++) {
+            seed = seed * 1103515245 + 12345;
+            src8[i][j] = seed >> 16;
+            src16[i][j] = (seed >> 8) & 0x3ff;
+        }
+    }
+}
+
+static char *check_widen(unsigned cpu_flags)
+{
+    int err;
+    uint16_t dst[H][W + 5];
+
+    vmaf_set_cpu_flags_mask(cpu_flags);
+
+    memset(dst, 0xff, sizeof(dst));
+    err = vmaf_picture_copy_plane(dst, sizeof(dst[0]), 10,
+                                  src8, sizeof(src8[0]), 8, W, H);
+    mu_assert("problem during vmaf_picture_copy_plane", !err);
+    for (unsigned i = 0; i < H; i++) {
+        for (unsigned j = 0; j < W; j++)
+            mu_assert("8-bit samples should be widened by a shift of 2",
+                      dst[i][j] == src8[i][j] << 2);
+        mu_assert("padding should not be written", dst[i][W] == 0xffff);
+    }
+
+    memset(dst, 0xff, sizeof(dst));
+    err = vmaf_picture_copy_plane(dst, sizeof(dst[0]), 12,
+                                  src16, sizeof(src16[0]), 10, W, H);
+    mu_assert("problem during vmaf_picture_copy_plane", !err);
+    for (unsigned i = 0; i < H; i++) {
+        for (unsigned j = 0; j < W; j++)
+            mu_assert("10-bit samples should be widened by a shift of 2",
+                      dst[i][j] == src16[i][j] << 2);
+        mu_assert("padding should not be written", dst[i][W] == 0xffff);
+    }
+
+    return NULL;
+}
+
+static char *test_picture_copy_plane()
+{
+    int err;
+    char *msg;
+
+    fill_sources();
+
+    msg = check_widen(0);
+    if (msg) return msg;
+    vmaf_init_cpu();
+    msg = check_widen(~0);
+    if (msg) return msg;
+
+    uint8_t dst8[H][W + 3];
+    err = vmaf_picture_copy_plane(dst8, sizeof(dst8[0]), 8,
+                                  src8, sizeof(src8[0]), 8, W, H);
+    mu_assert("problem during vmaf_picture_copy_plane", !err);
+    for (unsigned i = 0; i < H; i++)
+        mu_assert("same depth should be a plain copy",
+                  !memcmp(dst8[i], src8[i], W));
+
+    err = vmaf_picture_copy_plane(dst8, sizeof(dst8[0]), 8,
+                                  src16, sizeof(src16[0]), 10, W, H);
+    mu_assert("narrowing should be rejected", err);
+
+    return NULL;
+}
+
+static char *test_picture_copy_planes_drops_chroma()
+{
+    int err;
+
+    VmafPicture pic;
+    err = vmaf_picture_alloc(&pic, VMAF_PIX_FMT_YUV400P, 10, W, H);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+
+    // chroma planes are never read for a yuv400 destination
+    void *data[3] = { src8, NULL, NULL };
+    const ptrdiff_t stride[3] = { sizeof(src8[0]), 0, 0 };
+    err = vmaf_picture_copy_planes(&pic, data, stride, 8);
+    mu_assert("problem during vmaf_picture_copy_planes", !err);
+
+    uint16_t *y = pic.data[0];
+    for (unsigned i = 0; i < H; i++) {
+        for (unsigned j = 0; j < W; j++)
+            mu_assert("luma should be widened", y[j] == src8[i][j] << 2);
+        y += pic.stride[0] / 2;
+    }
+
+    err = vmaf_picture_unref(&pic);
+    mu_assert("problem during vmaf_picture_unref", !err);
+
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_picture_copy_plane);
+    mu_run_test(test_picture_copy_planes_drops_chroma);
+    return NULL;
+}
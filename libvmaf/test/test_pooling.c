@@ -0,0 +1,437 @@
+/**
+ *
+ *  Copyright 2016-2024 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test.h"
+#include "pooling.h"
+
+#include "libvmaf/libvmaf.h"
+#include "libvmaf/model.h"
+
+static uint32_t rnd_state = 1;
+
+static double rnd(unsigned levels)
+{
+    rnd_state = rnd_state * 1664525 + 1013904223;
+    return (rnd_state >> 8) % levels * (100. / levels);
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    const double da = *(const double *) a, db = *(const double *) b;
+    return (da > db) - (da < db);
+}
+
+static double brute_percentile(const double *scores, unsigned cnt, double p)
+{
+    double *sorted = malloc(sizeof(*sorted) * cnt);
+    memcpy(sorted, scores, sizeof(*sorted) * cnt);
+    qsort(sorted, cnt, sizeof(*sorted), cmp_double);
+
+    const double rank = p / 100. * (cnt - 1);
+    const unsigned lo = floor(rank), hi = ceil(rank);
+    const double res = sorted[lo] + (sorted[hi] - sorted[lo]) * (rank - lo);
+    free(sorted);
+    return res;
+}
+
+static double brute_window_min(const double *scores, unsigned cnt,
+                               unsigned window)
+{
+    if (window > cnt) window = cnt;
+    double min = INFINITY;
+    for (unsigned i = 0; i + window <= cnt; i++) {
+        double sum = 0.;
+        for (unsigned j = i; j < i + window; j++)
+            sum += scores[j];
+        if (sum / window < min) min = sum / window;
+    }
+    return min;
+}
+
+enum { SCORES_RANDOM, SCORES_SORTED, SCORES_REVERSED, SCORES_FEW_LEVELS };
+
+static void fill_scores(double *scores, unsigned cnt, unsigned kind)
+{
+    for (unsigned i = 0; i < cnt; i++) {
+        switch (kind) {
+        case SCORES_SORTED:
+            scores[i] = i;
+            break;
+        case SCORES_REVERSED:
+            scores[i] = cnt - i;
+            break;
+        case SCORES_FEW_LEVELS:
+            scores[i] = rnd(3);
+            break;
+        default:
+            scores[i] = rnd(1 << 20);
+            break;
+        }
+    }
+}
+
+static char *test_percentile()
+{
+    const unsigned cnt[] = { 1, 2, 3, 10, 101, 1000, 4099 };
+    const double p[] = { 0., 1., 5., 10., 33.3, 50., 95., 99., 100. };
+
+    for (unsigned kind = 0; kind <= SCORES_FEW_LEVELS; kind++) {
+        for (unsigned i = 0; i < sizeof(cnt) / sizeof(cnt[0]); i++) {
+            double *scores = malloc(sizeof(*scores) * cnt[i]);
+            double *work = malloc(sizeof(*work) * cnt[i]);
+            fill_scores(scores, cnt[i], kind);
+            for (unsigned j = 0; j < sizeof(p) / sizeof(p[0]); j++) {
+                memcpy(work, scores, sizeof(*work) * cnt[i]);
+                const double expected = brute_percentile(scores, cnt[i], p[j]);
+                const double res = vmaf_pool_percentile(work, cnt[i], p[j]);
+                mu_assert("percentile does not match sorted reference",
+                          fabs(res - expected) < 1e-9);
+            }
+            free(work);
+            free(scores);
+        }
+    }
+
+    return NULL;
+}
+
+static char *test_window_min()
+{
+    const unsigned cnt[] = { 1, 7, 100, 1000 };
+    const unsigned window[] = { 1, 2, 5, 24, 1000, 2000 };
+
+    for (unsigned kind = 0; kind <= SCORES_FEW_LEVELS; kind++) {
+        for (unsigned i = 0; i < sizeof(cnt) / sizeof(cnt[0]); i++) {
+            double *scores = malloc(sizeof(*scores) * cnt[i]);
+            fill_scores(scores, cnt[i], kind);
+            for (unsigned j = 0; j < sizeof(window) / sizeof(window[0]); j++) {
+                const double expected =
+                    brute_window_min(scores, cnt[i], window[j]);
+                const double res =
+                    vmaf_pool_window_min(scores, cnt[i], window[j]);
+                mu_assert("window minimum does not match brute force",
+                          fabs(res - expected) < 1e-6);
+            }
+            free(scores);
+        }
+    }
+
+    return NULL;
+}
+
+static char *test_pooling_cfg()
+{
+    char name[32];
+    VmafPoolingConfiguration cfg = {
+        .method = VMAF_POOL_METHOD_PERCENTILE, .param = 5.,
+    };
+    int err = vmaf_pooling_cfg_name(cfg, name, sizeof(name));
+    mu_assert("problem naming percentile", !err && !strcmp(name, "p5"));
+    cfg.param = 0.5;
+    err = vmaf_pooling_cfg_name(cfg, name, sizeof(name));
+    mu_assert("problem naming percentile", !err && !strcmp(name, "p0.5"));
+    cfg.param = 100.5;
+    mu_assert("percentile above 100 should be invalid",
+              !vmaf_pooling_cfg_is_valid(cfg));
+
+    cfg.method = VMAF_POOL_METHOD_WINDOW_MIN;
+    cfg.param = 48.;
+    err = vmaf_pooling_cfg_name(cfg, name, sizeof(name));
+    mu_assert("problem naming window minimum",
+              !err && !strcmp(name, "min_window48"));
+    cfg.param = 2.5;
+    mu_assert("fractional window should be invalid",
+              !vmaf_pooling_cfg_is_valid(cfg));
+    cfg.param = 0.;
+    mu_assert("empty window should be invalid",
+              !vmaf_pooling_cfg_is_valid(cfg));
+
+    return NULL;
+}
+
+static char *test_feature_score_pooled_with_config()
+{
+    VmafConfiguration cfg = { 0 };
+    VmafContext *vmaf;
+    int err = vmaf_init(&vmaf, cfg);
+    mu_assert("problem during vmaf_init", !err);
+
+    enum { CNT = 500 };
+    double scores[CNT];
+    fill_scores(scores, CNT, SCORES_RANDOM);
+    for (unsigned i = 0; i < CNT; i++) {
+        err = vmaf_import_feature_score(vmaf, "feature", scores[i], i);
+        mu_assert("problem during vmaf_import_feature_score", !err);
+    }
+
+    // the pooling interval leaves out the first and last 50 frames
+    double score;
+    VmafPoolingConfiguration p10 = {
+        .method = VMAF_POOL_METHOD_PERCENTILE, .param = 10.,
+    };
+    err = vmaf_feature_score_pooled_with_config(vmaf, "feature", p10, &score,
+                                                50, CNT - 51);
+    mu_assert("problem pooling percentile", !err);
+    mu_assert("pooled percentile does not match sorted reference",
+              fabs(score - brute_percentile(scores + 50, CNT - 100, 10.)) < 1e-9);
+
+    VmafPoolingConfiguration window = {
+        .method = VMAF_POOL_METHOD_WINDOW_MIN, .param = 24.,
+    };
+    err = vmaf_feature_score_pooled_with_config(vmaf, "feature", window,
+                                                &score, 50, CNT - 51);
+    mu_assert("problem pooling window minimum", !err);
+    mu_assert("pooled window minimum does not match brute force",
+              fabs(score - brute_window_min(scores + 50, CNT - 100, 24)) < 1e-6);
+
+    VmafPoolingConfiguration mean = { .method = VMAF_POOL_METHOD_MEAN };
+    double expected;
+    err = vmaf_feature_score_pooled_with_config(vmaf, "feature", mean, &score,
+                                                0, CNT - 1);
+    err |= vmaf_feature_score_pooled(vmaf, "feature", VMAF_POOL_METHOD_MEAN,
+                                     &expected, 0, CNT - 1);
+    mu_assert("problem pooling mean", !err && score == expected);
+
+    err = vmaf_feature_score_pooled(vmaf, "feature", VMAF_POOL_METHOD_PERCENTILE,
+                                    &score, 0, CNT - 1);
+    mu_assert("percentile without a parameter should fail", err);
+    err = vmaf_feature_score_pooled_with_config(vmaf, "feature", p10, &score,
+                                                0, CNT);
+    mu_assert("pooling over missing frames should fail", err);
+
+    vmaf_close(vmaf);
+    return NULL;
+}
+
+static char *test_output_pooling()
+{
+    const char *path = "test_pooling.json";
+    VmafConfiguration cfg = { 0 };
+    VmafContext *vmaf;
+    int err = vmaf_init(&vmaf, cfg);
+    mu_assert("problem during vmaf_init", !err);
+
+    VmafPoolingConfiguration p5 = {
+        .method = VMAF_POOL_METHOD_PERCENTILE, .param = 5.,
+    };
+    VmafPoolingConfiguration window = {
+        .method = VMAF_POOL_METHOD_WINDOW_MIN, .param = 2.,
+    };
+    VmafPoolingConfiguration invalid = {
+        .method = VMAF_POOL_METHOD_WINDOW_MIN, .param = 0.,
+    };
+    err = vmaf_use_pooling(vmaf, p5);
+    err |= vmaf_use_pooling(vmaf, window);
+    mu_assert("problem during vmaf_use_pooling", !err);
+    err = vmaf_use_pooling(vmaf, invalid);
+    mu_assert("invalid pooling method should be rejected", err);
+
+    for (unsigned i = 0; i < 4; i++) {
+        VmafPicture ref, dist;
+        err = vmaf_picture_alloc(&ref, VMAF_PIX_FMT_YUV420P, 8, 16, 16);
+        err |= vmaf_picture_alloc(&dist, VMAF_PIX_FMT_YUV420P, 8, 16, 16);
+        err |= vmaf_import_feature_score(vmaf, "feature", 10. * i, i);
+        err |= vmaf_read_pictures(vmaf, &ref, &dist, i);
+        mu_assert("problem reading pictures", !err);
+    }
+    err = vmaf_read_pictures(vmaf, NULL, NULL, 0);
+    mu_assert("problem flushing context", !err);
+
+    err = vmaf_write_output(vmaf, path, VMAF_OUTPUT_FORMAT_JSON);
+    mu_assert("problem during vmaf_write_output", !err);
+    vmaf_close(vmaf);
+
+    FILE *f = fopen(path, "r");
+    mu_assert("output was not written", f);
+    char buf[4096];
+    const size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+    buf[n] = '\0';
+    fclose(f);
+    remove(path);
+
+    mu_assert("output is missing the percentile",
+              strstr(buf, "\"p5\": 1.500000"));
+    mu_assert("output is missing the window minimum",
+              strstr(buf, "\"min_window2\": 5.000000"));
+
+    return NULL;
+}
+
+#define PIC_CNT 300
+#define PIC_W 64
+#define PIC_H 48
+
+static int fill_picture(VmafPicture *pic, unsigned index, unsigned seed)
+{
+    int err = vmaf_picture_alloc(pic, VMAF_PIX_FMT_YUV420P, 8, PIC_W, PIC_H);
+    if (err) return err;
+
+    uint32_t state = 1 + index * 7919 + seed;
+    for (unsigned p = 0; p < 3; p++) {
+        uint8_t *data = pic->data[p];
+        for (unsigned i = 0; i < pic->h[p]; i++) {
+            for (unsigned j = 0; j < pic->w[p]; j++) {
+                state = state * 1664525 + 1013904223;
+                data[j] = ((i + j + 3 * index) & 0xC0) | (state >> (26 - seed));
+            }
+            data += pic->stride[p];
+        }
+    }
+
+    return 0;
+}
+
+typedef struct {
+    double mean, p5, bagging, ci_lo;
+    double score[PIC_CNT];
+} PooledScores;
+
+static int score_with_threads(unsigned n_threads, const char *output_path,
+                              PooledScores *res)
+{
+    VmafConfiguration cfg = { .n_threads = n_threads };
+    VmafContext *vmaf;
+    int err = vmaf_init(&vmaf, cfg);
+    if (err) return err;
+
+    VmafModel *model, *model_b;
+    VmafModelCollection *model_collection = NULL;
+    VmafModelConfig model_cfg = { 0 };
+    err = vmaf_model_load(&model, &model_cfg, "vmaf_v0.6.1");
+    if (err) goto close_vmaf;
+    err = vmaf_model_collection_load(&model_b, &model_collection, &model_cfg,
+                                     "vmaf_b_v0.6.3");
+    if (err) goto destroy_model;
+    err = vmaf_use_features_from_model(vmaf, model);
+    err |= vmaf_use_features_from_model_collection(vmaf, model_collection);
+    if (err) goto destroy_models;
+
+    for (unsigned i = 0; i < PIC_CNT; i++) {
+        VmafPicture ref, dist;
+        err = fill_picture(&ref, i, 0);
+        err |= fill_picture(&dist, i, 1);
+        if (err) goto destroy_models;
+        err = vmaf_read_pictures(vmaf, &ref, &dist, i);
+        if (err) goto destroy_models;
+    }
+    err = vmaf_read_pictures(vmaf, NULL, NULL, 0);
+    if (err) goto destroy_models;
+
+    VmafPoolingConfiguration p5 = {
+        .method = VMAF_POOL_METHOD_PERCENTILE, .param = 5.,
+    };
+    VmafModelCollectionScore collection_score;
+    err = vmaf_score_pooled(vmaf, model, VMAF_POOL_METHOD_MEAN, &res->mean, 0,
+                            PIC_CNT - 1);
+    err |= vmaf_score_pooled_with_config(vmaf, model, p5, &res->p5, 0,
+                                         PIC_CNT - 1);
+    err |= vmaf_score_pooled_model_collection(vmaf, model_collection,
+                                              VMAF_POOL_METHOD_MEAN,
+                                              &collection_score, 0,
+                                              PIC_CNT - 1);
+    if (err) goto destroy_models;
+    res->bagging = collection_score.bootstrap.bagging_score;
+    res->ci_lo = collection_score.bootstrap.ci.p95.lo;
+
+    for (unsigned i = 0; i < PIC_CNT; i++) {
+        err = vmaf_score_at_index(vmaf, model, &res->score[i], i);
+        if (err) goto destroy_models;
+    }
+
+    err = vmaf_write_output(vmaf, output_path, VMAF_OUTPUT_FORMAT_XML);
+
+destroy_models:
+    vmaf_model_destroy(model_b);
+    vmaf_model_collection_destroy(model_collection);
+destroy_model:
+    vmaf_model_destroy(model);
+close_vmaf:
+    vmaf_close(vmaf);
+    return err;
+}
+
+static int files_match(const char *path_a, const char *path_b)
+{
+    FILE *a = fopen(path_a, "r");
+    FILE *b = fopen(path_b, "r");
+    int match = a && b;
+
+    char line_a[8192], line_b[8192];
+    while (match) {
+        char *ra = fgets(line_a, sizeof(line_a), a);
+        char *rb = fgets(line_b, sizeof(line_b), b);
+        if (!ra || !rb) {
+            match = !ra && !rb;
+            break;
+        }
+        // throughput differs between runs
+        if (strstr(line_a, "fps") && strstr(line_b, "fps"))
+            continue;
+        match = !strcmp(line_a, line_b);
+    }
+
+    if (a) fclose(a);
+    if (b) fclose(b);
+    return match;
+}
+
+static char *test_threaded_prediction()
+{
+    const char *serial_path = "test_pooling_serial.xml";
+    const char *threaded_path = "test_pooling_threaded.xml";
+
+    static PooledScores serial, threaded;
+    int err = score_with_threads(0, serial_path, &serial);
+    mu_assert("problem scoring without threads", !err);
+    err = score_with_threads(4, threaded_path, &threaded);
+    mu_assert("problem scoring with threads", !err);
+
+    mu_assert("threaded pooled mean differs", serial.mean == threaded.mean);
+    mu_assert("threaded pooled percentile differs", serial.p5 == threaded.p5);
+    mu_assert("threaded bagging score differs",
+              serial.bagging == threaded.bagging);
+    mu_assert("threaded confidence interval differs",
+              serial.ci_lo == threaded.ci_lo);
+    for (unsigned i = 0; i < PIC_CNT; i++) {
+        mu_assert("threaded per-frame score differs",
+                  serial.score[i] == threaded.score[i]);
+    }
+    mu_assert("threaded output differs",
+              files_match(serial_path, threaded_path));
+
+    remove(serial_path);
+    remove(threaded_path);
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_percentile);
+    mu_run_test(test_window_min);
+    mu_run_test(test_pooling_cfg);
+    mu_run_test(test_feature_score_pooled_with_config);
+    mu_run_test(test_output_pooling);
+    mu_run_test(test_threaded_prediction);
+    return NULL;
+}
@@ -266,11 +266,99 @@ static char *test_piecewise_linear_mapping()
     return NULL;
 }
 
+static char *test_shared_kernel()
+{
+    int err;
+
+    VmafModel *model;
+    VmafModelCollection *model_collection;
+    VmafModelConfig cfg = {
+        .name = "vmaf_b",
+        .flags = VMAF_MODEL_FLAGS_DEFAULT,
+    };
+    err = vmaf_model_collection_load(&model, &model_collection, &cfg,
+                                     "vmaf_b_v0.6.3");
+    mu_assert("problem during vmaf_model_collection_load", !err);
+    mu_assert("bootstrap models should share kernel evaluations",
+              model_collection->shared_kernel);
+
+    unsigned sv_cnt = 0;
+    for (unsigned i = 0; i < model_collection->cnt; i++)
+        sv_cnt += model_collection->model[i]->svm->l;
+    mu_assert("support vectors shared between models should be deduped",
+              vmaf_shared_kernel_sv_cnt(model_collection->shared_kernel) <
+              sv_cnt);
+
+    VmafFeatureCollector *fc_shared, *fc_per_model;
+    err = vmaf_feature_collector_init(&fc_shared);
+    err |= vmaf_feature_collector_init(&fc_per_model);
+    mu_assert("problem during vmaf_feature_collector_init", !err);
+
+    const unsigned n_frames = 8;
+    for (unsigned i = 0; i < n_frames; i++) {
+        for (unsigned j = 0; j < model->n_features; j++) {
+            // motion is scaled up, everything else lies in [0, 1]
+            const double score = (j == 1 ? 20. : 1.) * (i + j + 1) / 16.;
+            err = vmaf_feature_collector_append(fc_shared,
+                                                model->feature[j].name,
+                                                score, i);
+            err |= vmaf_feature_collector_append(fc_per_model,
+                                                 model->feature[j].name,
+                                                 score, i);
+            mu_assert("problem during vmaf_feature_collector_append", !err);
+        }
+    }
+
+    VmafSharedKernel *shared_kernel = model_collection->shared_kernel;
+    for (unsigned i = 0; i < n_frames; i++) {
+        VmafModelCollectionScore shared, per_model;
+        err = vmaf_predict_score_at_index_model_collection(model_collection,
+                                                           fc_shared, i,
+                                                           &shared);
+        mu_assert("problem predicting with shared kernels", !err);
+
+        model_collection->shared_kernel = NULL;
+        err = vmaf_predict_score_at_index_model_collection(model_collection,
+                                                           fc_per_model, i,
+                                                           &per_model);
+        model_collection->shared_kernel = shared_kernel;
+        mu_assert("problem predicting per model", !err);
+
+        mu_assert("bagging score differs",
+                  shared.bootstrap.bagging_score ==
+                  per_model.bootstrap.bagging_score);
+        mu_assert("stddev differs",
+                  shared.bootstrap.stddev == per_model.bootstrap.stddev);
+        mu_assert("confidence interval differs",
+                  shared.bootstrap.ci.p95.lo == per_model.bootstrap.ci.p95.lo &&
+                  shared.bootstrap.ci.p95.hi == per_model.bootstrap.ci.p95.hi);
+
+        for (unsigned j = 0; j < model_collection->cnt; j++) {
+            const char *name = model_collection->model[j]->name;
+            double score_shared, score_per_model;
+            err = vmaf_feature_collector_get_score(fc_shared, name,
+                                                   &score_shared, i);
+            err |= vmaf_feature_collector_get_score(fc_per_model, name,
+                                                    &score_per_model, i);
+            mu_assert("missing bootstrap model score", !err);
+            mu_assert("bootstrap model score differs",
+                      score_shared == score_per_model);
+        }
+    }
+
+    vmaf_feature_collector_destroy(fc_shared);
+    vmaf_feature_collector_destroy(fc_per_model);
+    vmaf_model_collection_destroy(model_collection);
+    vmaf_model_destroy(model);
+    return NULL;
+}
+
 char *run_tests()
 {
     mu_run_test(test_predict_score_at_index);
     mu_run_test(test_find_linear_function_parameters);
     mu_run_test(test_piecewise_linear_mapping);
     mu_run_test(test_propagate_metadata);
+    mu_run_test(test_shared_kernel);
     return NULL;
 }
@@ -0,0 +1,135 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "test.h"
+#include "libvmaf/libvmaf.h"
+
+/*
+ * The SIMD kernels compute the same integer DCT and add the masked errors in
+ * the same order as the C code. Only the masking thresholds, which come from
+ * exact integer variances, round differently, which moves the result by a
+ * few 1e-5 dB at most, also on large pictures.
+ */
+#define SIMD_TOLERANCE 3e-5
+
+static const char *feature_name[] = {
+    "psnr_hvs_y", "psnr_hvs_cb", "psnr_hvs_cr", "psnr_hvs",
+};
+
+static double diff(double a, double b)
+{
+    return a > b ? a - b : b - a;
+}
+
+static void fill_picture(VmafPicture *pic, unsigned seed, unsigned noise)
+{
+    const unsigned peak = (1 << pic->bpc) - 1;
+    uint32_t lcg = seed * 2654435761u + 1;
+    for (unsigned p = 0; p < 3; p++) {
+        for (unsigned i = 0; i < pic->h[p]; i++) {
+            for (unsigned j = 0; j < pic->w[p]; j++) {
+                lcg = lcg * 1664525u + 1013904223u;
+                const int base = ((i * 7 + j * 3 + (i * j) % 13) % 220) + 16;
+                int x = (base << (pic->bpc - 8)) +
+                        (int)(lcg >> 24) % (noise + 1) - noise / 2;
+                x = x < 0 ? 0 : x > (int)peak ? (int)peak : x;
+                if (pic->bpc == 8) {
+                    uint8_t *data = pic->data[p];
+                    data[i * pic->stride[p] + j] = x;
+                } else {
+                    uint16_t *data = pic->data[p];
+                    data[i * (pic->stride[p] / 2) + j] = x;
+                }
+            }
+        }
+    }
+}
+
+static char *score(uint64_t cpumask, unsigned bpc, unsigned w, unsigned h,
+                   double *scores)
+{
+    int err = 0;
+    VmafContext *vmaf;
+    VmafConfiguration cfg = { .cpumask = cpumask };
+
+    err = vmaf_init(&vmaf, cfg);
+    mu_assert("problem during vmaf_init", !err);
+    err = vmaf_use_feature(vmaf, "psnr_hvs", NULL);
+    mu_assert("problem during vmaf_use_feature", !err);
+
+    VmafPicture ref, dist;
+    err = vmaf_picture_alloc(&ref, VMAF_PIX_FMT_YUV420P, bpc, w, h);
+    err |= vmaf_picture_alloc(&dist, VMAF_PIX_FMT_YUV420P, bpc, w, h);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    fill_picture(&ref, 1, 0);
+    fill_picture(&dist, 2, 24 << (bpc - 8));
+    err = vmaf_read_pictures(vmaf, &ref, &dist, 0);
+    mu_assert("problem during vmaf_read_pictures", !err);
+    err = vmaf_read_pictures(vmaf, NULL, NULL, 0);
+    mu_assert("problem flushing context", !err);
+
+    for (unsigned i = 0; i < 4; i++) {
+        err = vmaf_feature_score_at_index(vmaf, feature_name[i], &scores[i], 0);
+        mu_assert("problem during vmaf_feature_score_at_index", !err);
+    }
+    err = vmaf_close(vmaf);
+    mu_assert("problem during vmaf_close", !err);
+
+    return NULL;
+}
+
+static char *test_psnr_hvs_simd_matches_c()
+{
+    /*
+     * 8, 10 and 12-bit, sizes which leave partial blocks at the borders, and
+     * 1080p, where the sum over many blocks amplifies a different order
+     */
+    const struct {
+        unsigned bpc, w, h;
+    } size[] = {
+        { 8, 176, 144 }, { 8, 83, 61 }, { 10, 176, 144 }, { 12, 96, 72 },
+        { 8, 1920, 1080 },
+    };
+    const uint64_t cpumask[] = { 0, 16 };
+
+    for (unsigned i = 0; i < sizeof(size) / sizeof(size[0]); i++) {
+        double c[4];
+        char *msg = score(~0ull, size[i].bpc, size[i].w, size[i].h, c);
+        if (msg) return msg;
+        for (unsigned j = 0; j < sizeof(cpumask) / sizeof(cpumask[0]); j++) {
+            double simd[4];
+            msg = score(cpumask[j], size[i].bpc, size[i].w, size[i].h, simd);
+            if (msg) return msg;
+            for (unsigned k = 0; k < 4; k++) {
+                mu_assert("simd psnr_hvs should match the c implementation",
+                          diff(simd[k], c[k]) < SIMD_TOLERANCE);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_psnr_hvs_simd_matches_c);
+    return NULL;
+}
@@ -174,7 +174,7 @@ static char *test_ring_buffer_threaded()
 
     VmafThreadPool *thread_pool;
     const unsigned n_threads = 4;
-    err = vmaf_thread_pool_create(&thread_pool, n_threads);
+    err = vmaf_thread_pool_create(&thread_pool, n_threads, NULL);
     mu_assert("problem during vmaf_thread_pool_init", !err);
 
     const unsigned n = n_threads * 8;
@@ -0,0 +1,177 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "test.h"
+#include "libvmaf/libvmaf.h"
+
+/* agreement with float_ssim, which filters in float at full precision */
+#define FLOAT_TOLERANCE 2e-4
+
+static double diff(double a, double b)
+{
+    return a > b ? a - b : b - a;
+}
+
+/* Smooth gradients plus per-pixel noise, distorted by a stronger noise. */
+static void fill_picture(VmafPicture *pic, unsigned seed, unsigned noise)
+{
+    const unsigned peak = (1 << pic->bpc) - 1;
+    uint32_t lcg = seed * 2654435761u + 1;
+    for (unsigned p = 0; p < 3; p++) {
+        for (unsigned i = 0; i < pic->h[p]; i++) {
+            for (unsigned j = 0; j < pic->w[p]; j++) {
+                lcg = lcg * 1664525u + 1013904223u;
+                const int base = ((i * 3 + j * 5) % 200) + 28;
+                int x = (base << (pic->bpc - 8)) +
+                        (int)(lcg >> 24) % (noise + 1) - noise / 2;
+                x = x < 0 ? 0 : x > (int)peak ? (int)peak : x;
+                if (pic->bpc == 8) {
+                    uint8_t *data = pic->data[p];
+                    data[i * pic->stride[p] + j] = x;
+                } else {
+                    uint16_t *data = pic->data[p];
+                    data[i * (pic->stride[p] / 2) + j] = x;
+                }
+            }
+        }
+    }
+}
+
+static char *score(uint64_t cpumask, unsigned bpc, unsigned w, unsigned h,
+                   unsigned noise, double *ssim, double *float_ssim)
+{
+    int err = 0;
+    VmafContext *vmaf;
+    VmafConfiguration cfg = { .cpumask = cpumask };
+
+    err = vmaf_init(&vmaf, cfg);
+    mu_assert("problem during vmaf_init", !err);
+    err = vmaf_use_feature(vmaf, "ssim", NULL);
+    err |= vmaf_use_feature(vmaf, "float_ssim", NULL);
+    mu_assert("problem during vmaf_use_feature", !err);
+
+    VmafPicture ref, dist;
+    err = vmaf_picture_alloc(&ref, VMAF_PIX_FMT_YUV420P, bpc, w, h);
+    err |= vmaf_picture_alloc(&dist, VMAF_PIX_FMT_YUV420P, bpc, w, h);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    fill_picture(&ref, 1, 4 << (bpc - 8));
+    fill_picture(&dist, 2, noise << (bpc - 8));
+    err = vmaf_read_pictures(vmaf, &ref, &dist, 0);
+    mu_assert("problem during vmaf_read_pictures", !err);
+    err = vmaf_read_pictures(vmaf, NULL, NULL, 0);
+    mu_assert("problem flushing context", !err);
+
+    err = vmaf_feature_score_at_index(vmaf, "ssim", ssim, 0);
+    err |= vmaf_feature_score_at_index(vmaf, "float_ssim", float_ssim, 0);
+    mu_assert("problem during vmaf_feature_score_at_index", !err);
+    err = vmaf_close(vmaf);
+    mu_assert("problem during vmaf_close", !err);
+
+    return NULL;
+}
+
+static char *test_ssim_matches_float_ssim()
+{
+    /* 8 and 10-bit, odd sizes, and 640x480 which both downscale by 2 */
+    const struct {
+        unsigned bpc, w, h;
+    } size[] = {
+        { 8, 176, 144 }, { 10, 176, 144 }, { 8, 67, 35 }, { 10, 640, 480 },
+    };
+
+    for (unsigned i = 0; i < sizeof(size) / sizeof(size[0]); i++) {
+        double prev = 1.;
+        for (unsigned noise = 0; noise <= 64; noise += 32) {
+            double ssim, float_ssim;
+            char *msg = score(0, size[i].bpc, size[i].w, size[i].h, noise,
+                              &ssim, &float_ssim);
+            if (msg) return msg;
+            mu_assert("ssim should stay within tolerance of float_ssim",
+                      diff(ssim, float_ssim) < FLOAT_TOLERANCE);
+            mu_assert("stronger distortion should lower ssim", ssim < prev);
+            prev = ssim;
+        }
+    }
+
+    return NULL;
+}
+
+static char *test_ssim_simd_matches_c()
+{
+    /*
+     * The moments are integers and the per-pixel math is done in the same
+     * order everywhere, so only the final summation order may differ.
+     */
+    const uint64_t cpumask[] = { 0, 16, ~0ull };
+    const unsigned width[] = { 64, 83, 176 };
+
+    for (unsigned i = 0; i < sizeof(width) / sizeof(width[0]); i++) {
+        double c, float_ssim;
+        char *msg = score(cpumask[2], 8, width[i], 48, 32, &c, &float_ssim);
+        if (msg) return msg;
+        for (unsigned j = 0; j < 2; j++) {
+            double simd;
+            msg = score(cpumask[j], 8, width[i], 48, 32, &simd, &float_ssim);
+            if (msg) return msg;
+            mu_assert("simd ssim should match the c implementation",
+                      diff(simd, c) < 1e-12);
+        }
+    }
+
+    return NULL;
+}
+
+static char *test_ssim_identical_pictures()
+{
+    VmafContext *vmaf;
+    VmafConfiguration cfg = { 0 };
+    int err = vmaf_init(&vmaf, cfg);
+    mu_assert("problem during vmaf_init", !err);
+    err = vmaf_use_feature(vmaf, "ssim", NULL);
+    mu_assert("problem during vmaf_use_feature", !err);
+
+    VmafPicture ref, dist;
+    err = vmaf_picture_alloc(&ref, VMAF_PIX_FMT_YUV420P, 8, 96, 64);
+    err |= vmaf_picture_alloc(&dist, VMAF_PIX_FMT_YUV420P, 8, 96, 64);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    fill_picture(&ref, 3, 16);
+    fill_picture(&dist, 3, 16);
+    err = vmaf_read_pictures(vmaf, &ref, &dist, 0);
+    err |= vmaf_read_pictures(vmaf, NULL, NULL, 0);
+    mu_assert("problem during vmaf_read_pictures", !err);
+
+    double ssim;
+    err = vmaf_feature_score_at_index(vmaf, "ssim", &ssim, 0);
+    mu_assert("problem during vmaf_feature_score_at_index", !err);
+    mu_assert("identical pictures should score exactly 1", ssim == 1.);
+    err = vmaf_close(vmaf);
+    mu_assert("problem during vmaf_close", !err);
+
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_ssim_matches_float_ssim);
+    mu_run_test(test_ssim_simd_matches_c);
+    mu_run_test(test_ssim_identical_pictures);
+    return NULL;
+}
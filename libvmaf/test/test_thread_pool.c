@@ -16,8 +16,15 @@
  *
  */
 
+#include <errno.h>
 #include <stdint.h>
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
 #include "test.h"
 #include "thread_pool.h"
 
@@ -56,7 +63,7 @@ static char *test_thread_pool_create_enqueue_wait_and_destroy()
     VmafThreadPool *pool;
     unsigned n_threads = 8;
 
-    err = vmaf_thread_pool_create(&pool, n_threads);
+    err = vmaf_thread_pool_create(&pool, n_threads, NULL);
     mu_assert("problem during vmaf_thread_pool_init", !err);
     err = vmaf_thread_pool_enqueue(pool, fn_a, NULL, 0);
     mu_assert("problem during vmaf_thread_pool_enqueue", !err);
@@ -77,8 +84,81 @@ static char *test_thread_pool_create_enqueue_wait_and_destroy()
     return NULL;
 }
 
+#ifdef __linux__
+typedef struct Affinity {
+    cpu_set_t set;
+    int err;
+} Affinity;
+
+static void fn_affinity(void *data)
+{
+    Affinity *affinity = *(Affinity **)data;
+    affinity->err = pthread_getaffinity_np(pthread_self(),
+                                           sizeof(affinity->set),
+                                           &affinity->set);
+}
+
+static char *test_thread_pool_affinity()
+{
+    int err;
+
+    cpu_set_t allowed;
+    err = sched_getaffinity(0, sizeof(allowed), &allowed);
+    mu_assert("problem during sched_getaffinity", !err);
+    int cpu = -1;
+    for (int i = CPU_SETSIZE - 1; i >= 0; i--)
+        if (CPU_ISSET(i, &allowed)) cpu = i;
+    mu_assert("no cpu available", cpu >= 0);
+
+    char spec[16];
+    snprintf(spec, sizeof(spec), "%d", cpu);
+
+    VmafThreadPool *pool;
+    const unsigned n_threads = 2;
+    err = vmaf_thread_pool_create(&pool, n_threads, spec);
+    mu_assert("problem during vmaf_thread_pool_create", !err);
+
+    Affinity affinity[4];
+    for (unsigned i = 0; i < 4; i++) {
+        Affinity *a = &affinity[i];
+        a->err = -1;
+        err = vmaf_thread_pool_enqueue(pool, fn_affinity, &a, sizeof(a));
+        mu_assert("problem during vmaf_thread_pool_enqueue", !err);
+    }
+    err = vmaf_thread_pool_wait(pool);
+    mu_assert("problem during vmaf_thread_pool_wait", !err);
+    for (unsigned i = 0; i < 4; i++) {
+        mu_assert("problem during pthread_getaffinity_np", !affinity[i].err);
+        mu_assert("worker should be pinned to exactly one cpu",
+                  CPU_COUNT(&affinity[i].set) == 1);
+        mu_assert("worker should be pinned to the requested cpu",
+                  CPU_ISSET(cpu, &affinity[i].set));
+    }
+    err = vmaf_thread_pool_destroy(pool);
+    mu_assert("problem during vmaf_thread_pool_destroy", !err);
+
+    if (!access("/sys/devices/system/node/node0/cpulist", R_OK)) {
+        err = vmaf_thread_pool_create(&pool, n_threads, "node:0");
+        mu_assert("problem pinning to numa node 0", !err);
+        err = vmaf_thread_pool_destroy(pool);
+        mu_assert("problem during vmaf_thread_pool_destroy", !err);
+    }
+
+    const char *invalid[] = { "", "x", "3-1", "0,", "0-", "node:", "node:x" };
+    for (unsigned i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        err = vmaf_thread_pool_create(&pool, n_threads, invalid[i]);
+        mu_assert("malformed affinity should be rejected", err == -EINVAL);
+    }
+
+    return NULL;
+}
+#endif
+
 char *run_tests()
 {
     mu_run_test(test_thread_pool_create_enqueue_wait_and_destroy);
+#ifdef __linux__
+    mu_run_test(test_thread_pool_affinity);
+#endif
     return NULL;
 }
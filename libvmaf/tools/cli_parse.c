@@ -1,5 +1,7 @@
 #include <assert.h>
+#include <errno.h>
 #include <getopt.h>
+#include <limits.h>
 #include <stdarg.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -20,8 +22,11 @@ enum {
     ARG_OUTPUT_CSV,
     ARG_OUTPUT_SUB,
     ARG_THREADS,
+    ARG_THREAD_AFFINITY,
     ARG_FEATURE,
     ARG_SUBSAMPLE,
+    ARG_SUBSAMPLE_THRESHOLD,
+    ARG_POOL,
     ARG_CPUMASK,
     ARG_GPUMASK,
     ARG_AOM_CTC,
@@ -29,6 +34,12 @@ enum {
     ARG_FRAME_CNT,
     ARG_FRAME_SKIP_REF,
     ARG_FRAME_SKIP_DIST,
+    ARG_FRAME_RANGE,
+    ARG_WARMUP,
+    ARG_STATE,
+    ARG_PROGRESS_FD,
+    ARG_PROGRESS_INTERVAL,
+    ARG_SERVE,
 };
 
 static const struct option long_opts[] = {
@@ -45,8 +56,11 @@ static const struct option long_opts[] = {
     { "csv",              0, NULL, ARG_OUTPUT_CSV },
     { "sub",              0, NULL, ARG_OUTPUT_SUB },
     { "threads",          1, NULL, ARG_THREADS },
+    { "thread_affinity",  1, NULL, ARG_THREAD_AFFINITY },
     { "feature",          1, NULL, ARG_FEATURE },
     { "subsample",        1, NULL, ARG_SUBSAMPLE },
+    { "subsample_threshold", 1, NULL, ARG_SUBSAMPLE_THRESHOLD },
+    { "pool",             1, NULL, ARG_POOL },
     { "cpumask",          1, NULL, ARG_CPUMASK },
     { "gpumask",          1, NULL, ARG_GPUMASK },
     { "aom_ctc",          1, NULL, ARG_AOM_CTC },
@@ -54,24 +68,39 @@ static const struct option long_opts[] = {
     { "frame_cnt",        1, NULL, ARG_FRAME_CNT },
     { "frame_skip_ref",   1, NULL, ARG_FRAME_SKIP_REF },
     { "frame_skip_dist",  1, NULL, ARG_FRAME_SKIP_DIST },
+    { "frame_range",      1, NULL, ARG_FRAME_RANGE },
+    { "warmup",           1, NULL, ARG_WARMUP },
+    { "state",            1, NULL, ARG_STATE },
+    { "progress_fd",      1, NULL, ARG_PROGRESS_FD },
+    { "progress_interval", 1, NULL, ARG_PROGRESS_INTERVAL },
+    { "serve",            1, NULL, ARG_SERVE },
     { "no_prediction",    0, NULL, 'n' },
     { "version",          0, NULL, 'v' },
     { "quiet",            0, NULL, 'q' },
     { NULL,               0, NULL, 0 },
 };
 
-static void usage(const char *const app, const char *const reason, ...) {
+// Problems are written to log and return -EINVAL when parsing a `--serve`
+// job; without a log the usage is printed and the process exits.
+static int usage(const char *const app, FILE *const log,
+                 const char *const reason, ...) {
     if (reason) {
+        FILE *const out = log ? log : stderr;
         va_list args;
         va_start(args, reason);
-        vfprintf(stderr, reason, args);
+        vfprintf(out, reason, args);
         va_end(args);
-        fprintf(stderr, "\n\n");
+        fprintf(out, "\n");
     }
-    fprintf(stderr, "Usage: %s [options]\n\n", app);
+    if (log) return -EINVAL;
+    if (reason) fprintf(stderr, "\n");
+    fprintf(stderr, "Usage: %s [options]\n", app);
+    fprintf(stderr, "       %s merge [options] $state...\n", app);
+    fprintf(stderr, "       %s client [options] $socket\n\n", app);
     fprintf(stderr, "Supported options:\n"
             " --reference/-r $path:        path to reference .y4m or .yuv\n"
-            " --distorted/-d $path:        path to distorted .y4m or .yuv\n"
+            " --distorted/-d $path:        path to distorted .y4m or .yuv, repeat\n"
+            "                              to score several against one reference\n"
             " --width/-w $unsigned:        width\n"
             " --height/-h $unsigned:       height\n"
             " --pixel_format/-p: $string   pixel format (420/422/444)\n"
@@ -80,28 +109,55 @@ static void usage(const char *const app, const char *const reason, ...) {
             "                              `path=` path to model file\n"
             "                              `version=` built-in model version\n"
             "                              `name=` name used in log (optional)\n"
-            " --output/-o $path:           output file\n"
+            " --output/-o $path:           output file, one per distorted input\n"
             " --xml:                       write output file as XML (default)\n"
             " --json:                      write output file as JSON\n"
             " --csv:                       write output file as CSV\n"
             " --sub:                       write output file as subtitle\n"
             " --threads $unsigned:         number of threads to use\n"
+            " --thread_affinity $cpus:     pin threads to cores (\"0-7,16-23\") or to\n"
+            "                              NUMA nodes (\"node:1\"), Linux only\n"
             " --feature $string:           additional feature\n"
             " --cpumask: $bitmask          restrict permitted CPU instruction sets\n"
             " --gpumask: $bitmask          restrict permitted GPU operations\n"
             " --frame_cnt $unsigned:       maximum number of frames to process\n"
             " --frame_skip_ref $unsigned:  skip the first N frames in reference\n"
             " --frame_skip_dist $unsigned: skip the first N frames in distorted\n"
+            " --frame_range $start:$end:   only score frames [start, end),\n"
+            "                              seeking directly to the start frame\n"
+            " --warmup $unsigned:          frames read before --frame_range to warm\n"
+            "                              up temporal features (default 1)\n"
+            " --state $path:               write mergeable partial results\n"
+            " --progress_fd $unsigned:     write JSON progress lines to this file\n"
+            "                              descriptor\n"
+            " --progress_interval $ms:     period of --progress_fd lines (default 1000)\n"
+            " --serve $socket:             keep models and threads resident and score\n"
+            "                              the jobs of `client` on this UNIX socket\n"
             " --subsample: $unsigned       compute scores only every N frames\n"
+            " --subsample_threshold $float:\n"
+            "                              repeat the scores of the last scored frame\n"
+            "                              while luma changes by at most this mean\n"
+            "                              absolute difference (8-bit scale)\n"
+            " --pool $method:              also pool every feature in the output with\n"
+            "                              p$percentile, e.g. p5, or min_window$frames,\n"
+            "                              the lowest mean over that many frames\n"
             " --quiet/-q:                  disable FPS meter when run in a TTY\n"
             " --no_prediction/-n:          no prediction, extract features only\n"
             " --version/-v:                print version and exit\n"
+            "\nmerge: combine the partial results of segments scored with\n"
+            "--frame_range and --state into a single output file.\n"
+            "Supports --output/-o, --xml, --json, --csv, --sub, --subsample\n"
+            "and --pool.\n"
+            "\nclient: score with the options above on the `--serve` daemon\n"
+            "listening on $socket. Outputs are written by the client.\n"
+            "--threads and --thread_affinity are those of the daemon.\n"
            );
     exit(1);
 }
 
-static void error(const char *const app, const char *const optarg,
-                  const int option, const char *const shouldbe)
+static int error(const char *const app, FILE *const log,
+                 const char *const optarg, const int option,
+                 const char *const shouldbe)
 {
     char optname[256];
     int n;
@@ -116,45 +172,109 @@ static void error(const char *const app, const char *const optarg,
         sprintf(optname, "--%s", long_opts[n].name);
     }
 
-    usage(app, "Invalid argument \"%s\" for option %s; should be %s",
-          optarg, optname, shouldbe);
+    return usage(app, log, "Invalid argument \"%s\" for option %s; should be %s",
+                 optarg, optname, shouldbe);
 }
 
-static unsigned parse_unsigned(const char *const optarg, const int option,
-                               const char *const app)
+static int parse_unsigned(const char *const optarg, const int option,
+                          const char *const app, FILE *const log,
+                          unsigned *const res)
 {
     char *end;
-    const unsigned res = (unsigned) strtoul(optarg, &end, 0);
-    if (*end || end == optarg) error(app, optarg, option, "an integer");
-    return res;
+    *res = (unsigned) strtoul(optarg, &end, 0);
+    if (*end || end == optarg)
+        return error(app, log, optarg, option, "an integer");
+    return 0;
 }
 
-static unsigned parse_bitdepth(const char *const optarg, const int option,
-                               const char *const app)
+static int parse_threshold(const char *const optarg, const int option,
+                           const char *const app, FILE *const log,
+                           float *const res)
 {
-    unsigned bitdepth = parse_unsigned(optarg, option, app);
-    if (!((bitdepth == 8) || (bitdepth == 10) || (bitdepth == 12) || (bitdepth == 16)))
-        error(app, optarg, option, "a valid bitdepth (8/10/12/16)");
-    return bitdepth;
+    char *end;
+    *res = strtof(optarg, &end);
+    if (*end || end == optarg || !(*res >= 0.f))
+        return error(app, log, optarg, option, "a non-negative number");
+    return 0;
+}
+
+static int parse_pool(const char *const optarg, const int option,
+                      const char *const app, FILE *const log,
+                      VmafPoolingConfiguration *const pool_cfg)
+{
+    VmafPoolingConfiguration cfg = { 0 };
+    const char *param = NULL;
+    if (!strncmp(optarg, "p", 1)) {
+        cfg.method = VMAF_POOL_METHOD_PERCENTILE;
+        param = optarg + 1;
+    } else if (!strncmp(optarg, "min_window", 10)) {
+        cfg.method = VMAF_POOL_METHOD_WINDOW_MIN;
+        param = optarg + 10;
+    }
+
+    char *end = NULL;
+    if (param) cfg.param = strtod(param, &end);
+    const bool valid = param && end != param && !*end &&
+        (cfg.method == VMAF_POOL_METHOD_PERCENTILE ?
+            cfg.param >= 0. && cfg.param <= 100. :
+            cfg.param >= 1. && cfg.param <= UINT_MAX &&
+            cfg.param == (unsigned) cfg.param);
+    if (!valid) {
+        return error(app, log, optarg, option,
+                     "p$percentile (0-100) or min_window$frames");
+    }
+    *pool_cfg = cfg;
+    return 0;
+}
+
+static int parse_bitdepth(const char *const optarg, const int option,
+                          const char *const app, FILE *const log,
+                          unsigned *const bitdepth)
+{
+    int err = parse_unsigned(optarg, option, app, log, bitdepth);
+    if (err) return err;
+    if (!((*bitdepth == 8) || (*bitdepth == 10) || (*bitdepth == 12) || (*bitdepth == 16)))
+        return error(app, log, optarg, option, "a valid bitdepth (8/10/12/16)");
+    return 0;
 }
 
-static enum VmafPixelFormat parse_pix_fmt(const char *const optarg,
-                                          const int option,
-                                          const char *const app)
+static int parse_pix_fmt(const char *const optarg, const int option,
+                         const char *const app, FILE *const log,
+                         enum VmafPixelFormat *const pix_fmt)
 {
-    enum VmafPixelFormat pix_fmt = VMAF_PIX_FMT_UNKNOWN;
+    *pix_fmt = VMAF_PIX_FMT_UNKNOWN;
 
     if (!strcmp(optarg, "420"))
-        pix_fmt = VMAF_PIX_FMT_YUV420P;
+        *pix_fmt = VMAF_PIX_FMT_YUV420P;
     if (!strcmp(optarg, "422"))
-        pix_fmt = VMAF_PIX_FMT_YUV422P;
+        *pix_fmt = VMAF_PIX_FMT_YUV422P;
     if (!strcmp(optarg, "444"))
-        pix_fmt = VMAF_PIX_FMT_YUV444P;
+        *pix_fmt = VMAF_PIX_FMT_YUV444P;
 
-    if (!pix_fmt) error(app, optarg, option, "a valid pixel format "
-                                             "(420/422/444)");
+    if (!*pix_fmt) return error(app, log, optarg, option, "a valid pixel format "
+                                                          "(420/422/444)");
+
+    return 0;
+}
 
-    return pix_fmt;
+static int parse_frame_range(const char *const optarg, const int option,
+                             const char *const app, FILE *const log,
+                             unsigned *start, unsigned *end)
+{
+    char *sep;
+    *start = (unsigned) strtoul(optarg, &sep, 0);
+    if (sep == optarg || *sep != ':')
+        return error(app, log, optarg, option, "a frame range ($start:$end)");
+
+    const char *const end_str = sep + 1;
+    char *tail;
+    *end = (unsigned) strtoul(end_str, &tail, 0);
+    if (*tail || tail == end_str)
+        return error(app, log, optarg, option, "a frame range ($start:$end)");
+    if (*end <= *start)
+        return error(app, log, optarg, option,
+                     "a non-empty frame range, start < end");
+    return 0;
 }
 
 #ifndef HAVE_STRSEP
@@ -170,13 +290,13 @@ static char *strsep(char **sp, char *sep)
 }
 #endif
 
-static CLIModelConfig parse_model_config(const char *const optarg,
-                                         const char *const app)
+static int parse_model_config(const char *const optarg, const char *const app,
+                              FILE *const log, CLIModelConfig *const cfg)
 {
     const size_t optarg_sz = strnlen(optarg, 1024);
     char *optarg_copy = malloc(optarg_sz + 1);
     if (!optarg_copy)
-        usage(app, "error while parsing model option: %s", optarg);
+        return usage(app, log, "error while parsing model option: %s", optarg);
     memset(optarg_copy, 0, optarg_sz + 1);
     strncpy(optarg_copy, optarg, optarg_sz);
 
@@ -190,6 +310,7 @@ static CLIModelConfig parse_model_config(const char *const optarg,
         .buf = optarg_copy,
     };
 
+    int err = 0;
     char *key_val;
     while ((key_val = strsep(&optarg_copy, ":")) != NULL) {
         char *key = strsep(&key_val, "=");
@@ -200,8 +321,9 @@ static CLIModelConfig parse_model_config(const char *const optarg,
             } else if (!strcmp(key, "enable_transform")) {
                 val = "true";
             } else {
-                usage(app, "Problem parsing model, "
-                           "bad option string \"%s\".", key);
+                err = usage(app, log, "Problem parsing model, "
+                                      "bad option string \"%s\".", key);
+                break;
             }
         }
 
@@ -221,26 +343,36 @@ static CLIModelConfig parse_model_config(const char *const optarg,
             char *name = strsep(&key, ".");
             model_cfg.feature_overload[model_cfg.overload_cnt].name = name;
             char *opt = strsep(&key, ".");
-            int err =
+            err =
                 vmaf_feature_dictionary_set(
                     &model_cfg.feature_overload[model_cfg.overload_cnt].opts_dict,
                     opt, val);
-            if (err) usage(app, "Problem parsing model: \"%s\"\n", name);
+            if (err) {
+                err = usage(app, log, "Problem parsing model: \"%s\"\n", name);
+                break;
+            }
 
             model_cfg.overload_cnt++;
         }
     }
 
-    return model_cfg;
+    if (err) {
+        for (unsigned i = 0; i < model_cfg.overload_cnt; i++)
+            vmaf_feature_dictionary_free(&model_cfg.feature_overload[i].opts_dict);
+        free(model_cfg.buf);
+        return err;
+    }
+    *cfg = model_cfg;
+    return 0;
 }
 
-static CLIFeatureConfig parse_feature_config(const char *const optarg,
-                                             const char *const app)
+static int parse_feature_config(const char *const optarg, const char *const app,
+                                FILE *const log, CLIFeatureConfig *const cfg)
 {
     const size_t optarg_sz = strnlen(optarg, 1024);
     char *optarg_copy = malloc(optarg_sz + 1);
     if (!optarg_copy)
-        usage(app, "error while parsing feature option: %s", optarg);
+        return usage(app, log, "error while parsing feature option: %s", optarg);
     memset(optarg_copy, 0, optarg_sz + 1);
     strncpy(optarg_copy, optarg, optarg_sz);
     void *buf = optarg_copy;
@@ -251,23 +383,45 @@ static CLIFeatureConfig parse_feature_config(const char *const optarg,
         .buf = buf,
     };
 
+    int err = 0;
     char *key_val;
     while ((key_val = strsep(&optarg_copy, ":")) != NULL) {
         const char *key = strsep(&key_val, "=");
         const char *val = strsep(&key_val, "=");
         if (!val) {
-            usage(app, "Problem parsing feature \"%s\","
-                       " bad option string \"%s\".\n", feature_cfg.name, key);
+            err = usage(app, log, "Problem parsing feature \"%s\","
+                                  " bad option string \"%s\".\n",
+                                  feature_cfg.name, key);
+            break;
         }
-        int err = vmaf_feature_dictionary_set(&feature_cfg.opts_dict, key, val);
-        if (err)
-            usage(app, "Problem parsing feature \"%s\"\n", optarg);
+        err = vmaf_feature_dictionary_set(&feature_cfg.opts_dict, key, val);
+        if (err) {
+            err = usage(app, log, "Problem parsing feature \"%s\"\n", optarg);
+            break;
+        }
+    }
+
+    if (err) {
+        vmaf_feature_dictionary_free(&feature_cfg.opts_dict);
+        free(buf);
+        return err;
     }
+    *cfg = feature_cfg;
+    return 0;
+}
 
-    return feature_cfg;
+static int add_feature(CLISettings *settings, const char *const optarg,
+                       const char *const app, FILE *const log)
+{
+    int err = parse_feature_config(optarg, app, log,
+                              &settings->feature_cfg[settings->feature_cnt]);
+    if (err) return err;
+    settings->feature_cnt++;
+    return 0;
 }
 
-static void aom_ctc_v1_0(CLISettings *settings, const char *const app)
+static int aom_ctc_v1_0(CLISettings *settings, const char *const app,
+                        FILE *const log)
 {
     CLIModelConfig cfg = {
         .version = "vmaf_v0.6.1",
@@ -281,91 +435,76 @@ static void aom_ctc_v1_0(CLISettings *settings, const char *const app)
     };
     settings->model_config[settings->model_cnt++] = cfg_neg;
 
-    settings->feature_cfg[settings->feature_cnt++] =
-        parse_feature_config("psnr=reduced_hbd_peak=true:"
-                             "enable_apsnr=true:min_sse=0.5", app);
-
-    settings->feature_cfg[settings->feature_cnt++] =
-        parse_feature_config("ciede", app);
-
-    settings->feature_cfg[settings->feature_cnt++] =
-        parse_feature_config("float_ssim=enable_db=true:clip_db=true", app);
-
-    settings->feature_cfg[settings->feature_cnt++] =
-        parse_feature_config("float_ms_ssim=enable_db=true:clip_db=true", app);
-
-    settings->feature_cfg[settings->feature_cnt++] =
-        parse_feature_config("psnr_hvs", app);
+    int err = 0;
+    err |= add_feature(settings, "psnr=reduced_hbd_peak=true:"
+                       "enable_apsnr=true:min_sse=0.5", app, log);
+    err |= add_feature(settings, "ciede", app, log);
+    err |= add_feature(settings, "float_ssim=enable_db=true:clip_db=true",
+                       app, log);
+    err |= add_feature(settings, "float_ms_ssim=enable_db=true:clip_db=true",
+                       app, log);
+    err |= add_feature(settings, "psnr_hvs", app, log);
+    return err ? -EINVAL : 0;
 }
 
-static void aom_ctc_v2_0(CLISettings *settings, const char *app)
+static int aom_ctc_v2_0(CLISettings *settings, const char *app, FILE *log)
 {
-    aom_ctc_v1_0(settings, app);
+    return aom_ctc_v1_0(settings, app, log);
 }
 
-static void aom_ctc_v3_0(CLISettings *settings, const char *app)
+static int aom_ctc_v3_0(CLISettings *settings, const char *app, FILE *log)
 {
-    aom_ctc_v2_0(settings, app);
-    settings->feature_cfg[settings->feature_cnt++] =
-        parse_feature_config("cambi", app);
+    int err = aom_ctc_v2_0(settings, app, log);
+    if (err) return err;
+    return add_feature(settings, "cambi", app, log);
 }
 
-static void aom_ctc_v4_0(CLISettings *settings, const char *app)
+static int aom_ctc_v4_0(CLISettings *settings, const char *app, FILE *log)
 {
-    aom_ctc_v3_0(settings, app);
+    return aom_ctc_v3_0(settings, app, log);
 }
 
-static void aom_ctc_v5_0(CLISettings *settings, const char *app)
+static int aom_ctc_v5_0(CLISettings *settings, const char *app, FILE *log)
 {
-    aom_ctc_v4_0(settings, app);
+    return aom_ctc_v4_0(settings, app, log);
 }
 
-static void aom_ctc_v6_0(CLISettings *settings, const char *app)
+static int aom_ctc_v6_0(CLISettings *settings, const char *app, FILE *log)
 {
-    aom_ctc_v5_0(settings, app);
+    int err = aom_ctc_v5_0(settings, app, log);
     settings->common_bitdepth = true;
+    return err;
 }
 
-static void parse_aom_ctc(CLISettings *settings, const char *const optarg,
-                          const char *const app)
+static int parse_aom_ctc(CLISettings *settings, const char *const optarg,
+                         const char *const app, FILE *const log)
 {
     if (!strcmp(optarg, "proposed"))
-        usage(app, "`--aom_ctc proposed` is deprecated.");
+        return usage(app, log, "`--aom_ctc proposed` is deprecated.");
 
-    if (!strcmp(optarg, "v1.0")) {
-        aom_ctc_v1_0(settings, app);
-        return;
-    }
+    if (!strcmp(optarg, "v1.0"))
+        return aom_ctc_v1_0(settings, app, log);
 
-    if (!strcmp(optarg, "v2.0")) {
-        aom_ctc_v2_0(settings, app);
-        return;
-    }
+    if (!strcmp(optarg, "v2.0"))
+        return aom_ctc_v2_0(settings, app, log);
 
-    if (!strcmp(optarg, "v3.0")) {
-        aom_ctc_v3_0(settings, app);
-        return;
-    }
+    if (!strcmp(optarg, "v3.0"))
+        return aom_ctc_v3_0(settings, app, log);
 
-    if (!strcmp(optarg, "v4.0")) {
-        aom_ctc_v4_0(settings, app);
-        return;
-    }
+    if (!strcmp(optarg, "v4.0"))
+        return aom_ctc_v4_0(settings, app, log);
 
-    if (!strcmp(optarg, "v5.0")) {
-        aom_ctc_v5_0(settings, app);
-        return;
-    }
+    if (!strcmp(optarg, "v5.0"))
+        return aom_ctc_v5_0(settings, app, log);
 
-    if (!strcmp(optarg, "v6.0")) {
-        aom_ctc_v6_0(settings, app);
-        return;
-    }
+    if (!strcmp(optarg, "v6.0"))
+        return aom_ctc_v6_0(settings, app, log);
 
-    usage(app, "bad aom_ctc version \"%s\"", optarg);
+    return usage(app, log, "bad aom_ctc version \"%s\"", optarg);
 }
 
-static void nflx_ctc_v1_0(CLISettings *settings, const char *const app)
+static int nflx_ctc_v1_0(CLISettings *settings, const char *const app,
+                         FILE *const log)
 {
     CLIModelConfig cfg = {
         .version = "vmaf_4k_v0.6.1",
@@ -379,59 +518,81 @@ static void nflx_ctc_v1_0(CLISettings *settings, const char *const app)
     };
     settings->model_config[settings->model_cnt++] = cfg_neg;
 
-    settings->feature_cfg[settings->feature_cnt++] =
-        parse_feature_config("psnr=enable_chroma=true:enable_apsnr=true", app);
-
-    settings->feature_cfg[settings->feature_cnt++] =
-        parse_feature_config("float_ssim=enable_db=true:clip_db=true", app);
-
-    settings->feature_cfg[settings->feature_cnt++] =
-        parse_feature_config("cambi", app);
+    int err = 0;
+    err |= add_feature(settings, "psnr=enable_chroma=true:enable_apsnr=true",
+                       app, log);
+    err |= add_feature(settings, "float_ssim=enable_db=true:clip_db=true",
+                       app, log);
+    err |= add_feature(settings, "cambi", app, log);
+    return err ? -EINVAL : 0;
 }
 
-static void parse_nflx_ctc(CLISettings *settings, const char *const optarg,
-                         const char *const app)
+static int parse_nflx_ctc(CLISettings *settings, const char *const optarg,
+                          const char *const app, FILE *const log)
 {
-    if (!strcmp(optarg, "v1.0")) {
-        nflx_ctc_v1_0(settings, app);
-        return;
-    }
+    if (!strcmp(optarg, "v1.0"))
+        return nflx_ctc_v1_0(settings, app, log);
 
-    usage(app, "bad nflx_ctc version \"%s\"", optarg);
+    return usage(app, log, "bad nflx_ctc version \"%s\"", optarg);
 }
 
-void cli_parse(const int argc, char *const *const argv,
-               CLISettings *const settings)
+static int parse(const int argc, char *const *const argv,
+                 CLISettings *const settings, FILE *const log)
 {
     memset(settings, 0, sizeof(*settings));
-    int o;
-
-    while ((o = getopt_long(argc, argv, short_opts, long_opts, NULL)) >= 0) {
+    settings->warmup = 1;
+    settings->progress_fd = -1;
+    settings->progress_interval = 1000;
+    unsigned progress_fd;
+    int o, err;
+
+    // `vmaf merge ...` and `vmaf client ...` are parsed like commands of
+    // their own
+    const bool merge = argc > 1 && !strcmp(argv[1], "merge");
+    const bool client = argc > 1 && !strcmp(argv[1], "client");
+    const int cmd = merge || client;
+    settings->merge = merge;
+
+    while ((o = getopt_long(argc - cmd, argv + cmd, short_opts, long_opts,
+                            NULL)) >= 0)
+    {
         switch (o) {
         case 'r':
             settings->path_ref = optarg;
             break;
         case 'd':
-            settings->path_dist = optarg;
+            if (settings->dist_cnt == CLI_SETTINGS_STATIC_ARRAY_LEN) {
+                return usage(argv[0], log, "A maximum of %d distorted inputs is allowed",
+                             CLI_SETTINGS_STATIC_ARRAY_LEN);
+            }
+            settings->path_dist[settings->dist_cnt++] = optarg;
             break;
         case 'w':
-            settings->width = parse_unsigned(optarg, 'w', argv[0]);
+            err = parse_unsigned(optarg, 'w', argv[0], log, &settings->width);
+            if (err) return err;
             settings->use_yuv = true;
             break;
         case 'h':
-            settings->height = parse_unsigned(optarg, 'h', argv[0]);
+            err = parse_unsigned(optarg, 'h', argv[0], log, &settings->height);
+            if (err) return err;
             settings->use_yuv = true;
             break;
         case 'p':
-            settings->pix_fmt = parse_pix_fmt(optarg, 'p', argv[0]);
+            err = parse_pix_fmt(optarg, 'p', argv[0], log, &settings->pix_fmt);
+            if (err) return err;
             settings->use_yuv = true;
             break;
         case 'b':
-            settings->bitdepth = parse_bitdepth(optarg, 'b', argv[0]);
+            err = parse_bitdepth(optarg, 'b', argv[0], log, &settings->bitdepth);
+            if (err) return err;
             settings->use_yuv = true;
             break;
         case 'o':
-            settings->output_path = optarg;
+            if (settings->output_cnt == CLI_SETTINGS_STATIC_ARRAY_LEN) {
+                return usage(argv[0], log, "A maximum of %d outputs is allowed",
+                             CLI_SETTINGS_STATIC_ARRAY_LEN);
+            }
+            settings->output_path[settings->output_cnt++] = optarg;
             break;
         case ARG_OUTPUT_XML:
             settings->output_fmt = VMAF_OUTPUT_FORMAT_XML;
@@ -447,47 +608,107 @@ void cli_parse(const int argc, char *const *const argv,
             break;
         case 'm':
             if (settings->model_cnt == CLI_SETTINGS_STATIC_ARRAY_LEN) {
-                usage(argv[0], "A maximum of %d models are supported\n",
-                      CLI_SETTINGS_STATIC_ARRAY_LEN);
+                return usage(argv[0], log, "A maximum of %d models are supported\n",
+                             CLI_SETTINGS_STATIC_ARRAY_LEN);
             }
-            settings->model_config[settings->model_cnt++] =
-                parse_model_config(optarg, argv[0]);
+            err = parse_model_config(optarg, argv[0], log,
+                    &settings->model_config[settings->model_cnt]);
+            if (err) return err;
+            settings->model_cnt++;
             break;
         case ARG_FEATURE:
             if (settings->feature_cnt == CLI_SETTINGS_STATIC_ARRAY_LEN) {
-                usage(argv[0], "A maximum of %d features is supported\n",
-                      CLI_SETTINGS_STATIC_ARRAY_LEN);
+                return usage(argv[0], log, "A maximum of %d features is supported\n",
+                             CLI_SETTINGS_STATIC_ARRAY_LEN);
             }
-            settings->feature_cfg[settings->feature_cnt++] =
-                parse_feature_config(optarg, argv[0]);
+            err = add_feature(settings, optarg, argv[0], log);
+            if (err) return err;
             break;
         case ARG_THREADS:
-            settings->thread_cnt = parse_unsigned(optarg, 't', argv[0]);
+            err = parse_unsigned(optarg, 't', argv[0], log, &settings->thread_cnt);
+            if (err) return err;
+            break;
+        case ARG_THREAD_AFFINITY:
+            settings->thread_affinity = optarg;
             break;
         case ARG_SUBSAMPLE:
-            settings->subsample = parse_unsigned(optarg, 's', argv[0]);
+            err = parse_unsigned(optarg, 's', argv[0], log, &settings->subsample);
+            if (err) return err;
+            break;
+        case ARG_POOL:
+            if (settings->pool_cnt == CLI_SETTINGS_STATIC_ARRAY_LEN) {
+                return usage(argv[0], log, "A maximum of %d pooling methods is allowed",
+                             CLI_SETTINGS_STATIC_ARRAY_LEN);
+            }
+            err = parse_pool(optarg, ARG_POOL, argv[0], log,
+                             &settings->pool_cfg[settings->pool_cnt]);
+            if (err) return err;
+            settings->pool_cnt++;
+            break;
+        case ARG_SUBSAMPLE_THRESHOLD:
+            err = parse_threshold(optarg, ARG_SUBSAMPLE_THRESHOLD, argv[0], log,
+                                  &settings->subsample_threshold);
+            if (err) return err;
             break;
         case ARG_CPUMASK:
-            settings->cpumask = parse_unsigned(optarg, 'c', argv[0]);
+            err = parse_unsigned(optarg, 'c', argv[0], log, &settings->cpumask);
+            if (err) return err;
             break;
         case ARG_GPUMASK:
-            settings->gpumask = parse_unsigned(optarg, ARG_GPUMASK, argv[0]);
+            err = parse_unsigned(optarg, ARG_GPUMASK, argv[0], log,
+                                 &settings->gpumask);
+            if (err) return err;
             break;
         case ARG_AOM_CTC:
-            parse_aom_ctc(settings, optarg, argv[0]);
+            err = parse_aom_ctc(settings, optarg, argv[0], log);
+            if (err) return err;
             break;
         case ARG_NFLX_CTC:
-            parse_nflx_ctc(settings, optarg, argv[0]);
+            err = parse_nflx_ctc(settings, optarg, argv[0], log);
+            if (err) return err;
             break;
         case ARG_FRAME_CNT:
-            settings->frame_cnt =
-                parse_unsigned(optarg, ARG_FRAME_CNT, argv[0]);
+            err = parse_unsigned(optarg, ARG_FRAME_CNT, argv[0], log,
+                                 &settings->frame_cnt);
+            if (err) return err;
             break;
         case ARG_FRAME_SKIP_REF:
-            settings->frame_skip_ref = parse_unsigned(optarg, ARG_FRAME_SKIP_REF, argv[0]);
+            err = parse_unsigned(optarg, ARG_FRAME_SKIP_REF, argv[0], log,
+                                 &settings->frame_skip_ref);
+            if (err) return err;
             break;
         case ARG_FRAME_SKIP_DIST:
-            settings->frame_skip_dist = parse_unsigned(optarg, ARG_FRAME_SKIP_DIST, argv[0]);
+            err = parse_unsigned(optarg, ARG_FRAME_SKIP_DIST, argv[0], log,
+                                 &settings->frame_skip_dist);
+            if (err) return err;
+            break;
+        case ARG_FRAME_RANGE:
+            err = parse_frame_range(optarg, ARG_FRAME_RANGE, argv[0], log,
+                                    &settings->frame_range.start,
+                                    &settings->frame_range.end);
+            if (err) return err;
+            break;
+        case ARG_WARMUP:
+            err = parse_unsigned(optarg, ARG_WARMUP, argv[0], log,
+                                 &settings->warmup);
+            if (err) return err;
+            break;
+        case ARG_STATE:
+            settings->state_path = optarg;
+            break;
+        case ARG_PROGRESS_FD:
+            err = parse_unsigned(optarg, ARG_PROGRESS_FD, argv[0], log,
+                                 &progress_fd);
+            if (err) return err;
+            settings->progress_fd = progress_fd;
+            break;
+        case ARG_PROGRESS_INTERVAL:
+            err = parse_unsigned(optarg, ARG_PROGRESS_INTERVAL, argv[0], log,
+                                 &settings->progress_interval);
+            if (err) return err;
+            break;
+        case ARG_SERVE:
+            settings->serve_path = optarg;
             break;
         case 'n':
             settings->no_prediction = true;
@@ -496,6 +717,7 @@ void cli_parse(const int argc, char *const *const argv,
             settings->quiet = true;
             break;
         case 'v':
+            if (log) return usage(argv[0], log, "--version is not a job");
             fprintf(stderr, "%s\n", vmaf_version());
             exit(0);
         default:
@@ -505,18 +727,48 @@ void cli_parse(const int argc, char *const *const argv,
 
     if (!settings->output_fmt)
         settings->output_fmt = VMAF_OUTPUT_FORMAT_XML;
+
+    if (settings->merge) {
+        settings->merge_path = argv + cmd + optind;
+        settings->merge_cnt = argc - cmd - optind;
+        if (!settings->merge_cnt)
+            return usage(argv[0], log, "merge requires at least one partial results file");
+        if (settings->output_cnt != 1)
+            return usage(argv[0], log, "merge requires one output file (-o/--output)");
+        return 0;
+    }
+    if (client) {
+        if (argc - cmd - optind != 1)
+            return usage(argv[0], log, "client requires one $socket of a --serve daemon");
+        settings->client_path = argv[cmd + optind];
+        if (settings->serve_path)
+            return usage(argv[0], log, "client and --serve are mutually exclusive");
+        if (settings->progress_fd >= 0)
+            return usage(argv[0], log, "client does not support --progress_fd");
+    }
+    if (settings->serve_path) {
+        if (settings->thread_affinity && !settings->thread_cnt)
+            return usage(argv[0], log, "--thread_affinity requires --threads");
+        return 0;
+    }
     if (!settings->path_ref)
-        usage(argv[0], "Reference .y4m or .yuv (-r/--reference) is required");
-    if (!settings->path_dist)
-        usage(argv[0], "Distorted .y4m or .yuv (-d/--distorted) is required");
+        return usage(argv[0], log, "Reference .y4m or .yuv (-r/--reference) is required");
+    if (!settings->dist_cnt)
+        return usage(argv[0], log, "Distorted .y4m or .yuv (-d/--distorted) is required");
+    if (settings->output_cnt && settings->output_cnt != settings->dist_cnt)
+        return usage(argv[0], log, "One output (-o/--output) per distorted input is required");
+    if (settings->state_path && settings->dist_cnt > 1)
+        return usage(argv[0], log, "--state supports a single distorted input");
+    if (settings->thread_affinity && !settings->thread_cnt)
+        return usage(argv[0], log, "--thread_affinity requires --threads");
     if (settings->use_yuv && !(settings->width && settings->height &&
         settings->pix_fmt && settings->bitdepth))
     {
-        usage(argv[0], "The following options are required for .yuv input:\n"
-                       "  --width/-w\n"
-                       "  --height/-h\n"
-                       "  --pixel_format/-p\n"
-                       "  --bitdepth/-b\n");
+        return usage(argv[0], log, "The following options are required for .yuv input:\n"
+                     "  --width/-w\n"
+                     "  --height/-h\n"
+                     "  --pixel_format/-p\n"
+                     "  --bitdepth/-b\n");
     }
 
     if (settings->model_cnt == 0 && !settings->no_prediction) {
@@ -526,8 +778,8 @@ void cli_parse(const int argc, char *const *const argv,
         };
         settings->model_config[settings->model_cnt++] = cfg;
 #else
-        usage(argv[0], "At least one model (-m/--model) is required "
-                       "unless no prediction (-n/--no_prediction) is set");
+        return usage(argv[0], log, "At least one model (-m/--model) is required "
+                     "unless no prediction (-n/--no_prediction) is set");
 #endif
     }
 
@@ -537,11 +789,32 @@ void cli_parse(const int argc, char *const *const argv,
             if (!strcmp(settings->model_config[i].cfg.name,
                         settings->model_config[j].cfg.name))
             {
-                usage(argv[0], "Each model should be uniquely named. "
-                               "Set using `--model` via the `name=...` param.");
+                return usage(argv[0], log, "Each model should be uniquely named. "
+                             "Set using `--model` via the `name=...` param.");
             }
         }
     }
+    return 0;
+}
+
+void cli_parse(const int argc, char *const *const argv,
+               CLISettings *const settings)
+{
+    parse(argc, argv, settings, NULL);
+}
+
+int cli_parse_job(const int argc, char *const *const argv,
+                  CLISettings *const settings, FILE *log)
+{
+    const int opterr_prev = opterr;
+    opterr = 0;
+    // 0 also resets the scan state getopt keeps between calls, in case the
+    // last job stopped in the middle of a group of short options
+    optind = 0;
+    int err = parse(argc, argv, settings, log);
+    opterr = opterr_prev;
+    if (err) cli_free(settings);
+    return err;
 }
 
 void cli_free(CLISettings *settings)
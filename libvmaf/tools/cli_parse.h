@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 
 #include "libvmaf/libvmaf.h"
 #include "libvmaf/model.h"
@@ -29,15 +30,28 @@ typedef struct {
 } CLIModelConfig;
 
 typedef struct {
-    char *path_ref, *path_dist;
+    char *path_ref;
+    char *path_dist[CLI_SETTINGS_STATIC_ARRAY_LEN];
+    unsigned dist_cnt;
     unsigned frame_skip_ref;
     unsigned frame_skip_dist;
     unsigned frame_cnt;
+    struct {
+        unsigned start, end;
+    } frame_range;
+    unsigned warmup;
+    char *state_path;
+    int progress_fd;
+    unsigned progress_interval;
+    bool merge;
+    char *const *merge_path;
+    unsigned merge_cnt;
     unsigned width, height;
     enum VmafPixelFormat pix_fmt;
     unsigned bitdepth;
     bool use_yuv;
-    char *output_path;
+    char *output_path[CLI_SETTINGS_STATIC_ARRAY_LEN];
+    unsigned output_cnt;
     enum VmafOutputFormat output_fmt;
     CLIModelConfig model_config[CLI_SETTINGS_STATIC_ARRAY_LEN];
     unsigned model_cnt;
@@ -45,17 +59,28 @@ typedef struct {
     unsigned feature_cnt;
     enum VmafLogLevel log_level;
     unsigned subsample;
+    float subsample_threshold;
+    VmafPoolingConfiguration pool_cfg[CLI_SETTINGS_STATIC_ARRAY_LEN];
+    unsigned pool_cnt;
     unsigned thread_cnt;
+    char *thread_affinity;
     bool no_prediction;
     bool quiet;
     bool common_bitdepth;
     unsigned cpumask;
     unsigned gpumask;
+    char *serve_path;
+    char *client_path;
 } CLISettings;
 
 void cli_parse(const int argc, char *const *const argv,
                CLISettings *const settings);
 
+// Like cli_parse(), for the argv of a `--serve` job: problems are written to
+// log and return -EINVAL instead of exiting.
+int cli_parse_job(const int argc, char *const *const argv,
+                  CLISettings *const settings, FILE *log);
+
 void cli_free(CLISettings *settings);
 
 #endif /* __VMAF_CLI_PARSE_H__ */
@@ -0,0 +1,583 @@
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "serve.h"
+
+#ifndef _WIN32
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/*
+ * A client sends one job per connection:
+ *
+ *   u32 version, u32 istty, str cwd, u32 argc, argc * str
+ *
+ * where str is a u32 size followed by that many bytes. The daemon answers
+ * with frames of a u8 type, a u32 payload size and the payload: the log of
+ * the job (FRAME_LOG), the contents of the files it wrote (FRAME_FILE, a u32
+ * index followed by the contents) and its exit status (FRAME_EXIT, an i32),
+ * which is always last. Files are numbered like the --output paths of the
+ * job, followed by its --state path. Integers are in host byte order, since
+ * both ends run on the same machine.
+ */
+#define PROTOCOL_VERSION 1
+#define MAX_STRING_SZ (1 << 20)
+#define MAX_ARGC 4096
+// a client that stalls for longer loses its job, the daemon scores one job
+// at a time
+#define IO_TIMEOUT_SEC 10
+
+enum {
+    FRAME_LOG = 'l',
+    FRAME_FILE = 'f',
+    FRAME_EXIT = 'x',
+};
+
+static int write_all(int fd, const void *buf, size_t sz)
+{
+    const char *p = buf;
+    while (sz) {
+        const ssize_t n = write(fd, p, sz);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        sz -= n;
+    }
+    return 0;
+}
+
+static int read_all(int fd, void *buf, size_t sz)
+{
+    char *p = buf;
+    while (sz) {
+        const ssize_t n = read(fd, p, sz);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        sz -= n;
+    }
+    return 0;
+}
+
+static int send_u32(int fd, uint32_t val)
+{
+    return write_all(fd, &val, sizeof(val));
+}
+
+static int recv_u32(int fd, uint32_t *val)
+{
+    return read_all(fd, val, sizeof(*val));
+}
+
+static int send_str(int fd, const char *str)
+{
+    const size_t sz = strlen(str);
+    if (sz > MAX_STRING_SZ) return -1;
+    if (send_u32(fd, sz)) return -1;
+    return write_all(fd, str, sz);
+}
+
+static int recv_str(int fd, char **str)
+{
+    uint32_t sz;
+    if (recv_u32(fd, &sz)) return -1;
+    if (sz > MAX_STRING_SZ) return -1;
+    char *s = malloc(sz + 1);
+    if (!s) return -1;
+    if (read_all(fd, s, sz)) {
+        free(s);
+        return -1;
+    }
+    s[sz] = '\0';
+    *str = s;
+    return 0;
+}
+
+static int send_frame_header(int fd, uint8_t type, uint32_t sz)
+{
+    if (write_all(fd, &type, sizeof(type))) return -1;
+    return send_u32(fd, sz);
+}
+
+static int model_cache_key(const CLIModelConfig *m, char *key, size_t key_sz)
+{
+    char path[PATH_MAX];
+    const char *id = m->version;
+    struct stat st = { 0 };
+    if (!id) {
+        // relative paths are resolved in the working directory of the client
+        if (!realpath(m->path, path)) return -1;
+        // a model file that changed on disk has to be loaded again
+        if (stat(path, &st)) return -1;
+        id = path;
+    }
+
+    const int n = snprintf(key, key_sz,
+                           "%s=%s:mtime=%lld.%09ld:size=%lld:name=%s:flags=%"
+                           PRIu64, m->version ? "version" : "path", id,
+                           (long long) st.st_mtim.tv_sec,
+                           (long) st.st_mtim.tv_nsec, (long long) st.st_size,
+                           m->cfg.name ? m->cfg.name : "", m->cfg.flags);
+    return n < 0 || (size_t) n >= key_sz ? -1 : 0;
+}
+
+bool model_cache_get(ModelCache *cache, const CLIModelConfig *m,
+                     VmafModel **model, VmafModelCollection **model_collection)
+{
+    if (!cache || m->overload_cnt) return false;
+
+    char key[PATH_MAX + 256];
+    if (model_cache_key(m, key, sizeof(key))) return false;
+
+    for (unsigned i = 0; i < cache->cnt; i++) {
+        if (strcmp(cache->entry[i].key, key)) continue;
+        *model = cache->entry[i].model;
+        *model_collection = cache->entry[i].model_collection;
+        return true;
+    }
+    return false;
+}
+
+bool model_cache_put(ModelCache *cache, const CLIModelConfig *m,
+                     VmafModel *model, VmafModelCollection *model_collection)
+{
+    if (!cache || m->overload_cnt) return false;
+    if (cache->cnt == MODEL_CACHE_LEN) return false;
+
+    char key[PATH_MAX + 256];
+    if (model_cache_key(m, key, sizeof(key))) return false;
+    char *k = strdup(key);
+    if (!k) return false;
+
+    cache->entry[cache->cnt].key = k;
+    cache->entry[cache->cnt].model = model;
+    cache->entry[cache->cnt].model_collection = model_collection;
+    cache->cnt++;
+    return true;
+}
+
+void model_cache_close(ModelCache *cache)
+{
+    for (unsigned i = 0; i < cache->cnt; i++) {
+        free(cache->entry[i].key);
+        vmaf_model_destroy(cache->entry[i].model);
+        vmaf_model_collection_destroy(cache->entry[i].model_collection);
+    }
+    cache->cnt = 0;
+}
+
+static int make_tmp_file(char *path, size_t path_sz)
+{
+    const char *dir = getenv("TMPDIR");
+    if (!dir || !*dir) dir = "/tmp";
+    const int n = snprintf(path, path_sz, "%s/vmaf-serve-XXXXXX", dir);
+    if (n < 0 || (size_t) n >= path_sz) return -1;
+    const int fd = mkstemp(path);
+    if (fd < 0) return -1;
+    close(fd);
+    return 0;
+}
+
+static int send_file(int fd, uint32_t index, const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file) return 0;
+
+    int err = 0;
+    struct stat st;
+    if (fstat(fileno(file), &st) || (uint64_t) st.st_size > UINT32_MAX - sizeof(index)) {
+        err = -1;
+        goto close_file;
+    }
+    // nothing was written, e.g. because scoring failed
+    if (!st.st_size) goto close_file;
+
+    err = send_frame_header(fd, FRAME_FILE, sizeof(index) + st.st_size);
+    err |= send_u32(fd, index);
+    char buf[1 << 16];
+    size_t n;
+    while (!err && (n = fread(buf, 1, sizeof(buf), file)) > 0)
+        err = write_all(fd, buf, n);
+
+close_file:
+    fclose(file);
+    return err;
+}
+
+static int handle_job(int fd, VmafContext *threads, ModelCache *models)
+{
+    int err = 0;
+    uint32_t version, istty, argc;
+    if (recv_u32(fd, &version) || version != PROTOCOL_VERSION) return -1;
+    if (recv_u32(fd, &istty)) return -1;
+
+    char *cwd;
+    if (recv_str(fd, &cwd)) return -1;
+    if (recv_u32(fd, &argc) || !argc || argc > MAX_ARGC) {
+        err = -1;
+        goto free_cwd;
+    }
+    char **argv = calloc(argc + 1, sizeof(*argv));
+    if (!argv) {
+        err = -1;
+        goto free_cwd;
+    }
+    for (unsigned i = 0; i < argc; i++) {
+        err = recv_str(fd, &argv[i]);
+        if (err) goto free_argv;
+    }
+
+    char *log_buf = NULL;
+    size_t log_sz = 0;
+    FILE *log = open_memstream(&log_buf, &log_sz);
+    if (!log) {
+        err = -1;
+        goto free_argv;
+    }
+
+    char tmp_path[CLI_SETTINGS_STATIC_ARRAY_LEN + 1][PATH_MAX];
+    unsigned tmp_cnt = 0;
+    int32_t status = -1;
+
+    if (chdir(cwd)) {
+        fprintf(log, "could not change to directory: %s\n", cwd);
+        goto send_result;
+    }
+
+    CLISettings c;
+    if (cli_parse_job(argc, argv, &c, log)) goto send_result;
+    if (!c.client_path) {
+        fprintf(log, "not a client job\n");
+        goto free_settings;
+    }
+    c.progress_fd = -1;
+
+    // files are written to temporary paths and sent back to the client
+    for (unsigned i = 0; i < c.output_cnt; i++) {
+        if (make_tmp_file(tmp_path[tmp_cnt], PATH_MAX)) goto tmp_error;
+        c.output_path[i] = tmp_path[tmp_cnt++];
+    }
+    if (c.state_path) {
+        if (make_tmp_file(tmp_path[tmp_cnt], PATH_MAX)) goto tmp_error;
+        c.state_path = tmp_path[tmp_cnt++];
+    }
+
+    const ScoreEnv env = {
+        .log = log,
+        .istty = istty,
+        .threads = threads,
+        .models = models,
+    };
+    status = score(&c, &env);
+    goto free_settings;
+
+tmp_error:
+    fprintf(log, "could not create temporary file: %s\n", strerror(errno));
+free_settings:
+    cli_free(&c);
+send_result:
+    fclose(log);
+    err = send_frame_header(fd, FRAME_LOG, log_sz);
+    err |= write_all(fd, log_buf, log_sz);
+    for (unsigned i = 0; i < tmp_cnt; i++) {
+        if (!err) err = send_file(fd, i, tmp_path[i]);
+        unlink(tmp_path[i]);
+    }
+    if (!err) {
+        err = send_frame_header(fd, FRAME_EXIT, sizeof(status));
+        err |= write_all(fd, &status, sizeof(status));
+    }
+    free(log_buf);
+free_argv:
+    for (unsigned i = 0; i < argc; i++)
+        free(argv[i]);
+    free(argv);
+free_cwd:
+    free(cwd);
+    return err;
+}
+
+static int socket_address(const char *path, struct sockaddr_un *addr)
+{
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr->sun_path)) {
+        fprintf(stderr, "socket path is too long: %s\n", path);
+        return -1;
+    }
+    strcpy(addr->sun_path, path);
+    return 0;
+}
+
+// Binds to path, replacing the socket of a daemon that is no longer running.
+static int bind_socket(int sock, const struct sockaddr_un *addr)
+{
+    if (!bind(sock, (const struct sockaddr *) addr, sizeof(*addr))) return 0;
+    if (errno != EADDRINUSE) return -1;
+
+    const int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe < 0) return -1;
+    const int alive =
+        !connect(probe, (const struct sockaddr *) addr, sizeof(*addr));
+    close(probe);
+    if (alive || errno != ECONNREFUSED) {
+        errno = EADDRINUSE;
+        return -1;
+    }
+
+    struct stat st;
+    if (lstat(addr->sun_path, &st) || !S_ISSOCK(st.st_mode)) {
+        errno = EADDRINUSE;
+        return -1;
+    }
+    unlink(addr->sun_path);
+    return bind(sock, (const struct sockaddr *) addr, sizeof(*addr));
+}
+
+static volatile sig_atomic_t stop;
+
+static void on_signal(int sig)
+{
+    (void) sig;
+    stop = 1;
+}
+
+int serve(CLISettings *c)
+{
+    int err = 0;
+
+    struct sockaddr_un addr;
+    if (socket_address(c->serve_path, &addr)) return -1;
+
+    // jobs change into the directory of their client
+    const int cwd = open(".", O_RDONLY);
+    if (cwd < 0) {
+        fprintf(stderr, "could not open working directory\n");
+        return -1;
+    }
+
+    VmafContext *threads = NULL;
+    if (c->thread_cnt) {
+        VmafConfiguration cfg = {
+            .log_level = VMAF_LOG_LEVEL_INFO,
+            .n_threads = c->thread_cnt,
+            .thread_affinity = c->thread_affinity,
+        };
+        err = vmaf_init(&threads, cfg);
+        if (err) {
+            fprintf(stderr, "problem initializing VMAF context\n");
+            err = -1;
+            goto close_cwd;
+        }
+    }
+
+    const int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0) {
+        fprintf(stderr, "could not create socket: %s\n", strerror(errno));
+        err = -1;
+        goto close_threads;
+    }
+
+    // only the user running the daemon may submit jobs
+    const mode_t mask = umask(0077);
+    err = bind_socket(sock, &addr);
+    umask(mask);
+    if (err || listen(sock, 16)) {
+        fprintf(stderr, "could not listen on socket: %s: %s\n",
+                c->serve_path, strerror(errno));
+        err = -1;
+        goto close_socket;
+    }
+
+    struct sigaction sa = { .sa_handler = on_signal };
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    fprintf(stderr, "listening on %s\n", c->serve_path);
+
+    ModelCache models = { 0 };
+    while (!stop) {
+        const int conn = accept(sock, NULL, NULL);
+        if (conn < 0) {
+            if (errno != EINTR)
+                fprintf(stderr, "problem accepting job: %s\n", strerror(errno));
+            continue;
+        }
+        const struct timeval timeout = { .tv_sec = IO_TIMEOUT_SEC };
+        if (setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &timeout,
+                       sizeof(timeout)) ||
+            setsockopt(conn, SOL_SOCKET, SO_SNDTIMEO, &timeout,
+                       sizeof(timeout)))
+        {
+            fprintf(stderr, "could not set job timeout: %s\n",
+                    strerror(errno));
+            close(conn);
+            continue;
+        }
+        if (handle_job(conn, threads, &models))
+            fprintf(stderr, "problem handling job\n");
+        close(conn);
+        if (fchdir(cwd)) {
+            fprintf(stderr, "could not restore working directory\n");
+            err = -1;
+            break;
+        }
+    }
+
+    model_cache_close(&models);
+    unlink(c->serve_path);
+close_socket:
+    close(sock);
+close_threads:
+    if (threads) vmaf_close(threads);
+close_cwd:
+    close(cwd);
+    return err;
+}
+
+static int copy_payload(int fd, uint32_t sz, FILE *out)
+{
+    char buf[1 << 16];
+    while (sz) {
+        const size_t n = sz < sizeof(buf) ? sz : sizeof(buf);
+        if (read_all(fd, buf, n)) return -1;
+        if (out && fwrite(buf, 1, n, out) != n) out = NULL;
+        sz -= n;
+    }
+    return 0;
+}
+
+static const char *file_path(CLISettings *c, uint32_t index)
+{
+    if (index < c->output_cnt) return c->output_path[index];
+    if (index == c->output_cnt) return c->state_path;
+    return NULL;
+}
+
+int client(CLISettings *c, int argc, char *argv[], bool istty)
+{
+    struct sockaddr_un addr;
+    if (socket_address(c->client_path, &addr)) return -1;
+
+    char cwd[PATH_MAX];
+    if (!getcwd(cwd, sizeof(cwd))) {
+        fprintf(stderr, "could not get working directory\n");
+        return -1;
+    }
+
+    const int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0) {
+        fprintf(stderr, "could not create socket: %s\n", strerror(errno));
+        return -1;
+    }
+    if (connect(sock, (struct sockaddr *) &addr, sizeof(addr))) {
+        fprintf(stderr, "could not connect to daemon: %s: %s\n",
+                c->client_path, strerror(errno));
+        close(sock);
+        return -1;
+    }
+
+    int err = send_u32(sock, PROTOCOL_VERSION);
+    err |= send_u32(sock, istty);
+    err |= send_str(sock, cwd);
+    err |= send_u32(sock, argc);
+    for (int i = 0; !err && i < argc; i++)
+        err = send_str(sock, argv[i]);
+    if (err) {
+        fprintf(stderr, "problem sending job to daemon\n");
+        close(sock);
+        return -1;
+    }
+
+    int32_t status = -1;
+    for (;;) {
+        uint8_t type;
+        uint32_t sz;
+        if (read_all(sock, &type, sizeof(type)) || recv_u32(sock, &sz)) {
+            fprintf(stderr, "connection to daemon was lost\n");
+            break;
+        }
+
+        if (type == FRAME_EXIT) {
+            if (sz != sizeof(status) || read_all(sock, &status, sz)) {
+                fprintf(stderr, "connection to daemon was lost\n");
+                status = -1;
+            }
+            break;
+        }
+
+        if (type == FRAME_LOG) {
+            if (copy_payload(sock, sz, stderr)) {
+                fprintf(stderr, "connection to daemon was lost\n");
+                break;
+            }
+            continue;
+        }
+
+        uint32_t index;
+        const char *path;
+        if (type != FRAME_FILE || sz < sizeof(index) ||
+            recv_u32(sock, &index) || !(path = file_path(c, index)))
+        {
+            fprintf(stderr, "unexpected response from daemon\n");
+            break;
+        }
+        FILE *out = fopen(path, "wb");
+        if (!out)
+            fprintf(stderr, "could not open file: %s\n", path);
+        err = copy_payload(sock, sz - sizeof(index), out);
+        if (out) fclose(out);
+        if (err) {
+            fprintf(stderr, "connection to daemon was lost\n");
+            break;
+        }
+    }
+
+    close(sock);
+    return status;
+}
+
+#else
+
+bool model_cache_get(ModelCache *cache, const CLIModelConfig *m,
+                     VmafModel **model, VmafModelCollection **model_collection)
+{
+    return false;
+}
+
+bool model_cache_put(ModelCache *cache, const CLIModelConfig *m,
+                     VmafModel *model, VmafModelCollection *model_collection)
+{
+    return false;
+}
+
+void model_cache_close(ModelCache *cache)
+{
+}
+
+int serve(CLISettings *c)
+{
+    fprintf(stderr, "--serve is not supported on this platform\n");
+    return -1;
+}
+
+int client(CLISettings *c, int argc, char *argv[], bool istty)
+{
+    fprintf(stderr, "client is not supported on this platform\n");
+    return -1;
+}
+
+#endif
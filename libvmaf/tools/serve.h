@@ -0,0 +1,54 @@
+#ifndef __VMAF_SERVE_H__
+#define __VMAF_SERVE_H__
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "cli_parse.h"
+
+#include "libvmaf/libvmaf.h"
+#include "libvmaf/model.h"
+
+#define MODEL_CACHE_LEN 64
+
+// Models loaded by the jobs of a `--serve` daemon, kept for later jobs.
+typedef struct {
+    struct {
+        char *key;
+        VmafModel *model;
+        VmafModelCollection *model_collection;
+    } entry[MODEL_CACHE_LEN];
+    unsigned cnt;
+} ModelCache;
+
+typedef struct {
+    FILE *log; // diagnostics and pooled scores
+    bool istty; // whether log is watched in a terminal
+    bool meter; // draw an FPS meter onto log
+    VmafContext *threads; // context whose worker threads to share, or NULL
+    ModelCache *models; // models kept across jobs, or NULL
+} ScoreEnv;
+
+// Scores the inputs of c, implemented by vmaf.c.
+int score(CLISettings *c, const ScoreEnv *env);
+
+/*
+ * Looks up the model (collection) of m, which stays owned by the cache.
+ * Models with feature overloads are never cached.
+ */
+bool model_cache_get(ModelCache *cache, const CLIModelConfig *m,
+                     VmafModel **model, VmafModelCollection **model_collection);
+
+// Returns true if the cache took ownership of a freshly loaded model.
+bool model_cache_put(ModelCache *cache, const CLIModelConfig *m,
+                     VmafModel *model, VmafModelCollection *model_collection);
+
+void model_cache_close(ModelCache *cache);
+
+// Runs the daemon on c->serve_path until SIGINT or SIGTERM.
+int serve(CLISettings *c);
+
+// Sends the job in argv to the daemon on c->client_path.
+int client(CLISettings *c, int argc, char *argv[], bool istty);
+
+#endif /* __VMAF_SERVE_H__ */
@@ -0,0 +1,45 @@
+#!/bin/sh -x
+set -e
+
+vmaf="$(pwd)/tools/vmaf"
+dir="$(mktemp -d)"
+trap 'kill $daemon 2>/dev/null || true; rm -rf "$dir"' EXIT
+cd "$dir"
+
+# 3 frames of 352x288 420 8-bit noise
+head -c 456192 /dev/urandom > ref.yuv
+head -c 456192 /dev/urandom > dis.yuv
+
+"$vmaf" --serve vmaf.sock --threads 2 2> daemon.log &
+daemon=$!
+while ! grep -q listening daemon.log; do sleep 0.1; done
+
+# a job run by the daemon scores like the cli, twice to exercise the model
+# cache; lines are sorted since threads write features in any order
+for i in 1 2; do
+    "$vmaf" client \
+        --reference ref.yuv --distorted dis.yuv \
+        --width 352 --height 288 --pixel_format 420 --bitdepth 8 \
+        --feature psnr --json --output served.json \
+        vmaf.sock
+    "$vmaf" \
+        --reference ref.yuv --distorted dis.yuv \
+        --width 352 --height 288 --pixel_format 420 --bitdepth 8 \
+        --feature psnr --json --output direct.json
+    grep -v fps served.json | sort > served.txt
+    grep -v fps direct.json | sort > direct.txt
+    cmp served.txt direct.txt
+done
+
+# errors of a job are reported by the client
+if "$vmaf" client \
+    --reference missing.yuv --distorted dis.yuv \
+    --width 352 --height 288 --pixel_format 420 --bitdepth 8 \
+    vmaf.sock 2> client.log; then
+    exit 1
+fi
+grep -q missing.yuv client.log
+
+kill $daemon
+wait $daemon
+test ! -e vmaf.sock
@@ -23,9 +23,12 @@ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.*/
 
 #include "vidinput.h"
+#include <errno.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "libvmaf/picture.h"
+
 extern video_input_vtbl Y4M_INPUT_VTBL;
 extern video_input_vtbl YUV_INPUT_VTBL;
 
@@ -67,6 +70,45 @@ int video_input_fetch_frame(video_input *_vid,
   return (*_vid->vtbl->fetch_frame)(_vid->ctx,_vid->fin,_ycbcr,_tag);
 }
 
+int video_input_fetch_frame_into(video_input *_vid,video_input_ycbcr _dst,
+ int _dst_depth) {
+  video_input_ycbcr ycbcr;
+  video_input_info  info;
+  int               xstride;
+  int               ret;
+  int               pli;
+  if(_vid->vtbl->fetch_frame_into!=NULL){
+    ret=(*_vid->vtbl->fetch_frame_into)(_vid->ctx,_vid->fin,_dst,_dst_depth);
+    if(ret!=-EAGAIN)return ret;
+  }
+  ret=video_input_fetch_frame(_vid,ycbcr,NULL);
+  if(ret<1)return ret;
+  video_input_get_info(_vid,&info);
+  xstride=info.depth>8?2:1;
+  for(pli=0;pli<3;pli++){
+    int            xdec;
+    int            ydec;
+    unsigned char *src;
+    if(_dst[pli].data==NULL)continue;
+    xdec=pli&&!(info.pixel_fmt&1);
+    ydec=pli&&!(info.pixel_fmt&2);
+    src=ycbcr[pli].data+(info.pic_y>>ydec)*ycbcr[pli].stride
+     +(info.pic_x>>xdec)*xstride;
+    if(vmaf_picture_copy_plane(_dst[pli].data,_dst[pli].stride,_dst_depth,
+     src,ycbcr[pli].stride,info.depth,_dst[pli].width,_dst[pli].height)<0){
+      fprintf(stderr,"Cannot convert %i-bit input to %i bits.\n",
+       info.depth,_dst_depth);
+      return -1;
+    }
+  }
+  return 1;
+}
+
+int video_input_seek_frame(video_input *_vid,uint64_t _frame) {
+  if(_vid->vtbl->seek_frame==NULL)return -1;
+  return (*_vid->vtbl->seek_frame)(_vid->ctx,_vid->fin,_frame);
+}
+
 void video_input_close(video_input *_vid) {
   (*_vid->vtbl->close)(_vid->ctx);
   free(_vid->ctx);
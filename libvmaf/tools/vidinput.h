@@ -35,6 +35,10 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.*/
 # endif
 # include <stdio.h>
 # include <stdint.h>
+# if defined(_MSC_VER)
+#  define fseeko _fseeki64
+#  define ftello _ftelli64
+# endif
 
 # if defined(__cplusplus)
 extern "C" {
@@ -55,6 +59,10 @@ typedef void* (*video_input_open_func)(FILE *_fin);
 typedef void (*video_input_get_info_func)(void *_ctx,video_input_info *_ti);
 typedef int (*video_input_fetch_frame_func)(void *_ctx,FILE *_fin,
  video_input_ycbcr _ycbcr,char _tag[5]);
+typedef int (*video_input_seek_frame_func)(void *_ctx,FILE *_fin,
+ uint64_t _frame);
+typedef int (*video_input_fetch_frame_into_func)(void *_ctx,FILE *_fin,
+ video_input_ycbcr _dst,int _dst_depth);
 typedef void (*video_input_close_func)(void *_ctx);
 typedef void* (*raw_input_open_func)(FILE *_fin,
                                      unsigned width, unsigned height,
@@ -68,6 +76,11 @@ struct video_input_vtbl {
   video_input_get_info_func     get_info;
   video_input_fetch_frame_func  fetch_frame;
   video_input_close_func        close;
+  video_input_seek_frame_func   seek_frame;
+  /**Optional: reads the next frame straight into caller-owned planes.
+     Returns -EAGAIN (without consuming any input) when the frame cannot be
+      read without conversion, and the generic copy path is used instead.*/
+  video_input_fetch_frame_into_func fetch_frame_into;
 };
 
 struct video_input {
@@ -86,6 +99,22 @@ void video_input_close(video_input *_vid);
 void video_input_get_info(video_input *_vid, video_input_info *_ti);
 int video_input_fetch_frame(video_input *_vid, video_input_ycbcr _ycbcr,
                             char _tag[5]);
+/**Reads the next frame into the caller-owned planes _dst, which describe the
+    visible picture (pic_w by pic_h and its chroma planes) with samples of
+    _dst_depth bits (2 bytes per sample when _dst_depth>8).
+   Samples are widened when _dst_depth is greater than the input depth.
+   A plane with NULL data is skipped, so chroma can be dropped at the source.
+   Where the input allows, the frame data is read directly into _dst, so the
+    frame is copied only once; otherwise it is fetched and copied row by row.
+   Return: 1 on success, 0 at the end of the stream, or a negative value on
+    error.*/
+int video_input_fetch_frame_into(video_input *_vid, video_input_ycbcr _dst,
+                                 int _dst_depth);
+/**Positions the input so that the next fetch returns frame number _frame
+   (counting from zero). Seeking past the last frame is not an error; the next
+   fetch will report end of stream.
+   Return: 0 on success, or a negative value on error.*/
+int video_input_seek_frame(video_input *_vid, uint64_t _frame);
 
 typedef enum {
   /** Chroma decimation by 2 in both the X and Y directions (4:2:0).
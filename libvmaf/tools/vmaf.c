@@ -4,6 +4,7 @@
 #include <unistd.h>
 
 #include "cli_parse.h"
+#include "serve.h"
 #include "spinner.h"
 #include "vidinput.h"
 
@@ -27,7 +28,8 @@ static enum VmafPixelFormat pix_fmt_map(int pf)
     }
 }
 
-static int validate_videos(video_input *vid1, video_input *vid2, bool common_bitdepth)
+static int validate_videos(video_input *vid1, video_input *vid2,
+                           bool common_bitdepth, FILE *log)
 {
     int err_cnt = 0;
 
@@ -36,30 +38,30 @@ static int validate_videos(video_input *vid1, video_input *vid2, bool common_bit
     video_input_get_info(vid2, &info2);
 
     if ((info1.frame_w != info2.frame_w) || (info1.frame_h != info2.frame_h)) {
-        fprintf(stderr, "dimensions do not match: %dx%d, %dx%d\n",
+        fprintf(log, "dimensions do not match: %dx%d, %dx%d\n",
                 info1.frame_w, info1.frame_h, info2.frame_w, info2.frame_h);
         err_cnt++;
     }
 
     if (info1.pixel_fmt != info2.pixel_fmt) {
-        fprintf(stderr, "pixel formats do not match: %d, %d\n",
+        fprintf(log, "pixel formats do not match: %d, %d\n",
                 info1.pixel_fmt, info2.pixel_fmt);
         err_cnt++;
     }
 
     if (!pix_fmt_map(info1.pixel_fmt) || !pix_fmt_map(info2.pixel_fmt)) {
-        fprintf(stderr, "unsupported pixel format: %d\n", info1.pixel_fmt);
+        fprintf(log, "unsupported pixel format: %d\n", info1.pixel_fmt);
         err_cnt++;
     }
 
     if (!common_bitdepth && info1.depth != info2.depth) {
-        fprintf(stderr, "bitdepths do not match: %d, %d\n",
+        fprintf(log, "bitdepths do not match: %d, %d\n",
                 info1.depth, info2.depth);
         err_cnt++;
     }
 
     if (info1.depth < 8 || info1.depth > 16) {
-        fprintf(stderr, "unsupported bitdepth: %d\n", info1.depth);
+        fprintf(log, "unsupported bitdepth: %d\n", info1.depth);
         err_cnt++;
     }
 
@@ -68,182 +70,342 @@ static int validate_videos(video_input *vid1, video_input *vid2, bool common_bit
     return err_cnt;
 }
 
-static int fetch_picture(video_input *vid, VmafPicture *pic, int depth)
+static int fetch_picture(VmafContext *vmaf, video_input *vid,
+                         VmafPicture *pic, int depth, FILE *log)
 {
     int ret;
     video_input_ycbcr ycbcr;
-    video_input_info info;
-
-    ret = video_input_fetch_frame(vid, ycbcr, NULL);
-    if (ret < 1) return !ret;
-
-    video_input_get_info(vid, &info);
-    ret = vmaf_picture_alloc(pic, pix_fmt_map(info.pixel_fmt), depth,
-                             info.pic_w, info.pic_h);
 
+    ret = vmaf_fetch_preallocated_picture(vmaf, pic);
     if (ret) {
-        fprintf(stderr, "problem allocating picture.\n");
+        fprintf(log, "problem allocating picture.\n");
         return -1;
     }
 
-    if (info.depth == depth) {
-        if (info.depth == 8) {
-            for (unsigned i = 0; i < 3; i++) {
-                int xdec = i&&!(info.pixel_fmt&1);
-                int ydec = i&&!(info.pixel_fmt&2);
-                uint8_t *ycbcr_data = ycbcr[i].data +
-                    (info.pic_y >> ydec) * ycbcr[i].stride +
-                    (info.pic_x >> xdec);
-                uint8_t *pic_data = pic->data[i];
-
-                for (unsigned j = 0; j < pic->h[i]; j++) {
-                    memcpy(pic_data, ycbcr_data, sizeof(*pic_data) * pic->w[i]);
-                    pic_data += pic->stride[i];
-                    ycbcr_data += ycbcr[i].stride;
-                }
-            }
-        } else {
-            for (unsigned i = 0; i < 3; i++) {
-                int xdec = i&&!(info.pixel_fmt&1);
-                int ydec = i&&!(info.pixel_fmt&2);
-                uint16_t *ycbcr_data = (uint16_t*) ycbcr[i].data +
-                    (info.pic_y >> ydec) * (ycbcr[i].stride / 2) +
-                    (info.pic_x >> xdec);
-                uint16_t *pic_data = pic->data[i];
-
-                for (unsigned j = 0; j < pic->h[i]; j++) {
-                    memcpy(pic_data, ycbcr_data, sizeof(*pic_data) * pic->w[i]);
-                    pic_data += pic->stride[i] / 2;
-                    ycbcr_data += ycbcr[i].stride / 2;
-                }
-            }
-        }
-    } else if (depth > 8) {
-        // unequal bit-depth
-        // therefore depth must be > 8 since we do not support depth < 8
-        int left_shift = depth - info.depth;
-        if (info.depth == 8) {
-            for (unsigned i = 0; i < 3; i++) {
-                int xdec = i&&!(info.pixel_fmt&1);
-                int ydec = i&&!(info.pixel_fmt&2);
-                uint8_t *ycbcr_data = ycbcr[i].data +
-                    (info.pic_y >> ydec) * ycbcr[i].stride +
-                    (info.pic_x >> xdec);
-                uint16_t *pic_data = (uint16_t*)pic->data[i];
-
-                for (unsigned j = 0; j < pic->h[i]; j++) {
-                    for (unsigned k = 0; k < pic->w[i]; k++) {
-                        pic_data[k] = ycbcr_data[k] << left_shift;
-                    }
-                    pic_data += pic->stride[i] / 2;
-                    ycbcr_data += ycbcr[i].stride;
-                }
-            }
-        } else {
-            for (unsigned i = 0; i < 3; i++) {
-                int xdec = i&&!(info.pixel_fmt&1);
-                int ydec = i&&!(info.pixel_fmt&2);
-                uint16_t *ycbcr_data = (uint16_t*) ycbcr[i].data +
-                    (info.pic_y >> ydec) * (ycbcr[i].stride / 2) +
-                    (info.pic_x >> xdec);
-                uint16_t *pic_data = pic->data[i];
-
-                for (unsigned j = 0; j < pic->h[i]; j++) {
-                    for (unsigned k = 0; k < pic->w[i]; k++) {
-                        pic_data[k] = ycbcr_data[k] << left_shift;
-                    }
-                    pic_data += pic->stride[i] / 2;
-                    ycbcr_data += ycbcr[i].stride / 2;
-                }
-            }
-        }
-        
-    } else {
-        fprintf(stderr, "expect depth > 8\n");
-        return -1;
+    // read straight into the picture, widening to the common bit depth
+    for (unsigned i = 0; i < 3; i++) {
+        ycbcr[i].width = pic->w[i];
+        ycbcr[i].height = pic->h[i];
+        ycbcr[i].stride = pic->stride[i];
+        ycbcr[i].data = pic->data[i];
+    }
+
+    ret = video_input_fetch_frame_into(vid, ycbcr, depth);
+    if (ret < 1) {
+        vmaf_picture_unref(pic);
+        return ret ? -1 : 1;
     }
 
     return 0;
 }
 
-int main(int argc, char *argv[])
+// Fetches the next reference picture and the next picture of every distorted
+// input. Unless all of them were fetched (0), none are held on return. Returns
+// 1 when the inputs ended together, and -1 on errors or uneven lengths.
+static int fetch_pictures(VmafContext *vmaf, CLISettings *c, int depth,
+                          video_input *vid_ref, VmafPicture *pic_ref,
+                          video_input *vid_dist, VmafPicture *pic_dist,
+                          FILE *log)
 {
+    int ret_dist[CLI_SETTINGS_STATIC_ARRAY_LEN];
+    const int ret_ref = fetch_picture(vmaf, vid_ref, pic_ref, depth, log);
+    bool fetched = !ret_ref, ended = ret_ref, failed = ret_ref < 0;
+    for (unsigned i = 0; i < c->dist_cnt; i++) {
+        ret_dist[i] = fetch_picture(vmaf, &vid_dist[i], &pic_dist[i], depth, log);
+        fetched &= !ret_dist[i];
+        ended &= !!ret_dist[i];
+        failed |= ret_dist[i] < 0;
+    }
+    if (fetched) return 0;
+
     int err = 0;
-    const int istty = isatty(fileno(stderr));
+    if (!ret_ref) err |= vmaf_picture_unref(pic_ref);
+    for (unsigned i = 0; i < c->dist_cnt; i++)
+        if (!ret_dist[i]) err |= vmaf_picture_unref(&pic_dist[i]);
+    if (err)
+        fprintf(log, "\nproblem during vmaf_picture_unref\n");
+
+    if (ended) return 1;
+    if (failed) {
+        fprintf(log, "\nproblem while reading pictures\n");
+        return -1;
+    }
+    for (unsigned i = 0; i < c->dist_cnt; i++) {
+        if (!ret_ref == !ret_dist[i]) continue;
+        fprintf(log, "\n\"%s\" ended before \"%s\".\n",
+                ret_ref ? c->path_ref : c->path_dist[i],
+                ret_ref ? c->path_dist[i] : c->path_ref);
+    }
+    return -1;
+}
 
-    CLISettings c;
-    cli_parse(argc, argv, &c);
+static double monotonic_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
 
-    if (istty && !c.quiet) {
-        fprintf(stderr, "VMAF version %s\n", vmaf_version());
-    }
+typedef struct {
+    FILE *out;
+    double interval;
+    double last_time;
+    unsigned last_frames_done;
+    // stages timed by the CLI itself, the rest are reported by libvmaf
+    double fetch, predict;
+} ProgressStream;
+
+static int progress_stream_open(ProgressStream *ps, int fd, unsigned interval)
+{
+    memset(ps, 0, sizeof(*ps));
+    if (fd < 0) return 0;
+
+    ps->out = fdopen(fd, "w");
+    if (!ps->out) return -1;
+    ps->interval = interval * 1e-3;
+    ps->last_time = monotonic_seconds();
+    return 0;
+}
+
+// One JSON object per line, so that a consumer can parse each line on its own.
+static void progress_stream_write(ProgressStream *ps, VmafContext *vmaf,
+                                  bool done)
+{
+    if (!ps->out) return;
+
+    const double now = monotonic_seconds();
+    if (!done && now - ps->last_time < ps->interval) return;
+
+    VmafProgress p;
+    if (vmaf_get_progress(vmaf, &p)) return;
+
+    const double dt = now - ps->last_time;
+    const double fps = dt > 0. ?
+        (p.frames_done - ps->last_frames_done) / dt : 0.;
+    const double avg_fps = p.timings.wall > 0. ?
+        p.frames_done / p.timings.wall : 0.;
+
+    fprintf(ps->out,
+            "{\"frames_read\": %u, \"frames_done\": %u, "
+            "\"queue_depth\": %u, \"fps\": %.2f, \"avg_fps\": %.2f, "
+            "\"wall\": %.3f, \"cpu\": %.3f, "
+            "\"stages\": {\"fetch\": %.3f, \"read\": %.3f, "
+            "\"extract\": %.3f, \"flush\": %.3f, \"predict\": %.3f}, "
+            "\"done\": %s}\n",
+            p.frames_read, p.frames_done, p.queue_depth, fps, avg_fps,
+            p.timings.wall, p.timings.cpu, ps->fetch, p.timings.read,
+            p.timings.extract, p.timings.flush, ps->predict,
+            done ? "true" : "false");
+    fflush(ps->out);
+
+    ps->last_time = now;
+    ps->last_frames_done = p.frames_done;
+}
+
+static void progress_stream_close(ProgressStream *ps)
+{
+    if (ps->out) fclose(ps->out);
+}
 
-    FILE *file_ref = fopen(c.path_ref, "rb");
-    if (!file_ref) {
-        fprintf(stderr, "could not open file: %s\n", c.path_ref);
+static int merge_partial_results(CLISettings *c)
+{
+    VmafConfiguration cfg = {
+        .log_level = VMAF_LOG_LEVEL_INFO,
+        .n_subsample = c->subsample,
+    };
+
+    VmafContext *vmaf;
+    int err = vmaf_init(&vmaf, cfg);
+    if (err) {
+        fprintf(stderr, "problem initializing VMAF context\n");
         return -1;
     }
 
-    FILE *file_dist = fopen(c.path_dist, "rb");
-    if (!file_dist) {
-        fprintf(stderr, "could not open file: %s\n", c.path_dist);
-        return -1;
+    for (unsigned i = 0; i < c->pool_cnt; i++) {
+        err = vmaf_use_pooling(vmaf, c->pool_cfg[i]);
+        if (err) {
+            fprintf(stderr, "problem adding pooling method\n");
+            vmaf_close(vmaf);
+            return -1;
+        }
+    }
+
+    for (unsigned i = 0; i < c->merge_cnt; i++) {
+        err = vmaf_merge_results(vmaf, c->merge_path[i]);
+        if (err) {
+            fprintf(stderr, "problem merging partial results: %s\n",
+                    c->merge_path[i]);
+            vmaf_close(vmaf);
+            return -1;
+        }
+    }
+
+    err = vmaf_write_output(vmaf, c->output_path[0], c->output_fmt);
+    if (err)
+        fprintf(stderr, "problem writing output: %s\n", c->output_path[0]);
+
+    vmaf_close(vmaf);
+    return err;
+}
+
+static const char *model_label(const CLIModelConfig *m)
+{
+    return m->version ? m->version : m->path;
+}
+
+// Loads a model or, since the `--model` option could take either, a model
+// collection, and applies the feature overloads of its config.
+static int load_model(CLIModelConfig *m, VmafModel **model,
+                      VmafModelCollection **model_collection, FILE *log)
+{
+    int err;
+    *model = NULL;
+    *model_collection = NULL;
+
+    if (m->version)
+        err = vmaf_model_load(model, &m->cfg, m->version);
+    else
+        err = vmaf_model_load_from_path(model, &m->cfg, m->path);
+
+    if (!err) {
+        for (unsigned j = 0; j < m->overload_cnt; j++) {
+            err = vmaf_model_feature_overload(*model,
+                                    m->feature_overload[j].name,
+                                    m->feature_overload[j].opts_dict);
+            if (err) {
+                fprintf(log, "problem overloading feature extractors from "
+                        "model: %s\n", model_label(m));
+                goto fail;
+            }
+        }
+        return 0;
     }
 
-    video_input vid_ref;
-    if (c.use_yuv) {
-        err = raw_input_open(&vid_ref, file_ref,
-                             c.width, c.height, c.pix_fmt, c.bitdepth);
+    // check for model_collection before failing
+    if (m->version) {
+        err = vmaf_model_collection_load(model, model_collection, &m->cfg,
+                                         m->version);
     } else {
-        err = video_input_open(&vid_ref, file_ref);
+        err = vmaf_model_collection_load_from_path(model, model_collection,
+                                                   &m->cfg, m->path);
     }
     if (err) {
-        fprintf(stderr, "problem with reference file: %s\n", c.path_ref);
+        fprintf(log, "problem loading model: %s\n", model_label(m));
+        goto fail;
+    }
+
+    for (unsigned j = 0; j < m->overload_cnt; j++) {
+        err = vmaf_model_collection_feature_overload(*model, model_collection,
+                                    m->feature_overload[j].name,
+                                    m->feature_overload[j].opts_dict);
+        if (err) {
+            fprintf(log, "problem overloading feature extractors from "
+                    "model collection: %s\n", model_label(m));
+            goto fail;
+        }
+    }
+    return 0;
+
+fail:
+    vmaf_model_destroy(*model);
+    vmaf_model_collection_destroy(*model_collection);
+    *model = NULL;
+    *model_collection = NULL;
+    return -1;
+}
+
+static int open_input(video_input *vid, const char *path, CLISettings *c,
+                      FILE *log)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        fprintf(log, "could not open file: %s\n", path);
         return -1;
     }
 
-    video_input vid_dist;
-    if (c.use_yuv) {
-        err = raw_input_open(&vid_dist, file_dist,
-                             c.width, c.height, c.pix_fmt, c.bitdepth);
+    int err;
+    if (c->use_yuv) {
+        err = raw_input_open(vid, file, c->width, c->height, c->pix_fmt,
+                             c->bitdepth);
     } else {
-        err = video_input_open(&vid_dist, file_dist);
+        err = video_input_open(vid, file);
     }
     if (err) {
-        fprintf(stderr, "problem with distorted file: %s\n", c.path_dist);
+        fclose(file);
         return -1;
     }
+    return 0;
+}
 
-    err = validate_videos(&vid_ref, &vid_dist, c.common_bitdepth);
-    if (err) {
-        fprintf(stderr, "videos are incompatible, %d %s.\n",
-                err, err == 1 ? "problem" : "problems");
+int score(CLISettings *c, const ScoreEnv *env)
+{
+    int err = 0;
+    FILE *const log = env->log;
+
+    VmafContext *vmaf = NULL;
+    VmafContext *lane[CLI_SETTINGS_STATIC_ARRAY_LEN] = { NULL };
+    unsigned lane_cnt = 0;
+    VmafModel *model[CLI_SETTINGS_STATIC_ARRAY_LEN] = { NULL };
+    VmafModelCollection *model_collection[CLI_SETTINGS_STATIC_ARRAY_LEN] =
+        { NULL };
+    bool model_owned[CLI_SETTINGS_STATIC_ARRAY_LEN] = { false };
+    ProgressStream progress = { 0 };
+
+    video_input vid_ref, vid_dist[CLI_SETTINGS_STATIC_ARRAY_LEN];
+    unsigned dist_open_cnt = 0;
+    if (open_input(&vid_ref, c->path_ref, c, log)) {
+        fprintf(log, "problem with reference file: %s\n", c->path_ref);
         return -1;
     }
 
+    for (unsigned i = 0; i < c->dist_cnt; i++) {
+        if (open_input(&vid_dist[i], c->path_dist[i], c, log)) {
+            fprintf(log, "problem with distorted file: %s\n", c->path_dist[i]);
+            err = -1;
+            goto close_inputs;
+        }
+        dist_open_cnt++;
+
+        err = validate_videos(&vid_ref, &vid_dist[i], c->common_bitdepth, log);
+        if (err) {
+            fprintf(log, "videos are incompatible, %d %s.\n",
+                    err, err == 1 ? "problem" : "problems");
+            err = -1;
+            goto close_inputs;
+        }
+    }
+
     int common_bitdepth;
-    if (c.use_yuv) {
-        common_bitdepth = c.bitdepth;
+    if (c->use_yuv) {
+        common_bitdepth = c->bitdepth;
     } else {
         video_input_info info1, info2;
         video_input_get_info(&vid_ref, &info1);
-        video_input_get_info(&vid_dist, &info2);
-        common_bitdepth = info1.depth > info2.depth ? info1.depth : info2.depth;
+        common_bitdepth = info1.depth;
+        for (unsigned i = 0; i < c->dist_cnt; i++) {
+            video_input_get_info(&vid_dist[i], &info2);
+            if (info2.depth > common_bitdepth)
+                common_bitdepth = info2.depth;
+        }
     }
 
     VmafConfiguration cfg = {
         .log_level = VMAF_LOG_LEVEL_INFO,
-        .n_threads = c.thread_cnt,
-        .n_subsample = c.subsample,
-        .cpumask = c.cpumask,
-        .gpumask = c.gpumask,
+        .n_threads = c->thread_cnt,
+        .thread_affinity = c->thread_affinity,
+        .n_subsample = c->subsample,
+        .subsample_threshold = c->subsample_threshold,
+        .cpumask = c->cpumask,
+        .gpumask = c->gpumask,
     };
 
-    VmafContext *vmaf;
-    err = vmaf_init(&vmaf, cfg);
+    err = env->threads ? vmaf_init_shared_threads(&vmaf, cfg, env->threads) :
+                         vmaf_init(&vmaf, cfg);
     if (err) {
-        fprintf(stderr, "problem initializing VMAF context\n");
-        return -1;
+        fprintf(log, "problem initializing VMAF context\n");
+        vmaf = NULL;
+        err = -1;
+        goto close_inputs;
     }
 
 #ifdef HAVE_CUDA
@@ -252,253 +414,327 @@ int main(int argc, char *argv[])
     err = vmaf_cuda_state_init(&cu_state, cuda_cfg);
     err |= vmaf_cuda_import_state(vmaf, cu_state);
     if (err) {
-        fprintf(stderr, "problem during vmaf_cuda_state_init\n");
-        return -1;
+        fprintf(log, "problem during vmaf_cuda_state_init\n");
+        err = -1;
+        goto close_contexts;
     }
 #endif
 
-    VmafModel **model;
-    const size_t model_sz = sizeof(*model) * c.model_cnt;
-    model = malloc(model_sz);
-    memset(model, 0, model_sz);
-
-    VmafModelCollection **model_collection;
-    const size_t model_collection_sz =
-        sizeof(*model_collection) * c.model_cnt;
-    model_collection = malloc(model_sz);
-    memset(model_collection, 0, model_collection_sz);
-
-    const char *model_collection_label[c.model_cnt];
-    unsigned model_collection_cnt = 0;
-
-    for (unsigned i = 0; i < c.model_cnt; i++) {
-        if (c.model_config[i].version) {
-            err = vmaf_model_load(&model[i], &c.model_config[i].cfg,
-                                  c.model_config[i].version);
-        } else {
-            err = vmaf_model_load_from_path(&model[i], &c.model_config[i].cfg,
-                                            c.model_config[i].path);
+    for (unsigned i = 0; i < c->model_cnt; i++) {
+        CLIModelConfig *m = &c->model_config[i];
+        if (!model_cache_get(env->models, m, &model[i], &model_collection[i])) {
+            err = load_model(m, &model[i], &model_collection[i], log);
+            if (err) goto free_models;
+            model_owned[i] = !model_cache_put(env->models, m, model[i],
+                                              model_collection[i]);
         }
 
-        if (err) {
-            // check for model_collection before failing
-            // this is implicit because the `--model` option could take either
-            // a model or model_collection
-            if (c.model_config[i].version) {
-                err = vmaf_model_collection_load(&model[i],
-                                        &model_collection[model_collection_cnt],
-                                        &c.model_config[i].cfg,
-                                        c.model_config[i].version);
-            } else {
-                err = vmaf_model_collection_load_from_path(&model[i],
-                                        &model_collection[model_collection_cnt],
-                                        &c.model_config[i].cfg,
-                                        c.model_config[i].path);
+        if (model_collection[i]) {
+            err = vmaf_use_features_from_model_collection(vmaf,
+                                                          model_collection[i]);
+            if (err) {
+                fprintf(log, "problem loading feature extractors from "
+                        "model collection: %s\n", model_label(m));
+                err = -1;
+                goto free_models;
             }
-
+        } else {
+            err = vmaf_use_features_from_model(vmaf, model[i]);
             if (err) {
-                fprintf(stderr, "problem loading model: %s\n",
-                        c.model_config[i].version ?
-                            c.model_config[i].version : c.model_config[i].path);
-                return -1;
+                fprintf(log, "problem loading feature extractors from "
+                        "model: %s\n", model_label(m));
+                err = -1;
+                goto free_models;
             }
+        }
+    }
 
-            model_collection_label[model_collection_cnt] =
-                c.model_config[i].version ?
-                    c.model_config[i].version : c.model_config[i].path;
+    for (unsigned i = 0; i < c->feature_cnt; i++) {
+        err = vmaf_use_feature(vmaf, c->feature_cfg[i].name,
+                               c->feature_cfg[i].opts_dict);
+        if (err) {
+            fprintf(log, "problem loading feature extractor: %s\n",
+                    c->feature_cfg[i].name);
+            err = -1;
+            goto free_models;
+        }
+    }
 
-            for (unsigned j = 0; j < c.model_config[i].overload_cnt; j++) {
-                err = vmaf_model_collection_feature_overload(
-                               model[i],
-                               &model_collection[model_collection_cnt],
-                               c.model_config[i].feature_overload[j].name,
-                               c.model_config[i].feature_overload[j].opts_dict);
-                if (err) {
-                    fprintf(stderr,
-                            "problem overloading feature extractors from "
-                            "model collection: %s\n",
-                            c.model_config[i].version ?
-                            c.model_config[i].version : c.model_config[i].path);
-                    return -1;
-                }
-            }
+    for (unsigned i = 0; i < c->pool_cnt; i++) {
+        err = vmaf_use_pooling(vmaf, c->pool_cfg[i]);
+        if (err) {
+            fprintf(log, "problem adding pooling method\n");
+            err = -1;
+            goto free_models;
+        }
+    }
 
-            err = vmaf_use_features_from_model_collection(vmaf,
-                                        model_collection[model_collection_cnt]);
-            if (err) {
-                fprintf(stderr,
-                        "problem loading feature extractors from "
-                        "model collection: %s\n",
-                        c.model_config[i].version ?
-                            c.model_config[i].version : c.model_config[i].path);
-                return -1;
-            }
+    video_input_info info;
+    video_input_get_info(&vid_ref, &info);
+    // after registration, so that chroma is dropped for luma-only features
+    VmafPictureConfiguration pic_cfg = {
+        .pic_params = {
+            .w = info.pic_w,
+            .h = info.pic_h,
+            .bpc = common_bitdepth,
+            .pix_fmt = pix_fmt_map(info.pixel_fmt),
+        },
+        .pic_cnt = 4,
+    };
+    err = vmaf_preallocate_pictures(vmaf, pic_cfg);
+    if (err) {
+        fprintf(log, "problem during vmaf_preallocate_pictures\n");
+        err = -1;
+        goto free_models;
+    }
 
-            model_collection_cnt++;
-            continue;
+    // further distorted inputs are scored by lanes, which share the reference
+    // pictures, reference-only features, models and threads of the first
+    lane[lane_cnt++] = vmaf;
+    for (unsigned i = 1; i < c->dist_cnt; i++) {
+        err = vmaf_init_lane(&lane[i], vmaf);
+        if (err) {
+            fprintf(log, "problem initializing VMAF context\n");
+            err = -1;
+            goto free_models;
         }
+        lane_cnt++;
+    }
 
-        for (unsigned j = 0; j < c.model_config[i].overload_cnt; j++) {
-            err = vmaf_model_feature_overload(model[i],
-                               c.model_config[i].feature_overload[j].name,
-                               c.model_config[i].feature_overload[j].opts_dict);
-            if (err) {
-                fprintf(stderr,
-                        "problem overloading feature extractors from "
-                        "model: %s\n",
-                        c.model_config[i].version ?
-                            c.model_config[i].version : c.model_config[i].path);
-                return -1;
+    unsigned frame_cnt = c->frame_cnt;
+    if (c->frame_range.end) {
+        const unsigned range_cnt = c->frame_range.end - c->frame_range.start;
+        if (!frame_cnt || range_cnt < frame_cnt)
+            frame_cnt = range_cnt;
+    }
 
+    // a frame range is scored with its original picture indices, so that the
+    // partial results of several ranges can be merged. temporal features are
+    // warmed up on the frames just before the range, and see one frame past
+    // the range, exactly as they would in a single run over the whole title.
+    const unsigned index_low = c->frame_range.start;
+    unsigned warmup = 0, lookahead = 0;
+    if (c->frame_range.end) {
+        warmup = c->warmup < index_low ? c->warmup : index_low;
+        lookahead = c->warmup ? 1 : 0;
+        for (unsigned i = 0; i < c->dist_cnt; i++) {
+            err = vmaf_set_score_window(lane[i], index_low,
+                                        index_low + frame_cnt - 1);
+            if (err) {
+                fprintf(log, "problem setting frame range\n");
+                err = -1;
+                goto free_models;
             }
         }
+    }
+    const unsigned index_first = index_low - warmup;
 
-        err = vmaf_use_features_from_model(vmaf, model[i]);
-        if (err) {
-            fprintf(stderr,
-                    "problem loading feature extractors from model: %s\n",
-                     c.model_config[i].version ?
-                         c.model_config[i].version : c.model_config[i].path);
-            return -1;
-        }
+    // inputs start out at frame 0, so pipes work unless frames are skipped
+    const uint64_t seek_ref = (uint64_t) c->frame_skip_ref + index_first;
+    err = seek_ref ? video_input_seek_frame(&vid_ref, seek_ref) : 0;
+    if (err) {
+        fprintf(log, "problem seeking in reference file: %s\n", c->path_ref);
+        err = -1;
+        goto free_models;
     }
 
-    for (unsigned i = 0; i < c.feature_cnt; i++) {
-        err = vmaf_use_feature(vmaf, c.feature_cfg[i].name,
-                               c.feature_cfg[i].opts_dict);
+    const uint64_t seek_dist = (uint64_t) c->frame_skip_dist + index_first;
+    for (unsigned i = 0; i < c->dist_cnt; i++) {
+        err = seek_dist ? video_input_seek_frame(&vid_dist[i], seek_dist) : 0;
         if (err) {
-            fprintf(stderr, "problem loading feature extractor: %s\n",
-                    c.feature_cfg[i].name);
-            return -1;
+            fprintf(log, "problem seeking in distorted file: %s\n",
+                    c->path_dist[i]);
+            err = -1;
+            goto free_models;
         }
     }
 
-    VmafPicture pic_ref, pic_dist;
-
-    for (unsigned i = 0; i < c.frame_skip_ref; i++)
-        fetch_picture(&vid_ref, &pic_ref, common_bitdepth);
-
-    for (unsigned i = 0; i < c.frame_skip_dist; i++)
-        fetch_picture(&vid_dist, &pic_dist, common_bitdepth);
+    err = progress_stream_open(&progress, c->progress_fd, c->progress_interval);
+    if (err) {
+        fprintf(log, "problem opening progress fd: %d\n", c->progress_fd);
+        err = -1;
+        goto free_models;
+    }
 
     float fps = 0.;
-    const time_t t0 = clock();
+    const double t0 = monotonic_seconds();
     unsigned picture_index;
-    for (picture_index = 0 ;; picture_index++) {
-
-        if (c.frame_cnt && picture_index >= c.frame_cnt)
-            break;
+    for (picture_index = index_first ;; picture_index++) {
 
-        VmafPicture pic_ref, pic_dist;
-        int ret1 = fetch_picture(&vid_ref, &pic_ref, common_bitdepth);
-        int ret2 = fetch_picture(&vid_dist, &pic_dist, common_bitdepth);
-
-        if (ret1 && ret2) {
-            break;
-        } else if (ret1 < 0 || ret2 < 0) {
-            fprintf(stderr, "\nproblem while reading pictures\n");
-            break;
-        } else if (ret1) {
-            fprintf(stderr, "\n\"%s\" ended before \"%s\".\n",
-                    c.path_ref, c.path_dist);
-            int err = vmaf_picture_unref(&pic_dist);
-            if (err)
-                fprintf(stderr, "\nproblem during vmaf_picture_unref\n");
+        if (frame_cnt && picture_index >= index_low + frame_cnt + lookahead)
             break;
-        } else if (ret2) {
-            fprintf(stderr, "\n\"%s\" ended before \"%s\".\n",
-                    c.path_dist, c.path_ref);
-            int err = vmaf_picture_unref(&pic_ref);
-            if (err)
-                fprintf(stderr, "\nproblem during vmaf_picture_unref\n");
-            break;
-        }
 
-        if (istty && !c.quiet) {
-            if (picture_index > 0 && !(picture_index % 10)) {
-                fps = (picture_index + 1) /
-                      (((float)clock() - t0) / CLOCKS_PER_SEC);
+        VmafPicture pic_ref, pic_dist[CLI_SETTINGS_STATIC_ARRAY_LEN];
+        const double fetch_t0 = monotonic_seconds();
+        int ret = fetch_pictures(vmaf, c, common_bitdepth,
+                                 &vid_ref, &pic_ref, vid_dist, pic_dist, log);
+        progress.fetch += monotonic_seconds() - fetch_t0;
+        if (ret) break;
+
+        if (env->meter) {
+            const unsigned n = picture_index - index_first;
+            if (n > 0 && !(n % 10)) {
+                fps = (n + 1) / (monotonic_seconds() - t0);
             }
 
-            fprintf(stderr, "\r%d frame%s %s %.2f FPS\033[K",
-                    picture_index + 1, picture_index ? "s" : " ",
-                    spinner[picture_index % spinner_length], fps);
-            fflush(stderr);
+            fprintf(log, "\r%d frame%s %s %.2f FPS\033[K",
+                    n + 1, n ? "s" : " ",
+                    spinner[n % spinner_length], fps);
+            fflush(log);
         }
 
-        err = vmaf_read_pictures(vmaf, &pic_ref, &pic_dist, picture_index);
+        for (unsigned i = 0; i < c->dist_cnt; i++) {
+            VmafPicture pic_ref_lane = pic_ref;
+            if (i + 1 < c->dist_cnt)
+                vmaf_picture_ref(&pic_ref_lane, &pic_ref);
+            err = vmaf_read_pictures(lane[i], &pic_ref_lane, &pic_dist[i],
+                                     picture_index);
+            if (!err) continue;
+            // the lanes after this one never got their pictures
+            if (i + 1 < c->dist_cnt)
+                vmaf_picture_unref(&pic_ref);
+            for (unsigned j = i + 1; j < c->dist_cnt; j++)
+                vmaf_picture_unref(&pic_dist[j]);
+            break;
+        }
         if (err) {
-            fprintf(stderr, "\nproblem reading pictures\n");
+            fprintf(log, "\nproblem reading pictures\n");
             break;
         }
+        progress_stream_write(&progress, vmaf, false);
     }
-    if (istty && !c.quiet)
-        fprintf(stderr, "\n");
+    if (env->meter)
+        fprintf(log, "\n");
 
-    err |= vmaf_read_pictures(vmaf, NULL, NULL, 0);
+    // the lead flushes first, since it extracts the features it shares
+    for (unsigned i = 0; i < c->dist_cnt; i++)
+        err |= vmaf_read_pictures(lane[i], NULL, NULL, 0);
     if (err) {
-        fprintf(stderr, "problem flushing context\n");
-        return err;
+        fprintf(log, "problem flushing context\n");
+        goto close_progress;
     }
 
-    if (!c.no_prediction) {
-        for (unsigned i = 0; i < c.model_cnt; i++) {
-            double vmaf_score;
-            err = vmaf_score_pooled(vmaf, model[i], VMAF_POOL_METHOD_MEAN,
-                                    &vmaf_score, 0, picture_index - 1);
-            if (err) {
-                fprintf(stderr, "problem generating pooled VMAF score\n");
-                return -1;
-            }
+    unsigned index_high = picture_index - 1;
+    if (frame_cnt && index_high > index_low + frame_cnt - 1)
+        index_high = index_low + frame_cnt - 1;
+
+    const bool print_scores = env->istty && (!c->quiet || !c->output_cnt);
+    const double predict_t0 = monotonic_seconds();
+    for (unsigned d = 0; d < c->dist_cnt; d++) {
+        if (env->istty && c->dist_cnt > 1 && (!c->quiet || !c->output_cnt))
+            fprintf(log, "%s\n", c->path_dist[d]);
+
+        if (!c->no_prediction) {
+            for (unsigned i = 0; i < c->model_cnt; i++) {
+                double vmaf_score;
+                err = vmaf_score_pooled(lane[d], model[i],
+                                        VMAF_POOL_METHOD_MEAN, &vmaf_score,
+                                        index_low, index_high);
+                if (err) {
+                    fprintf(log, "problem generating pooled VMAF score\n");
+                    err = -1;
+                    goto close_progress;
+                }
 
-            if (istty && (!c.quiet || !c.output_path)) {
-                fprintf(stderr, "%s: %f\n",
-                        c.model_config[i].version ?
-                            c.model_config[i].version : c.model_config[i].path,
-                        vmaf_score);
+                if (print_scores) {
+                    fprintf(log, "%s: %f\n", model_label(&c->model_config[i]),
+                            vmaf_score);
+                }
             }
-        }
 
-        for (unsigned i = 0; i < model_collection_cnt; i++) {
-            VmafModelCollectionScore score = { 0 };
-            err = vmaf_score_pooled_model_collection(vmaf, model_collection[i],
-                                                     VMAF_POOL_METHOD_MEAN, &score,
-                                                     0, picture_index - 1);
-            if (err) {
-                fprintf(stderr, "problem generating pooled VMAF score\n");
-                return -1;
-            }
+            for (unsigned i = 0; i < c->model_cnt; i++) {
+                if (!model_collection[i]) continue;
+                VmafModelCollectionScore score = { 0 };
+                err = vmaf_score_pooled_model_collection(lane[d],
+                                                model_collection[i],
+                                                VMAF_POOL_METHOD_MEAN, &score,
+                                                index_low, index_high);
+                if (err) {
+                    fprintf(log, "problem generating pooled VMAF score\n");
+                    err = -1;
+                    goto close_progress;
+                }
 
-            switch (score.type) {
-            case VMAF_MODEL_COLLECTION_SCORE_BOOTSTRAP:
-                if (istty && (!c.quiet || !c.output_path)) {
-                    fprintf(stderr, "%s: %f, ci.p95: [%f, %f], stddev: %f\n",
-                            model_collection_label[i],
-                            score.bootstrap.bagging_score, score.bootstrap.ci.p95.lo,
-                            score.bootstrap.ci.p95.hi,
-                            score.bootstrap.stddev);
+                switch (score.type) {
+                case VMAF_MODEL_COLLECTION_SCORE_BOOTSTRAP:
+                    if (print_scores) {
+                        fprintf(log, "%s: %f, ci.p95: [%f, %f], stddev: %f\n",
+                                model_label(&c->model_config[i]),
+                                score.bootstrap.bagging_score, score.bootstrap.ci.p95.lo,
+                                score.bootstrap.ci.p95.hi,
+                                score.bootstrap.stddev);
+                    }
+                    break;
+                default:
+                    break;
                 }
-                break;
-            default:
-                break;
             }
         }
+
+        if (c->output_cnt)
+            vmaf_write_output(lane[d], c->output_path[d], c->output_fmt);
     }
 
-    if (c.output_path)
-        vmaf_write_output(vmaf, c.output_path, c.output_fmt);
+    if (c->state_path) {
+        err = vmaf_write_partial_results(vmaf, c->state_path);
+        if (err)
+            fprintf(log, "problem writing partial results: %s\n",
+                    c->state_path);
+    }
 
-    for (unsigned i = 0; i < c.model_cnt; i++)
-        vmaf_model_destroy(model[i]);
-    free(model);
+    progress.predict = monotonic_seconds() - predict_t0;
+    progress_stream_write(&progress, vmaf, true);
 
-    for (unsigned i = 0; i < model_collection_cnt; i++)
+close_progress:
+    progress_stream_close(&progress);
+free_models:
+    for (unsigned i = 0; i < c->model_cnt; i++) {
+        if (!model_owned[i]) continue;
+        vmaf_model_destroy(model[i]);
         vmaf_model_collection_destroy(model_collection[i]);
-    free(model_collection);
-
+    }
+#ifdef HAVE_CUDA
+close_contexts:
+#endif
+    // lanes before their lead
+    if (!lane_cnt && vmaf)
+        vmaf_close(vmaf);
+    for (unsigned i = lane_cnt; i-- > 0;)
+        vmaf_close(lane[i]);
+close_inputs:
     video_input_close(&vid_ref);
-    video_input_close(&vid_dist);
-    vmaf_close(vmaf);
+    for (unsigned i = 0; i < dist_open_cnt; i++)
+        video_input_close(&vid_dist[i]);
+    return err;
+}
+
+int main(int argc, char *argv[])
+{
+    int err = 0;
+    const int istty = isatty(fileno(stderr));
+
+    CLISettings c;
+    cli_parse(argc, argv, &c);
+
+    if (istty && !c.quiet) {
+        fprintf(stderr, "VMAF version %s\n", vmaf_version());
+    }
+
+    if (c.merge) {
+        err = merge_partial_results(&c);
+    } else if (c.serve_path) {
+        err = serve(&c);
+    } else if (c.client_path) {
+        err = client(&c, argc, argv, istty);
+    } else {
+        const ScoreEnv env = {
+            .log = stderr,
+            .istty = istty,
+            .meter = istty && !c.quiet,
+        };
+        err = score(&c, &env);
+    }
+
     cli_free(&c);
     return err;
 }
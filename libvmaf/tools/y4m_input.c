@@ -23,8 +23,14 @@ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.*/
 
 #include "vidinput.h"
+#include <errno.h>
 #include <stdlib.h>
 #include <string.h>
+#if defined(__SSE2__)
+# include <emmintrin.h>
+#endif
+
+#include "libvmaf/picture.h"
 
 typedef struct y4m_input y4m_input;
 
@@ -73,8 +79,55 @@ struct y4m_input{
   y4m_convert_func  convert;
   unsigned char    *dst_buf;
   unsigned char    *aux_buf;
+  /*The file offsets of the FRAME headers seen so far.
+    Frame headers may carry parameters, so frames are not a fixed size and
+     the offsets have to be discovered by scanning.*/
+  int64_t          *frame_offsets;
+  size_t            nframe_offsets;
+  size_t            cframe_offsets;
+  /*The index of the next frame to be read.*/
+  uint64_t          cur_frame;
 };
 
+static int y4m_push_frame_offset(y4m_input *_y4m,int64_t _offset){
+  if(_y4m->nframe_offsets>=_y4m->cframe_offsets){
+    size_t   cframe_offsets;
+    int64_t *frame_offsets;
+    cframe_offsets=_y4m->cframe_offsets?2*_y4m->cframe_offsets:1024;
+    frame_offsets=(int64_t *)realloc(_y4m->frame_offsets,
+     cframe_offsets*sizeof(*frame_offsets));
+    if(frame_offsets==NULL)return -1;
+    _y4m->frame_offsets=frame_offsets;
+    _y4m->cframe_offsets=cframe_offsets;
+  }
+  _y4m->frame_offsets[_y4m->nframe_offsets++]=_offset;
+  return 0;
+}
+
+/*Reads and checks a FRAME header, including any frame parameters.
+  Return: 1 on success, 0 at the end of the stream, or a negative value on
+   error.*/
+static int y4m_read_frame_header(FILE *_fin){
+  char frame[6];
+  char params[80];
+  int  ret;
+  ret=fread(frame,1,6,_fin);
+  if(ret<6)return 0;
+  if(memcmp(frame,"FRAME",5)){
+    fprintf(stderr,"Loss of framing in YUV input data\n");
+    return -1;
+  }
+  if(frame[5]!='\n'){
+    /*Frame parameters are skipped, up to 78 of them plus the newline.*/
+    if(fgets(params,sizeof(params),_fin)!=NULL&&
+     strlen(params)==sizeof(params)-1&&params[sizeof(params)-2]!='\n'){
+      fprintf(stderr,"Error parsing YUV frame header\n");
+      return -1;
+    }
+  }
+  return 1;
+}
+
 static int y4m_parse_tags(y4m_input *_y4m,char *_tags){
   int   got_w;
   int   got_h;
@@ -194,14 +247,71 @@ static int y4m_parse_tags(y4m_input *_y4m,char *_tags){
    the chroma plane's resolution) to the right.
   The 4:2:2 modes look exactly the same, except there are twice as many chroma
    lines, and they are vertically co-sited with the luma samples in both the
-   mpeg2 and jpeg cases (thus requiring no vertical resampling).*/
+   mpeg2 and jpeg cases (thus requiring no vertical resampling).
+  This resamples one row of _c_w chroma samples.
+  Filter: [4 -17 114 35 -9 1]/128, derived from a 6-tap Lanczos window.*/
+static void y4m_42xmpeg2_42xjpeg_row(unsigned char *_dst,
+ const unsigned char *_aux,int _c_w){
+  int x;
+  for(x=0;x<OC_MINI(_c_w,2);x++){
+    _dst[x]=(unsigned char)OC_CLAMPI(0,(4*_aux[0]-17*_aux[OC_MAXI(x-1,0)]+
+     114*_aux[x]+35*_aux[OC_MINI(x+1,_c_w-1)]-9*_aux[OC_MINI(x+2,_c_w-1)]+
+     _aux[OC_MINI(x+3,_c_w-1)]+64)>>7,255);
+  }
+#if defined(__SSE2__)
+  /*The positive taps sum to at most 154*255+64, which fits in 16 unsigned
+     bits, and the negative taps are subtracted with unsigned saturation.
+    That clamps at 0, and the final pack clamps at 255, so the result is
+     bit-exact with the C loop below.*/
+  {
+    const __m128i zero=_mm_setzero_si128();
+    const __m128i c4=_mm_set1_epi16(4);
+    const __m128i c17=_mm_set1_epi16(17);
+    const __m128i c114=_mm_set1_epi16(114);
+    const __m128i c35=_mm_set1_epi16(35);
+    const __m128i c9=_mm_set1_epi16(9);
+    const __m128i c64=_mm_set1_epi16(64);
+    for(;x+8<=_c_w-3;x+=8){
+      __m128i a0=_mm_unpacklo_epi8(
+       _mm_loadl_epi64((const __m128i *)(_aux+x-2)),zero);
+      __m128i a1=_mm_unpacklo_epi8(
+       _mm_loadl_epi64((const __m128i *)(_aux+x-1)),zero);
+      __m128i a2=_mm_unpacklo_epi8(
+       _mm_loadl_epi64((const __m128i *)(_aux+x)),zero);
+      __m128i a3=_mm_unpacklo_epi8(
+       _mm_loadl_epi64((const __m128i *)(_aux+x+1)),zero);
+      __m128i a4=_mm_unpacklo_epi8(
+       _mm_loadl_epi64((const __m128i *)(_aux+x+2)),zero);
+      __m128i a5=_mm_unpacklo_epi8(
+       _mm_loadl_epi64((const __m128i *)(_aux+x+3)),zero);
+      __m128i pos=_mm_add_epi16(_mm_mullo_epi16(a0,c4),
+       _mm_mullo_epi16(a2,c114));
+      __m128i neg=_mm_add_epi16(_mm_mullo_epi16(a1,c17),
+       _mm_mullo_epi16(a4,c9));
+      pos=_mm_add_epi16(pos,_mm_mullo_epi16(a3,c35));
+      pos=_mm_add_epi16(pos,_mm_add_epi16(a5,c64));
+      pos=_mm_srli_epi16(_mm_subs_epu16(pos,neg),7);
+      _mm_storel_epi64((__m128i *)(_dst+x),_mm_packus_epi16(pos,pos));
+    }
+  }
+#endif
+  for(;x<_c_w-3;x++){
+    _dst[x]=(unsigned char)OC_CLAMPI(0,(4*_aux[x-2]-17*_aux[x-1]+
+     114*_aux[x]+35*_aux[x+1]-9*_aux[x+2]+_aux[x+3]+64)>>7,255);
+  }
+  for(;x<_c_w;x++){
+    _dst[x]=(unsigned char)OC_CLAMPI(0,(4*_aux[x-2]-17*_aux[x-1]+
+     114*_aux[x]+35*_aux[OC_MINI(x+1,_c_w-1)]-9*_aux[OC_MINI(x+2,_c_w-1)]+
+     _aux[_c_w-1]+64)>>7,255);
+  }
+}
+
 static void y4m_convert_42xmpeg2_42xjpeg(y4m_input *_y4m,unsigned char *_dst,
  unsigned char *_aux){
   int c_w;
   int c_h;
   int pli;
   int y;
-  int x;
   /*Skip past the luma data.*/
   _dst+=_y4m->pic_w*_y4m->pic_h;
   /*Compute the size of each chroma plane.*/
@@ -209,22 +319,7 @@ static void y4m_convert_42xmpeg2_42xjpeg(y4m_input *_y4m,unsigned char *_dst,
   c_h=(_y4m->pic_h+_y4m->dst_c_dec_v-1)/_y4m->dst_c_dec_v;
   for(pli=1;pli<3;pli++){
     for(y=0;y<c_h;y++){
-      /*Filter: [4 -17 114 35 -9 1]/128, derived from a 6-tap Lanczos
-         window.*/
-      for(x=0;x<OC_MINI(c_w,2);x++){
-        _dst[x]=(unsigned char)OC_CLAMPI(0,(4*_aux[0]-17*_aux[OC_MAXI(x-1,0)]+
-         114*_aux[x]+35*_aux[OC_MINI(x+1,c_w-1)]-9*_aux[OC_MINI(x+2,c_w-1)]+
-         _aux[OC_MINI(x+3,c_w-1)]+64)>>7,255);
-      }
-      for(;x<c_w-3;x++){
-        _dst[x]=(unsigned char)OC_CLAMPI(0,(4*_aux[x-2]-17*_aux[x-1]+
-         114*_aux[x]+35*_aux[x+1]-9*_aux[x+2]+_aux[x+3]+64)>>7,255);
-      }
-      for(;x<c_w;x++){
-        _dst[x]=(unsigned char)OC_CLAMPI(0,(4*_aux[x-2]-17*_aux[x-1]+
-         114*_aux[x]+35*_aux[OC_MINI(x+1,c_w-1)]-9*_aux[OC_MINI(x+2,c_w-1)]+
-         _aux[c_w-1]+64)>>7,255);
-      }
+      y4m_42xmpeg2_42xjpeg_row(_dst,_aux,c_w);
       _dst+=c_w;
       _aux+=c_w;
     }
@@ -564,12 +659,10 @@ static int y4m_input_open_impl(y4m_input *_y4m,FILE *_fin){
   int  i;
   int  xstride;
   /*Read until newline, or Y4M_HEADER_BUFSIZE cols, whichever happens first.*/
-  for(i=0;i<Y4M_HEADER_BUFSIZE-1;i++){
-    ret=fread(buffer+i,1,1,_fin);
-    if(ret<1)return -1;
-    if(buffer[i]=='\n')break;
-  }
-  buffer[i]='\0';
+  if(fgets(buffer,Y4M_HEADER_BUFSIZE,_fin)==NULL)return -1;
+  i=strlen(buffer);
+  if(i>0&&buffer[i-1]=='\n')buffer[--i]='\0';
+  else if(i<Y4M_HEADER_BUFSIZE-1)return -1;
   if(memcmp(buffer,"YUV4MPEG",8)){
     fprintf(stderr,"Incomplete magic for YUV4MPEG file.\n");
     return -1;
@@ -701,6 +794,14 @@ static int y4m_input_open_impl(y4m_input *_y4m,FILE *_fin){
   _y4m->pic_y=(_y4m->frame_h-_y4m->pic_h)>>1&~1;
   _y4m->dst_buf=(unsigned char *)malloc(_y4m->dst_buf_sz);
   _y4m->aux_buf=_y4m->aux_buf_sz?(unsigned char *)malloc(_y4m->aux_buf_sz):NULL;
+  /*The first frame starts right after the stream header.*/
+  _y4m->frame_offsets=NULL;
+  _y4m->nframe_offsets=_y4m->cframe_offsets=0;
+  _y4m->cur_frame=0;
+  if(y4m_push_frame_offset(_y4m,ftello(_fin))<0){
+    fprintf(stderr,"Could not allocate y4m frame index.\n");
+    return -1;
+  }
   return 0;
 }
 
@@ -734,9 +835,140 @@ static void y4m_input_get_info(y4m_input *_y4m,video_input_info *_info){
   _info->depth=_y4m->depth;
 }
 
+/*Remembers where the next frame starts, if we have not seen it yet.*/
+static int y4m_frame_done(y4m_input *_y4m,FILE *_fin){
+  if(++_y4m->cur_frame==_y4m->nframe_offsets){
+    if(y4m_push_frame_offset(_y4m,ftello(_fin))<0){
+      fprintf(stderr,"Could not allocate y4m frame index.\n");
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/*Skips _sz bytes of input, reading through them when the input is a pipe.*/
+static int y4m_skip(y4m_input *_y4m,FILE *_fin,size_t _sz){
+  if(!_sz||!fseeko(_fin,_sz,SEEK_CUR))return 0;
+  while(_sz>0){
+    size_t n;
+    n=OC_MINI(_sz,_y4m->dst_buf_sz);
+    if(fread(_y4m->dst_buf,1,n,_fin)!=n)return -1;
+    _sz-=n;
+  }
+  return 0;
+}
+
+/*Reads a _w by _h plane of input samples into _dst, widening them to
+   _dst_depth bits.
+  Samples are read straight into _dst when no widening is needed, in a
+   single read when the rows are contiguous.
+  Otherwise each row goes through dst_buf, where it stays in cache.
+  A plane with no destination is skipped.*/
+static int y4m_read_plane(y4m_input *_y4m,FILE *_fin,
+ const struct video_input_plane *_dst,int _dst_depth,int _w,int _h){
+  unsigned char *row;
+  int            depth;
+  unsigned char *dst;
+  size_t         row_sz;
+  int            y;
+  depth=_y4m->depth;
+  row=_y4m->dst_buf;
+  row_sz=(size_t)_w*(depth>8?2:1);
+  if(_dst->data==NULL)return y4m_skip(_y4m,_fin,row_sz*_h);
+  dst=_dst->data;
+  if(_dst_depth==depth){
+    if(_dst->stride==row_sz){
+      return fread(dst,1,row_sz*_h,_fin)==row_sz*_h?0:-1;
+    }
+    for(y=0;y<_h;y++){
+      if(fread(dst,1,row_sz,_fin)!=row_sz)return -1;
+      dst+=_dst->stride;
+    }
+    return 0;
+  }
+  for(y=0;y<_h;y++){
+    if(fread(row,1,row_sz,_fin)!=row_sz)return -1;
+    if(vmaf_picture_copy_plane(dst,_dst->stride,_dst_depth,
+     row,row_sz,depth,_w,1)<0){
+      return -1;
+    }
+    dst+=_dst->stride;
+  }
+  return 0;
+}
+
+static int y4m_input_fetch_frame_into(y4m_input *_y4m,FILE *_fin,
+ video_input_ycbcr _dst,int _dst_depth){
+  int c_w;
+  int c_h;
+  int pli;
+  int ret;
+  /*Only frames that are stored as they are output, or whose chroma is just
+     resited row by row, are read without going through dst_buf.*/
+  if(_y4m->convert!=y4m_convert_null&&
+   _y4m->convert!=y4m_convert_42xmpeg2_42xjpeg){
+    return -EAGAIN;
+  }
+  if(_dst_depth<_y4m->depth)return -EAGAIN;
+  c_w=(_y4m->pic_w+_y4m->dst_c_dec_h-1)/_y4m->dst_c_dec_h;
+  c_h=(_y4m->pic_h+_y4m->dst_c_dec_v-1)/_y4m->dst_c_dec_v;
+  for(pli=0;pli<3;pli++){
+    if(_dst[pli].data==NULL)continue;
+    if(_dst[pli].width!=(uint32_t)(pli?c_w:_y4m->pic_w)||
+     _dst[pli].height!=(uint32_t)(pli?c_h:_y4m->pic_h)){
+      return -EAGAIN;
+    }
+  }
+  ret=y4m_read_frame_header(_fin);
+  if(ret<1)return ret;
+  /*dst_buf is not otherwise used on this path, and holds at least a row.*/
+  if(y4m_read_plane(_y4m,_fin,&_dst[0],_dst_depth,
+   _y4m->pic_w,_y4m->pic_h)<0){
+    goto read_fail;
+  }
+  if(_y4m->convert==y4m_convert_null){
+    for(pli=1;pli<3;pli++){
+      if(y4m_read_plane(_y4m,_fin,&_dst[pli],_dst_depth,c_w,c_h)<0){
+        goto read_fail;
+      }
+    }
+    /*Anything else in the frame (e.g., an alpha plane) is discarded.*/
+    if(y4m_skip(_y4m,_fin,_y4m->aux_buf_read_sz)<0)goto read_fail;
+  }
+  else{
+    const unsigned char *aux;
+    int                  y;
+    if(fread(_y4m->aux_buf,1,_y4m->aux_buf_read_sz,_fin)!=
+     _y4m->aux_buf_read_sz){
+      goto read_fail;
+    }
+    aux=_y4m->aux_buf;
+    for(pli=1;pli<3;pli++){
+      unsigned char *dst;
+      dst=_dst[pli].data;
+      for(y=0;dst!=NULL&&y<c_h;y++){
+        if(_dst_depth==_y4m->depth){
+          y4m_42xmpeg2_42xjpeg_row(dst,aux+y*c_w,c_w);
+        }
+        else{
+          y4m_42xmpeg2_42xjpeg_row(_y4m->dst_buf,aux+y*c_w,c_w);
+          vmaf_picture_copy_plane(dst,_dst[pli].stride,_dst_depth,
+           _y4m->dst_buf,c_w,_y4m->depth,c_w,1);
+        }
+        dst+=_dst[pli].stride;
+      }
+      aux+=c_w*c_h;
+    }
+  }
+  if(y4m_frame_done(_y4m,_fin)<0)return -1;
+  return 1;
+read_fail:
+  fprintf(stderr,"Error reading YUV frame data.\n");
+  return -1;
+}
+
 static int y4m_input_fetch_frame(y4m_input *_y4m,FILE *_fin,
  video_input_ycbcr _ycbcr,char _tag[5]){
-  char frame[6];
   int  pic_sz;
   int  frame_c_w;
   int  frame_c_h;
@@ -753,21 +985,8 @@ static int y4m_input_fetch_frame(y4m_input *_y4m,FILE *_fin,
   c_h=(_y4m->pic_h+_y4m->dst_c_dec_v-1)/_y4m->dst_c_dec_v;
   c_sz=c_w*c_h*xstride;
   /*Read and skip the frame header.*/
-  ret=fread(frame,1,6,_fin);
-  if(ret<6)return 0;
-  if(memcmp(frame,"FRAME",5)){
-    fprintf(stderr,"Loss of framing in YUV input data\n");
-    return -1;
-  }
-  if(frame[5]!='\n'){
-    char c;
-    int  j;
-    for(j=0;j<79&&fread(&c,1,1,_fin)&&c!='\n';j++);
-    if(j==79){
-      fprintf(stderr,"Error parsing YUV frame header\n");
-      return -1;
-    }
-  }
+  ret=y4m_read_frame_header(_fin);
+  if(ret<1)return ret;
   /*Read the frame data that needs no conversion.*/
   if(fread(_y4m->dst_buf,1,_y4m->dst_buf_read_sz,_fin)!=_y4m->dst_buf_read_sz){
     fprintf(stderr,"Error reading YUV frame data.\n");
@@ -778,6 +997,7 @@ static int y4m_input_fetch_frame(y4m_input *_y4m,FILE *_fin,
     fprintf(stderr,"Error reading YUV frame data.\n");
     return -1;
   }
+  if(y4m_frame_done(_y4m,_fin)<0)return -1;
   /*Now convert the just read frame.*/
   (*_y4m->convert)(_y4m,_y4m->dst_buf,_y4m->aux_buf);
   /*Fill in the frame buffer pointers.*/
@@ -798,9 +1018,45 @@ static int y4m_input_fetch_frame(y4m_input *_y4m,FILE *_fin,
   return 1;
 }
 
+static int y4m_input_seek_frame(y4m_input *_y4m,FILE *_fin,uint64_t _frame){
+  size_t frame_sz;
+  /*Jump straight to the closest frame we already know the offset of.*/
+  if(_frame<_y4m->nframe_offsets){
+    if(fseeko(_fin,_y4m->frame_offsets[_frame],SEEK_SET))goto seek_fail;
+    _y4m->cur_frame=_frame;
+    return 0;
+  }
+  if(fseeko(_fin,_y4m->frame_offsets[_y4m->nframe_offsets-1],SEEK_SET)){
+    goto seek_fail;
+  }
+  _y4m->cur_frame=_y4m->nframe_offsets-1;
+  /*Then scan forward, reading only the frame headers and skipping over the
+     fixed-size frame payloads.*/
+  frame_sz=_y4m->dst_buf_read_sz+_y4m->aux_buf_read_sz;
+  while(_y4m->cur_frame<_frame){
+    int ret;
+    ret=y4m_read_frame_header(_fin);
+    /*Seeking past the end is fine; the next fetch reports end of stream.*/
+    if(ret==0)return 0;
+    if(ret<0)return ret;
+    if(fseeko(_fin,frame_sz,SEEK_CUR))goto seek_fail;
+    if(y4m_push_frame_offset(_y4m,ftello(_fin))<0){
+      fprintf(stderr,"Could not allocate y4m frame index.\n");
+      return -1;
+    }
+    _y4m->cur_frame++;
+  }
+  return 0;
+seek_fail:
+  fprintf(stderr,"Error seeking to YUV frame %llu.\n",
+   (unsigned long long)_frame);
+  return -1;
+}
+
 static void y4m_input_close(y4m_input *_y4m){
   free(_y4m->dst_buf);
   free(_y4m->aux_buf);
+  free(_y4m->frame_offsets);
 }
 
 OC_EXTERN const video_input_vtbl Y4M_INPUT_VTBL={
@@ -808,5 +1064,7 @@ OC_EXTERN const video_input_vtbl Y4M_INPUT_VTBL={
   (video_input_open_func)y4m_input_open,
   (video_input_get_info_func)y4m_input_get_info,
   (video_input_fetch_frame_func)y4m_input_fetch_frame,
-  (video_input_close_func)y4m_input_close
+  (video_input_close_func)y4m_input_close,
+  (video_input_seek_frame_func)y4m_input_seek_frame,
+  (video_input_fetch_frame_into_func)y4m_input_fetch_frame_into
 };
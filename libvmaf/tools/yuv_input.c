@@ -1,3 +1,4 @@
+#include <errno.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
@@ -136,6 +137,76 @@ static int yuv_input_fetch_frame(yuv_input *yuv, FILE *fin,
     return 1;
 }
 
+static int yuv_input_fetch_frame_into(yuv_input *yuv, FILE *fin,
+                                      video_input_ycbcr dst, int dst_depth)
+{
+    const unsigned xstride = (yuv->bitdepth>8) ? 2 : 1;
+    const unsigned c_w = (yuv->width+yuv->dst_c_dec_h-1) / yuv->dst_c_dec_h;
+    const unsigned c_h = (yuv->height+yuv->dst_c_dec_v-1) / yuv->dst_c_dec_v;
+
+    if (!dst[0].data || dst_depth < (int) yuv->bitdepth)
+        return -EAGAIN;
+    for (unsigned i = 0; i < 3; i++) {
+        const unsigned w = i ? c_w : yuv->width;
+        const unsigned h = i ? c_h : yuv->height;
+        if (dst[i].data && (dst[i].width != w || dst[i].height != h))
+            return -EAGAIN;
+    }
+
+    for (unsigned i = 0; i < 3; i++) {
+        const unsigned w = i ? c_w : yuv->width;
+        const unsigned h = i ? c_h : yuv->height;
+        const size_t row_sz = (size_t) w * xstride;
+        uint8_t *data = dst[i].data;
+        size_t bytes_read;
+
+        // dropped planes are read through the scratch buffer if not seekable
+        if (!data) {
+            if (!fseeko(fin, row_sz * h, SEEK_CUR)) continue;
+            bytes_read = fread(yuv->dst_buf, 1, row_sz * h, fin);
+            if (bytes_read != row_sz * h) goto read_fail;
+            continue;
+        }
+
+        if (dst_depth == (int) yuv->bitdepth && dst[i].stride == row_sz) {
+            bytes_read = fread(data, 1, row_sz * h, fin);
+            if (bytes_read == 0 && i == 0) return 0;
+            if (bytes_read != row_sz * h) goto read_fail;
+            continue;
+        }
+
+        for (unsigned j = 0; j < h; j++) {
+            const bool widen = dst_depth != (int) yuv->bitdepth;
+            bytes_read = fread(widen ? yuv->dst_buf : data, 1, row_sz, fin);
+            if (bytes_read == 0 && i == 0 && j == 0) return 0;
+            if (bytes_read != row_sz) goto read_fail;
+            if (widen) {
+                vmaf_picture_copy_plane(data, dst[i].stride, dst_depth,
+                                        yuv->dst_buf, row_sz, yuv->bitdepth,
+                                        w, 1);
+            }
+            data += dst[i].stride;
+        }
+    }
+
+    return 1;
+
+read_fail:
+    fprintf(stderr, "Error reading YUV frame data.\n");
+    return -1;
+}
+
+static int yuv_input_seek_frame(yuv_input *yuv, FILE *fin, uint64_t frame)
+{
+    /* Raw frames are fixed size, so the offset can be computed directly. */
+    if (fseeko(fin, frame * yuv->dst_buf_sz, SEEK_SET)) {
+        fprintf(stderr, "Error seeking to YUV frame %llu.\n",
+                (unsigned long long)frame);
+        return -1;
+    }
+    return 0;
+}
+
 static void yuv_input_close(yuv_input *_yuv){
   free(_yuv->dst_buf);
 }
@@ -145,5 +216,7 @@ OC_EXTERN const video_input_vtbl YUV_INPUT_VTBL={
   (video_input_open_func)NULL,
   (video_input_get_info_func)yuv_input_get_info,
   (video_input_fetch_frame_func)yuv_input_fetch_frame,
-  (video_input_close_func)yuv_input_close
+  (video_input_close_func)yuv_input_close,
+  (video_input_seek_frame_func)yuv_input_seek_frame,
+  (video_input_fetch_frame_into_func)yuv_input_fetch_frame_into
 };
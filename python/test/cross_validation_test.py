@@ -256,6 +256,57 @@ class CrossValidationTest(unittest.TestCase):
         self.assertEqual(output['top_model_param'], expected_top_model_param)
         self.assertEqual(output['top_ratio'], expected_top_ratio)
 
+    def test_run_kfold_cross_validation_parallel(self):
+
+        xs = LibsvmNusvrTrainTestModel.get_xs_from_results(self.features)
+
+        for train_test_model_class, model_param in [
+            (SklearnRandomForestTrainTestModel,
+             {'norm_type': 'normalize', 'n_estimators': 10, 'random_state': 0}),
+            (LibsvmNusvrTrainTestModel,
+             {'norm_type': 'normalize'}),
+        ]:
+            output = ModelCrossValidation.run_kfold_cross_validation(
+                train_test_model_class, model_param, self.features, 3)
+
+            for processes in [1, 3]:
+                output_ = ModelCrossValidation.run_kfold_cross_validation(
+                    train_test_model_class, model_param, self.features, 3,
+                    processes=processes)
+
+                for key in ['SRCC', 'PCC', 'KENDALL', 'RMSE']:
+                    self.assertEqual(output_['aggr_stats'][key], output['aggr_stats'][key])
+                self.assertEqual(output_['contentids'], output['contentids'])
+
+                # models returned from other processes predict the same
+                for model, model_ in zip(output['models'], output_['models']):
+                    self.assertTrue(all(model_.predict(xs)['ys_label_pred'] ==
+                                        model.predict(xs)['ys_label_pred']))
+
+    def test_run_nested_kfold_cross_validation_parallel(self):
+
+        train_test_model_class = LibsvmNusvrTrainTestModel
+        model_param_search_range = \
+            {'norm_type': ['normalize', 'clip_0to1', 'clip_minus1to1'],
+             'kernel': ['rbf'],
+             'nu': [0.5],
+             'C': [1, 2],
+             'gamma': [0.0]
+             }
+
+        output = ModelCrossValidation.run_nested_kfold_cross_validation(
+            train_test_model_class, model_param_search_range, self.features, 3)
+        output_ = ModelCrossValidation.run_nested_kfold_cross_validation(
+            train_test_model_class, model_param_search_range, self.features, 3,
+            processes=4)
+
+        for key in ['SRCC', 'PCC', 'KENDALL', 'RMSE']:
+            self.assertEqual(output_['aggr_stats'][key], output['aggr_stats'][key])
+        self.assertEqual(output_['model_params'], output['model_params'])
+        self.assertEqual(output_['top_model_param'], output['top_model_param'])
+        self.assertEqual(output_['top_ratio'], output['top_ratio'])
+        self.assertEqual(output_['contentids'], output['contentids'])
+
 
 if __name__ == '__main__':
     unittest.main(verbosity=2)
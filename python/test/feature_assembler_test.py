@@ -8,6 +8,9 @@ import unittest
 from vmaf.core.feature_assembler import FeatureAssembler
 from vmaf.core.feature_extractor import VmafFeatureExtractor, FeatureExtractor, \
     MomentFeatureExtractor
+from vmaf.core.result_store import FileSystemResultStore
+from vmaf.core.vmafexec_feature_extractor import FloatMotionFeatureExtractor, IntegerMotionFeatureExtractor, \
+    IntegerPsnrFeatureExtractor, IntegerVifFeatureExtractor, VmafexecFeatureExtractorGroup
 
 from test.testutil import set_default_576_324_videos_for_testing
 
@@ -124,6 +127,49 @@ class FeatureAssemblerTest(unittest.TestCase):
         with self.assertRaises(KeyError):
             _ = results[0]['VMAF_feature_adm_score']
 
+    def test_feature_assembler_vmafexec_features_folded(self):
+
+        ref_path, dis_path, asset, asset_original = set_default_576_324_videos_for_testing()
+
+        result_store = FileSystemResultStore()
+        self.fassembler = FeatureAssembler(
+            feature_dict={'float_motion_feature': 'all',
+                          'integer_VIF_feature': ['vif_scale0', 'vif_scale3'],
+                          'integer_PSNR_feature': 'all'},
+            feature_option_dict=None,
+            assets=[asset, asset_original],
+            logger=None,
+            fifo_mode=True,
+            delete_workdir=True,
+            result_store=result_store,
+            optional_dict=None,
+            optional_dict2=None,
+            parallelize=True,
+        )
+
+        self.fassembler.run()
+
+        results = self.fassembler.results
+
+        # one vmafexec run per asset gives the scores of separate runs
+        for fextractor_class in [FloatMotionFeatureExtractor, IntegerVifFeatureExtractor, IntegerPsnrFeatureExtractor]:
+            fextractor = fextractor_class([asset, asset_original], None, fifo_mode=True, delete_workdir=True,
+                                          result_store=None)
+            fextractor.run()
+            for result, result_alone in zip(results, fextractor.results):
+                for atom_feature in self.fassembler._get_atom_features(fextractor_class.TYPE):
+                    score_key = fextractor_class.get_score_key(atom_feature)
+                    self.assertAlmostEqual(result[score_key], result_alone[score_key], places=10)
+
+            # results are stored under each FeatureExtractor's own executor_id
+            self.assertIsNotNone(result_store.load(asset, fextractor.executor_id))
+
+        self.assertAlmostEqual(results[0]['float_motion_feature_motion2_score'], 3.8953518541666665, places=6)
+        self.assertAlmostEqual(results[0]['integer_PSNR_feature_psnr_y_score'], 30.755063979166664, places=4)
+        self.assertAlmostEqual(results[1]['float_motion_feature_motion2_score'], 3.8953518541666665, places=6)
+        self.assertAlmostEqual(results[1]['integer_VIF_feature_vif_scale0_score'], 1.0, places=4)
+        self.assertAlmostEqual(results[1]['integer_PSNR_feature_psnr_y_score'], 60.0, places=4)
+
 
 class FeatureAssemblerUnitTest(unittest.TestCase):
 
@@ -148,6 +194,30 @@ class FeatureAssemblerUnitTest(unittest.TestCase):
         self.assertEqual(fex.optional_dict, {'adm_ref_display_height': 540})
         self.assertEqual(fex.optional_dict2, None)
 
+    def test_vmafexec_feature_extractor_group_can_group(self):
+        ref_path, dis_path, asset, asset_original = set_default_576_324_videos_for_testing()
+
+        def _fextractor(fextractor_class, optional_dict=None):
+            return fextractor_class([asset], None, fifo_mode=False, delete_workdir=True, result_store=None,
+                                    optional_dict=optional_dict)
+
+        self.assertTrue(VmafexecFeatureExtractorGroup.can_group(
+            [_fextractor(FloatMotionFeatureExtractor), _fextractor(IntegerMotionFeatureExtractor),
+             _fextractor(IntegerVifFeatureExtractor), _fextractor(IntegerPsnrFeatureExtractor)]))
+
+        # the same vmafexec feature cannot run twice
+        self.assertFalse(VmafexecFeatureExtractorGroup.can_group(
+            [_fextractor(IntegerVifFeatureExtractor),
+             _fextractor(IntegerVifFeatureExtractor, {'vif_enhn_gain_limit': 1.0})]))
+
+        # vmafexec options which apply to the whole run must agree
+        self.assertTrue(VmafexecFeatureExtractorGroup.can_group(
+            [_fextractor(FloatMotionFeatureExtractor, {'n_threads': 2}),
+             _fextractor(IntegerPsnrFeatureExtractor, {'n_threads': 2})]))
+        self.assertFalse(VmafexecFeatureExtractorGroup.can_group(
+            [_fextractor(FloatMotionFeatureExtractor, {'n_threads': 2}),
+             _fextractor(IntegerPsnrFeatureExtractor, {'n_threads': 4})]))
+
 
 if __name__ == '__main__':
     unittest.main(verbosity=2)
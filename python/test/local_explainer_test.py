@@ -1,7 +1,10 @@
 import os
+import time
 import unittest
 
 import numpy as np
+import sklearn.metrics
+from sklearn.linear_model import Ridge
 
 from vmaf.config import VmafConfig
 from vmaf.core.asset import Asset
@@ -11,7 +14,7 @@ from vmaf.core.noref_feature_extractor import MomentNorefFeatureExtractor
 from vmaf.core.raw_extractor import DisYUVRawVideoExtractor
 from vmaf.core.result_store import FileSystemResultStore
 from vmaf.core.train_test_model import SklearnRandomForestTrainTestModel, \
-    MomentRandomForestTrainTestModel
+    MomentRandomForestTrainTestModel, TrainTestModel, RegressorMixin
 from vmaf.routine import read_dataset
 from vmaf.tools.misc import import_python_file
 
@@ -19,6 +22,113 @@ __copyright__ = "Copyright 2016-2020, Netflix, Inc."
 __license__ = "BSD+Patent"
 
 
+class SyntheticTrainTestModel(TrainTestModel, RegressorMixin):
+    """Smooth nonlinear function of three features, counting predict calls."""
+
+    TYPE = 'SYNTHETIC_LOCAL_EXPLAINER'
+    VERSION = '0.1'
+
+    num_predict_calls = 0
+
+    @classmethod
+    def _train(cls, model_param, xys_2d, **kwargs):
+        return 'synthetic'
+
+    @classmethod
+    def _predict(cls, model, xs_2d):
+        cls.num_predict_calls += 1
+        return np.sin(xs_2d[:, 0]) + xs_2d[:, 1] ** 2 - 0.5 * xs_2d[:, 0] * xs_2d[:, 2]
+
+
+def explain_one_at_a_time(explainer, train_test_model, xs):
+    """LocalExplainer.explain() as it was before batching: one neighborhood,
+    one model call and one Ridge fit per data point."""
+    xs_2d = train_test_model._to_tabular_xs(train_test_model.feature_names, xs)
+    xs_2d = train_test_model.normalize_xs(xs_2d)
+    n_sample, n_feature = xs_2d.shape
+    feature_weights = np.zeros([n_sample, n_feature])
+    regressor = Ridge(alpha=1, fit_intercept=True)
+    for i_sample in range(n_sample):
+        x_row = xs_2d[i_sample, :]
+        xs_2d_neighbor = np.random.randn(explainer.neighbor_samples, n_feature) * explainer.neighbor_std
+        xs_2d_neighbor += np.tile(x_row, (explainer.neighbor_samples, 1))
+        xs_2d_neighbor = np.vstack([x_row, xs_2d_neighbor])
+        distances = sklearn.metrics.pairwise_distances(
+            xs_2d_neighbor, xs_2d_neighbor[0].reshape(1, -1), metric='euclidean').ravel()
+        sample_weight = explainer.kernel_fn(distances)
+        ys = train_test_model._predict(train_test_model.model, xs_2d_neighbor)
+        regressor.fit(xs_2d_neighbor, ys, sample_weight=sample_weight)
+        feature_weights[i_sample, :] = regressor.coef_.copy()
+    return feature_weights
+
+
+class LocalExplainerBatchTest(unittest.TestCase):
+
+    def setUp(self):
+        np.random.seed(1)
+        n_train = 50
+        xys = {'f1': np.random.uniform(0, 10, n_train),
+               'f2': np.random.uniform(-1, 1, n_train),
+               'f3': np.random.uniform(50, 100, n_train),
+               'label': np.random.uniform(0, 100, n_train),
+               'content_id': np.arange(n_train)}
+        self.model = SyntheticTrainTestModel({'norm_type': 'normalize'}, None)
+        self.model.train(xys)
+
+        n_sample = 200
+        self.xs = {'f1': np.random.uniform(0, 10, n_sample),
+                   'f2': np.random.uniform(-1, 1, n_sample),
+                   'f3': np.random.uniform(50, 100, n_sample)}
+
+    def test_explain_batched_matches_one_at_a_time(self):
+
+        # batches of 7 data points, the last one partial
+        explainer = LocalExplainer(neighbor_samples=1000, max_batch_rows=7 * 1001)
+
+        np.random.seed(0)
+        SyntheticTrainTestModel.num_predict_calls = 0
+        t = time.time()
+        expected = explain_one_at_a_time(explainer, self.model, self.xs)
+        time_one_at_a_time = time.time() - t
+        self.assertEqual(SyntheticTrainTestModel.num_predict_calls, 200)
+
+        np.random.seed(0)
+        SyntheticTrainTestModel.num_predict_calls = 0
+        t = time.time()
+        exps = explainer.explain(self.model, self.xs)
+        time_batched = time.time() - t
+        self.assertEqual(SyntheticTrainTestModel.num_predict_calls, 29)
+
+        np.testing.assert_array_equal(exps['feature_weights'], expected)
+
+        # same seed, same explanation, independent of batching
+        np.random.seed(0)
+        exps_ = LocalExplainer(neighbor_samples=1000).explain(self.model, self.xs)
+        np.testing.assert_array_equal(exps_['feature_weights'], exps['feature_weights'])
+
+        # vectorized Ridge fits, equal up to floating point rounding
+        np.random.seed(0)
+        t = time.time()
+        exps_ = LocalExplainer(neighbor_samples=1000, max_batch_rows=7 * 1001,
+                               vectorized_ridge=True).explain(self.model, self.xs)
+        time_vectorized = time.time() - t
+        np.testing.assert_allclose(exps_['feature_weights'], expected, rtol=1e-9, atol=1e-12)
+
+        print('explain() of 200 data points: {:.3f}s one at a time, {:.3f}s batched, '
+              '{:.3f}s with vectorized ridge'.format(time_one_at_a_time, time_batched, time_vectorized))
+
+    def test_explain_custom_regressor(self):
+
+        # a custom regressor is fit per data point, on batched predictions
+        explainer = LocalExplainer(neighbor_samples=1000,
+                                   model_regressor=Ridge(alpha=1, fit_intercept=True))
+        np.random.seed(0)
+        expected = explain_one_at_a_time(explainer, self.model, self.xs)
+        np.random.seed(0)
+        exps = explainer.explain(self.model, self.xs)
+        np.testing.assert_array_equal(exps['feature_weights'], expected)
+
+
 class LocalExplainerTest(unittest.TestCase):
 
     def setUp(self):
@@ -1,6 +1,7 @@
 from __future__ import absolute_import
 
 import json
+import os
 import unittest
 from functools import partial
 
@@ -9,9 +10,9 @@ import numpy as np
 from vmaf.core.asset import Asset
 from vmaf.config import VmafConfig
 from vmaf.core.result import Result
-from vmaf.core.result_store import FileSystemResultStore
+from vmaf.core.result_store import FileSystemResultStore, SqliteResultStore
 from vmaf.core.quality_runner import VmafLegacyQualityRunner, VmafQualityRunner
-from vmaf.tools.misc import MyTestCase
+from vmaf.tools.misc import MyTestCase, parallel_map
 from vmaf.tools.stats import ListStats
 
 from test.testutil import set_default_576_324_videos_for_testing
@@ -242,6 +243,110 @@ class ResultStoreTest(unittest.TestCase):
 
         self.assertEqual(self.result, loaded_result)
 
+    def test_sqlite_result_store_save_load(self):
+        self.result_store = SqliteResultStore(logger=None)
+        asset = self.result.asset
+        executor_id = self.result.executor_id
+
+        self.result_store.save(self.result)
+
+        loaded_result = self.result_store.load(asset, executor_id)
+
+        self.assertEqual(self.result, loaded_result)
+
+
+class SqliteResultStoreTest(unittest.TestCase):
+
+    def setUp(self):
+        self.sqlite_store = SqliteResultStore(
+            result_store_dir=VmafConfig.workdir_path('sqlite_result_store_test'))
+        self.file_store = FileSystemResultStore(
+            result_store_dir=VmafConfig.workdir_path('file_result_store_test'))
+
+    def tearDown(self):
+        self.sqlite_store.clean_up()
+        self.file_store.clean_up()
+
+    @staticmethod
+    def _make_result(asset_id, scores=None):
+        asset = Asset(dataset="test", content_id=0, asset_id=asset_id,
+                      workdir_root=VmafConfig.workdir_path(),
+                      ref_path="dir/refvideo.yuv",
+                      dis_path="dir/disvideo_{}.yuv".format(asset_id),
+                      asset_dict={'width': 720, 'height': 480})
+        if scores is None:
+            scores = [0.1 * asset_id + i / 7.0 for i in range(5)]
+        return Result(asset, 'EXECUTOR_V1', {
+            'EXECUTOR_a_scores': scores,
+            'EXECUTOR_b_scores': [0.5 * i for i in range(5)],
+            'EXECUTOR_scores': [1.0, 2.0, 3.0, 4.0, 5.0],
+        })
+
+    def test_save_load_delete_parity(self):
+        result = self._make_result(0)
+        for store in [self.sqlite_store, self.file_store]:
+            self.assertIsNone(store.load(result.asset, result.executor_id))
+            store.save(result)
+        loaded_sqlite = self.sqlite_store.load(result.asset, result.executor_id)
+        loaded_file = self.file_store.load(result.asset, result.executor_id)
+        self.assertEqual(loaded_sqlite, result)
+        self.assertEqual(loaded_sqlite, loaded_file)
+        self.assertEqual(repr(loaded_sqlite.asset), repr(loaded_file.asset))
+        self.assertEqual(loaded_sqlite.get_ordered_list_scores_key(),
+                         loaded_file.get_ordered_list_scores_key())
+        self.assertAlmostEqual(loaded_sqlite['EXECUTOR_a_score'], loaded_file['EXECUTOR_a_score'], places=12)
+
+        # saving again replaces the previous result, including its scores keys
+        result2 = Result(result.asset, result.executor_id, {'EXECUTOR_c_scores': [0.5, 0.25]})
+        for store in [self.sqlite_store, self.file_store]:
+            store.save(result2)
+        loaded_sqlite = self.sqlite_store.load(result.asset, result.executor_id)
+        self.assertEqual(loaded_sqlite.get_ordered_list_scores_key(), ['EXECUTOR_c_scores'])
+        self.assertEqual(loaded_sqlite, self.file_store.load(result.asset, result.executor_id))
+
+        self.assertIsNone(self.sqlite_store.load(result.asset, 'EXECUTOR_V2'))
+        self.assertIsNone(self.sqlite_store.load(self._make_result(1).asset, result.executor_id))
+
+        for store in [self.sqlite_store, self.file_store]:
+            store.delete(result.asset, result.executor_id)
+            self.assertIsNone(store.load(result.asset, result.executor_id))
+
+    def test_save_load_non_float_scores(self):
+        result = self._make_result(0, scores=[1.5, None, 2, 3.25, None])
+        self.sqlite_store.save(result)
+        self.file_store.save(result)
+        loaded_sqlite = self.sqlite_store.load(result.asset, result.executor_id)
+        self.assertEqual(loaded_sqlite.result_dict['EXECUTOR_a_scores'], [1.5, None, 2, 3.25, None])
+        self.assertEqual(loaded_sqlite, self.file_store.load(result.asset, result.executor_id))
+
+    def test_workfile_parity(self):
+        result = self._make_result(0)
+        workfile_path = VmafConfig.workdir_path('sqlite_result_store_test_workfile.yuv')
+        os.makedirs(os.path.dirname(workfile_path), exist_ok=True)
+        with open(workfile_path, 'wb') as f:
+            f.write(b'\x00\x01\x02')
+        try:
+            for store in [self.sqlite_store, self.file_store]:
+                self.assertFalse(store.has_workfile(result.asset, result.executor_id, '_dis.yuv'))
+                store.save_workfile(result, workfile_path, '_dis.yuv')
+                self.assertTrue(store.has_workfile(result.asset, result.executor_id, '_dis.yuv'))
+                store.delete_workfile(result.asset, result.executor_id, '_dis.yuv')
+                self.assertFalse(store.has_workfile(result.asset, result.executor_id, '_dis.yuv'))
+        finally:
+            os.remove(workfile_path)
+
+    def test_concurrent_save(self):
+        results = [self._make_result(i) for i in range(16)]
+        store = self.sqlite_store
+
+        def _save(result):
+            store.save(result)
+            return True
+
+        self.assertTrue(all(parallel_map(_save, results, processes=4)))
+        for result in results:
+            self.assertEqual(store.load(result.asset, result.executor_id), result)
+
 
 class ResultStoreTestWithNone(unittest.TestCase):
 
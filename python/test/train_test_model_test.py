@@ -2,15 +2,17 @@ import os
 import unittest
 
 import numpy as np
+from libsvm import svmutil
 
 from vmaf.config import VmafConfig
 from vmaf.core.train_test_model import TrainTestModel, \
     LibsvmNusvrTrainTestModel, SklearnRandomForestTrainTestModel, \
     MomentRandomForestTrainTestModel, SklearnExtraTreesTrainTestModel, \
-    SklearnLinearRegressionTrainTestModel, Logistic5PLRegressionTrainTestModel
+    SklearnLinearRegressionTrainTestModel, Logistic5PLRegressionTrainTestModel, \
+    LibsvmRbfPredictor
 from vmaf.core.noref_feature_extractor import MomentNorefFeatureExtractor
 from vmaf.routine import read_dataset
-from vmaf.tools.misc import import_python_file
+from vmaf.tools.misc import import_python_file, NoPrint
 from vmaf.core.raw_extractor import DisYUVRawVideoExtractor
 
 __copyright__ = "Copyright 2016-2020, Netflix, Inc."
@@ -146,6 +148,41 @@ class TrainTestModelTest(unittest.TestCase):
         result = model.evaluate(xs, ys)
         self.assertAlmostEqual(result['RMSE'], 0.23294283650716496, places=4)
 
+    @staticmethod
+    def _svm_predict(svm_model, xs_2d):
+        f = [list(row) for row in xs_2d]
+        with NoPrint():
+            score, _, _ = svmutil.svm_predict([0] * len(f), f, svm_model)
+        return np.array(score)
+
+    def test_vectorized_predict_libsvmnusvr(self):
+
+        xs = LibsvmNusvrTrainTestModel.get_xs_from_results(self.features)
+        xys = LibsvmNusvrTrainTestModel.get_xys_from_results(self.features)
+
+        for norm_type in ['normalize', 'clip_0to1', 'clip_minus1to1', 'none']:
+            model = LibsvmNusvrTrainTestModel({'norm_type': norm_type}, None)
+            model.train(xys)
+            xs_2d = model._preproc_predict(xs)
+            self.assertTrue(LibsvmRbfPredictor.supports(model.model))
+            np.testing.assert_allclose(
+                LibsvmRbfPredictor(model.model).predict(xs_2d),
+                self._svm_predict(model.model, xs_2d), rtol=0, atol=1e-9)
+
+    def test_vectorized_predict_libsvmnusvr_loaded(self):
+
+        model = LibsvmNusvrTrainTestModel.from_file(
+            VmafConfig.model_path("vmaf_float_v0.6.1.json"), None, format='json')
+        np.random.seed(0)
+        # spans more than one kernel block, features include exact zeros
+        xs_2d = np.random.uniform(-0.2, 1.2, [5000, len(model.feature_names)])
+        xs_2d[::7, 1] = 0.0
+        predictor = LibsvmRbfPredictor(model.model)
+        predictor.MAX_KERNEL_VALUES_PER_BLOCK = 100000
+        np.testing.assert_allclose(
+            predictor.predict(xs_2d),
+            self._svm_predict(model.model, xs_2d), rtol=0, atol=1e-9)
+
     def test_train_across_test_splits_ci_libsvmnusvr(self):
 
         xs = LibsvmNusvrTrainTestModel.get_xs_from_results(self.features)
@@ -118,23 +118,34 @@ class ExternalProgramCaller(object):
     Caller of ExternalProgram.
     """
 
+    # options of call_vmafexec_single_feature() which apply to the whole
+    # vmafexec run rather than to one feature
+    VMAFEXEC_RUN_OPTIONS = ['disable_avx', 'n_threads', '_open_workfile_method', '_close_workfile_method']
+
     @staticmethod
     def call_vmafexec_single_feature(feature, yuv_type, ref_path, dis_path, w, h, log_file_path, logger=None, options=None):
-        options2 = {feature: options.copy() if options is not None else None}
-        if options2[feature] is not None and 'disable_avx' in options2[feature]:
-            options2['disable_avx'] = options2[feature]['disable_avx']
-            del options2[feature]['disable_avx']
-        if options2[feature] is not None and 'n_threads' in options2[feature]:
-            options2['n_threads'] = options2[feature]['n_threads']
-            del options2[feature]['n_threads']
-        if options2[feature] is not None and '_open_workfile_method' in options2[feature]:
-            options2['_open_workfile_method'] = options2[feature]['_open_workfile_method']
-            del options2[feature]['_open_workfile_method']
-        if options2[feature] is not None and '_close_workfile_method' in options2[feature]:
-            options2['_close_workfile_method'] = options2[feature]['_close_workfile_method']
-            del options2[feature]['_close_workfile_method']
+        return ExternalProgramCaller.call_vmafexec_folded_features(
+            {feature: options}, yuv_type, ref_path, dis_path, w, h, log_file_path, logger=logger)
+
+    @staticmethod
+    def call_vmafexec_folded_features(feature_options_dict, yuv_type, ref_path, dis_path, w, h, log_file_path, logger=None):
+        """
+        Run several features in one vmafexec invocation. feature_options_dict
+        maps each feature to its options, in the same format as the options of
+        call_vmafexec_single_feature(). Options in VMAFEXEC_RUN_OPTIONS apply to
+        the whole run, so the features must agree on their values.
+        """
+        options2 = {}
+        for feature, options in feature_options_dict.items():
+            options2[feature] = options.copy() if options is not None else None
+            for opt in ExternalProgramCaller.VMAFEXEC_RUN_OPTIONS:
+                if options2[feature] is not None and opt in options2[feature]:
+                    assert opt not in options2 or options2[opt] == options2[feature][opt], \
+                        f'features disagree on vmafexec option {opt}'
+                    options2[opt] = options2[feature][opt]
+                    del options2[feature][opt]
         return ExternalProgramCaller.call_vmafexec_multi_features(
-            [feature], yuv_type, ref_path, dis_path, w, h, log_file_path, logger=logger, options=options2)
+            list(feature_options_dict), yuv_type, ref_path, dis_path, w, h, log_file_path, logger=logger, options=options2)
 
     @staticmethod
     def call_vmafexec_multi_features(features, yuv_type, ref_path, dis_path, w, h, log_file_path, logger=None, options=None):
@@ -179,6 +179,10 @@ class VmafConfig(object):
     def file_result_store_path(cls, *components):
         return cls.root_path('workspace', 'result_store_dir', 'file_result_store', *components)
 
+    @classmethod
+    def sqlite_result_store_path(cls, *components):
+        return cls.root_path('workspace', 'result_store_dir', 'sqlite_result_store', *components)
+
     @classmethod
     def encode_store_path(cls, *components):
         return cls.root_path('workspace', 'result_store_dir', 'encode_store', *components)
@@ -1,4 +1,4 @@
-from vmaf.tools.misc import unroll_dict_of_lists
+from vmaf.tools.misc import unroll_dict_of_lists, parallel_map
 
 __copyright__ = "Copyright 2016-2020, Netflix, Inc."
 __license__ = "BSD+Patent"
@@ -7,6 +7,8 @@ import random
 from math import floor
 import sys
 
+import numpy as np
+
 
 class ModelCrossValidation(object):
 
@@ -49,7 +51,8 @@ class ModelCrossValidation(object):
                                    results_or_df,
                                    kfold,
                                    logger=None,
-                                   optional_dict2=None):
+                                   optional_dict2=None,
+                                   processes=None):
         """
         Standard k-fold cross validation, given hyperparameter set model_param
         :param train_test_model_class:
@@ -58,6 +61,9 @@ class ModelCrossValidation(object):
         :param kfold: if it is an integer, it is the number of folds; if it is
         list of indices, then each list contains row indices of the dataframe
         selected as one fold
+        :param processes: if not None, folds are run through parallel_map()
+        with that many processes, see _map_seeded(); the trained models must
+        be picklable
         :return: output
         """
 
@@ -83,38 +89,39 @@ class ModelCrossValidation(object):
         assert len(kfold) >= 2, 'kfold list must have length >= 2 for k-fold ' \
                                 'cross validation.'
 
-        statss = []
-        models = []
-        contentids = []
-
-        for fold in range(len(kfold)):
-
+        def _run_fold(fold):
             # to avoid interference among folds
             if hasattr(train_test_model_class, 'reset'):
                 train_test_model_class.reset()
 
-            if logger:
-                logger.info("Fold {}...".format(fold))
-
-            test_index_range = kfold[fold]
-            train_index_range = []
-            for train_fold in range(len(kfold)):
-                if train_fold != fold:
-                    train_index_range += kfold[train_fold]
+            train_index_range, test_index_range, _ = cls._split_kfold(kfold, fold)
 
-            output = cls.run_cross_validation(train_test_model_class,
-                                              model_param,
-                                              results_or_df,
-                                              train_index_range,
-                                              test_index_range,
-                                              optional_dict2)
+            return cls.run_cross_validation(train_test_model_class,
+                                            model_param,
+                                            results_or_df,
+                                            train_index_range,
+                                            test_index_range,
+                                            optional_dict2)
 
-            stats = output['stats']
-            model = output['model']
+        if processes is not None:
+            if logger:
+                logger.info("Folds 0 to {} in {} processes...".format(
+                    len(kfold) - 1, processes))
+            outputs = cls._map_seeded(_run_fold, range(len(kfold)), processes)
+        else:
+            outputs = []
+            for fold in range(len(kfold)):
+                if logger:
+                    logger.info("Fold {}...".format(fold))
+                outputs.append(_run_fold(fold))
 
-            statss.append(stats)
-            models.append(model)
+        statss = []
+        models = []
+        contentids = []
 
+        for output in outputs:
+            statss.append(output['stats'])
+            models.append(output['model'])
             contentids += list(output['contentids'])
 
         aggr_stats = train_test_model_class.aggregate_stats_list(statss)
@@ -136,6 +143,7 @@ class ModelCrossValidation(object):
                                           random_search_times=100,
                                           logger=None,
                                           optional_dict2=None,
+                                          processes=None,
                                           ):
         """
         Nested k-fold cross validation, given hyperparameter search range. The
@@ -150,6 +158,10 @@ class ModelCrossValidation(object):
         lists of indices, then each list contains row indices of the dataframe
         selected as one fold
         :param search_strategy: either 'grid' or 'random'
+        :param processes: if not None, every (fold, model parameter) pair of
+        the search, and then every fold with its best model parameter, are
+        run through parallel_map() with that many processes, see
+        _map_seeded()
         :return: output
         """
 
@@ -186,41 +198,20 @@ class ModelCrossValidation(object):
         else:
             assert False, "Unknown search_strategy: {}".format(search_strategy)
 
-        statss = []
-        model_params = []
-        contentids = []
-
-        for fold in range(len(kfold)):
-
-            if logger:
-                logger.info("Fold {}...".format(fold))
-
-            test_index_range = kfold[fold]
-            train_index_range = []
-            train_index_range_in_list_of_indices = []
-
-            # in this case, train_index_range is list of lists
-            for train_fold in range(len(kfold)):
-                if train_fold != fold:
-                    train_index_range += kfold[train_fold]
-                    train_index_range_in_list_of_indices.append(kfold[train_fold])
-
-            # iterate through all possible combinations of model_params
+        def _run_candidate(fold, model_param):
+            _, _, train_kfold = cls._split_kfold(kfold, fold)
+            output = \
+                cls.run_kfold_cross_validation(train_test_model_class,
+                                               model_param,
+                                               results_or_df,
+                                               train_kfold,
+                                               optional_dict2=optional_dict2)
+            return output['aggr_stats']
+
+        def _select_best(candidate_statss):
             best_model_param = None
             best_stats = None
-            for model_param in list_model_param:
-
-                if logger:
-                    logger.info("\tModel parameter: {}".format(model_param))
-
-                output = \
-                    cls.run_kfold_cross_validation(train_test_model_class,
-                                                   model_param,
-                                                   results_or_df,
-                                                   train_index_range_in_list_of_indices,
-                                                   optional_dict2)
-                stats = output['aggr_stats']
-
+            for model_param, stats in zip(list_model_param, candidate_statss):
                 if (best_stats is None) or (
                     train_test_model_class.get_objective_score(stats, score_type='SRCC')
                     >
@@ -228,18 +219,62 @@ class ModelCrossValidation(object):
                 ):
                     best_stats = stats
                     best_model_param = model_param
+            return best_model_param
 
+        def _run_best(fold, best_model_param):
             # run cross validation based on best model parameters
+            train_index_range, test_index_range, _ = cls._split_kfold(kfold, fold)
             output_ = cls.run_cross_validation(
                 train_test_model_class, best_model_param, results_or_df,
                 train_index_range, test_index_range, optional_dict2
             )
-            stats_ = output_['stats']
+            # the model is not part of the output, nor returned from workers
+            return output_['stats'], output_['contentids']
+
+        if processes is not None:
+            num_params = len(list_model_param)
+            fold_params = [(fold, model_param)
+                           for fold in range(len(kfold))
+                           for model_param in list_model_param]
+            if logger:
+                logger.info("{} folds x {} model parameters in {} processes...".format(
+                    len(kfold), num_params, processes))
+            candidate_statss = cls._map_seeded(
+                lambda fold_param: _run_candidate(*fold_param), fold_params, processes)
+            best_model_params = [
+                _select_best(candidate_statss[fold * num_params:(fold + 1) * num_params])
+                for fold in range(len(kfold))]
+            best_outputs = cls._map_seeded(
+                lambda fold: _run_best(fold, best_model_params[fold]),
+                range(len(kfold)), processes)
+        else:
+            best_model_params = []
+            best_outputs = []
+            for fold in range(len(kfold)):
+
+                if logger:
+                    logger.info("Fold {}...".format(fold))
+
+                # iterate through all possible combinations of model_params
+                candidate_statss = []
+                for model_param in list_model_param:
+
+                    if logger:
+                        logger.info("\tModel parameter: {}".format(model_param))
+
+                    candidate_statss.append(_run_candidate(fold, model_param))
+
+                best_model_params.append(_select_best(candidate_statss))
+                best_outputs.append(_run_best(fold, best_model_params[-1]))
+
+        statss = []
+        model_params = []
+        contentids = []
 
+        for best_model_param, (stats_, contentids_) in zip(best_model_params, best_outputs):
             statss.append(stats_)
             model_params.append(best_model_param)
-
-            contentids += list(output_['contentids'])
+            contentids += list(contentids_)
 
         aggr_stats = train_test_model_class.aggregate_stats_list(statss)
         top_model_param, count = cls._find_most_frequent_dict(model_params)
@@ -256,6 +291,47 @@ class ModelCrossValidation(object):
 
         return output__
 
+    @staticmethod
+    def _split_kfold(kfold, fold):
+        """
+        Split kfold into the test indices of fold, and the train indices of
+        all other folds, both flattened and as a list of folds.
+        """
+        test_index_range = kfold[fold]
+        train_index_range = []
+        train_kfold = []
+        for train_fold in range(len(kfold)):
+            if train_fold != fold:
+                train_index_range += kfold[train_fold]
+                train_kfold.append(kfold[train_fold])
+        return train_index_range, test_index_range, train_kfold
+
+    @staticmethod
+    def _map_seeded(func, list_args, processes):
+        """
+        Map func over list_args through parallel_map() in processes
+        processes, or in this process if processes is 1. Before each call,
+        random and numpy.random are seeded with the position of its argument,
+        so that results depend neither on processes nor on scheduling.
+        """
+        list_args = list(list_args)
+
+        def _run_seeded(idx):
+            random.seed(idx)
+            np.random.seed(idx)
+            return func(list_args[idx])
+
+        if processes == 1:
+            random_state = random.getstate()
+            np_random_state = np.random.get_state()
+            try:
+                return [_run_seeded(idx) for idx in range(len(list_args))]
+            finally:
+                random.setstate(random_state)
+                np.random.set_state(np_random_state)
+
+        return parallel_map(_run_seeded, list(range(len(list_args))), processes=processes)
+
     @classmethod
     def _assert_grid_search(cls, model_param_search_range):
         assert isinstance(model_param_search_range, dict)
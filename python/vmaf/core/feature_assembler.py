@@ -1,8 +1,9 @@
 __copyright__ = "Copyright 2016-2020, Netflix, Inc."
 __license__ = "BSD+Patent"
 
-from vmaf.core.feature_extractor import FeatureExtractor
+from vmaf.core.feature_extractor import FeatureExtractor, VmafexecSingleFeatureExtractorMixin
 from vmaf.core.result import BasicResult
+from vmaf.core.vmafexec_feature_extractor import VmafexecFeatureExtractorGroup
 
 
 class FeatureAssembler(object):
@@ -67,8 +68,26 @@ class FeatureAssembler(object):
 
         # for each FeatureExtractor_type key in feature_dict, find the subclass
         # of FeatureExtractor, run, and put results in a dict
+        fextractors = {fextractor_type: self._get_fextractor_instance(fextractor_type)
+                       for fextractor_type in self.feature_dict}
+
+        # FeatureExtractors backed by a single vmafexec feature are folded into
+        # one vmafexec run per asset, so that each asset is read only once
+        grouped_types = [fextractor_type for fextractor_type in self.feature_dict
+                         if isinstance(fextractors[fextractor_type], VmafexecSingleFeatureExtractorMixin)]
+        if len(grouped_types) > 1 and \
+                VmafexecFeatureExtractorGroup.can_group([fextractors[t] for t in grouped_types]):
+            group = VmafexecFeatureExtractorGroup([fextractors[t] for t in grouped_types])
+            group.run(parallelize=self.parallelize, processes=self.processes)
+            for i, fextractor_type in enumerate(grouped_types):
+                self.type2results_dict[fextractor_type] = [results[i] for results in group.results]
+        else:
+            grouped_types = []
+
         for fextractor_type in self.feature_dict:
-            runner = self._get_fextractor_instance(fextractor_type)
+            if fextractor_type in grouped_types:
+                continue
+            runner = fextractors[fextractor_type]
             runner.run(parallelize=self.parallelize, processes=self.processes)
             results = runner.results
             self.type2results_dict[fextractor_type] = results
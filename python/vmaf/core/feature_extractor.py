@@ -182,6 +182,39 @@ class VmafexecFeatureExtractorMixin(object):
         return feature_found
 
 
+class VmafexecSingleFeatureExtractorMixin(VmafexecFeatureExtractorMixin):
+    """
+    Mixin for a FeatureExtractor backed by the single vmafexec feature named
+    by VMAFEXEC_FEATURE. FeatureAssembler folds several of these into one
+    vmafexec run per asset (see VmafexecFeatureExtractorGroup).
+    """
+
+    def _get_vmafexec_options(self, asset):
+        optional_dict = self.optional_dict if self.optional_dict is not None else dict()
+        optional_dict2 = self.optional_dict2 if self.optional_dict2 is not None else dict()
+        return {**optional_dict, **optional_dict2}
+
+    def _generate_result(self, asset):
+        # routine to call the command-line executable and generate quality
+        # scores in the log file.
+
+        assert hasattr(self, 'VMAFEXEC_FEATURE')
+
+        quality_width, quality_height = asset.quality_width_height
+        log_file_path = self._get_log_file_path(asset)
+
+        yuv_type = self._get_workfile_yuv_type(asset)
+        ref_path = asset.ref_procfile_path
+        dis_path = asset.dis_procfile_path
+        w = quality_width
+        h = quality_height
+        logger = self.logger
+
+        ExternalProgramCaller.call_vmafexec_single_feature(
+            self.VMAFEXEC_FEATURE, yuv_type, ref_path, dis_path, w, h,
+            log_file_path, logger, options=self._get_vmafexec_options(asset))
+
+
 class VmafFeatureExtractor(VmafexecFeatureExtractorMixin, FeatureExtractor):
 
     TYPE = "VMAF_feature"
@@ -44,6 +44,8 @@ class LocalExplainer(object):
                  distance_metric='euclidean',
                  kernel_width=3,
                  model_regressor=None,
+                 max_batch_rows=1 << 20,
+                 vectorized_ridge=False,
                  ):
         """Init function.
 
@@ -52,12 +54,21 @@ class LocalExplainer(object):
         :param distance_metric: distance metric used
         :param kernel_width: width for kernel function
         :param model_regressor: regressor to train local linear model. If None, use Ridge
+        :param max_batch_rows: maximum number of neighborhood rows predicted by
+        one call of the model; neighborhoods of consecutive data points are
+        stacked up to that size
+        :param vectorized_ridge: if True and model_regressor is None, fit the
+        Ridge of all neighborhoods of a batch at once in NumPy; faster, but the
+        weights match those of sklearn's Ridge only up to floating point rounding
         """
         self.neighbor_std = neighbor_std
         self.neighbor_samples = neighbor_samples
         self.distance_metric = distance_metric
         self.kernel_fn = lambda d: np.sqrt(np.exp(-(d**2) / kernel_width ** 2))
         self.model_regressor = Ridge(alpha=1, fit_intercept=True) if model_regressor is None else model_regressor
+        # the default Ridge may be fit for all neighborhoods of a batch at once
+        self.ridge_alpha = 1.0 if model_regressor is None and vectorized_ridge else None
+        self.max_batch_rows = max_batch_rows
 
     def _assert_model(self, train_test_model):
 
@@ -93,41 +104,59 @@ class LocalExplainer(object):
         xs_2d = train_test_model.normalize_xs(xs_2d)
 
         # for each row of xs, repeat feature of a unit (e.g. frame),
-        # generate a new 2d_array by sampling its neighborhood
+        # generate a new 2d_array by sampling its neighborhood; neighborhoods
+        # of several rows are predicted in one batch
         n_sample, n_feature = xs_2d.shape
+        n_neighbor = self.neighbor_samples + 1
+        batch_size = max(1, self.max_batch_rows // n_neighbor)
+
+        model = train_test_model.model
+        if isinstance(model, list):
+            model = model[0]  # HACKY, TODO: fix it
+
         feature_weights = np.zeros([n_sample, n_feature])
-        for i_sample in range(n_sample):
+        for i_start in range(0, n_sample, batch_size):
+            x_rows = xs_2d[i_start:i_start + batch_size, :]
+            n_batch = x_rows.shape[0]
 
-            # generate neighborhood samples
-            x_row = xs_2d[i_sample, :]
-            xs_2d_neighbor = np.random.randn(self.neighbor_samples, n_feature) * self.neighbor_std
-            xs_2d_neighbor += np.tile(x_row, (self.neighbor_samples, 1))
+            # generate neighborhood samples, drawn in the same order as one
+            # row at a time
+            xs_3d_neighbor = np.random.randn(n_batch, self.neighbor_samples, n_feature) * self.neighbor_std
+            xs_3d_neighbor += x_rows[:, np.newaxis, :]
 
             # add center to first row
-            xs_2d_neighbor = np.vstack([x_row, xs_2d_neighbor])
+            xs_3d_neighbor = np.concatenate([x_rows[:, np.newaxis, :], xs_3d_neighbor], axis=1)
 
             # calculate distance to center
-            distances = sklearn.metrics.pairwise_distances(
-                xs_2d_neighbor,
-                xs_2d_neighbor[0].reshape(1, -1),
-                metric=self.distance_metric
-            ).ravel()
-            sample_weight = self.kernel_fn(distances)
-
-            model = train_test_model.model
-            if isinstance(model, list):
-                model = model[0]  # HACKY, TODO: fix it
+            if self.ridge_alpha is not None and self.distance_metric == 'euclidean':
+                distances = np.sqrt(np.sum((xs_3d_neighbor - x_rows[:, np.newaxis, :]) ** 2, axis=2))
+            else:
+                # sklearn gets a copy of each neighborhood, as it rounds
+                # differently on a view into the batch
+                distances = np.vstack([
+                    sklearn.metrics.pairwise_distances(
+                        xs_2d_neighbor.copy(),
+                        xs_2d_neighbor[0].reshape(1, -1),
+                        metric=self.distance_metric
+                    ).ravel() for xs_2d_neighbor in xs_3d_neighbor])
+            sample_weights = self.kernel_fn(distances)
 
             # predict
-            ys_label_pred_neighbor = train_test_model._predict(model, xs_2d_neighbor)
+            ys_label_pred_neighbor = train_test_model._predict(
+                model, xs_3d_neighbor.reshape(n_batch * n_neighbor, n_feature))
+            ys_label_pred_neighbor = np.asarray(ys_label_pred_neighbor).reshape(n_batch, n_neighbor)
 
             # take xs_2d_neighbor and ys_label_pred_neighbor, train a linear
             # model
-            self.model_regressor.fit(xs_2d_neighbor,
-                                     ys_label_pred_neighbor,
-                                     sample_weight=sample_weight)
-            feature_weight = self.model_regressor.coef_.copy()
-            feature_weights[i_sample, :] = feature_weight
+            if self.ridge_alpha is not None:
+                feature_weights[i_start:i_start + n_batch, :] = self._fit_ridge(
+                    xs_3d_neighbor, ys_label_pred_neighbor, sample_weights, self.ridge_alpha)
+            else:
+                for i_batch in range(n_batch):
+                    self.model_regressor.fit(xs_3d_neighbor[i_batch],
+                                             ys_label_pred_neighbor[i_batch],
+                                             sample_weight=sample_weights[i_batch])
+                    feature_weights[i_start + i_batch, :] = self.model_regressor.coef_.copy()
 
         exps = {
             'feature_weights': feature_weights,
@@ -138,6 +167,26 @@ class LocalExplainer(object):
 
         return exps
 
+    @staticmethod
+    def _fit_ridge(xs_3d, ys_2d, sample_weights, alpha):
+        """Weighted ridge regression with intercept, fit independently for
+        every neighborhood along the first axis, following the steps of
+        sklearn's Ridge with the cholesky solver. Returns the coefficients.
+        """
+        n_feature = xs_3d.shape[2]
+        sw_sum = np.sum(sample_weights, axis=1)
+        x_offset = np.einsum('bn,bnf->bf', sample_weights, xs_3d) / sw_sum[:, np.newaxis]
+        y_offset = np.sum(sample_weights * ys_2d, axis=1) / sw_sum
+
+        sw_sqrt = np.sqrt(sample_weights)
+        xs_3d = (xs_3d - x_offset[:, np.newaxis, :]) * sw_sqrt[:, :, np.newaxis]
+        ys_2d = (ys_2d - y_offset[:, np.newaxis]) * sw_sqrt
+
+        xs_3d_t = xs_3d.transpose(0, 2, 1)
+        a = np.matmul(xs_3d_t, xs_3d) + alpha * np.eye(n_feature)
+        xy = np.matmul(xs_3d_t, ys_2d[:, :, np.newaxis])
+        return np.linalg.solve(a, xy)[:, :, 0]
+
     @staticmethod
     def assert_explanations(exps, assets=None, ys=None, ys_pred=None):
         N = exps['feature_weights'].shape[0]
@@ -2,7 +2,10 @@ import os
 import hashlib
 import ast
 import shutil
+import sqlite3
+from contextlib import contextmanager
 
+import numpy as np
 import pandas as pd
 
 from vmaf.config import VmafConfig
@@ -17,16 +20,143 @@ __license__ = ("BSD"
 
 class ResultStore(object):
     """
-    Provide capability to save and load a Result.
+    Provide capability to save and load a Result. Workfiles are kept under
+    result_store_dir by every store, named after the asset and executor_id.
     """
-    pass
+
+    def save_workfile(self, result: Result, workfile_path: str, suffix: str):
+        result_file_path = self._get_workfile_path(result.asset, result.executor_id, suffix)
+        try:
+            make_parent_dirs_if_nonexist(result_file_path)
+        except OSError as e:
+            print('make_parent_dirs_if_nonexist {path} fails: {e}'.format(path=result_file_path, e=str(e)))
+
+        shutil.copyfile(workfile_path, result_file_path)
+
+    def has_workfile(self, asset: Asset, executor_id: str, suffix: str) -> bool:
+        return os.path.isfile(self._get_workfile_path(asset, executor_id, suffix))
+
+    def delete_workfile(self, asset, executor_id, suffix: str):
+        workfile_path = self._get_workfile_path(asset, executor_id, suffix)
+        if os.path.isfile(workfile_path):
+            os.remove(workfile_path)
+
+    def clean_up(self):
+        """
+        WARNING: RMOVE ENTIRE RESULT STORE, USE WITH CAUTION!!!
+        :return:
+        """
+        if os.path.isdir(self.result_store_dir):
+            shutil.rmtree(self.result_store_dir)
+
+    def _get_workfile_path(self, asset, executor_id, suffix):
+        str_to_hash = str(asset).encode("utf-8")
+        return "{dir}/{executor_id}/{dataset}/{content_id}/{str}{suffix}".format(
+            dir=self.result_store_dir, executor_id=executor_id,
+            dataset=asset.dataset,
+            content_id=asset.content_id,
+            str=hashlib.sha1(str_to_hash).hexdigest(),
+            suffix=suffix)
 
 
 class SqliteResultStore(ResultStore):
     """
-    persist result by a SQLite engine that save/load result.
+    persist result by a SQLite engine that save/load result. The database file
+    result.db lives in result_store_dir and has one row per (executor_id,
+    repr(asset), scores_key). The per-frame scores of a row are packed into a
+    single little-endian float64 blob; scores that are not all floats (e.g.
+    containing None) fall back to their repr. Workfiles are kept next to the
+    database with the same layout as FileSystemResultStore. Every operation
+    opens its own connection, so the store can be shared with forked
+    parallel_map workers; concurrent writers are serialized by SQLite's locking.
     """
-    pass
+
+    DB_FILENAME = 'result.db'
+    TIMEOUT_SEC = 60.0
+
+    ENCODING_FLOAT64 = 'f8'
+    ENCODING_REPR = 'repr'
+
+    def __init__(self, logger=None,
+                 result_store_dir=VmafConfig.sqlite_result_store_path()
+                 ):
+        self.logger = logger
+        self.result_store_dir = result_store_dir
+
+    @property
+    def db_path(self):
+        return os.path.join(self.result_store_dir, self.DB_FILENAME)
+
+    @contextmanager
+    def _connect(self):
+        os.makedirs(self.result_store_dir, exist_ok=True)
+        conn = sqlite3.connect(self.db_path, timeout=self.TIMEOUT_SEC, isolation_level=None)
+        try:
+            conn.execute('PRAGMA journal_mode=WAL')
+            conn.execute('CREATE TABLE IF NOT EXISTS scores ('
+                         'executor_id TEXT NOT NULL, '
+                         'asset TEXT NOT NULL, '
+                         'scores_key TEXT NOT NULL, '
+                         'encoding TEXT NOT NULL, '
+                         'scores BLOB NOT NULL, '
+                         'PRIMARY KEY (executor_id, asset, scores_key)) WITHOUT ROWID')
+            yield conn
+        finally:
+            conn.close()
+
+    @contextmanager
+    def _transaction(self):
+        with self._connect() as conn:
+            # take the write lock upfront, so that concurrent writers wait on
+            # busy_timeout instead of failing on a lock upgrade
+            conn.execute('BEGIN IMMEDIATE')
+            try:
+                yield conn
+            except BaseException:
+                conn.execute('ROLLBACK')
+                raise
+            conn.execute('COMMIT')
+
+    @classmethod
+    def _encode_scores(cls, scores):
+        if all(isinstance(score, float) for score in scores):
+            return cls.ENCODING_FLOAT64, np.asarray(scores, dtype='<f8').tobytes()
+        return cls.ENCODING_REPR, repr(list(scores)).encode('utf-8')
+
+    @classmethod
+    def _decode_scores(cls, encoding, blob):
+        if encoding == cls.ENCODING_FLOAT64:
+            return np.frombuffer(blob, dtype='<f8').tolist()
+        assert encoding == cls.ENCODING_REPR, 'unknown scores encoding {}'.format(encoding)
+        return ast.literal_eval(blob.decode('utf-8'))
+
+    def save(self, result):
+        asset_repr = repr(result.asset)
+        rows = []
+        for scores_key in result.get_ordered_list_scores_key():
+            encoding, blob = self._encode_scores(result.result_dict[scores_key])
+            rows.append((result.executor_id, asset_repr, scores_key, encoding, blob))
+        with self._transaction() as conn:
+            conn.execute('DELETE FROM scores WHERE executor_id = ? AND asset = ?',
+                         (result.executor_id, asset_repr))
+            conn.executemany('INSERT INTO scores VALUES (?, ?, ?, ?, ?)', rows)
+
+    def load(self, asset, executor_id):
+        asset_repr = repr(asset)
+        with self._connect() as conn:
+            rows = conn.execute('SELECT scores_key, encoding, scores FROM scores '
+                                'WHERE executor_id = ? AND asset = ? ORDER BY scores_key',
+                                (executor_id, asset_repr)).fetchall()
+        if len(rows) == 0:
+            return None
+        result_dict = {scores_key: self._decode_scores(encoding, blob)
+                       for scores_key, encoding, blob in rows}
+        return Result(asset.__class__.from_repr(asset_repr), executor_id, result_dict)
+
+    def delete(self, asset, executor_id):
+        with self._transaction() as conn:
+            conn.execute('DELETE FROM scores WHERE executor_id = ? AND asset = ?',
+                         (executor_id, repr(asset)))
 
 
 class FileSystemResultStore(ResultStore):
@@ -53,15 +183,6 @@ class FileSystemResultStore(ResultStore):
 
         self.save_result(result, result_file_path)
 
-    def save_workfile(self, result: Result, workfile_path: str, suffix: str):
-        result_file_path = self._get_result_file_path(result)
-        try:
-            make_parent_dirs_if_nonexist(result_file_path)
-        except OSError as e:
-            print('make_parent_dirs_if_nonexist {path} fails: {e}'.format(path=result_file_path, e=str(e)))
-
-        shutil.copyfile(workfile_path, result_file_path + suffix)
-
     def load(self, asset, executor_id):
         result_file_path = self._get_result_file_path2(asset, executor_id)
         if not os.path.isfile(result_file_path):
@@ -69,10 +190,6 @@ class FileSystemResultStore(ResultStore):
         result = self.load_result(result_file_path, asset.__class__)
         return result
 
-    def has_workfile(self, asset: Asset, executor_id: str, suffix: str) -> bool:
-        result_file_path = self._get_result_file_path2(asset, executor_id)
-        return os.path.isfile(result_file_path + suffix)
-
     @staticmethod
     def save_result(result, result_file_path):
         with open(result_file_path, "wt") as result_file:
@@ -90,28 +207,8 @@ class FileSystemResultStore(ResultStore):
         if os.path.isfile(result_file_path):
             os.remove(result_file_path)
 
-    def delete_workfile(self, asset, executor_id, suffix: str):
-        result_file_path = self._get_result_file_path2(asset, executor_id)
-        workfile_path = result_file_path + suffix
-        if os.path.isfile(workfile_path):
-            os.remove(workfile_path)
-
-    def clean_up(self):
-        """
-        WARNING: RMOVE ENTIRE RESULT STORE, USE WITH CAUTION!!!
-        :return:
-        """
-        import shutil
-        if os.path.isdir(self.result_store_dir):
-            shutil.rmtree(self.result_store_dir)
-
     def _get_result_file_path(self, result):
         return self._get_result_file_path2(result.asset, result.executor_id)
 
     def _get_result_file_path2(self, asset, executor_id):
-        str_to_hash = str(asset).encode("utf-8")
-        return "{dir}/{executor_id}/{dataset}/{content_id}/{str}".format(
-            dir=self.result_store_dir, executor_id=executor_id,
-            dataset=asset.dataset,
-            content_id=asset.content_id,
-            str=hashlib.sha1(str_to_hash).hexdigest())
+        return self._get_workfile_path(asset, executor_id, suffix='')
@@ -1000,6 +1000,85 @@ class TrainTestModel(TypeVersionEnabled):
         pass
 
 
+class LibsvmRbfPredictor(object):
+    """
+    Evaluates the decision function of a libsvm RBF regression model on whole
+    batches with NumPy, instead of calling svmutil.svm_predict row by row.
+    The support vectors, coefficients, gamma and rho are read from the loaded
+    libsvm model, which is still what is trained and saved. Predictions match
+    svm_predict up to floating point rounding.
+    """
+
+    # upper bound on the number of kernel values held in memory at once
+    MAX_KERNEL_VALUES_PER_BLOCK = 1 << 22
+
+    def __init__(self, model):
+        assert self.supports(model)
+
+        num_sv = model.l
+        sv_list = []
+        num_dims = 0
+        for i in range(num_sv):
+            # sparse libsvm nodes: 1-based index, terminated by index -1
+            sv = {}
+            j = 0
+            while model.SV[i][j].index != -1:
+                sv[model.SV[i][j].index] = model.SV[i][j].value
+                j += 1
+            if len(sv) > 0:
+                num_dims = max(num_dims, max(sv.keys()))
+            sv_list.append(sv)
+
+        self.sv_2d = np.zeros([num_sv, num_dims])
+        for i, sv in enumerate(sv_list):
+            for index, value in sv.items():
+                self.sv_2d[i, index - 1] = value
+        self.sv_sq = np.sum(self.sv_2d ** 2, axis=1)
+        self.sv_coef = np.array([model.sv_coef[0][i] for i in range(num_sv)])
+        self.gamma = model.param.gamma
+        self.rho = model.rho[0]
+
+    @staticmethod
+    def supports(model):
+        return model.param.kernel_type == svmutil.RBF and \
+            model.param.svm_type in [svmutil.NU_SVR, svmutil.EPSILON_SVR]
+
+    @classmethod
+    def from_model(cls, model):
+        # cached on the model, which does not change once trained or loaded
+        predictor = getattr(model, '_rbf_predictor', None)
+        if predictor is None:
+            predictor = cls(model)
+            model._rbf_predictor = predictor
+        return predictor
+
+    def predict(self, xs_2d):
+        xs_2d = np.asarray(xs_2d, dtype=np.float64)
+        if xs_2d.ndim == 1:
+            xs_2d = xs_2d.reshape(1, -1)
+        num_rows, num_cols = xs_2d.shape
+        num_sv, num_dims = self.sv_2d.shape
+
+        # dimensions present on one side only are 0 on the other, as in libsvm
+        sv_2d = self.sv_2d
+        if num_cols > num_dims:
+            sv_2d = np.hstack([sv_2d, np.zeros([num_sv, num_cols - num_dims])])
+        elif num_cols < num_dims:
+            xs_2d = np.hstack([xs_2d, np.zeros([num_rows, num_dims - num_cols])])
+
+        ys = np.zeros(num_rows)
+        block = max(1, self.MAX_KERNEL_VALUES_PER_BLOCK // max(num_sv, 1))
+        for start in range(0, num_rows, block):
+            xs_block = xs_2d[start:start + block]
+            # ||x - sv||^2, clipped since the expansion may round below 0
+            dist_sq = np.sum(xs_block ** 2, axis=1)[:, None] + self.sv_sq[None, :] \
+                - 2.0 * (xs_block @ sv_2d.T)
+            np.maximum(dist_sq, 0.0, out=dist_sq)
+            ys[start:start + block] = \
+                np.exp(-self.gamma * dist_sq) @ self.sv_coef - self.rho
+        return ys
+
+
 class LibsvmNusvrTrainTestModel(TrainTestModel, RegressorMixin):
 
     TYPE = 'LIBSVMNUSVR'
@@ -1051,6 +1130,9 @@ class LibsvmNusvrTrainTestModel(TrainTestModel, RegressorMixin):
     def _predict(cls, model, xs_2d):
         # override TrainTestModel._predict
 
+        if LibsvmRbfPredictor.supports(model):
+            return LibsvmRbfPredictor.from_model(model).predict(xs_2d)
+
         f = list(xs_2d)
         for i, item in enumerate(f):
             f[i] = list(item)
@@ -1183,6 +1265,70 @@ class LibsvmNusvrTrainTestModel(TrainTestModel, RegressorMixin):
 
         return train_test_model
 
+    SVM_TYPE_NAMES = ['c_svc', 'nu_svc', 'one_class', 'epsilon_svr', 'nu_svr']
+    KERNEL_TYPE_NAMES = ['linear', 'polynomial', 'rbf', 'sigmoid', 'precomputed']
+
+    @classmethod
+    def _svm_model_to_str(cls, svm_model):
+        """
+        Write a regression libsvm model in the libsvm model file format, with
+        every value at full precision, unlike svmutil.svm_save_model.
+        """
+        param = svm_model.param
+        assert param.svm_type in [svmutil.EPSILON_SVR, svmutil.NU_SVR]
+        lines = ['svm_type {}'.format(cls.SVM_TYPE_NAMES[param.svm_type]),
+                 'kernel_type {}'.format(cls.KERNEL_TYPE_NAMES[param.kernel_type])]
+        if param.kernel_type == svmutil.POLY:
+            lines.append('degree {}'.format(param.degree))
+        if param.kernel_type in [svmutil.POLY, svmutil.RBF, svmutil.SIGMOID]:
+            lines.append('gamma {!r}'.format(param.gamma))
+        if param.kernel_type in [svmutil.POLY, svmutil.SIGMOID]:
+            lines.append('coef0 {!r}'.format(param.coef0))
+        lines += ['nr_class {}'.format(svm_model.nr_class),
+                  'total_sv {}'.format(svm_model.l),
+                  'rho {!r}'.format(svm_model.rho[0])]
+        if svm_model.probA:
+            lines.append('probA {!r}'.format(svm_model.probA[0]))
+        lines.append('SV')
+        for i in range(svm_model.l):
+            line = [repr(svm_model.sv_coef[0][i])]
+            j = 0
+            while svm_model.SV[i][j].index != -1:
+                line.append('{}:{!r}'.format(svm_model.SV[i][j].index,
+                                             svm_model.SV[i][j].value))
+                j += 1
+            lines.append(' '.join(line))
+        return '\n'.join(lines) + '\n'
+
+    @staticmethod
+    def _svm_model_from_str(svm_model_str):
+        with tempfile.NamedTemporaryFile(mode='w+t', delete=False) as tmpfile:
+            tmpfile.write(svm_model_str)
+        svm_model = svmutil.svm_load_model(tmpfile.name)
+        os.unlink(tmpfile.name)
+        return svm_model
+
+    def __getstate__(self):
+        # libsvm models hold ctypes pointers, which cannot be pickled; they
+        # are pickled as model files instead, e.g. to return them from
+        # parallel_map() workers
+        state = self.__dict__.copy()
+        state['model_dict'] = self.model_dict.copy()
+        model = state['model_dict'].get('model')
+        if isinstance(model, list):
+            state['model_dict']['model'] = [self._svm_model_to_str(m) for m in model]
+        elif model is not None:
+            state['model_dict']['model'] = self._svm_model_to_str(model)
+        return state
+
+    def __setstate__(self, state):
+        self.__dict__.update(state)
+        model = self.model_dict.get('model')
+        if isinstance(model, list):
+            self.model_dict['model'] = [self._svm_model_from_str(m) for m in model]
+        elif model is not None:
+            self.model_dict['model'] = self._svm_model_from_str(model)
+
 
 class SklearnRandomForestTrainTestModel(TrainTestModel, RegressorMixin):
 
@@ -1,13 +1,17 @@
+import shutil
+
 from vmaf import ExternalProgramCaller
-from vmaf.core.feature_extractor import VmafexecFeatureExtractorMixin, FeatureExtractor
+from vmaf.core.feature_extractor import VmafexecSingleFeatureExtractorMixin, FeatureExtractor
 
 
-class FloatMotionFeatureExtractor(VmafexecFeatureExtractorMixin, FeatureExtractor):
+class FloatMotionFeatureExtractor(VmafexecSingleFeatureExtractorMixin, FeatureExtractor):
 
     TYPE = "float_motion_feature"
     # VERSION = "1.0"
     VERSION = "1.1"  # add debug features
 
+    VMAFEXEC_FEATURE = 'float_motion'
+
     ATOM_FEATURES = ['motion2',
                      'motion',
                      ]
@@ -17,35 +21,16 @@ class FloatMotionFeatureExtractor(VmafexecFeatureExtractorMixin, FeatureExtracto
         'motion': 'motion',
     }
 
-    def _generate_result(self, asset):
-        # routine to call the command-line executable and generate quality
-        # scores in the log file.
-
-        quality_width, quality_height = asset.quality_width_height
-        log_file_path = self._get_log_file_path(asset)
-
-        yuv_type=self._get_workfile_yuv_type(asset)
-        ref_path=asset.ref_procfile_path
-        dis_path=asset.dis_procfile_path
-        w=quality_width
-        h=quality_height
-        logger = self.logger
-
-        optional_dict = self.optional_dict if self.optional_dict is not None else dict()
-        optional_dict2 = self.optional_dict2 if self.optional_dict2 is not None else dict()
-
-        ExternalProgramCaller.call_vmafexec_single_feature(
-            'float_motion', yuv_type, ref_path, dis_path, w, h,
-            log_file_path, logger, options={**optional_dict, **optional_dict2})
 
-
-class IntegerMotionFeatureExtractor(VmafexecFeatureExtractorMixin, FeatureExtractor):
+class IntegerMotionFeatureExtractor(VmafexecSingleFeatureExtractorMixin, FeatureExtractor):
 
     TYPE = "integer_motion_feature"
     # VERSION = "1.0"
     # VERSION = "1.1"  # vectorization
     VERSION = "1.2"  # add debug features
 
+    VMAFEXEC_FEATURE = 'motion'
+
     ATOM_FEATURES = ['motion2',
                      'motion',
                      ]
@@ -55,35 +40,15 @@ class IntegerMotionFeatureExtractor(VmafexecFeatureExtractorMixin, FeatureExtrac
         'motion': 'integer_motion',
     }
 
-    def _generate_result(self, asset):
-        # routine to call the command-line executable and generate quality
-        # scores in the log file.
-
-        quality_width, quality_height = asset.quality_width_height
-        log_file_path = self._get_log_file_path(asset)
-
-        yuv_type=self._get_workfile_yuv_type(asset)
-        ref_path=asset.ref_procfile_path
-        dis_path=asset.dis_procfile_path
-        w=quality_width
-        h=quality_height
-        logger = self.logger
-
-        optional_dict = self.optional_dict if self.optional_dict is not None else dict()
-        optional_dict2 = self.optional_dict2 if self.optional_dict2 is not None else dict()
-
-        ExternalProgramCaller.call_vmafexec_single_feature(
-            'motion', yuv_type, ref_path, dis_path, w, h,
-            log_file_path, logger,
-            options={**optional_dict, **optional_dict2})
 
-
-class FloatVifFeatureExtractor(VmafexecFeatureExtractorMixin, FeatureExtractor):
+class FloatVifFeatureExtractor(VmafexecSingleFeatureExtractorMixin, FeatureExtractor):
 
     TYPE = "float_VIF_feature"
     # VERSION = "1.0"
     VERSION = "1.1"  # add debug features
 
+    VMAFEXEC_FEATURE = 'float_vif'
+
     ATOM_FEATURES = [
                      'vif_scale0', 'vif_scale1', 'vif_scale2', 'vif_scale3',
                      'vif', 'vif_num', 'vif_den',
@@ -115,29 +80,8 @@ class FloatVifFeatureExtractor(VmafexecFeatureExtractorMixin, FeatureExtractor):
         'vif_den_scale3': 'vif_den_scale3',
     }
 
-    def _generate_result(self, asset):
-        # routine to call the command-line executable and generate quality
-        # scores in the log file.
-
-        quality_width, quality_height = asset.quality_width_height
-        log_file_path = self._get_log_file_path(asset)
-
-        yuv_type=self._get_workfile_yuv_type(asset)
-        ref_path=asset.ref_procfile_path
-        dis_path=asset.dis_procfile_path
-        w=quality_width
-        h=quality_height
-        logger = self.logger
-
-        optional_dict = self.optional_dict if self.optional_dict is not None else dict()
-        optional_dict2 = self.optional_dict2 if self.optional_dict2 is not None else dict()
-
-        ExternalProgramCaller.call_vmafexec_single_feature(
-            'float_vif', yuv_type, ref_path, dis_path, w, h,
-            log_file_path, logger, options={**optional_dict, **optional_dict2})
 
-
-class IntegerVifFeatureExtractor(VmafexecFeatureExtractorMixin, FeatureExtractor):
+class IntegerVifFeatureExtractor(VmafexecSingleFeatureExtractorMixin, FeatureExtractor):
 
     TYPE = "integer_VIF_feature"
     # VERSION = "1.0"
@@ -147,6 +91,8 @@ class IntegerVifFeatureExtractor(VmafexecFeatureExtractorMixin, FeatureExtractor
     # VERSION = "1.2"  # fix vectorization corner cases
     VERSION = "1.3"  # add debug features
 
+    VMAFEXEC_FEATURE = 'vif'
+
     ATOM_FEATURES = [
                      'vif_scale0', 'vif_scale1', 'vif_scale2', 'vif_scale3',
                      'vif', 'vif_num', 'vif_den',
@@ -178,34 +124,15 @@ class IntegerVifFeatureExtractor(VmafexecFeatureExtractorMixin, FeatureExtractor
         'vif_den_scale3': 'integer_vif_den_scale3',
     }
 
-    def _generate_result(self, asset):
-        # routine to call the command-line executable and generate quality
-        # scores in the log file.
-
-        quality_width, quality_height = asset.quality_width_height
-        log_file_path = self._get_log_file_path(asset)
-
-        yuv_type=self._get_workfile_yuv_type(asset)
-        ref_path=asset.ref_procfile_path
-        dis_path=asset.dis_procfile_path
-        w=quality_width
-        h=quality_height
-        logger = self.logger
-
-        optional_dict = self.optional_dict if self.optional_dict is not None else dict()
-        optional_dict2 = self.optional_dict2 if self.optional_dict2 is not None else dict()
-
-        ExternalProgramCaller.call_vmafexec_single_feature(
-            'vif', yuv_type, ref_path, dis_path, w, h,
-            log_file_path, logger, options={**optional_dict, **optional_dict2})
 
-
-class FloatAdmFeatureExtractor(VmafexecFeatureExtractorMixin, FeatureExtractor):
+class FloatAdmFeatureExtractor(VmafexecSingleFeatureExtractorMixin, FeatureExtractor):
 
     TYPE = "float_ADM_feature"
     # VERSION = "1.0"
     VERSION = "1.1"  # add debug features
 
+    VMAFEXEC_FEATURE = 'float_adm'
+
     ATOM_FEATURES = ['adm2',
                      'adm_scale0',
                      'adm_scale1',
@@ -243,33 +170,14 @@ class FloatAdmFeatureExtractor(VmafexecFeatureExtractorMixin, FeatureExtractor):
         'adm_den_scale3': 'adm_den_scale3',
     }
 
-    def _generate_result(self, asset):
-        # routine to call the command-line executable and generate quality
-        # scores in the log file.
-
-        quality_width, quality_height = asset.quality_width_height
-        log_file_path = self._get_log_file_path(asset)
-
-        yuv_type=self._get_workfile_yuv_type(asset)
-        ref_path=asset.ref_procfile_path
-        dis_path=asset.dis_procfile_path
-        w=quality_width
-        h=quality_height
-        logger = self.logger
-
-        optional_dict = self.optional_dict if self.optional_dict is not None else dict()
-        optional_dict2 = self.optional_dict2 if self.optional_dict2 is not None else dict()
-
-        ExternalProgramCaller.call_vmafexec_single_feature(
-            'float_adm', yuv_type, ref_path, dis_path, w, h,
-            log_file_path, logger, options={**optional_dict, **optional_dict2})
 
-
-class IntegerPsnrFeatureExtractor(VmafexecFeatureExtractorMixin, FeatureExtractor):
+class IntegerPsnrFeatureExtractor(VmafexecSingleFeatureExtractorMixin, FeatureExtractor):
 
     TYPE = 'integer_PSNR_feature'
     VERSION = "1.0"
 
+    VMAFEXEC_FEATURE = 'psnr'
+
     ATOM_FEATURES = ['psnr_y', 'psnr_cb', 'psnr_cr']
 
     ATOM_FEATURES_TO_VMAFEXEC_KEY_DICT = {
@@ -278,35 +186,16 @@ class IntegerPsnrFeatureExtractor(VmafexecFeatureExtractorMixin, FeatureExtracto
         'psnr_cr': 'psnr_cr',
     }
 
-    def _generate_result(self, asset):
-        # routine to call the command-line executable and generate quality
-        # scores in the log file.
-
-        quality_width, quality_height = asset.quality_width_height
-        log_file_path = self._get_log_file_path(asset)
-
-        yuv_type=self._get_workfile_yuv_type(asset)
-        ref_path=asset.ref_procfile_path
-        dis_path=asset.dis_procfile_path
-        w=quality_width
-        h=quality_height
-        logger = self.logger
-
-        optional_dict = self.optional_dict if self.optional_dict is not None else dict()
-        optional_dict2 = self.optional_dict2 if self.optional_dict2 is not None else dict()
-
-        ExternalProgramCaller.call_vmafexec_single_feature(
-            'psnr', yuv_type, ref_path, dis_path, w, h,
-            log_file_path, logger, options={**optional_dict, **optional_dict2})
 
-
-class IntegerAdmFeatureExtractor(VmafexecFeatureExtractorMixin, FeatureExtractor):
+class IntegerAdmFeatureExtractor(VmafexecSingleFeatureExtractorMixin, FeatureExtractor):
 
     TYPE = "integer_ADM_feature"
     # VERSION = "1.0"
     # VERSION = "1.1"  # vectorization; small numerical diff introduced by adm_enhn_gain_limit
     VERSION = "1.2"  # add debug features
 
+    VMAFEXEC_FEATURE = 'adm'
+
     ATOM_FEATURES = ['adm2',
                      'adm_scale0',
                      'adm_scale1',
@@ -344,56 +233,119 @@ class IntegerAdmFeatureExtractor(VmafexecFeatureExtractorMixin, FeatureExtractor
         'adm_den_scale3': 'integer_adm_den_scale3',
     }
 
-    def _generate_result(self, asset):
-        # routine to call the command-line executable and generate quality
-        # scores in the log file.
-
-        quality_width, quality_height = asset.quality_width_height
-        log_file_path = self._get_log_file_path(asset)
-
-        yuv_type=self._get_workfile_yuv_type(asset)
-        ref_path=asset.ref_procfile_path
-        dis_path=asset.dis_procfile_path
-        w=quality_width
-        h=quality_height
-        logger = self.logger
-
-        optional_dict = self.optional_dict if self.optional_dict is not None else dict()
-        optional_dict2 = self.optional_dict2 if self.optional_dict2 is not None else dict()
-
-        ExternalProgramCaller.call_vmafexec_single_feature(
-            'adm', yuv_type, ref_path, dis_path, w, h,
-            log_file_path, logger, options={**optional_dict, **optional_dict2})
 
-
-class CIEDE2000FeatureExtractor(VmafexecFeatureExtractorMixin, FeatureExtractor):
+class CIEDE2000FeatureExtractor(VmafexecSingleFeatureExtractorMixin, FeatureExtractor):
 
     TYPE = 'CIEDE2000_feature'
     VERSION = "1.0"
 
+    VMAFEXEC_FEATURE = 'ciede'
+
     ATOM_FEATURES = ['ciede2000']
 
     ATOM_FEATURES_TO_VMAFEXEC_KEY_DICT = {
         'ciede2000': 'ciede2000',
     }
 
-    def _generate_result(self, asset):
-        # routine to call the command-line executable and generate quality
-        # scores in the log file.
-
-        quality_width, quality_height = asset.quality_width_height
-        log_file_path = self._get_log_file_path(asset)
-
-        yuv_type=self._get_workfile_yuv_type(asset)
-        ref_path=asset.ref_procfile_path
-        dis_path=asset.dis_procfile_path
-        w=quality_width
-        h=quality_height
-        logger = self.logger
 
-        optional_dict = self.optional_dict if self.optional_dict is not None else dict()
-        optional_dict2 = self.optional_dict2 if self.optional_dict2 is not None else dict()
+class VmafexecFeatureExtractorGroup(FeatureExtractor):
+    """
+    Runs the features of several VmafexecSingleFeatureExtractorMixin
+    FeatureExtractors in one vmafexec invocation per asset, so that the asset
+    is decoded and read once, then splits the output back into one Result per
+    FeatureExtractor. Results are loaded from and saved to the result store
+    under each FeatureExtractor's own executor_id, exactly as if it had been
+    run on its own.
+
+    The FeatureExtractors must share assets, fifo_mode, delete_workdir,
+    result_store and optional_dict2, and must not run the same vmafexec
+    feature. Use can_group() to check the rest.
+    """
+
+    TYPE = 'vmafexec_feature_group'
+    VERSION = '1.0'
+
+    ATOM_FEATURES = []
+
+    def __init__(self, fextractors):
+        assert len(fextractors) > 0
+        assert self.can_group(fextractors)
+        self.fextractors = fextractors
+        self.pending_fextractors = fextractors
+        fextractor = fextractors[0]
+        super().__init__(assets=fextractor.assets,
+                         logger=fextractor.logger,
+                         fifo_mode=fextractor.fifo_mode,
+                         delete_workdir=fextractor.delete_workdir,
+                         result_store=fextractor.result_store,
+                         optional_dict2=fextractor.optional_dict2,
+                         save_workfiles=fextractor.save_workfiles)
+
+    @staticmethod
+    def can_group(fextractors):
+        features = [fextractor.VMAFEXEC_FEATURE for fextractor in fextractors]
+        if len(set(features)) != len(features):
+            return False
+
+        # options which apply to the whole vmafexec run must agree
+        run_options = {}
+        for fextractor in fextractors:
+            optional_dict = fextractor.optional_dict if fextractor.optional_dict is not None else dict()
+            optional_dict2 = fextractor.optional_dict2 if fextractor.optional_dict2 is not None else dict()
+            options = {**optional_dict, **optional_dict2}
+            for opt in ExternalProgramCaller.VMAFEXEC_RUN_OPTIONS:
+                if opt in options:
+                    if opt in run_options and run_options[opt] != options[opt]:
+                        return False
+                    run_options[opt] = options[opt]
+
+        # a vmafexec key must not be mistaken for another FeatureExtractor's
+        # key by the wildcard match of VmafexecFeatureExtractorMixin
+        for fextractor in fextractors:
+            for other in fextractors:
+                if other is fextractor:
+                    continue
+                for key in fextractor.ATOM_FEATURES_TO_VMAFEXEC_KEY_DICT.values():
+                    for other_key in other.ATOM_FEATURES_TO_VMAFEXEC_KEY_DICT.values():
+                        if key == other_key or other_key.startswith(key + '_'):
+                            return False
+
+        return True
+
+    def _run_on_asset(self, asset):
+        results = []
+        for fextractor in self.fextractors:
+            result = self.result_store.load(asset, fextractor.executor_id) if self.result_store else None
+            qw, qh = asset.quality_width_height
+            if result is not None and self.save_workfiles is True \
+                    and not self.result_store.has_workfile(asset, fextractor.executor_id, f'_dis.{qw}x{qh}.{self._get_workfile_yuv_type(asset)}.yuv'):
+                result = None
+            results.append(result)
+
+        self.pending_fextractors = [fextractor for fextractor, result in zip(self.fextractors, results) if result is None]
+        if len(self.pending_fextractors) > 0:
+            pending_results = iter(super()._run_on_asset(asset))
+            results = [next(pending_results) if result is None else result for result in results]
+
+        return [fextractor._post_process_result(result) for fextractor, result in zip(self.fextractors, results)]
 
-        ExternalProgramCaller.call_vmafexec_single_feature(
-            'ciede', yuv_type, ref_path, dis_path, w, h, log_file_path, logger,
-            options={**optional_dict, **optional_dict2})
+    def _generate_result(self, asset):
+        quality_width, quality_height = asset.quality_width_height
+        feature_options_dict = {fextractor.VMAFEXEC_FEATURE: fextractor._get_vmafexec_options(asset)
+                                for fextractor in self.pending_fextractors}
+        ExternalProgramCaller.call_vmafexec_folded_features(
+            feature_options_dict, self._get_workfile_yuv_type(asset),
+            asset.ref_procfile_path, asset.dis_procfile_path, quality_width, quality_height,
+            self._get_log_file_path(asset), self.logger)
+
+    def _read_result(self, asset):
+        # each FeatureExtractor parses the shared log from its own log path,
+        # which lives in the same workdir and is cleaned up along with it
+        results = []
+        for fextractor in self.pending_fextractors:
+            shutil.copyfile(self._get_log_file_path(asset), fextractor._get_log_file_path(asset))
+            results.append(fextractor._read_result(asset))
+        return results
+
+    def _save_result(self, results):
+        return [fextractor._save_result(result) for fextractor, result in zip(self.pending_fextractors, results)]